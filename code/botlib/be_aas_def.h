@@ -86,6 +86,14 @@ typedef struct aas_entity_s
 	bsp_link_t *leaves;
 } aas_entity_t;
 
+//bounds the entity was last linked with, kept apart from aas_entity_t
+//so collision tests only walk this array
+typedef struct aas_entitybounds_s
+{
+	vec3_t absmins;
+	vec3_t absmaxs;
+} aas_entitybounds_t;
+
 typedef struct aas_settings_s
 {
 	vec3_t phys_gravitydirection;
@@ -148,6 +156,15 @@ typedef struct aas_routingcache_s
 	unsigned short int traveltimes[1];			//travel time for every area (variable sized)
 } aas_routingcache_t;
 
+//precomputed travel times between all the cluster portals
+typedef struct aas_portaltable_s
+{
+	int travelflags;							//travel flags the table is calculated with
+	unsigned short int *traveltimes;			//[goalportal * numportals + portal], zero if not reachable
+	int numinvalidrows;							//number of rows to recalculate before use
+	byte *invalidrows;							//[goalportal], true if the row is out of date
+} aas_portaltable_t;
+
 //fields for the routing algorithm
 typedef struct aas_routingupdate_s
 {
@@ -248,6 +265,7 @@ typedef struct aas_s
 	int maxentities;
 	int maxclients;
 	aas_entity_t *entities;
+	aas_entitybounds_t *entitybounds;
 	//index to retrieve travel flag for a travel type
 	int travelflagfortype[MAX_TRAVELTYPES];
 	//travel flags for each area based on contents
@@ -269,6 +287,10 @@ typedef struct aas_s
 	aas_routingcache_t *newestcache;		// end of cache list sorted on time
 	//maximum travel time through portal areas
 	int *portalmaxtraveltimes;
+	//portal to portal travel times for a few sets of travel flags
+	int numportaltables;
+	int maxportaltables;
+	aas_portaltable_t *portaltables;
 	//areas the reachabilities go through
 	int *reachabilityareaindex;
 	aas_reachabilityareas_t *reachabilityareas;
@@ -45,6 +45,54 @@ Suite 120, Rockville, Maryland 20850 USA.
 #include "be_interface.h"
 #include "be_aas_def.h"
 
+#define MAX_ENTITYAREAS			128
+
+//===========================================================================
+// relink the entity into the AAS areas and BSP leaves
+// the AAS links are kept when the entity is still in the same areas
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_RelinkEntity(int entnum, bot_entitystate_t *state)
+{
+	int numareas, areas[MAX_ENTITYAREAS];
+	vec3_t mins, maxs, absmins, absmaxs;
+	aas_entity_t *ent;
+	aas_entitybounds_t *bounds;
+
+	ent = &aasworld.entities[entnum];
+	bounds = &aasworld.entitybounds[entnum];
+	//if the entity didn't move there's nothing to relink
+	if (ent->areas && VectorCompare(bounds->absmins, state->absmins) &&
+		VectorCompare(bounds->absmaxs, state->absmaxs))
+	{
+		return;
+	} //end if
+	//link the entity to the AAS areas using the largest bbox
+	AAS_PresenceTypeBoundingBox(PRESENCE_NORMAL, mins, maxs);
+	VectorSubtract(state->absmins, maxs, absmins);
+	VectorSubtract(state->absmaxs, mins, absmaxs);
+	numareas = AAS_BBoxAreaNums(absmins, absmaxs, areas, MAX_ENTITYAREAS);
+	if (numareas < 0)
+	{
+		AAS_UnlinkFromAreas(ent->areas);
+		ent->areas = AAS_AASLinkEntity(absmins, absmaxs, entnum);
+	} //end if
+	else if (!AAS_LinkedToAreas(ent->areas, areas, numareas))
+	{
+		AAS_UnlinkFromAreas(ent->areas);
+		ent->areas = AAS_LinkEntityToAreas(entnum, areas, numareas);
+	} //end else if
+	//unlink the entity from the BSP leaves
+	AAS_UnlinkFromBSPLeaves(ent->leaves);
+	//link the entity to the world BSP tree
+	ent->leaves = AAS_BSPLinkEntity(state->absmins, state->absmaxs, entnum, 0);
+	//
+	VectorCopy(state->absmins, bounds->absmins);
+	VectorCopy(state->absmaxs, bounds->absmaxs);
+} //end of the function AAS_RelinkEntity
 //===========================================================================
 //
 // Parameter:				-
@@ -87,19 +135,36 @@ int AAS_UpdateEntity(int entnum, bot_entitystate_t *state)
 		//don't link the world model
 		if (entnum != ENTITYNUM_WORLD)
 		{
-			//unlink the entity
-			AAS_UnlinkFromAreas(ent->areas);
-			//relink the entity to the AAS areas (use the larges bbox)
-			ent->areas = AAS_LinkEntityClientBBox(state->absmins, state->absmaxs, entnum, PRESENCE_NORMAL);
-			//unlink the entity from the BSP leaves
-			AAS_UnlinkFromBSPLeaves(ent->leaves);
-			//link the entity to the world BSP tree
-			ent->leaves = AAS_BSPLinkEntity(state->absmins, state->absmaxs, entnum, 0);
+			AAS_RelinkEntity(entnum, state);
 		} //end if
 	} //end if
 	return BLERR_NOERROR;
 } //end of the function AAS_UpdateEntity
 //===========================================================================
+// update all entities of a frame at once
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+int AAS_UpdateEntities(int numentities, int *entnums, bot_entitystate_t *states)
+{
+	int i, errnum;
+
+	if (!aasworld.loaded)
+	{
+		botimport.Print(PRT_MESSAGE, "AAS_UpdateEntities: not loaded\n");
+		return BLERR_NOAASFILE;
+	} //end if
+
+	for (i = 0; i < numentities; i++)
+	{
+		errnum = AAS_UpdateEntity(entnums[i], &states[i]);
+		if (errnum != BLERR_NOERROR) return errnum;
+	} //end for
+	return BLERR_NOERROR;
+} //end of the function AAS_UpdateEntities
+//===========================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -46,5 +46,7 @@ void AAS_UnlinkInvalidEntities(void);
 void AAS_ResetEntityLinks(void);
 //updates an entity
 int AAS_UpdateEntity(int ent, bot_entitystate_t *state);
+//updates the given entities
+int AAS_UpdateEntities(int numentities, int *entnums, bot_entitystate_t *states);
 #endif //AASINTERN
 
@@ -50,6 +50,20 @@ Suite 120, Rockville, Maryland 20850 USA.
 aas_t aasworld;
 
 libvar_t *saveroutingcache;
+libvar_t *max_frameusec;
+
+//time spent on routing and movement prediction during the current frame
+int frameusec;
+//nesting depth of the calls charged against the frame budget
+int framebudgetdepth;
+int framebudgetstart;
+qboolean framebudgetactive;
+//frame budget statistics
+int numbudgetframes;
+int numbudgetoverruns;
+int numbudgetdeferred;
+int maxbudgetframeusec;
+double totalbudgetframeusec;
 
 //===========================================================================
 //
@@ -142,6 +156,105 @@ void AAS_ContinueInit(float time)
 	AAS_SetInitialized();
 } //end of the function AAS_ContinueInit
 //===========================================================================
+// time in microseconds, only used to measure time lapse
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+unsigned int AAS_MicroSeconds(void)
+{
+	if (botimport.MicroSeconds) return (unsigned int) botimport.MicroSeconds();
+	//NOTE: without the import the frame budget is measured in whole milliseconds
+	return (unsigned int) botimport.MilliSeconds() * 1000u;
+} //end of the function AAS_MicroSeconds
+//===========================================================================
+// start a call that is charged against the frame budget
+// nested calls are charged as part of the outermost call
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_FrameBudgetStart(void)
+{
+	if (framebudgetdepth++) return;
+	framebudgetactive = (max_frameusec && max_frameusec->value > 0);
+	if (framebudgetactive) framebudgetstart = AAS_MicroSeconds();
+} //end of the function AAS_FrameBudgetStart
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_FrameBudgetEnd(void)
+{
+	if (--framebudgetdepth) return;
+	if (framebudgetactive) frameusec += (int) (AAS_MicroSeconds() - framebudgetstart);
+} //end of the function AAS_FrameBudgetEnd
+//===========================================================================
+// returns qtrue when non-urgent work should be deferred to a later frame
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+int AAS_FrameBudgetExpired(void)
+{
+	int usec;
+
+	if (!max_frameusec || max_frameusec->value <= 0) return qfalse;
+	usec = frameusec;
+	if (framebudgetdepth && framebudgetactive)
+	{
+		usec += (int) (AAS_MicroSeconds() - framebudgetstart);
+	} //end if
+	return usec >= (int) max_frameusec->value;
+} //end of the function AAS_FrameBudgetExpired
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_FrameBudgetDefer(void)
+{
+	numbudgetdeferred++;
+} //end of the function AAS_FrameBudgetDefer
+//===========================================================================
+// add the time used during the last frame to the statistics
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_FrameBudgetEndFrame(void)
+{
+	if (max_frameusec && max_frameusec->value > 0)
+	{
+		numbudgetframes++;
+		totalbudgetframeusec += frameusec;
+		if (frameusec > maxbudgetframeusec) maxbudgetframeusec = frameusec;
+		if (frameusec > (int) max_frameusec->value) numbudgetoverruns++;
+	} //end if
+	frameusec = 0;
+} //end of the function AAS_FrameBudgetEndFrame
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_FrameBudgetInfo(void)
+{
+	botimport.Print(PRT_MESSAGE, "frame budget %d usec\n", (int) max_frameusec->value);
+	botimport.Print(PRT_MESSAGE, "%d frames, %d usec average, %d usec max\n", numbudgetframes,
+					numbudgetframes ? (int) (totalbudgetframeusec / numbudgetframes) : 0, maxbudgetframeusec);
+	botimport.Print(PRT_MESSAGE, "%d frames over budget\n", numbudgetoverruns);
+	botimport.Print(PRT_MESSAGE, "%d calls deferred\n", numbudgetdeferred);
+} //end of the function AAS_FrameBudgetInfo
+//===========================================================================
 // called at the start of every frame
 //
 // Parameter:				-
@@ -159,6 +272,7 @@ int AAS_StartFrame(float time)
 	AAS_ContinueInit(time);
 	//
 	aasworld.frameroutingupdates = 0;
+	AAS_FrameBudgetEndFrame();
 	//
 	if (botDeveloper)
 	{
@@ -177,6 +291,11 @@ int AAS_StartFrame(float time)
 			PrintMemoryLabels();
 			LibVarSet("memorydump", "0");
 		} //end if
+		if (LibVarGetValue("showframebudget"))
+		{
+			AAS_FrameBudgetInfo();
+			LibVarSet("showframebudget", "0");
+		} //end if
 	} //end if
 	//
 	if (saveroutingcache->value)
@@ -298,9 +417,20 @@ int AAS_Setup(void)
 	aasworld.maxentities = (int) LibVarValue("maxentities", "1024");
 	// as soon as it's set to 1 the routing cache will be saved
 	saveroutingcache = LibVar("saveroutingcache", "0");
+	//microseconds per frame for routing and movement prediction, 0 = no limit
+	max_frameusec = LibVar("max_frameusec", "0");
+	frameusec = 0;
+	framebudgetdepth = 0;
+	numbudgetframes = 0;
+	numbudgetoverruns = 0;
+	numbudgetdeferred = 0;
+	maxbudgetframeusec = 0;
+	totalbudgetframeusec = 0;
 	//allocate memory for the entities
 	if (aasworld.entities) FreeMemory(aasworld.entities);
 	aasworld.entities = (aas_entity_t *) GetClearedHunkMemory(aasworld.maxentities * sizeof(aas_entity_t));
+	if (aasworld.entitybounds) FreeMemory(aasworld.entitybounds);
+	aasworld.entitybounds = (aas_entitybounds_t *) GetClearedHunkMemory(aasworld.maxentities * sizeof(aas_entitybounds_t));
 	//invalidate all the entities
 	AAS_InvalidateEntities();
 	//force some recalculations
@@ -330,6 +460,7 @@ void AAS_Shutdown(void)
 	AAS_DumpAASData();
 	//free the entities
 	if (aasworld.entities) FreeMemory(aasworld.entities);
+	if (aasworld.entitybounds) FreeMemory(aasworld.entitybounds);
 	//clear the aasworld structure
 	Com_Memset(&aasworld, 0, sizeof(aas_t));
 	//aas has not been initialized
@@ -53,6 +53,13 @@ void AAS_Shutdown(void);
 int AAS_LoadMap(const char *mapname);
 //start a new time frame
 int AAS_StartFrame(float time);
+//start and end a call that is charged against the frame budget
+void AAS_FrameBudgetStart(void);
+void AAS_FrameBudgetEnd(void);
+//returns true if the frame budget is used up
+int AAS_FrameBudgetExpired(void);
+//count a call deferred because the frame budget is used up
+void AAS_FrameBudgetDefer(void);
 #endif //AASINTERN
 
 //returns true if AAS is initialized
@@ -48,6 +48,9 @@ Suite 120, Rockville, Maryland 20850 USA.
 #include "be_aas_funcs.h"
 #include "be_interface.h"
 #include "be_aas_def.h"
+#ifdef BSPC
+#include "../bspc/l_threads.h"
+#endif //BSPC
 
 //#define REACH_DEBUG
 
@@ -63,6 +66,10 @@ Suite 120, Rockville, Maryland 20850 USA.
 #define INSIDEUNITS_WATERJUMP				15
 //area flag used for weapon jumping
 #define AREA_WEAPONJUMP						8192	//valid area to weapon jump to
+//where the reachabilities of an area come from with multiple threads
+#define REACHSOURCE_THREAD					0
+#define REACHSOURCE_CACHED					1
+#define REACHSOURCE_LADDER					2
 //number of reachabilities of each type
 int reach_swim;			//swim
 int reach_equalfloor;	//walk on floors with equal height
@@ -83,8 +90,24 @@ int reach_strafejump;	//strafe jump (just normal jump but further)
 int reach_rocketjump;	//rocket jump
 int reach_bfgjump;		//bfg jump
 int reach_jumppad;		//jump pads
+#ifdef BSPC
+//the threads count reachabilities at the same time
+#define REACH_COUNT(x)		(reachabilitythreads ? ThreadAtomicAdd(&(x), 1) : (x)++)
+//all the counters for taking reachabilities out of the statistics
+int *reachcounters[] = {&reach_swim, &reach_equalfloor, &reach_step, &reach_walk,
+	&reach_barrier, &reach_waterjump, &reach_walkoffledge, &reach_jump, &reach_ladder,
+	&reach_teleport, &reach_elevator, &reach_funcbob, &reach_grapple, &reach_doublejump,
+	&reach_rampjump, &reach_strafejump, &reach_rocketjump, &reach_bfgjump, &reach_jumppad};
+#define NUM_REACHCOUNTERS	ARRAY_LEN(reachcounters)
+#else
+#define REACH_COUNT(x)		((x)++)
+#endif //BSPC
 //if true grapple reachabilities are skipped
 int calcgrapplereach;
+#ifdef BSPC
+//reachabilities kept from a previous compile (bspc/aas_cache.c)
+int AAS_CachedReachability(int areanum, aas_reachability_t **reach);
+#endif //BSPC
 //linked reachability
 typedef struct aas_lreachability_s
 {
@@ -103,6 +126,10 @@ aas_lreachability_t *reachabilityheap;	//heap with reachabilities
 aas_lreachability_t *nextreachability;	//next free reachability from the heap
 aas_lreachability_t **areareachability;	//reachability links for every area
 int numlreachabilities;
+#ifdef BSPC
+int *threadreachareas;					//areas the threads calculate reachabilities for
+qboolean reachabilitythreads;			//true while the threads share the heap
+#endif //BSPC
 
 //===========================================================================
 // returns the surface area of the given face
@@ -491,13 +518,21 @@ aas_lreachability_t *AAS_AllocReachability(void)
 {
 	aas_lreachability_t *r;
 
-	if (!nextreachability) return NULL;
-	//make sure the error message only shows up once
-	if (!nextreachability->next) AAS_Error("AAS_MAX_REACHABILITYSIZE\n");
-	//
+#ifdef BSPC
+	if (reachabilitythreads) ThreadLock();
+#endif //BSPC
 	r = nextreachability;
-	nextreachability = nextreachability->next;
-	numlreachabilities++;
+	if (r)
+	{
+		//make sure the error message only shows up once
+		if (!r->next) AAS_Error("AAS_MAX_REACHABILITYSIZE\n");
+		//
+		nextreachability = r->next;
+		numlreachabilities++;
+	} //end if
+#ifdef BSPC
+	if (reachabilitythreads) ThreadUnlock();
+#endif //BSPC
 	return r;
 } //end of the function AAS_AllocReachability
 //===========================================================================
@@ -895,7 +930,7 @@ int AAS_Reachability_Swim(int area1num, int area2num)
 					//link the reachability
 					lreach->next = areareachability[area1num];
 					areareachability[area1num] = lreach;
-					reach_swim++;
+					REACH_COUNT(reach_swim);
 					return qtrue;
 				} //end if
 			} //end if
@@ -1045,7 +1080,7 @@ int AAS_Reachability_EqualFloorHeight(int area1num, int area2num)
 		//avoid rather small areas
 		//if (AAS_AreaGroundFaceArea(lreach->areanum) < 500) lreach->traveltime += 100;
 		//
-		reach_equalfloor++;
+		REACH_COUNT(reach_equalfloor);
 		return qtrue;
 	} //end if
 	return qfalse;
@@ -1388,7 +1423,7 @@ int AAS_Reachability_Step_Barrier_WaterJump_WalkOffLedge(int area1num, int area2
 			//avoid rather small areas
 			//if (AAS_AreaGroundFaceArea(lreach->areanum) < 500) lreach->traveltime += 100;
 			//
-			reach_step++;
+			REACH_COUNT(reach_step);
 			return qtrue;
 		} //end if
 	} //end if
@@ -1441,7 +1476,7 @@ int AAS_Reachability_Step_Barrier_WaterJump_WalkOffLedge(int area1num, int area2
 					lreach->next = areareachability[area1num];
 					areareachability[area1num] = lreach;
 					//we've got another waterjump reachability
-					reach_waterjump++;
+					REACH_COUNT(reach_waterjump);
 					return qtrue;
 				} //end if
 			} //end if
@@ -1489,7 +1524,7 @@ int AAS_Reachability_Step_Barrier_WaterJump_WalkOffLedge(int area1num, int area2
 					lreach->next = areareachability[area1num];
 					areareachability[area1num] = lreach;
 					//we've got another barrierjump reachability
-					reach_barrier++;
+					REACH_COUNT(reach_barrier);
 					return qtrue;
 				} //end if
 			} //end if
@@ -1536,7 +1571,7 @@ int AAS_Reachability_Step_Barrier_WaterJump_WalkOffLedge(int area1num, int area2
 				lreach->next = areareachability[area1num];
 				areareachability[area1num] = lreach;
 				//we've got another walk reachability
-				reach_walk++;
+				REACH_COUNT(reach_walk);
 				return qtrue;
 			} //end if
 			// if no maximum fall height set or less than the max
@@ -1587,7 +1622,7 @@ int AAS_Reachability_Step_Barrier_WaterJump_WalkOffLedge(int area1num, int area2
 							lreach->next = areareachability[area1num];
 							areareachability[area1num] = lreach;
 							//
-							reach_walkoffledge++;
+							REACH_COUNT(reach_walkoffledge);
 							//NOTE: don't create a weapon (rl, bfg) jump reachability here
 							//because it interferes with other reachabilities
 							//like the ladder reachability
@@ -2364,9 +2399,9 @@ int AAS_Reachability_Jump(int area1num, int area2num)
 		areareachability[area1num] = lreach;
 		//
 		if ((traveltype & TRAVELTYPE_MASK) == TRAVEL_JUMP)
-			reach_jump++;
+			REACH_COUNT(reach_jump);
 		else
-			reach_walkoffledge++;
+			REACH_COUNT(reach_walkoffledge);
 	} //end if
 	return qfalse;
 } //end of the function AAS_Reachability_Jump
@@ -2494,7 +2529,7 @@ int AAS_Reachability_Ladder(int area1num, int area2num)
 			lreach->next = areareachability[area1num];
 			areareachability[area1num] = lreach;
 			//
-			reach_ladder++;
+			REACH_COUNT(reach_ladder);
 			//create a new reachability link
 			lreach = AAS_AllocReachability();
 			if (!lreach) return qfalse;
@@ -2509,7 +2544,7 @@ int AAS_Reachability_Ladder(int area1num, int area2num)
 			lreach->next = areareachability[area2num];
 			areareachability[area2num] = lreach;
 			//
-			reach_ladder++;
+			REACH_COUNT(reach_ladder);
 			//
 			return qtrue;
 		} //end if
@@ -2533,7 +2568,7 @@ int AAS_Reachability_Ladder(int area1num, int area2num)
 			lreach->next = areareachability[area1num];
 			areareachability[area1num] = lreach;
 			//
-			reach_ladder++;
+			REACH_COUNT(reach_ladder);
 			//create a new reachability link
 			lreach = AAS_AllocReachability();
 			if (!lreach) return qfalse;
@@ -2547,7 +2582,7 @@ int AAS_Reachability_Ladder(int area1num, int area2num)
 			lreach->next = areareachability[area2num];
 			areareachability[area2num] = lreach;
 			//
-			reach_walkoffledge++;
+			REACH_COUNT(reach_walkoffledge);
 			//
 			return qtrue;
 		} //end if
@@ -2628,7 +2663,7 @@ int AAS_Reachability_Ladder(int area1num, int area2num)
 					lreach->next = areareachability[area1num];
 					areareachability[area1num] = lreach;
 					//
-					reach_ladder++;
+					REACH_COUNT(reach_ladder);
 					//create a new reachability link
 					lreach = AAS_AllocReachability();
 					if (!lreach) return qfalse;
@@ -2645,7 +2680,7 @@ int AAS_Reachability_Ladder(int area1num, int area2num)
 					lreach->next = areareachability[area2num];
 					areareachability[area2num] = lreach;
 					//
-					reach_jump++;	
+					REACH_COUNT(reach_jump);	
 					//
 					return qtrue;
 #ifdef REACH_DEBUG
@@ -2694,7 +2729,7 @@ int AAS_Reachability_Ladder(int area1num, int area2num)
 					lreach->next = areareachability[area2num];
 					areareachability[area2num] = lreach;
 					//
-					reach_jump++;
+					REACH_COUNT(reach_jump);
 					//
 					Log_Write("jump far to ladder reach between %d and %d\r\n", area2num, area1num);
 					//
@@ -2922,7 +2957,7 @@ void AAS_Reachability_Teleport(void)
 			lreach->next = areareachability[area1num];
 			areareachability[area1num] = lreach;
 			//
-			reach_teleport++;
+			REACH_COUNT(reach_teleport);
 		} //end for
 		//unlink the invalid entity
 		AAS_UnlinkFromAreas(areas);
@@ -3138,7 +3173,7 @@ void AAS_Reachability_Elevator(void)
 						Log_Write("elevator reach from %d to %d\r\n", area1num, area2num);
 #endif //REACH_DEBUG
 						//
-						reach_elevator++;
+						REACH_COUNT(reach_elevator);
 					} //end for
 				} //end for
 			} //end for
@@ -3462,7 +3497,7 @@ void AAS_Reachability_FuncBobbing(void)
 					lreach->traveltype = TRAVEL_FUNCBOB;
 					lreach->traveltype |= AAS_TravelFlagsForTeam(ent);
 					lreach->traveltime = aassettings.rs_funcbob;
-					reach_funcbob++;
+					REACH_COUNT(reach_funcbob);
 					lreach->next = areareachability[startreach->areanum];
 					areareachability[startreach->areanum] = lreach;
 					//
@@ -3663,7 +3698,7 @@ void AAS_Reachability_JumpPad(void)
 					lreach->next = areareachability[link->areanum];
 					areareachability[link->areanum] = lreach;
 					//
-					reach_jumppad++;
+					REACH_COUNT(reach_jumppad);
 				} //end for
 			} //end if
 		} //end if
@@ -3767,7 +3802,7 @@ void AAS_Reachability_JumpPad(void)
 									lreach->next = areareachability[link->areanum];
 									areareachability[link->areanum] = lreach;
 									//
-									reach_jumppad++;
+									REACH_COUNT(reach_jumppad);
 								} //end for
 							}
 						} //end if
@@ -3916,7 +3951,7 @@ int AAS_Reachability_Grapple(int area1num, int area2num)
 		lreach->next = areareachability[area1num];
 		areareachability[area1num] = lreach;
 		//
-		reach_grapple++;
+		REACH_COUNT(reach_grapple);
 	} //end for
 	//
 	return qfalse;
@@ -4109,7 +4144,7 @@ int AAS_Reachability_WeaponJump(int area1num, int area2num)
 						lreach->next = areareachability[area1num];
 						areareachability[area1num] = lreach;
 						//
-						reach_rocketjump++;
+						REACH_COUNT(reach_rocketjump);
 						return qtrue;
 					} //end if
 				} //end if
@@ -4294,7 +4329,7 @@ void AAS_Reachability_WalkOffLedge(int areanum)
 						lreach->next = areareachability[areanum];
 						areareachability[areanum] = lreach;
 						//we've got another walk off ledge reachability
-						reach_walkoffledge++;
+						REACH_COUNT(reach_walkoffledge);
 					} //end if
 				} //end for
 			} //end for
@@ -4302,6 +4337,248 @@ void AAS_Reachability_WalkOffLedge(int areanum)
 	} //end for
 } //end of the function AAS_Reachability_WalkOffLedge
 //===========================================================================
+// calculates the reachabilities from the given area to all other areas
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_Reachability_Area(int areanum)
+{
+	int j;
+
+	//only create jumppad reachabilities from jumppad areas
+	if (aasworld.areasettings[areanum].contents & AREACONTENTS_JUMPPAD)
+	{
+		return;
+	} //end if
+	//loop over the areas
+	for (j = 1; j < aasworld.numareas; j++)
+	{
+		if (areanum == j) continue;
+		//never create reachabilities from teleporter or jumppad areas to regular areas
+		if (aasworld.areasettings[areanum].contents & (AREACONTENTS_TELEPORTER|AREACONTENTS_JUMPPAD))
+		{
+			if (!(aasworld.areasettings[j].contents & (AREACONTENTS_TELEPORTER|AREACONTENTS_JUMPPAD)))
+			{
+				continue;
+			} //end if
+		} //end if
+		//if there already is a reachability link from the area to j
+		if (AAS_ReachabilityExists(areanum, j)) continue;
+		//check for a swim reachability
+		if (AAS_Reachability_Swim(areanum, j)) continue;
+		//check for a simple walk on equal floor height reachability
+		if (AAS_Reachability_EqualFloorHeight(areanum, j)) continue;
+		//check for step, barrier, waterjump and walk off ledge reachabilities
+		if (AAS_Reachability_Step_Barrier_WaterJump_WalkOffLedge(areanum, j)) continue;
+		//check for ladder reachabilities
+		if (AAS_Reachability_Ladder(areanum, j)) continue;
+		//check for a jump reachability
+		if (AAS_Reachability_Jump(areanum, j)) continue;
+	} //end for
+	//never create these reachabilities from teleporter or jumppad areas
+	if (aasworld.areasettings[areanum].contents & (AREACONTENTS_TELEPORTER|AREACONTENTS_JUMPPAD))
+	{
+		return;
+	} //end if
+	//loop over the areas
+	for (j = 1; j < aasworld.numareas; j++)
+	{
+		if (areanum == j) continue;
+		//
+		if (AAS_ReachabilityExists(areanum, j)) continue;
+		//check for a grapple hook reachability
+		if (calcgrapplereach) AAS_Reachability_Grapple(areanum, j);
+		//check for a weapon jump reachability
+		AAS_Reachability_WeaponJump(areanum, j);
+	} //end for
+} //end of the function AAS_Reachability_Area
+#ifdef BSPC
+//===========================================================================
+// links the reachabilities of an area that didn't change since the previous
+// compile, returns qfalse if they have to be calculated
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+int AAS_Reachability_Cached(int areanum)
+{
+	int i, numreach;
+	aas_reachability_t *reach;
+	aas_lreachability_t *lreach, *created;
+
+	numreach = AAS_CachedReachability(areanum, &reach);
+	if (numreach < 0) return qfalse;
+	//reachabilities already created by other areas (ladders)
+	created = areareachability[areanum];
+	//link in reverse so the reachabilities are stored in the original order
+	for (i = numreach - 1; i >= 0; i--)
+	{
+		for (lreach = created; lreach; lreach = lreach->next)
+		{
+			if (lreach->areanum == reach[i].areanum) break;
+		} //end for
+		if (lreach) continue;
+		//
+		lreach = AAS_AllocReachability();
+		if (!lreach) return qtrue;
+		lreach->areanum = reach[i].areanum;
+		lreach->facenum = reach[i].facenum;
+		lreach->edgenum = reach[i].edgenum;
+		VectorCopy(reach[i].start, lreach->start);
+		VectorCopy(reach[i].end, lreach->end);
+		lreach->traveltype = reach[i].traveltype;
+		lreach->traveltime = reach[i].traveltime;
+		//
+		lreach->next = areareachability[areanum];
+		areareachability[areanum] = lreach;
+	} //end for
+	return qtrue;
+} //end of the function AAS_Reachability_Cached
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_Reachability_AreaThread(int work)
+{
+	AAS_Reachability_Area(threadreachareas[work]);
+} //end of the function AAS_Reachability_AreaThread
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_FreeReachabilityList(aas_lreachability_t *lreach)
+{
+	aas_lreachability_t *nextlreach;
+
+	for (; lreach; lreach = nextlreach)
+	{
+		nextlreach = lreach->next;
+		AAS_FreeReachability(lreach);
+	} //end for
+} //end of the function AAS_FreeReachabilityList
+//===========================================================================
+// calculates the reachabilities of all areas with multiple threads
+// the reachabilities of an area are linked to the area itself except for
+// ladder reachabilities which are also linked to the other ladder area and
+// jump up to ladder reachabilities which are linked to the area below the
+// ladder. the threads calculate the areas without ladders and the cached
+// areas are looked up first, then the lists are linked in area order with
+// the ladder areas calculated in between. an area a ladder already linked
+// a reachability to is handled the way a single thread would have, so the
+// result is the same as with a single thread
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_Reachability_Threaded(void)
+{
+	int i, j, numthreadareas, numreach[NUM_REACHCOUNTERS];
+	byte *reachsource;
+	aas_lreachability_t **reachlist, *lreach, *nextlreach, *created, *last, *r;
+
+	threadreachareas = (int *) GetMemory(aasworld.numareas * sizeof(int));
+	reachsource = (byte *) GetClearedMemory(aasworld.numareas * sizeof(byte));
+	reachlist = (aas_lreachability_t **) GetClearedMemory(aasworld.numareas * sizeof(aas_lreachability_t *));
+	numthreadareas = 0;
+	for (i = 1; i < aasworld.numareas; i++)
+	{
+		//reuse the reachabilities of areas that didn't change since the previous compile
+		if (AAS_Reachability_Cached(i))
+		{
+			reachsource[i] = REACHSOURCE_CACHED;
+			reachlist[i] = areareachability[i];
+			areareachability[i] = NULL;
+			continue;
+		} //end if
+		//ladder areas link reachabilities to other areas
+		if (AAS_AreaLadder(i))
+		{
+			reachsource[i] = REACHSOURCE_LADDER;
+			continue;
+		} //end if
+		threadreachareas[numthreadareas++] = i;
+	} //end for
+	//the threads allocate reachabilities from the same heap
+	reachabilitythreads = qtrue;
+	RunThreadsOnIndividual(numthreadareas, qtrue, AAS_Reachability_AreaThread);
+	reachabilitythreads = qfalse;
+	//
+	for (i = 0; i < numthreadareas; i++)
+	{
+		reachlist[threadreachareas[i]] = areareachability[threadreachareas[i]];
+		areareachability[threadreachareas[i]] = NULL;
+	} //end for
+	//link the reachabilities in area order
+	for (i = 1; i < aasworld.numareas; i++)
+	{
+		if (reachsource[i] == REACHSOURCE_LADDER)
+		{
+			AAS_Reachability_Area(i);
+			continue;
+		} //end if
+		//reachabilities already created by ladder areas before this area
+		created = areareachability[i];
+		if (!created)
+		{
+			areareachability[i] = reachlist[i];
+			continue;
+		} //end if
+		if (reachsource[i] == REACHSOURCE_CACHED)
+		{
+			//drop the cached reachabilities to areas a ladder already linked
+			last = NULL;
+			for (lreach = reachlist[i]; lreach; lreach = nextlreach)
+			{
+				nextlreach = lreach->next;
+				for (r = created; r; r = r->next)
+				{
+					if (r->areanum == lreach->areanum) break;
+				} //end for
+				if (r)
+				{
+					AAS_FreeReachability(lreach);
+					continue;
+				} //end if
+				if (last) last->next = lreach;
+				else areareachability[i] = lreach;
+				last = lreach;
+			} //end for
+			if (last) last->next = created;
+		} //end if
+		else
+		{
+			//the ladder reachabilities change the calculation of this area,
+			//calculate what the thread did once more to take it out of the
+			//statistics as well
+			for (j = 0; j < NUM_REACHCOUNTERS; j++) numreach[j] = *reachcounters[j];
+			areareachability[i] = NULL;
+			AAS_Reachability_Area(i);
+			for (j = 0; j < NUM_REACHCOUNTERS; j++)
+			{
+				*reachcounters[j] -= 2 * (*reachcounters[j] - numreach[j]);
+			} //end for
+			AAS_FreeReachabilityList(areareachability[i]);
+			AAS_FreeReachabilityList(reachlist[i]);
+			areareachability[i] = created;
+			AAS_Reachability_Area(i);
+		} //end else
+	} //end for
+	//
+	FreeMemory(reachlist);
+	FreeMemory(reachsource);
+	FreeMemory(threadreachareas);
+	threadreachareas = NULL;
+} //end of the function AAS_Reachability_Threaded
+#endif //BSPC
+//===========================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -4366,7 +4643,7 @@ void AAS_StoreReachability(void)
 //===========================================================================
 int AAS_ContinueInitReachability(float time)
 {
-	int i, j, todo, start_time;
+	int i, todo, start_time;
 	static float framereachability, reachability_delay;
 	static int lastpercentage;
 
@@ -4381,6 +4658,14 @@ int AAS_ContinueInitReachability(float time)
 		framereachability = 2000;
 		reachability_delay = 1000;
 	} //end if
+#ifdef BSPC
+	//calculate the reachabilities of all areas at once with multiple threads
+	if (aasworld.numreachabilityareas == 1 && numthreads != 1)
+	{
+		AAS_Reachability_Threaded();
+		aasworld.numreachabilityareas = aasworld.numareas;
+	} //end if
+#endif //BSPC
 	//number of areas to calculate reachability for this cycle
 	todo = aasworld.numreachabilityareas + (int) framereachability;
 	start_time = botimport.MilliSeconds();
@@ -4388,52 +4673,12 @@ int AAS_ContinueInitReachability(float time)
 	for (i = aasworld.numreachabilityareas; i < aasworld.numareas && i < todo; i++)
 	{
 		aasworld.numreachabilityareas++;
-		//only create jumppad reachabilities from jumppad areas
-		if (aasworld.areasettings[i].contents & AREACONTENTS_JUMPPAD)
-		{
-			continue;
-		} //end if
-		//loop over the areas
-		for (j = 1; j < aasworld.numareas; j++)
-		{
-			if (i == j) continue;
-			//never create reachabilities from teleporter or jumppad areas to regular areas
-			if (aasworld.areasettings[i].contents & (AREACONTENTS_TELEPORTER|AREACONTENTS_JUMPPAD))
-			{
-				if (!(aasworld.areasettings[j].contents & (AREACONTENTS_TELEPORTER|AREACONTENTS_JUMPPAD)))
-				{
-					continue;
-				} //end if
-			} //end if
-			//if there already is a reachability link from area i to j
-			if (AAS_ReachabilityExists(i, j)) continue;
-			//check for a swim reachability
-			if (AAS_Reachability_Swim(i, j)) continue;
-			//check for a simple walk on equal floor height reachability
-			if (AAS_Reachability_EqualFloorHeight(i, j)) continue;
-			//check for step, barrier, waterjump and walk off ledge reachabilities
-			if (AAS_Reachability_Step_Barrier_WaterJump_WalkOffLedge(i, j)) continue;
-			//check for ladder reachabilities
-			if (AAS_Reachability_Ladder(i, j)) continue;
-			//check for a jump reachability
-			if (AAS_Reachability_Jump(i, j)) continue;
-		} //end for
-		//never create these reachabilities from teleporter or jumppad areas
-		if (aasworld.areasettings[i].contents & (AREACONTENTS_TELEPORTER|AREACONTENTS_JUMPPAD))
-		{
-			continue;
-		} //end if
-		//loop over the areas
-		for (j = 1; j < aasworld.numareas; j++)
-		{
-			if (i == j) continue;
-			//
-			if (AAS_ReachabilityExists(i, j)) continue;
-			//check for a grapple hook reachability
-			if (calcgrapplereach) AAS_Reachability_Grapple(i, j);
-			//check for a weapon jump reachability
-			AAS_Reachability_WeaponJump(i, j);
-		} //end for
+#ifdef BSPC
+		//reuse the reachabilities of areas that didn't change since the previous compile
+		if (AAS_Reachability_Cached(i)) continue;
+#endif //BSPC
+		//calculate the reachabilities from this area to all other areas
+		AAS_Reachability_Area(i);
 		//if the calculation took more time than the max reachability delay
 		if (botimport.MilliSeconds() - start_time > (int) reachability_delay) break;
 		//
@@ -78,15 +78,29 @@ Suite 120, Rockville, Maryland 20850 USA.
   for every area (aasworld.numareas) the portal cache stores
   aasworld.numportals travel times
 
+  portal table:
+  stores the distances of all portals to all other portals for one set
+  of travel flags, with a table the portal routing cache of a goal area
+  is filled in with the distances of the goal to the portals of its own
+  cluster instead of a routing update over all the clusters
+
 */
 
 #ifdef ROUTING_DEBUG
 int numareacacheupdates;
 int numportalcacheupdates;
+int numportaltablecacheupdates;
+int numportaltablerowupdates;
 #endif //ROUTING_DEBUG
 
 int routingcachesize;
 int max_routingcachesize;
+int portaltablesize;
+int portaltabletime;
+
+aas_portaltable_t *AAS_GetPortalTable(int travelflags);
+void AAS_UpdatePortalTableRows(aas_portaltable_t *table, int goalclusternum);
+void AAS_InvalidatePortalTableRows(int areanum, int changed);
 
 //===========================================================================
 //
@@ -100,6 +114,9 @@ void AAS_RoutingInfo(void)
 	botimport.Print(PRT_MESSAGE, "%d area cache updates\n", numareacacheupdates);
 	botimport.Print(PRT_MESSAGE, "%d portal cache updates\n", numportalcacheupdates);
 	botimport.Print(PRT_MESSAGE, "%d bytes routing cache\n", routingcachesize);
+	botimport.Print(PRT_MESSAGE, "%d portal cache updates from %d portal tables\n", numportaltablecacheupdates, aasworld.numportaltables);
+	botimport.Print(PRT_MESSAGE, "%d portal table rows recalculated\n", numportaltablerowupdates);
+	botimport.Print(PRT_MESSAGE, "%d bytes portal tables calculated in %d msec\n", portaltablesize, portaltabletime);
 } //end of the function AAS_RoutingInfo
 #endif //ROUTING_DEBUG
 //===========================================================================
@@ -248,6 +265,26 @@ void AAS_FreeRoutingCache(aas_routingcache_t *cache)
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
+void AAS_FreePortalTables(void)
+{
+	int i;
+
+	for (i = 0; i < aasworld.numportaltables; i++)
+	{
+		FreeMemory(aasworld.portaltables[i].traveltimes);
+		FreeMemory(aasworld.portaltables[i].invalidrows);
+		aasworld.portaltables[i].traveltimes = NULL;
+		aasworld.portaltables[i].invalidrows = NULL;
+	} //end for
+	aasworld.numportaltables = 0;
+	portaltablesize = 0;
+} //end of the function AAS_FreePortalTables
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
 void AAS_RemoveRoutingCacheInCluster( int clusternum )
 {
 	int i;
@@ -324,15 +361,19 @@ int AAS_EnableRoutingArea(int areanum, int enable)
 	if (enable < 0)
 		return !flags;
 
-	if (enable)
-		aasworld.areasettings[areanum].areaflags &= ~AREA_DISABLED;
-	else
-		aasworld.areasettings[areanum].areaflags |= AREA_DISABLED;
-	// if the status of the area changed
-	if ( (flags & AREA_DISABLED) != (aasworld.areasettings[areanum].areaflags & AREA_DISABLED) )
+	// if the status of the area changes
+	if ( enable ? flags : !flags )
 	{
+		//portal table rows with routes through the area's clusters
+		AAS_InvalidatePortalTableRows( areanum, qfalse );
+		if (enable)
+			aasworld.areasettings[areanum].areaflags &= ~AREA_DISABLED;
+		else
+			aasworld.areasettings[areanum].areaflags |= AREA_DISABLED;
 		//remove all routing cache involving this area
 		AAS_RemoveRoutingCacheUsingArea( areanum );
+		//portal table rows the area's clusters now make shorter
+		AAS_InvalidatePortalTableRows( areanum, qtrue );
 	} //end if
 	return !flags;
 } //end of the function AAS_EnableRoutingArea
@@ -920,7 +961,8 @@ void AAS_CreateAllRoutingCache(void)
 
 //the route cache header
 //this header is followed by numportalcache + numareacache aas_routingcache_t
-//structures that store routing cache
+//structures that store routing cache, followed by the number of portal tables
+//and the travel flags and travel times of every portal table
 typedef struct routecacheheader_s
 {
 	int ident;
@@ -948,6 +990,11 @@ void AAS_WriteRouteCache(void)
 	char filename[MAX_QPATH];
 	routecacheheader_t routecacheheader;
 
+	//bring the portal tables up to date first, this may add area cache
+	for (i = 0; i < aasworld.numportaltables; i++)
+	{
+		AAS_UpdatePortalTableRows(&aasworld.portaltables[i], 0);
+	} //end for
 	numportalcache = 0;
 	for (i = 0; i < aasworld.numareas; i++)
 	{
@@ -1010,6 +1057,15 @@ void AAS_WriteRouteCache(void)
 			} //end for
 		} //end for
 	} //end for
+	// write the portal tables
+	botimport.FS_Write(&aasworld.numportaltables, sizeof(int), fp);
+	for (i = 0; i < aasworld.numportaltables; i++)
+	{
+		botimport.FS_Write(&aasworld.portaltables[i].travelflags, sizeof(int), fp);
+		botimport.FS_Write(aasworld.portaltables[i].traveltimes,
+					aasworld.numportals * aasworld.numportals * sizeof(unsigned short int), fp);
+	} //end for
+	totalsize += portaltablesize;
 	// write the visareas
 	/*
 	for (i = 0; i < aasworld.numareas; i++)
@@ -1038,15 +1094,23 @@ void AAS_WriteRouteCache(void)
 //===========================================================================
 aas_routingcache_t *AAS_ReadCache(fileHandle_t fp)
 {
-	int size;
-	aas_routingcache_t *cache;
-
-	botimport.FS_Read(&size, sizeof(size), fp);
-	cache = (aas_routingcache_t *) GetMemory(size);
-	cache->size = size;
-	botimport.FS_Read((unsigned char *)cache + sizeof(size), size - sizeof(size), fp);
-	cache->reachabilities = (unsigned char *) cache + sizeof(aas_routingcache_t) - sizeof(unsigned short) +
-		(size - sizeof(aas_routingcache_t) + sizeof(unsigned short)) / 3 * 2;
+	int headsize, numtraveltimes;
+	aas_routingcache_t head, *cache;
+
+	//the cache is written as is, so the size isn't the first field
+	headsize = (unsigned char *) head.traveltimes - (unsigned char *) &head;
+	botimport.FS_Read(&head, headsize, fp);
+	cache = (aas_routingcache_t *) GetMemory(head.size);
+	Com_Memcpy(cache, &head, headsize);
+	botimport.FS_Read((unsigned char *) cache + headsize, head.size - headsize, fp);
+	numtraveltimes = (head.size - sizeof(aas_routingcache_t)) / 3;
+	cache->reachabilities = (unsigned char *) cache + sizeof(aas_routingcache_t)
+								+ numtraveltimes * sizeof(unsigned short int);
+	//the list pointers are from the written cache
+	cache->time_prev = NULL;
+	cache->time_next = NULL;
+	AAS_LinkCache(cache);
+	routingcachesize += cache->size;
 	return cache;
 } //end of the function AAS_ReadCache
 //===========================================================================
@@ -1057,7 +1121,7 @@ aas_routingcache_t *AAS_ReadCache(fileHandle_t fp)
 //===========================================================================
 int AAS_ReadRouteCache(void)
 {
-	int i, clusterareanum;//, size;
+	int i, clusterareanum, numportaltables, size;
 	fileHandle_t fp;
 	char filename[MAX_QPATH];
 	routecacheheader_t routecacheheader;
@@ -1123,6 +1187,22 @@ int AAS_ReadRouteCache(void)
 			aasworld.clusterareacache[cache->cluster][clusterareanum]->prev = cache;
 		aasworld.clusterareacache[cache->cluster][clusterareanum] = cache;
 	} //end for
+	// read the portal tables, older dumps end here
+	if (botimport.FS_Read(&numportaltables, sizeof(int), fp) != sizeof(int))
+	{
+		numportaltables = 0;
+	} //end if
+	size = aasworld.numportals * aasworld.numportals * sizeof(unsigned short int);
+	for (i = 0; i < numportaltables && i < aasworld.maxportaltables; i++)
+	{
+		botimport.FS_Read(&aasworld.portaltables[i].travelflags, sizeof(int), fp);
+		aasworld.portaltables[i].traveltimes = (unsigned short int *) GetMemory(size);
+		botimport.FS_Read(aasworld.portaltables[i].traveltimes, size, fp);
+		aasworld.portaltables[i].numinvalidrows = 0;
+		aasworld.portaltables[i].invalidrows = (byte *) GetClearedMemory(aasworld.numportals * sizeof(byte));
+		aasworld.numportaltables++;
+		portaltablesize += size + aasworld.numportals * sizeof(byte);
+	} //end for
 	// read the visareas
 	/*
 	aasworld.areavisibility = (byte **) GetClearedMemory(aasworld.numareas * sizeof(byte *));
@@ -1243,12 +1323,29 @@ void AAS_InitRouting(void)
 #ifdef ROUTING_DEBUG
 	numareacacheupdates = 0;
 	numportalcacheupdates = 0;
+	numportaltablecacheupdates = 0;
+	numportaltablerowupdates = 0;
 #endif //ROUTING_DEBUG
 	//
 	routingcachesize = 0;
 	max_routingcachesize = 1024 * (int) LibVarValue("max_routingcache", "4096");
+	//
+	aasworld.numportaltables = 0;
+	aasworld.maxportaltables = (int) LibVarValue("max_portaltables", "0");
+	if (aasworld.maxportaltables > 0)
+	{
+		aasworld.portaltables = (aas_portaltable_t *) GetClearedMemory(
+									aasworld.maxportaltables * sizeof(aas_portaltable_t));
+	} //end if
+	portaltablesize = 0;
+	portaltabletime = 0;
 	// read any routing cache if available
 	AAS_ReadRouteCache();
+	// calculate the portal table for the default travel flags
+	if (aasworld.maxportaltables > 0)
+	{
+		AAS_GetPortalTable(TFL_DEFAULT);
+	} //end if
 } //end of the function AAS_InitRouting
 //===========================================================================
 //
@@ -1262,6 +1359,11 @@ void AAS_FreeRoutingCaches(void)
 	AAS_FreeAllClusterAreaCache();
 	// free all the existing portal cache
 	AAS_FreeAllPortalCache();
+	// free the portal to portal travel times
+	AAS_FreePortalTables();
+	if (aasworld.portaltables) FreeMemory(aasworld.portaltables);
+	aasworld.portaltables = NULL;
+	aasworld.maxportaltables = 0;
 	// free cached travel times within areas
 	if (aasworld.areatraveltimes) FreeMemory(aasworld.areatraveltimes);
 	aasworld.areatraveltimes = NULL;
@@ -1432,7 +1534,9 @@ aas_routingcache_t *AAS_GetAreaRoutingCache(int clusternum, int areanum, int tra
 		cache->next = clustercache;
 		if (clustercache) clustercache->prev = cache;
 		aasworld.clusterareacache[clusternum][clusterareanum] = cache;
+		AAS_FrameBudgetStart();
 		AAS_UpdateAreaRoutingCache(cache);
+		AAS_FrameBudgetEnd();
 	} //end if
 	else
 	{
@@ -1543,6 +1647,351 @@ void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
 	} //end while
 } //end of the function AAS_UpdatePortalRoutingCache
 //===========================================================================
+// recalculates the invalid rows of the portal table, the travel times from
+// all portals to the goal portal of the row. Only the rows of the portals
+// of the goal cluster are recalculated if goalclusternum isn't zero.
+// moving from a portal to another portal of the same cluster takes the
+// travel time within that cluster plus the maximum travel time through
+// the portal area it arrives in, the same as AAS_UpdatePortalRoutingCache
+//
+// Parameter:			table		: portal table to update
+//						goalclusternum	: cluster with the goal portals or zero
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_UpdatePortalTableRows(aas_portaltable_t *table, int goalclusternum)
+{
+	int goalportalnum, portalnum, nextportalnum, side, clusternum, clusterareanum, numgoals;
+	int i, j, t, numupdates, first, last, starttime;
+	int *portaltraveltimes, *portalupdates;
+	qboolean *inlist;
+	unsigned short int *traveltimes;
+	aas_portal_t *portal, *nextportal;
+	aas_cluster_t *cluster, *goalcluster;
+	aas_routingcache_t *cache;
+
+	if (!table->numinvalidrows) return;
+	//
+	goalcluster = &aasworld.clusters[goalclusternum];
+	numgoals = goalclusternum ? goalcluster->numportals : aasworld.numportals;
+	for (j = 0; j < numgoals; j++)
+	{
+		goalportalnum = goalclusternum ? aasworld.portalindex[goalcluster->firstportal + j] : j;
+		if (table->invalidrows[goalportalnum]) break;
+	} //end for
+	if (j >= numgoals) return;
+	//
+	starttime = botimport.MilliSeconds();
+	//
+	portaltraveltimes = (int *) GetMemory(aasworld.numportals * sizeof(int));
+	portalupdates = (int *) GetMemory(aasworld.numportals * sizeof(int));
+	inlist = (qboolean *) GetClearedMemory(aasworld.numportals * sizeof(qboolean));
+	//
+	for (; j < numgoals; j++)
+	{
+		goalportalnum = goalclusternum ? aasworld.portalindex[goalcluster->firstportal + j] : j;
+		if (!table->invalidrows[goalportalnum]) continue;
+		//
+		for (i = 0; i < aasworld.numportals; i++) portaltraveltimes[i] = -1;
+		portaltraveltimes[goalportalnum] = 0;
+		//circular list with the portals to update
+		portalupdates[0] = goalportalnum;
+		inlist[goalportalnum] = qtrue;
+		first = 0;
+		last = 1;
+		numupdates = 1;
+		while (numupdates > 0)
+		{
+			portalnum = portalupdates[first];
+			first = (first + 1) % aasworld.numportals;
+			numupdates--;
+			inlist[portalnum] = qfalse;
+			//
+			portal = &aasworld.portals[portalnum];
+			//the portals of the clusters at both sides can move into this portal
+			for (side = 0; side < 2; side++)
+			{
+				clusternum = side ? portal->backcluster : portal->frontcluster;
+				cluster = &aasworld.clusters[clusternum];
+				//travel times towards the portal within the cluster
+				cache = AAS_GetAreaRoutingCache(clusternum, portal->areanum, table->travelflags);
+				for (i = 0; i < cluster->numportals; i++)
+				{
+					nextportalnum = aasworld.portalindex[cluster->firstportal + i];
+					if (nextportalnum == portalnum) continue;
+					nextportal = &aasworld.portals[nextportalnum];
+					//
+					clusterareanum = AAS_ClusterAreaNum(clusternum, nextportal->areanum);
+					if (clusterareanum >= cluster->numreachabilityareas) continue;
+					//
+					t = cache->traveltimes[clusterareanum];
+					if (!t) continue;
+					t += portaltraveltimes[portalnum] + aasworld.portalmaxtraveltimes[portalnum];
+					//
+					if (portaltraveltimes[nextportalnum] < 0 || portaltraveltimes[nextportalnum] > t)
+					{
+						portaltraveltimes[nextportalnum] = t;
+						if (!inlist[nextportalnum])
+						{
+							portalupdates[last] = nextportalnum;
+							last = (last + 1) % aasworld.numportals;
+							numupdates++;
+							inlist[nextportalnum] = qtrue;
+						} //end if
+					} //end if
+				} //end for
+			} //end for
+		} //end while
+		//store the travel times towards the goal portal
+		traveltimes = &table->traveltimes[goalportalnum * aasworld.numportals];
+		Com_Memset(traveltimes, 0, aasworld.numportals * sizeof(unsigned short int));
+		for (i = 1; i < aasworld.numportals; i++)
+		{
+			if (i == goalportalnum) continue;
+			if (portaltraveltimes[i] <= 0 || portaltraveltimes[i] > 0xffff) continue;
+			traveltimes[i] = portaltraveltimes[i];
+		} //end for
+		table->invalidrows[goalportalnum] = qfalse;
+		table->numinvalidrows--;
+#ifdef ROUTING_DEBUG
+		numportaltablerowupdates++;
+#endif //ROUTING_DEBUG
+	} //end for
+	FreeMemory(portaltraveltimes);
+	FreeMemory(portalupdates);
+	FreeMemory(inlist);
+	//
+	portaltabletime += botimport.MilliSeconds() - starttime;
+} //end of the function AAS_UpdatePortalTableRows
+//===========================================================================
+// calculates the travel times from all portals to all other portals
+//
+// Parameter:			table		: portal table to calculate
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_UpdatePortalTable(aas_portaltable_t *table)
+{
+	table->traveltimes = (unsigned short int *) GetClearedMemory(
+				aasworld.numportals * aasworld.numportals * sizeof(unsigned short int));
+	table->invalidrows = (byte *) GetMemory(aasworld.numportals * sizeof(byte));
+	portaltablesize += aasworld.numportals * aasworld.numportals * sizeof(unsigned short int) +
+				aasworld.numportals * sizeof(byte);
+	//portal 0 is a dummy
+	Com_Memset(table->invalidrows, qtrue, aasworld.numportals * sizeof(byte));
+	table->invalidrows[0] = qfalse;
+	table->numinvalidrows = aasworld.numportals - 1;
+	//
+	AAS_UpdatePortalTableRows(table, 0);
+} //end of the function AAS_UpdatePortalTable
+//===========================================================================
+// returns the portal table for the travel flags, the table is calculated
+// if it doesn't exist yet and there's room for another one
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+aas_portaltable_t *AAS_GetPortalTable(int travelflags)
+{
+	int i;
+	aas_portaltable_t *table;
+
+	for (i = 0; i < aasworld.numportaltables; i++)
+	{
+		if (aasworld.portaltables[i].travelflags == travelflags)
+		{
+			return &aasworld.portaltables[i];
+		} //end if
+	} //end for
+	if (aasworld.numportaltables >= aasworld.maxportaltables) return NULL;
+	//
+	table = &aasworld.portaltables[aasworld.numportaltables++];
+	table->travelflags = travelflags;
+	AAS_UpdatePortalTable(table);
+	return table;
+} //end of the function AAS_GetPortalTable
+//===========================================================================
+// marks the rows of the portal table that may change with the travel times
+// between the portals of the cluster. Before an area of the cluster is
+// enabled or disabled these are the rows with a shortest path through the
+// cluster, after the change the rows the cluster now gives a shorter path.
+// Both are needed either way, the travel time through an area depends on
+// where it's entered so disabling an area can make other routes shorter.
+//
+// Parameter:			table		: portal table
+//						clusternum	: cluster with the changed area
+//						changed		: qtrue after the area changed
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_InvalidatePortalTableCluster(aas_portaltable_t *table, int clusternum, int changed)
+{
+	int goalportalnum, portalnum, nextportalnum, clusterareanum;
+	int i, j, t, *portaltimes;
+	unsigned short int *traveltimes;
+	aas_cluster_t *cluster;
+	aas_routingcache_t *cache;
+
+	cluster = &aasworld.clusters[clusternum];
+	if (!cluster->numportals) return;
+	//travel times from portal j to portal i through the cluster,
+	//the same as AAS_UpdatePortalTableRows uses
+	portaltimes = (int *) GetClearedMemory(cluster->numportals * cluster->numportals * sizeof(int));
+	for (i = 0; i < cluster->numportals; i++)
+	{
+		portalnum = aasworld.portalindex[cluster->firstportal + i];
+		cache = AAS_GetAreaRoutingCache(clusternum, aasworld.portals[portalnum].areanum, table->travelflags);
+		for (j = 0; j < cluster->numportals; j++)
+		{
+			if (j == i) continue;
+			nextportalnum = aasworld.portalindex[cluster->firstportal + j];
+			clusterareanum = AAS_ClusterAreaNum(clusternum, aasworld.portals[nextportalnum].areanum);
+			if (clusterareanum >= cluster->numreachabilityareas) continue;
+			if (!cache->traveltimes[clusterareanum]) continue;
+			portaltimes[i * cluster->numportals + j] = cache->traveltimes[clusterareanum] +
+														aasworld.portalmaxtraveltimes[portalnum];
+		} //end for
+	} //end for
+	//
+	for (goalportalnum = 1; goalportalnum < aasworld.numportals; goalportalnum++)
+	{
+		if (table->invalidrows[goalportalnum]) continue;
+		traveltimes = &table->traveltimes[goalportalnum * aasworld.numportals];
+		for (i = 0; i < cluster->numportals; i++)
+		{
+			portalnum = aasworld.portalindex[cluster->firstportal + i];
+			if (portalnum != goalportalnum && !traveltimes[portalnum]) continue;
+			for (j = 0; j < cluster->numportals; j++)
+			{
+				if (!portaltimes[i * cluster->numportals + j]) continue;
+				nextportalnum = aasworld.portalindex[cluster->firstportal + j];
+				if (nextportalnum == goalportalnum) continue;
+				t = traveltimes[portalnum] + portaltimes[i * cluster->numportals + j];
+				if (changed)
+				{
+					//the travel time through the cluster is shorter
+					if (t > 0xffff) continue;
+					if (traveltimes[nextportalnum] && traveltimes[nextportalnum] <= t) continue;
+				} //end if
+				else
+				{
+					//the travel time goes through the cluster
+					if (traveltimes[nextportalnum] != t) continue;
+				} //end else
+				break;
+			} //end for
+			if (j < cluster->numportals) break;
+		} //end for
+		if (i < cluster->numportals)
+		{
+			table->invalidrows[goalportalnum] = qtrue;
+			table->numinvalidrows++;
+		} //end if
+	} //end for
+	FreeMemory(portaltimes);
+} //end of the function AAS_InvalidatePortalTableCluster
+//===========================================================================
+// marks the rows of the portal tables that may change when the area is
+// enabled or disabled, called before and after the change. The rows are
+// recalculated when they're used, so only the rows with routes through
+// the area's clusters are searched again instead of the whole table.
+//
+// Parameter:			areanum		: area that's enabled or disabled
+//						changed		: qtrue after the area changed
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_InvalidatePortalTableRows(int areanum, int changed)
+{
+	int i, clusternum;
+	aas_portal_t *portal;
+
+	clusternum = aasworld.areasettings[areanum].cluster;
+	for (i = 0; i < aasworld.numportaltables; i++)
+	{
+		if (clusternum > 0)
+		{
+			AAS_InvalidatePortalTableCluster(&aasworld.portaltables[i], clusternum, changed);
+		} //end if
+		else
+		{
+			//a portal changes the travel times in both clusters
+			portal = &aasworld.portals[-clusternum];
+			AAS_InvalidatePortalTableCluster(&aasworld.portaltables[i], portal->frontcluster, changed);
+			AAS_InvalidatePortalTableCluster(&aasworld.portaltables[i], portal->backcluster, changed);
+		} //end else
+	} //end for
+} //end of the function AAS_InvalidatePortalTableRows
+//===========================================================================
+// fills in the portal routing cache with the portal table for the travel
+// flags of the cache, returns qfalse if there is no such portal table
+//
+// Parameter:			portalcache		: routing cache to update
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+int AAS_UpdatePortalRoutingCacheFromTable(aas_routingcache_t *portalcache)
+{
+	int i, j, goalportalnum, clusterareanum, t, starttraveltime;
+	unsigned short int *traveltimes;
+	aas_portaltable_t *table;
+	aas_portal_t *portal;
+	aas_cluster_t *cluster;
+	aas_routingcache_t *cache;
+
+	table = AAS_GetPortalTable(portalcache->travelflags);
+	if (!table) return qfalse;
+	//the rows of the goal cluster portals have to be up to date
+	AAS_UpdatePortalTableRows(table, portalcache->cluster);
+#ifdef ROUTING_DEBUG
+	numportaltablecacheupdates++;
+#endif //ROUTING_DEBUG
+	//
+	starttraveltime = (unsigned short int) portalcache->starttraveltime;
+	cluster = &aasworld.clusters[portalcache->cluster];
+	//travel times towards the goal area within the goal cluster
+	cache = AAS_GetAreaRoutingCache(portalcache->cluster, portalcache->areanum, portalcache->travelflags);
+	//every portal of the goal cluster is a start for the other portals
+	for (i = 0; i < cluster->numportals; i++)
+	{
+		goalportalnum = aasworld.portalindex[cluster->firstportal + i];
+		portal = &aasworld.portals[goalportalnum];
+		//if the goal area is this portal
+		if (portal->areanum == portalcache->areanum)
+		{
+			t = starttraveltime;
+		} //end if
+		else
+		{
+			clusterareanum = AAS_ClusterAreaNum(portalcache->cluster, portal->areanum);
+			if (clusterareanum >= cluster->numreachabilityareas) continue;
+			if (!cache->traveltimes[clusterareanum]) continue;
+			t = cache->traveltimes[clusterareanum] + starttraveltime;
+		} //end else
+		if (t > 0xffff) continue;
+		//
+		if (!portalcache->traveltimes[goalportalnum] ||
+				portalcache->traveltimes[goalportalnum] > t)
+		{
+			portalcache->traveltimes[goalportalnum] = t;
+		} //end if
+		//travel times of all the portals towards this portal
+		traveltimes = &table->traveltimes[goalportalnum * aasworld.numportals];
+		for (j = 1; j < aasworld.numportals; j++)
+		{
+			if (!traveltimes[j]) continue;
+			if (t + traveltimes[j] > 0xffff) continue;
+			if (!portalcache->traveltimes[j] ||
+					portalcache->traveltimes[j] > t + traveltimes[j])
+			{
+				portalcache->traveltimes[j] = t + traveltimes[j];
+			} //end if
+		} //end for
+	} //end for
+	return qtrue;
+} //end of the function AAS_UpdatePortalRoutingCacheFromTable
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -1571,8 +2020,13 @@ aas_routingcache_t *AAS_GetPortalRoutingCache(int clusternum, int areanum, int t
 		cache->next = aasworld.portalcache[areanum];
 		if (aasworld.portalcache[areanum]) aasworld.portalcache[areanum]->prev = cache;
 		aasworld.portalcache[areanum] = cache;
-		//update the cache
-		AAS_UpdatePortalRoutingCache(cache);
+		//update the cache, with the portal table when available
+		AAS_FrameBudgetStart();
+		if (!AAS_UpdatePortalRoutingCacheFromTable(cache))
+		{
+			AAS_UpdatePortalRoutingCache(cache);
+		} //end if
+		AAS_FrameBudgetEnd();
 	} //end if
 	else
 	{
@@ -2022,6 +2476,12 @@ int AAS_RandomGoalArea(int areanum, int travelflags, int contentmask, int *goala
 	n = aasworld.numareas * random();
 	for (i = 0; i < aasworld.numareas; i++)
 	{
+		//every tested area may fill a routing cache, continue another frame
+		if (AAS_FrameBudgetExpired())
+		{
+			AAS_FrameBudgetDefer();
+			return qfalse;
+		} //end if
 		if (n <= 0) n = 1;
 		if (n >= aasworld.numareas) n = 1;
 		if (AAS_AreaReachability(n))
@@ -2136,6 +2596,16 @@ int AAS_NearestHideArea(int srcnum, vec3_t origin, int areanum, int enemynum, ve
 		updateliststart = curupdate->next;
 		//
 		curupdate->inlist = qfalse;
+		//settle for the best hide area found so far when the frame budget is used up
+		if (bestarea && AAS_FrameBudgetExpired())
+		{
+			AAS_FrameBudgetDefer();
+			for (curupdate = updateliststart; curupdate; curupdate = curupdate->next)
+			{
+				curupdate->inlist = qfalse;
+			} //end for
+			break;
+		} //end if
 		//check all reversed reachability links
 		numreach = aasworld.areasettings[curupdate->areanum].numreachableareas;
 		reach = &aasworld.reachability[aasworld.areasettings[curupdate->areanum].firstreachablearea];
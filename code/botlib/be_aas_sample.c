@@ -410,12 +410,27 @@ vec_t AAS_BoxOriginDistanceFromPlane(vec3_t normal, vec3_t mins, vec3_t maxs, in
 qboolean AAS_AreaEntityCollision(int areanum, vec3_t start, vec3_t end,
 										int presencetype, int passent, int contentmask, aas_trace_t *trace)
 {
-	int collision;
-	vec3_t boxmins, boxmaxs;
+	int i, collision;
+	vec3_t boxmins, boxmaxs, sweptmins, sweptmaxs;
 	aas_link_t *link;
+	aas_entitybounds_t *bounds;
 	bsp_trace_t bsptrace;
 
 	AAS_PresenceTypeBoundingBox(presencetype, boxmins, boxmaxs);
+	//bounds of the box moved from start to end
+	for (i = 0; i < 3; i++)
+	{
+		if (start[i] < end[i])
+		{
+			sweptmins[i] = start[i] + boxmins[i] - 1;
+			sweptmaxs[i] = end[i] + boxmaxs[i] + 1;
+		} //end if
+		else
+		{
+			sweptmins[i] = end[i] + boxmins[i] - 1;
+			sweptmaxs[i] = start[i] + boxmaxs[i] + 1;
+		} //end else
+	} //end for
 
 	Com_Memset(&bsptrace, 0, sizeof(bsp_trace_t)); //make compiler happy
 	//assume no collision
@@ -425,6 +440,17 @@ qboolean AAS_AreaEntityCollision(int areanum, vec3_t start, vec3_t end,
 	{
 		//ignore the pass entity
 		if (link->entnum == passent) continue;
+		//skip the entity trace when the moved box doesn't touch the entity
+		if (link->entnum >= 0 && aasworld.entitybounds)
+		{
+			bounds = &aasworld.entitybounds[link->entnum];
+			if (bounds->absmins[0] > sweptmaxs[0] || bounds->absmaxs[0] < sweptmins[0] ||
+				bounds->absmins[1] > sweptmaxs[1] || bounds->absmaxs[1] < sweptmins[1] ||
+				bounds->absmins[2] > sweptmaxs[2] || bounds->absmaxs[2] < sweptmins[2])
+			{
+				continue;
+			} //end if
+		} //end if
 		//
 		if (AAS_EntityCollision(link->entnum, start, boxmins, boxmaxs, end,
 												contentmask, &bsptrace))
@@ -1327,6 +1353,117 @@ aas_link_t *AAS_AASLinkEntity(vec3_t absmins, vec3_t absmaxs, int entnum)
 	return areas;
 } //end of the function AAS_AASLinkEntity
 //===========================================================================
+// find the areas the bounding box is totally or partly situated in
+// without allocating any links
+//
+// Parameter:				-
+// Returns:					number of areas or -1 if there are more than maxareas
+// Changes Globals:		-
+//===========================================================================
+int AAS_BBoxAreaNums(vec3_t absmins, vec3_t absmaxs, int *areas, int maxareas)
+{
+	int side, nodenum, numareas, i;
+	int nodestack[128];
+	int *nstack_p;
+	aas_node_t *aasnode;
+	aas_plane_t *plane;
+
+	if (!aasworld.loaded) return -1;
+
+	numareas = 0;
+	nstack_p = nodestack;
+	//start with node 1 because node zero is a dummy used for solid leafs
+	*nstack_p++ = 1;
+	while (nstack_p > nodestack)
+	{
+		nodenum = *--nstack_p;
+		//if it is an area
+		if (nodenum < 0)
+		{
+			//several node children can point to the same area
+			for (i = 0; i < numareas; i++)
+			{
+				if (areas[i] == -nodenum) break;
+			} //end for
+			if (i < numareas) continue;
+			if (numareas >= maxareas) return -1;
+			areas[numareas++] = -nodenum;
+			continue;
+		} //end if
+		//if solid leaf
+		if (!nodenum) continue;
+		aasnode = &aasworld.nodes[nodenum];
+		plane = &aasworld.planes[aasnode->planenum];
+		side = AAS_BoxOnPlaneSide2(absmins, absmaxs, plane);
+		if (nstack_p >= &nodestack[127])
+		{
+			botimport.Print(PRT_ERROR, "AAS_BBoxAreaNums: stack overflow\n");
+			return -1;
+		} //end if
+		if (side & 1) *nstack_p++ = aasnode->children[0];
+		if (side & 2) *nstack_p++ = aasnode->children[1];
+	} //end while
+	return numareas;
+} //end of the function AAS_BBoxAreaNums
+//===========================================================================
+// link the entity into the given areas
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+aas_link_t *AAS_LinkEntityToAreas(int entnum, int *areas, int numareas)
+{
+	int i;
+	aas_link_t *link, *links;
+
+	links = NULL;
+	for (i = 0; i < numareas; i++)
+	{
+		link = AAS_AllocAASLink();
+		if (!link) break;
+		link->entnum = entnum;
+		link->areanum = areas[i];
+		//put the link into the double linked area list of the entity
+		link->prev_area = NULL;
+		link->next_area = links;
+		if (links) links->prev_area = link;
+		links = link;
+		//put the link into the double linked entity list of the area
+		link->prev_ent = NULL;
+		link->next_ent = aasworld.arealinkedentities[areas[i]];
+		if (aasworld.arealinkedentities[areas[i]])
+			aasworld.arealinkedentities[areas[i]]->prev_ent = link;
+		aasworld.arealinkedentities[areas[i]] = link;
+	} //end for
+	return links;
+} //end of the function AAS_LinkEntityToAreas
+//===========================================================================
+// returns true if the links are into exactly the given areas
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+qboolean AAS_LinkedToAreas(aas_link_t *links, int *areas, int numareas)
+{
+	int i, numlinks;
+	aas_link_t *link;
+
+	numlinks = 0;
+	for (link = links; link; link = link->next_area)
+	{
+		for (i = 0; i < numareas; i++)
+		{
+			if (areas[i] == link->areanum) break;
+		} //end for
+		if (i >= numareas) return qfalse;
+		numlinks++;
+	} //end for
+	//the areas are unique so the same number means the same set
+	return numlinks == numareas;
+} //end of the function AAS_LinkedToAreas
+//===========================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -50,6 +50,9 @@ aas_link_t *AAS_LinkEntityClientBBox(vec3_t absmins, vec3_t absmaxs, int entnum,
 qboolean AAS_PointInsideFace(int facenum, vec3_t point, float epsilon);
 qboolean AAS_InsideFace(aas_face_t *face, vec3_t pnormal, vec3_t point, float epsilon);
 void AAS_UnlinkFromAreas(aas_link_t *areas);
+int AAS_BBoxAreaNums(vec3_t absmins, vec3_t absmaxs, int *areas, int maxareas);
+aas_link_t *AAS_LinkEntityToAreas(int entnum, int *areas, int numareas);
+qboolean AAS_LinkedToAreas(aas_link_t *links, int *areas, int numareas);
 #endif //AASINTERN
 
 //returns the mins and maxs of the bounding box for the given presence type
@@ -262,6 +262,24 @@ int Export_BotLibUpdateEntity(int ent, bot_entitystate_t *state)
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
+int Export_BotLibUpdateEntities(int numentities, int *entnums, bot_entitystate_t *states)
+{
+	int i;
+
+	if (!BotLibSetup("BotUpdateEntities")) return BLERR_LIBRARYNOTSETUP;
+	for (i = 0; i < numentities; i++)
+	{
+		if (!ValidEntityNumber(entnums[i], "BotUpdateEntities")) return BLERR_INVALIDENTITYNUMBER;
+	} //end for
+
+	return AAS_UpdateEntities(numentities, entnums, states);
+} //end of the function Export_BotLibUpdateEntities
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
 void Export_AAS_TracePlayerBBox(struct aas_trace_s *trace, vec3_t start, vec3_t end, int presencetype, int passent, int contentmask)
 {
 	aas_trace_t tr;
@@ -269,6 +287,91 @@ void Export_AAS_TracePlayerBBox(struct aas_trace_s *trace, vec3_t start, vec3_t
 	tr = AAS_TracePlayerBBox(start, end, presencetype, passent, contentmask);
 	Com_Memcpy(trace, &tr, sizeof (aas_trace_t));
 } //end of the function Export_AAS_TracePlayerBBox
+//===========================================================================
+// finding a random goal isn't urgent, defer it when the frame budget is used up
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+int Export_AAS_RandomGoalArea(int areanum, int travelflags, int contentmask, int *goalareanum, vec3_t goalorigin)
+{
+	int found;
+
+	if (AAS_FrameBudgetExpired())
+	{
+		AAS_FrameBudgetDefer();
+		return qfalse;
+	} //end if
+	AAS_FrameBudgetStart();
+	found = AAS_RandomGoalArea(areanum, travelflags, contentmask, goalareanum, goalorigin);
+	AAS_FrameBudgetEnd();
+	return found;
+} //end of the function Export_AAS_RandomGoalArea
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+int Export_AAS_PredictRoute(struct aas_predictroute_s *route, int areanum, vec3_t origin,
+							int goalareanum, int travelflags, int maxareas, int maxtime,
+							int stopevent, int stopcontents, int stoptfl, int stopareanum)
+{
+	int reached;
+
+	AAS_FrameBudgetStart();
+	reached = AAS_PredictRoute(route, areanum, origin, goalareanum, travelflags, maxareas, maxtime,
+								stopevent, stopcontents, stoptfl, stopareanum);
+	AAS_FrameBudgetEnd();
+	return reached;
+} //end of the function Export_AAS_PredictRoute
+//===========================================================================
+// alternative route goals aren't urgent, defer them when the frame budget is used up
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+int Export_AAS_AlternativeRouteGoals(vec3_t start, int startareanum, vec3_t goal, int goalareanum, int travelflags,
+										aas_altroutegoal_t *altroutegoals, int maxaltroutegoals,
+										int type)
+{
+	int numaltroutegoals;
+
+	if (AAS_FrameBudgetExpired())
+	{
+		AAS_FrameBudgetDefer();
+		return 0;
+	} //end if
+	AAS_FrameBudgetStart();
+	numaltroutegoals = AAS_AlternativeRouteGoals(start, startareanum, goal, goalareanum, travelflags,
+													altroutegoals, maxaltroutegoals, type);
+	AAS_FrameBudgetEnd();
+	return numaltroutegoals;
+} //end of the function Export_AAS_AlternativeRouteGoals
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+int Export_AAS_PredictPlayerMovement(struct aas_clientmove_s *move,
+								int entnum, vec3_t origin,
+								int presencetype, int onground,
+								vec3_t velocity, vec3_t cmdmove,
+								int cmdframes,
+								int maxframes, float frametime,
+								int stopevent, int stopareanum, int visualize, int contentmask)
+{
+	int stopped;
+
+	AAS_FrameBudgetStart();
+	stopped = AAS_PredictPlayerMovement(move, entnum, origin, presencetype, onground, velocity, cmdmove,
+								cmdframes, maxframes, frametime, stopevent, stopareanum, visualize, contentmask);
+	AAS_FrameBudgetEnd();
+	return stopped;
+} //end of the function Export_AAS_PredictPlayerMovement
 
 
 /*
@@ -345,19 +448,19 @@ static void Init_AAS_Export( aas_export_t *aas ) {
 	aas->AAS_AreaContentsTravelFlags = AAS_AreaContentsTravelFlags;
 	aas->AAS_NextAreaReachability = AAS_NextAreaReachability;
 	aas->AAS_ReachabilityFromNum = AAS_ReachabilityFromNum;
-	aas->AAS_RandomGoalArea = AAS_RandomGoalArea;
+	aas->AAS_RandomGoalArea = Export_AAS_RandomGoalArea;
 	aas->AAS_EnableRoutingArea = AAS_EnableRoutingArea;
 	aas->AAS_AreaTravelTime = AAS_AreaTravelTime;
 	aas->AAS_AreaTravelTimeToGoalArea = AAS_AreaTravelTimeToGoalArea;
-	aas->AAS_PredictRoute = AAS_PredictRoute;
+	aas->AAS_PredictRoute = Export_AAS_PredictRoute;
 	//--------------------------------------------
 	// be_aas_altroute.c
 	//--------------------------------------------
-	aas->AAS_AlternativeRouteGoals = AAS_AlternativeRouteGoals;
+	aas->AAS_AlternativeRouteGoals = Export_AAS_AlternativeRouteGoals;
 	//--------------------------------------------
 	// be_aas_move.c
 	//--------------------------------------------
-	aas->AAS_PredictPlayerMovement = AAS_PredictPlayerMovement;
+	aas->AAS_PredictPlayerMovement = Export_AAS_PredictPlayerMovement;
 	aas->AAS_OnGround = AAS_OnGround;
 	aas->AAS_Swimming = AAS_Swimming;
 	aas->AAS_JumpReachRunStart = AAS_JumpReachRunStart;
@@ -394,6 +497,7 @@ botlib_export_t *GetBotLibAPI(int apiVersion, botlib_import_t *import) {
 	be_botlib_export.BotLibStartFrame = Export_BotLibStartFrame;
 	be_botlib_export.BotLibLoadMap = Export_BotLibLoadMap;
 	be_botlib_export.BotLibUpdateEntity = Export_BotLibUpdateEntity;
+	be_botlib_export.BotLibUpdateEntities = Export_BotLibUpdateEntities;
 
 	return &be_botlib_export;
 }
@@ -37,7 +37,7 @@ Suite 120, Rockville, Maryland 20850 USA.
  *
  *****************************************************************************/
 
-#define	BOTLIB_API_VERSION		3
+#define	BOTLIB_API_VERSION		5
 
 struct aas_clientmove_s;
 struct aas_areainfo_s;
@@ -99,6 +99,8 @@ typedef struct botlib_import_s
 {
 	//get time for measuring time lapse
 	int			(*MilliSeconds)(void);
+	//get time in microseconds for the frame budget, may be NULL
+	int			(*MicroSeconds)(void);
 	//print messages from the bot library
 	void		(QDECL *Print)(int type, char *fmt, ...) __attribute__ ((format (printf, 2, 3)));
 	//trace a bbox through the world
@@ -256,6 +258,8 @@ typedef struct botlib_export_s
 	int (*BotLibLoadMap)(const char *mapname);
 	//entity updates
 	int (*BotLibUpdateEntity)(int ent, bot_entitystate_t *state);
+	//update all entities of a frame at once, states[i] is the state of entity entnums[i]
+	int (*BotLibUpdateEntities)(int numentities, int *entnums, bot_entitystate_t *states);
 } botlib_export_t;
 
 //linking of bot library
@@ -313,6 +317,9 @@ name:						default:			module(s):			description:
 
 "max_aaslinks"				"4096"				be_aas_sample.c		maximum links in the AAS
 "max_routingcache"			"4096"				be_aas_route.c		maximum routing cache size in KB
+"max_portaltables"			"0"					be_aas_route.c		travel flag sets with a portal to portal travel time table
+"max_frameusec"				"0"					be_aas_main.c		microseconds per frame for routing and movement prediction
+"showframebudget"			"0"					be_aas_main.c		show frame budget statistics (bot developer only)
 "forceclustering"			"0"					be_aas_main.c		force recalculation of clusters
 "forcereachability"			"0"					be_aas_main.c		force recalculation of reachabilities
 "forcewrite"				"0"					be_aas_main.c		force writing of aas file
@@ -78,6 +78,11 @@ typedef enum {qfalse, qtrue}	qboolean;
 
 //#define DEBUG_EVAL
 
+#ifdef BOTLIB
+//cache the preprocessed tokens read through source handles
+#define TOKENCACHE
+#endif //BOTLIB
+
 #define MAX_DEFINEPARMS			128
 
 #define DEFINEHASHING			1
@@ -103,6 +108,14 @@ token_t *freetokens;					//free tokens from the heap
 //list with global defines added to every source loaded
 define_t *globaldefines_implicit;
 
+#ifdef TOKENCACHE
+void PC_SourceIncluded(source_t *source, script_t *script);
+void PC_SourceNotCacheable(source_t *source);
+#else
+#define PC_SourceIncluded(source, script)
+#define PC_SourceNotCacheable(source)
+#endif //TOKENCACHE
+
 //============================================================================
 //
 // Parameter:				-
@@ -117,6 +130,8 @@ void QDECL SourceError(source_t *source, char *str, ...)
 	va_start(ap, str);
 	Q_vsnprintf(text, sizeof(text), str, ap);
 	va_end(ap);
+	//the message wouldn't be printed again when reading from the cache
+	PC_SourceNotCacheable(source);
 #ifdef BOTLIB
 	Com_Printf(S_COLOR_RED "Error: file %s, line %d: %s\n", source->scriptstack->filename, source->scriptstack->line, text);
 #endif	//BOTLIB
@@ -138,6 +153,7 @@ void QDECL SourceWarning(source_t *source, char *str, ...)
 	va_start(ap, str);
 	Q_vsnprintf(text, sizeof(text), str, ap);
 	va_end(ap);
+	PC_SourceNotCacheable(source);
 #ifdef BOTLIB
 	Com_Printf(S_COLOR_YELLOW "Warning: file %s, line %d: %s\n", source->scriptstack->filename, source->scriptstack->line, text);
 #endif //BOTLIB
@@ -1018,6 +1034,7 @@ int PC_Directive_include(source_t *source)
 #endif //SCREWUP
 	} //end if
 	PC_PushScript(source, script);
+	PC_SourceIncluded(source, script);
 	return qtrue;
 } //end of the function PC_Directive_include
 //============================================================================
@@ -3043,17 +3060,535 @@ void FreeSource(source_t *source)
 	//free the source itself
 	FreeMemory(source);
 } //end of the function FreeSource
+#define MAX_SOURCEFILES		64
+
+#ifdef TOKENCACHE
+//============================================================================
+// token cache
+//
+// The tokens read through a source handle are recorded after all the
+// directives and macros are processed. When the same file is loaded again
+// with the same global defines the tokens are read from the cache, without
+// lexing or preprocessing. A cached source is only used while the checksums
+// of the file and all the files it included still match.
+//============================================================================
+
+#define MAX_TOKENCACHESIZE		(4 * 1024 * 1024)
+
+typedef struct pc_cachedfile_s
+{
+	char filename[MAX_QPATH];				//file name including the base folder
+	int length;
+	int checksum;
+} pc_cachedfile_t;
+
+typedef struct pc_cachedtoken_s
+{
+	int type;
+	int subtype;
+	int intvalue;
+	float floatvalue;
+	int line;								//script line after reading the token
+	int string;								//offset of the token string
+} pc_cachedtoken_t;
+
+typedef struct pc_cachedsource_s
+{
+	char filename[MAX_QPATH];				//file name the source was loaded with
+	char basepath[MAX_QPATH];				//base folder the source was loaded from
+	int definechecksum;						//checksum of the global defines
+	qboolean complete;						//true if the tokens run up to the end of the source
+	int numfiles;
+	pc_cachedfile_t *files;					//the source file followed by the included files
+	int numtokens;
+	pc_cachedtoken_t *tokens;
+	char *strings;							//token strings
+	int size;								//size of the cached source in bytes
+	struct pc_cachedsource_s *prev, *next;	//list with most recently used first
+} pc_cachedsource_t;
+
+pc_cachedsource_t *tokencache;
+int tokencachesize;
+#endif //TOKENCACHE
+
+typedef struct pc_handle_s
+{
+	source_t *source;
+#ifdef TOKENCACHE
+	char basepath[MAX_QPATH];
+	int definechecksum;
+	pc_cachedsource_t *cache;				//source read from, NULL when reading the source itself
+	int tokennum;							//number of tokens read from the cache
+	qboolean lastread;						//true if the last token was read successfully
+	qboolean record;						//false if the read tokens can't be cached
+	qboolean complete;						//true if all tokens up to the end of the source were read
+	//recorded files and tokens
+	int numfiles, maxfiles;
+	pc_cachedfile_t *files;
+	int numtokens, maxtokens;
+	pc_cachedtoken_t *tokens;
+	int stringsize, maxstringsize;
+	char *strings;
+#endif //TOKENCACHE
+} pc_handle_t;
+
+pc_handle_t sourcehandles[MAX_SOURCEFILES];
+
+#ifdef TOKENCACHE
+void PC_StopReadingCache(pc_handle_t *handle);
+
 //============================================================================
 //
 // Parameter:			-
 // Returns:				-
 // Changes Globals:		-
 //============================================================================
+void *PC_GrowArray(void *ptr, int num, int *max, int size)
+{
+	void *newptr;
 
-#define MAX_SOURCEFILES		64
+	if (num < *max) return ptr;
+	*max = *max ? *max * 2 : 64;
+	newptr = GetMemory(*max * size);
+	if (ptr)
+	{
+		Com_Memcpy(newptr, ptr, num * size);
+		FreeMemory(ptr);
+	} //end if
+	return newptr;
+} //end of the function PC_GrowArray
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+int PC_StringChecksum(int checksum, const char *string)
+{
+	while(*string)
+	{
+		checksum = checksum * 31 + *string++;
+	} //end while
+	return checksum * 31;
+} //end of the function PC_StringChecksum
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+int PC_DefinesChecksum(const define_t *defines)
+{
+	int checksum;
+	const define_t *define;
+	token_t *token;
 
-source_t *sourceFiles[MAX_SOURCEFILES];
+	checksum = 0;
+	for (define = defines; define; define = define->next)
+	{
+		checksum = PC_StringChecksum(checksum, define->name);
+		checksum = checksum * 31 + define->numparms;
+		for (token = define->parms; token; token = token->next)
+		{
+			checksum = PC_StringChecksum(checksum, token->string);
+		} //end for
+		for (token = define->tokens; token; token = token->next)
+		{
+			checksum = PC_StringChecksum(checksum, token->string);
+		} //end for
+	} //end for
+	return checksum;
+} //end of the function PC_DefinesChecksum
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+pc_handle_t *PC_HandleForSource(source_t *source)
+{
+	int i;
+
+	for (i = 1; i < MAX_SOURCEFILES; i++)
+	{
+		if (sourcehandles[i].source == source) return &sourcehandles[i];
+	} //end for
+	return NULL;
+} //end of the function PC_HandleForSource
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+void PC_RecordFile(pc_handle_t *handle, const char *filename, int length, int checksum)
+{
+	pc_cachedfile_t *file;
 
+	handle->files = PC_GrowArray(handle->files, handle->numfiles, &handle->maxfiles, sizeof(pc_cachedfile_t));
+	file = &handle->files[handle->numfiles++];
+	Q_strncpyz(file->filename, filename, sizeof(file->filename));
+	file->length = length;
+	file->checksum = checksum;
+} //end of the function PC_RecordFile
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+void PC_SourceIncluded(source_t *source, script_t *script)
+{
+	pc_handle_t *handle;
+	char pathname[MAX_QPATH];
+
+	handle = PC_HandleForSource(source);
+	if (!handle) return;
+	PS_ScriptPath(script->filename, pathname, sizeof(pathname));
+	PC_RecordFile(handle, pathname, script->length, Com_BlockChecksum(script->buffer, script->length));
+} //end of the function PC_SourceIncluded
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+void PC_SourceNotCacheable(source_t *source)
+{
+	pc_handle_t *handle;
+
+	handle = PC_HandleForSource(source);
+	if (handle) handle->record = qfalse;
+} //end of the function PC_SourceNotCacheable
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+void PC_RecordToken(pc_handle_t *handle, pc_token_t *pc_token, int line)
+{
+	pc_cachedtoken_t *token;
+	int length;
+
+	length = strlen(pc_token->string) + 1;
+	handle->tokens = PC_GrowArray(handle->tokens, handle->numtokens, &handle->maxtokens, sizeof(pc_cachedtoken_t));
+	while (handle->stringsize + length > handle->maxstringsize)
+	{
+		handle->strings = PC_GrowArray(handle->strings, handle->maxstringsize, &handle->maxstringsize, 1);
+	} //end while
+	token = &handle->tokens[handle->numtokens++];
+	token->type = pc_token->type;
+	token->subtype = pc_token->subtype;
+	token->intvalue = pc_token->intvalue;
+	token->floatvalue = pc_token->floatvalue;
+	token->line = line;
+	token->string = handle->stringsize;
+	Com_Memcpy(handle->strings + handle->stringsize, pc_token->string, length);
+	handle->stringsize += length;
+} //end of the function PC_RecordToken
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+void PC_FreeHandleRecord(pc_handle_t *handle)
+{
+	if (handle->files) FreeMemory(handle->files);
+	if (handle->tokens) FreeMemory(handle->tokens);
+	if (handle->strings) FreeMemory(handle->strings);
+	handle->files = NULL;
+	handle->tokens = NULL;
+	handle->strings = NULL;
+	handle->numfiles = handle->maxfiles = 0;
+	handle->numtokens = handle->maxtokens = 0;
+	handle->stringsize = handle->maxstringsize = 0;
+} //end of the function PC_FreeHandleRecord
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+void PC_UnlinkCachedSource(pc_cachedsource_t *cached)
+{
+	if (cached->prev) cached->prev->next = cached->next;
+	else tokencache = cached->next;
+	if (cached->next) cached->next->prev = cached->prev;
+	cached->prev = NULL;
+	cached->next = NULL;
+} //end of the function PC_UnlinkCachedSource
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+void PC_LinkCachedSource(pc_cachedsource_t *cached)
+{
+	cached->prev = NULL;
+	cached->next = tokencache;
+	if (tokencache) tokencache->prev = cached;
+	tokencache = cached;
+} //end of the function PC_LinkCachedSource
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+void PC_FreeCachedSource(pc_cachedsource_t *cached)
+{
+	int i;
+
+	//handles still reading the cached source continue with the source itself
+	for (i = 1; i < MAX_SOURCEFILES; i++)
+	{
+		if (sourcehandles[i].cache == cached)
+		{
+			PC_StopReadingCache(&sourcehandles[i]);
+		} //end if
+	} //end for
+	PC_UnlinkCachedSource(cached);
+	tokencachesize -= cached->size;
+	FreeMemory(cached);
+} //end of the function PC_FreeCachedSource
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+pc_cachedsource_t *PC_FindCachedSource(const char *filename, const char *basepath, int definechecksum)
+{
+	pc_cachedsource_t *cached;
+
+	for (cached = tokencache; cached; cached = cached->next)
+	{
+		if (cached->definechecksum != definechecksum) continue;
+		if (Q_stricmp(cached->filename, filename)) continue;
+		if (Q_stricmp(cached->basepath, basepath)) continue;
+		return cached;
+	} //end for
+	return NULL;
+} //end of the function PC_FindCachedSource
+//============================================================================
+// returns true if none of the files of the cached source changed
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+qboolean PC_CachedSourceValid(pc_cachedsource_t *cached, int length, int checksum)
+{
+	int i, filelength;
+	void *buffer;
+	qboolean valid;
+
+	if (cached->files[0].length != length || cached->files[0].checksum != checksum) return qfalse;
+	for (i = 1; i < cached->numfiles; i++)
+	{
+		filelength = FS_ReadFile(cached->files[i].filename, &buffer);
+		if (!buffer) return qfalse;
+		valid = (filelength == cached->files[i].length &&
+					Com_BlockChecksum(buffer, filelength) == cached->files[i].checksum);
+		FS_FreeFile(buffer);
+		if (!valid) return qfalse;
+	} //end for
+	return qtrue;
+} //end of the function PC_CachedSourceValid
+//============================================================================
+// store the tokens read through the handle in the cache
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+void PC_CacheHandleTokens(pc_handle_t *handle)
+{
+	pc_cachedsource_t *cached;
+	int size;
+
+	if (handle->cache || !handle->record || !handle->numtokens) return;
+	//
+	cached = PC_FindCachedSource(handle->source->filename, handle->basepath, handle->definechecksum);
+	if (cached)
+	{
+		//keep the cached source if it has at least as many tokens
+		if (cached->complete || cached->numtokens >= handle->numtokens) return;
+		PC_FreeCachedSource(cached);
+	} //end if
+	size = sizeof(pc_cachedsource_t) + handle->numfiles * sizeof(pc_cachedfile_t) +
+				handle->numtokens * sizeof(pc_cachedtoken_t) + handle->stringsize;
+	if (size > MAX_TOKENCACHESIZE / 4) return;
+	//free the least recently used sources
+	while(tokencache && tokencachesize + size > MAX_TOKENCACHESIZE)
+	{
+		for (cached = tokencache; cached->next; cached = cached->next) ;
+		PC_FreeCachedSource(cached);
+	} //end while
+	//
+	cached = (pc_cachedsource_t *) GetMemory(size);
+	Com_Memset(cached, 0, sizeof(pc_cachedsource_t));
+	Q_strncpyz(cached->filename, handle->source->filename, sizeof(cached->filename));
+	Q_strncpyz(cached->basepath, handle->basepath, sizeof(cached->basepath));
+	cached->definechecksum = handle->definechecksum;
+	cached->complete = handle->complete;
+	cached->numfiles = handle->numfiles;
+	cached->files = (pc_cachedfile_t *) (cached + 1);
+	Com_Memcpy(cached->files, handle->files, handle->numfiles * sizeof(pc_cachedfile_t));
+	cached->numtokens = handle->numtokens;
+	cached->tokens = (pc_cachedtoken_t *) (cached->files + cached->numfiles);
+	Com_Memcpy(cached->tokens, handle->tokens, handle->numtokens * sizeof(pc_cachedtoken_t));
+	cached->strings = (char *) (cached->tokens + cached->numtokens);
+	Com_Memcpy(cached->strings, handle->strings, handle->stringsize);
+	cached->size = size;
+	tokencachesize += size;
+	PC_LinkCachedSource(cached);
+} //end of the function PC_CacheHandleTokens
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+source_t *PC_LoadCachedSource(pc_handle_t *handle, const char *filename, const char *basepath, const define_t *globaldefines)
+{
+	char pathname[MAX_QPATH];
+	int length, checksum;
+	void *buffer;
+	source_t *source;
+	pc_cachedsource_t *cached;
+
+	//the source is loaded from memory so the file is only read once
+	PS_ScriptPath(filename, pathname, sizeof(pathname));
+	length = FS_ReadFile(pathname, &buffer);
+	if (!buffer) return NULL;
+	source = LoadSourceMemory(buffer, length, filename, globaldefines);
+	checksum = Com_BlockChecksum(buffer, length);
+	FS_FreeFile(buffer);
+	if (!source) return NULL;
+	//
+	Q_strncpyz(handle->basepath, basepath ? basepath : "", sizeof(handle->basepath));
+	//same defines as PC_AddGlobalDefinesToSource adds to the source
+	handle->definechecksum = PC_DefinesChecksum(globaldefines ? globaldefines : globaldefines_implicit);
+	handle->tokennum = 0;
+	handle->lastread = qfalse;
+	handle->record = qtrue;
+	handle->complete = qfalse;
+	PC_RecordFile(handle, pathname, length, checksum);
+	//
+	cached = PC_FindCachedSource(filename, handle->basepath, handle->definechecksum);
+	if (cached)
+	{
+		if (PC_CachedSourceValid(cached, length, checksum))
+		{
+			PC_UnlinkCachedSource(cached);
+			PC_LinkCachedSource(cached);
+			handle->cache = cached;
+		} //end if
+		else
+		{
+			PC_FreeCachedSource(cached);
+		} //end else
+	} //end if
+	return source;
+} //end of the function PC_LoadCachedSource
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+int PC_ReadCachedToken(pc_handle_t *handle, pc_token_t *pc_token)
+{
+	pc_cachedtoken_t *token;
+
+	if (handle->tokennum >= handle->cache->numtokens)
+	{
+		pc_token->type = 0;
+		pc_token->string[0] = '\0';
+		handle->lastread = qfalse;
+		return 0;
+	} //end if
+	token = &handle->cache->tokens[handle->tokennum++];
+	pc_token->type = token->type;
+	pc_token->subtype = token->subtype;
+	pc_token->intvalue = token->intvalue;
+	pc_token->floatvalue = token->floatvalue;
+	Q_strncpyz(pc_token->string, handle->cache->strings + token->string, sizeof(pc_token->string));
+	handle->lastread = qtrue;
+	return 1;
+} //end of the function PC_ReadCachedToken
+#endif //TOKENCACHE
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+int PC_ReadSourceTokenHandle(pc_handle_t *handle, pc_token_t *pc_token)
+{
+	token_t token;
+	int ret;
+
+	ret = PC_ReadToken(handle->source, &token);
+	strcpy(pc_token->string, token.string);
+	pc_token->type = token.type;
+	pc_token->subtype = token.subtype;
+	pc_token->intvalue = token.intvalue;
+	pc_token->floatvalue = token.floatvalue;
+	if (pc_token->type == TT_STRING)
+		StripDoubleQuotes(pc_token->string);
+	if (pc_token->type == TT_LITERAL)
+		StripSingleQuotes(pc_token->string);
+#ifdef TOKENCACHE
+	handle->lastread = ret;
+	if (ret)
+	{
+		PC_RecordToken(handle, pc_token, handle->source->scriptstack->line);
+	} //end if
+	else
+	{
+		//only a source read up to the end of the initial script is complete
+		handle->complete = !handle->source->tokens && !handle->source->scriptstack->next &&
+								EndOfScript(handle->source->scriptstack);
+	} //end else
+#endif //TOKENCACHE
+	return ret;
+} //end of the function PC_ReadSourceTokenHandle
+#ifdef TOKENCACHE
+//============================================================================
+// continue reading the source itself where the cached tokens end
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
+void PC_StopReadingCache(pc_handle_t *handle)
+{
+	pc_token_t pc_token;
+	int i, numtokens;
+
+	numtokens = handle->tokennum;
+	handle->cache = NULL;
+	//record the tokens again while skipping them
+	handle->numfiles = 1;
+	handle->numtokens = 0;
+	handle->stringsize = 0;
+	for (i = 0; i < numtokens; i++)
+	{
+		if (!PC_ReadSourceTokenHandle(handle, &pc_token)) break;
+	} //end for
+} //end of the function PC_StopReadingCache
+#endif //TOKENCACHE
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
 int PC_LoadSourceHandle(const char *filename, const char *basepath, const define_t *globaldefines)
 {
 	source_t *source;
@@ -3061,16 +3596,25 @@ int PC_LoadSourceHandle(const char *filename, const char *basepath, const define
 
 	for (i = 1; i < MAX_SOURCEFILES; i++)
 	{
-		if (!sourceFiles[i])
+		if (!sourcehandles[i].source)
 			break;
 	} //end for
 	if (i >= MAX_SOURCEFILES)
 		return 0;
 	PS_SetBaseFolder(basepath);
+#ifdef TOKENCACHE
+	source = PC_LoadCachedSource(&sourcehandles[i], filename, basepath, globaldefines);
+	if (!source)
+	{
+		PC_FreeHandleRecord(&sourcehandles[i]);
+		return 0;
+	} //end if
+#else
 	source = LoadSourceFile(filename, globaldefines);
 	if (!source)
 		return 0;
-	sourceFiles[i] = source;
+#endif //TOKENCACHE
+	sourcehandles[i].source = source;
 	return i;
 } //end of the function PC_LoadSourceHandle
 //============================================================================
@@ -3083,11 +3627,16 @@ int PC_FreeSourceHandle(int handle)
 {
 	if (handle < 1 || handle >= MAX_SOURCEFILES)
 		return qfalse;
-	if (!sourceFiles[handle])
+	if (!sourcehandles[handle].source)
 		return qfalse;
 
-	FreeSource(sourceFiles[handle]);
-	sourceFiles[handle] = NULL;
+#ifdef TOKENCACHE
+	PC_CacheHandleTokens(&sourcehandles[handle]);
+	PC_FreeHandleRecord(&sourcehandles[handle]);
+	sourcehandles[handle].cache = NULL;
+#endif //TOKENCACHE
+	FreeSource(sourcehandles[handle].source);
+	sourcehandles[handle].source = NULL;
 	return qtrue;
 } //end of the function PC_FreeSourceHandle
 //============================================================================
@@ -3100,10 +3649,15 @@ int PC_AddDefineHandle(int handle, const char *define)
 {
 	if (handle < 1 || handle >= MAX_SOURCEFILES)
 		return qfalse;
-	if (!sourceFiles[handle])
+	if (!sourcehandles[handle].source)
 		return qfalse;
 
-	return PC_AddDefine(sourceFiles[handle], define);
+#ifdef TOKENCACHE
+	//the tokens after the define depend on it, so they're not cached
+	if (sourcehandles[handle].cache) PC_StopReadingCache(&sourcehandles[handle]);
+	sourcehandles[handle].record = qfalse;
+#endif //TOKENCACHE
+	return PC_AddDefine(sourcehandles[handle].source, define);
 } //end of the function PC_FreeSourceHandle
 //============================================================================
 //
@@ -3113,25 +3667,23 @@ int PC_AddDefineHandle(int handle, const char *define)
 //============================================================================
 int PC_ReadTokenHandle(int handle, pc_token_t *pc_token)
 {
-	token_t token;
-	int ret;
-
 	if (handle < 1 || handle >= MAX_SOURCEFILES)
 		return 0;
-	if (!sourceFiles[handle])
+	if (!sourcehandles[handle].source)
 		return 0;
 
-	ret = PC_ReadToken(sourceFiles[handle], &token);
-	strcpy(pc_token->string, token.string);
-	pc_token->type = token.type;
-	pc_token->subtype = token.subtype;
-	pc_token->intvalue = token.intvalue;
-	pc_token->floatvalue = token.floatvalue;
-	if (pc_token->type == TT_STRING)
-		StripDoubleQuotes(pc_token->string);
-	if (pc_token->type == TT_LITERAL)
-		StripSingleQuotes(pc_token->string);
-	return ret;
+#ifdef TOKENCACHE
+	if (sourcehandles[handle].cache)
+	{
+		if (sourcehandles[handle].tokennum < sourcehandles[handle].cache->numtokens ||
+				sourcehandles[handle].cache->complete)
+		{
+			return PC_ReadCachedToken(&sourcehandles[handle], pc_token);
+		} //end if
+		PC_StopReadingCache(&sourcehandles[handle]);
+	} //end if
+#endif //TOKENCACHE
+	return PC_ReadSourceTokenHandle(&sourcehandles[handle], pc_token);
 } //end of the function PC_ReadTokenHandle
 //============================================================================
 //
@@ -3143,11 +3695,28 @@ void PC_UnreadLastTokenHandle( int handle ) {
 	if ( handle < 1 || handle >= MAX_SOURCEFILES ) {
 		return;
 	}
-	if ( !sourceFiles[handle] ) {
+	if ( !sourcehandles[handle].source ) {
 		return;
 	}
 
-	PC_UnreadSourceToken( sourceFiles[handle], &sourceFiles[handle]->token );
+#ifdef TOKENCACHE
+	if ( sourcehandles[handle].cache && !sourcehandles[handle].lastread ) {
+		PC_StopReadingCache( &sourcehandles[handle] );
+	}
+	if ( sourcehandles[handle].cache ) {
+		sourcehandles[handle].tokennum--;
+		sourcehandles[handle].lastread = qfalse;
+		return;
+	}
+	//the token will be recorded again when it's read
+	if ( sourcehandles[handle].lastread ) {
+		sourcehandles[handle].numtokens--;
+	} else {
+		sourcehandles[handle].record = qfalse;
+	}
+	sourcehandles[handle].lastread = qfalse;
+#endif //TOKENCACHE
+	PC_UnreadSourceToken( sourcehandles[handle].source, &sourcehandles[handle].source->token );
 } //end of the function PC_UnreadLastTokenHandle
 //============================================================================
 //
@@ -3157,14 +3726,27 @@ void PC_UnreadLastTokenHandle( int handle ) {
 //============================================================================
 int PC_SourceFileAndLine(int handle, char *filename, int *line)
 {
+	source_t *source;
+
 	if (handle < 1 || handle >= MAX_SOURCEFILES)
 		return qfalse;
-	if (!sourceFiles[handle])
+	if (!sourcehandles[handle].source)
 		return qfalse;
 
-	strcpy(filename, sourceFiles[handle]->filename);
-	if (sourceFiles[handle]->scriptstack)
-		*line = sourceFiles[handle]->scriptstack->line;
+	source = sourcehandles[handle].source;
+	strcpy(filename, source->filename);
+#ifdef TOKENCACHE
+	if (sourcehandles[handle].cache)
+	{
+		if (sourcehandles[handle].tokennum > 0)
+			*line = sourcehandles[handle].cache->tokens[sourcehandles[handle].tokennum - 1].line;
+		else
+			*line = 1;
+		return qtrue;
+	} //end if
+#endif //TOKENCACHE
+	if (source->scriptstack)
+		*line = source->scriptstack->line;
 	else
 		*line = 0;
 	return qtrue;
@@ -3191,10 +3773,10 @@ void PC_CheckOpenSourceHandles(void)
 
 	for (i = 1; i < MAX_SOURCEFILES; i++)
 	{
-		if (sourceFiles[i])
+		if (sourcehandles[i].source)
 		{
 #ifdef BOTLIB
-			Com_Printf(S_COLOR_RED "Error: file %s still open in precompiler\n", sourceFiles[i]->scriptstack->filename);
+			Com_Printf(S_COLOR_RED "Error: file %s still open in precompiler\n", sourcehandles[i].source->scriptstack->filename);
 #endif	//BOTLIB
 		} //end if
 	} //end for
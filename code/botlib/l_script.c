@@ -1309,6 +1309,21 @@ int FileLength(FILE *fp)
 // Returns:					-
 // Changes Globals:		-
 //============================================================================
+#ifdef BOTLIB
+void PS_ScriptPath(const char *filename, char *pathname, int size)
+{
+	if (strlen(basefolder))
+		Com_sprintf(pathname, size, "%s/%s", basefolder, filename);
+	else
+		Com_sprintf(pathname, size, "%s", filename);
+} //end of the function PS_ScriptPath
+#endif //BOTLIB
+//============================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
 script_t *LoadScriptFile(const char *filename)
 {
 #ifdef BOTLIB
@@ -1322,10 +1337,7 @@ script_t *LoadScriptFile(const char *filename)
 	script_t *script;
 
 #ifdef BOTLIB
-	if (strlen(basefolder))
-		Com_sprintf(pathname, sizeof(pathname), "%s/%s", basefolder, filename);
-	else
-		Com_sprintf(pathname, sizeof(pathname), "%s", filename);
+	PS_ScriptPath(filename, pathname, sizeof(pathname));
 	length = FS_FOpenFileByMode( pathname, &fp, FS_READ );
 	if (!fp) return NULL;
 #else
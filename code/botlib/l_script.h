@@ -243,6 +243,10 @@ script_t *LoadScriptMemory(const char *ptr, int length, const char *name);
 void FreeScript(script_t *script);
 //set the base folder to load files from
 void PS_SetBaseFolder(const char *path);
+#ifdef BOTLIB
+//path of a script file in the base folder
+void PS_ScriptPath(const char *filename, char *pathname, int size);
+#endif //BOTLIB
 //print a script error with filename and line number
 void QDECL ScriptError(script_t *script, char *str, ...) __attribute__ ((format (printf, 2, 3)));
 //print a script warning with filename and line number
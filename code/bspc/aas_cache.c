@@ -0,0 +1,1017 @@
+/*
+===========================================================================
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of Spearmint Source Code.
+
+Spearmint Source Code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 3 of the License,
+or (at your option) any later version.
+
+Spearmint Source Code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Spearmint Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, Spearmint Source Code is also subject to certain additional terms.
+You should have received a copy of these additional terms immediately following
+the terms and conditions of the GNU General Public License.  If not, please
+request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional
+terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc.,
+Suite 120, Rockville, Maryland 20850 USA.
+===========================================================================
+*/
+
+#include "qbsp.h"
+#include "l_bsp_q3.h"
+#include "../botlib/aasfile.h"
+#include "aas_store.h"
+#include "aas_file.h"
+#include "aas_cfg.h"
+#include "aas_cache.h"
+
+#define AASCACHE_KEYSTART		2166136261u	//FNV-1a offset basis
+#define AASCACHE_KEYPRIME		16777619u	//FNV-1a prime
+#define AASCACHE_HASHSIZE		65536		//must be power of 2
+#define AASCACHE_REGIONSIZE		256			//size of the region columns in the xy plane
+
+extern qboolean optimize;			//bspc.c
+extern qboolean forcesidesvisible;	//bspc.c
+extern int calcgrapplereach;		//be_aas_reach.c
+extern aas_settings_t aassettings;	//be_aas_move.c
+
+//keys of the BSP being compiled
+unsigned aascache_settingskey;
+unsigned aascache_entitykey;
+int aascache_bspchecksum;
+int aascache_numbrushes;
+aascache_item_t *aascache_brushes;
+//keys of the areas being compiled
+int aascache_numareas;
+aascache_item_t *aascache_areas;
+//cache and AAS file of the previous compile
+qboolean aascache_valid;
+byte *aascache_buffer;
+aascache_header_t aascache_header;
+aascache_item_t *aascache_oldbrushes;
+aascache_item_t *aascache_oldareas;
+aas_t aascache_oldaas;
+//area numbers of the previous compile for the new areas and vice versa
+int *aascache_areamap;
+int *aascache_oldareamap;
+//new faces and edges hashed by their geometry
+unsigned *aascache_facekeys;
+int *aascache_facehash;
+int *aascache_facechain;
+int *aascache_edgehash;
+int *aascache_edgechain;
+//regions with changed geometry
+int aascache_gridmins[2];
+int aascache_gridsize[2];
+byte *aascache_dirty;
+qboolean aascache_inreach;
+//reachabilities handed out to the reachability calculation
+aas_reachability_t *aascache_reach;
+int aascache_maxreach;
+int aascache_numreused;
+
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+unsigned AAS_CacheKey(unsigned key, int value)
+{
+	int i;
+
+	for (i = 0; i < 4; i++)
+	{
+		key ^= (value >> (i * 8)) & 0xFF;
+		key *= AASCACHE_KEYPRIME;
+	} //end for
+	return key;
+} //end of the function AAS_CacheKey
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+unsigned AAS_CacheKeyFloat(unsigned key, float value)
+{
+	int bits;
+
+	//-0 and 0 are the same
+	if (value == 0) bits = 0;
+	else memcpy(&bits, &value, sizeof(int));
+	return AAS_CacheKey(key, bits);
+} //end of the function AAS_CacheKeyFloat
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+unsigned AAS_CacheKeyData(unsigned key, void *data, int length)
+{
+	int i;
+
+	for (i = 0; i < length; i++)
+	{
+		key ^= ((byte *) data)[i];
+		key *= AASCACHE_KEYPRIME;
+	} //end for
+	return key;
+} //end of the function AAS_CacheKeyData
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+unsigned AAS_CacheKeyVec(unsigned key, vec3_t v)
+{
+	key = AAS_CacheKeyFloat(key, v[0]);
+	key = AAS_CacheKeyFloat(key, v[1]);
+	return AAS_CacheKeyFloat(key, v[2]);
+} //end of the function AAS_CacheKeyVec
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+int AAS_CacheCompareItems(const void *a, const void *b)
+{
+	const aascache_item_t *item1, *item2;
+	int i;
+
+	item1 = (const aascache_item_t *) a;
+	item2 = (const aascache_item_t *) b;
+	if (item1->key != item2->key) return item1->key < item2->key ? -1 : 1;
+	for (i = 0; i < 3; i++)
+	{
+		if (item1->mins[i] != item2->mins[i]) return item1->mins[i] < item2->mins[i] ? -1 : 1;
+		if (item1->maxs[i] != item2->maxs[i]) return item1->maxs[i] < item2->maxs[i] ? -1 : 1;
+	} //end for
+	return 0;
+} //end of the function AAS_CacheCompareItems
+//===========================================================================
+// the file name of the cache that goes with the given AAS file
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_CacheFileName(char *filename, char *cachename)
+{
+	COM_StripExtension(filename, cachename, MAX_PATH);
+	strcat(cachename, ".aascache");
+} //end of the function AAS_CacheFileName
+//===========================================================================
+// returns a key for the contents of the given file or 0 if it doesn't exist
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+unsigned AAS_CacheFileKey(char *filename)
+{
+	void *buffer;
+	int length;
+	unsigned key;
+
+	length = TryLoadFile(filename, &buffer);
+	if (length < 0) return 0;
+	key = AAS_CacheKeyData(AASCACHE_KEYSTART, buffer, length);
+	FreeMemory(buffer);
+	return key;
+} //end of the function AAS_CacheFileKey
+//===========================================================================
+// every switch and cfg setting that changes the AAS output
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+unsigned AAS_CacheSettingsKey(void)
+{
+	unsigned key;
+
+	key = AAS_CacheKey(AASCACHE_KEYSTART, AASVERSION);
+	key = AAS_CacheKey(key, AASCACHE_VERSION);
+	key = AAS_CacheKeyData(key, &cfg, sizeof(cfg_t));
+	key = AAS_CacheKey(key, nodetail);
+	key = AAS_CacheKey(key, fulldetail);
+	key = AAS_CacheKey(key, nowater);
+	key = AAS_CacheKey(key, nocsg);
+	key = AAS_CacheKey(key, nobrushmerge);
+	key = AAS_CacheKey(key, lessbrushes);
+	key = AAS_CacheKey(key, forcesidesvisible);
+	key = AAS_CacheKey(key, capsule_collision);
+	key = AAS_CacheKey(key, calcgrapplereach);
+	key = AAS_CacheKey(key, optimize);
+	key = AAS_CacheKeyFloat(key, subdivide_size);
+	key = AAS_CacheKeyFloat(key, microvolume);
+	return key;
+} //end of the function AAS_CacheSettingsKey
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+unsigned AAS_CacheShaderKey(bspFile_t *bsp, unsigned key, int shadernum)
+{
+	if (shadernum < 0 || shadernum >= bsp->numShaders) return AAS_CacheKey(key, -1);
+	key = AAS_CacheKey(key, bsp->shaders[shadernum].contentFlags);
+	return AAS_CacheKey(key, bsp->shaders[shadernum].surfaceFlags);
+} //end of the function AAS_CacheShaderKey
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_CacheBrush(bspFile_t *bsp, int modelnum, int brushnum, aascache_item_t *item)
+{
+	int i, j;
+	dbrush_t *brush;
+	dbrushside_t *side;
+	dplane_t *plane;
+	unsigned key;
+
+	brush = &bsp->brushes[brushnum];
+	key = AAS_CacheKey(AASCACHE_KEYSTART, modelnum);
+	key = AAS_CacheShaderKey(bsp, key, brush->shaderNum);
+	//brushes without axial sides are treated as filling the whole map
+	VectorSet(item->mins, -MAX_MAP_BOUNDS, -MAX_MAP_BOUNDS, -MAX_MAP_BOUNDS);
+	VectorSet(item->maxs, MAX_MAP_BOUNDS, MAX_MAP_BOUNDS, MAX_MAP_BOUNDS);
+	for (i = 0; i < brush->numSides; i++)
+	{
+		side = &bsp->brushSides[brush->firstSide + i];
+		plane = &bsp->planes[side->planeNum];
+		key = AAS_CacheKeyVec(key, plane->normal);
+		key = AAS_CacheKeyFloat(key, plane->dist);
+		key = AAS_CacheShaderKey(bsp, key, side->shaderNum);
+		for (j = 0; j < 3; j++)
+		{
+			if (plane->normal[j] == 1) item->maxs[j] = plane->dist;
+			else if (plane->normal[j] == -1) item->mins[j] = -plane->dist;
+		} //end for
+	} //end for
+	item->key = key;
+} //end of the function AAS_CacheBrush
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_CachePatch(bspFile_t *bsp, int modelnum, int surfacenum, aascache_item_t *item)
+{
+	int i;
+	dsurface_t *surface;
+	drawVert_t *vert;
+	unsigned key;
+
+	surface = &bsp->surfaces[surfacenum];
+	key = AAS_CacheKey(AASCACHE_KEYSTART, modelnum);
+	key = AAS_CacheShaderKey(bsp, key, surface->shaderNum);
+	key = AAS_CacheKey(key, surface->patchWidth);
+	key = AAS_CacheKey(key, surface->patchHeight);
+	ClearBounds(item->mins, item->maxs);
+	for (i = 0; i < surface->numVerts; i++)
+	{
+		vert = &bsp->drawVerts[surface->firstVert + i];
+		key = AAS_CacheKeyVec(key, vert->xyz);
+		AddPointToBounds(vert->xyz, item->mins, item->maxs);
+	} //end for
+	item->key = key;
+} //end of the function AAS_CachePatch
+//===========================================================================
+// creates keys for the entities and the collision brushes and patches
+// of the BSP file
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+qboolean AAS_CacheBSP(struct quakefile_s *qf)
+{
+	int i, modelnum, surfacenum;
+	bspFile_t *bsp;
+	dmodel_t *model;
+
+	bsp = BSP_Load((const char *) qf);
+	if (!bsp) return false;
+	aascache_bspchecksum = bsp->checksum;
+	aascache_entitykey = AAS_CacheKeyData(AASCACHE_KEYSTART, bsp->entityString, bsp->entityStringLength);
+	//
+	aascache_brushes = (aascache_item_t *) GetClearedMemory((bsp->numBrushes + bsp->numSurfaces + 1) * sizeof(aascache_item_t));
+	aascache_numbrushes = 0;
+	for (modelnum = 0; modelnum < bsp->numSubmodels; modelnum++)
+	{
+		model = &bsp->submodels[modelnum];
+		for (i = 0; i < model->numBrushes; i++)
+		{
+			AAS_CacheBrush(bsp, modelnum, model->firstBrush + i, &aascache_brushes[aascache_numbrushes++]);
+		} //end for
+		for (i = 0; i < model->numSurfaces; i++)
+		{
+			surfacenum = model->firstSurface + i;
+			if (bsp->surfaces[surfacenum].surfaceType != MST_PATCH) continue;
+			AAS_CachePatch(bsp, modelnum, surfacenum, &aascache_brushes[aascache_numbrushes++]);
+		} //end for
+	} //end for
+	qsort(aascache_brushes, aascache_numbrushes, sizeof(aascache_item_t), AAS_CacheCompareItems);
+	BSP_Free(bsp);
+	return true;
+} //end of the function AAS_CacheBSP
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_CacheSwapItems(aascache_item_t *items, int numitems)
+{
+	int i, j;
+
+	for (i = 0; i < numitems; i++)
+	{
+		items[i].key = LittleLong(items[i].key);
+		for (j = 0; j < 3; j++)
+		{
+			items[i].mins[j] = LittleFloat(items[i].mins[j]);
+			items[i].maxs[j] = LittleFloat(items[i].maxs[j]);
+		} //end for
+	} //end for
+} //end of the function AAS_CacheSwapItems
+//===========================================================================
+// loads the cache and the AAS file of the previous compile, the cache is
+// only valid when it was written for the AAS file that is still there and
+// the settings and entities didn't change
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_LoadCompileCache(struct quakefile_s *qf, char *filename)
+{
+	char cachename[MAX_PATH];
+	int length;
+
+	AAS_FreeCompileCache();
+	aascache_settingskey = AAS_CacheSettingsKey();
+	if (!AAS_CacheBSP(qf)) return;
+	//
+	AAS_CacheFileName(filename, cachename);
+	length = TryLoadFile(cachename, (void **) &aascache_buffer);
+	if (length < 0)
+	{
+		Log_Print("no compile cache %s, compiling everything\n", cachename);
+		return;
+	} //end if
+	if (length < (int) sizeof(aascache_header_t))
+	{
+		Log_Print("%s is not a compile cache\n", cachename);
+		return;
+	} //end if
+	memcpy(&aascache_header, aascache_buffer, sizeof(aascache_header_t));
+	aascache_header.ident = LittleLong(aascache_header.ident);
+	aascache_header.version = LittleLong(aascache_header.version);
+	aascache_header.settingskey = LittleLong(aascache_header.settingskey);
+	aascache_header.entitykey = LittleLong(aascache_header.entitykey);
+	aascache_header.aaskey = LittleLong(aascache_header.aaskey);
+	aascache_header.numbrushes = LittleLong(aascache_header.numbrushes);
+	aascache_header.numareas = LittleLong(aascache_header.numareas);
+	if (aascache_header.ident != AASCACHE_IDENT || aascache_header.version != AASCACHE_VERSION ||
+		aascache_header.numbrushes < 0 || aascache_header.numareas < 0 ||
+		length != (int) (sizeof(aascache_header_t) + (aascache_header.numbrushes + aascache_header.numareas) * sizeof(aascache_item_t)))
+	{
+		Log_Print("%s is not a version %d compile cache\n", cachename, AASCACHE_VERSION);
+		return;
+	} //end if
+	aascache_oldbrushes = (aascache_item_t *) (aascache_buffer + sizeof(aascache_header_t));
+	aascache_oldareas = aascache_oldbrushes + aascache_header.numbrushes;
+	AAS_CacheSwapItems(aascache_oldbrushes, aascache_header.numbrushes + aascache_header.numareas);
+	//
+	if (aascache_header.settingskey != aascache_settingskey)
+	{
+		Log_Print("settings changed since the last compile, compiling everything\n");
+		return;
+	} //end if
+	if (aascache_header.entitykey != aascache_entitykey)
+	{
+		Log_Print("entities changed since the last compile, compiling everything\n");
+		return;
+	} //end if
+	if (aascache_header.aaskey != AAS_CacheFileKey(filename))
+	{
+		Log_Print("%s doesn't match the compile cache, compiling everything\n", filename);
+		return;
+	} //end if
+	if (!AAS_LoadAASFile(filename)) return;
+	//keep the previous compile out of the way of the new one
+	aascache_oldaas = aasworld;
+	Com_Memset(&aasworld, 0, sizeof(aas_t));
+	if (aascache_oldaas.numareas != aascache_header.numareas)
+	{
+		Log_Print("%s doesn't match the compile cache, compiling everything\n", filename);
+		return;
+	} //end if
+	aascache_valid = true;
+} //end of the function AAS_LoadCompileCache
+//===========================================================================
+// returns true when the BSP has the same collision geometry as in the
+// previous compile, the AAS file only gets the new BSP checksum
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+qboolean AAS_CompileCacheUpToDate(char *filename)
+{
+	int i;
+
+	if (!aascache_valid) return false;
+	if (aascache_numbrushes != aascache_header.numbrushes) return false;
+	for (i = 0; i < aascache_numbrushes; i++)
+	{
+		if (AAS_CacheCompareItems(&aascache_brushes[i], &aascache_oldbrushes[i])) return false;
+	} //end for
+	//the BSP may have been recompiled without changing the geometry
+	if (aascache_oldaas.bspchecksum != aascache_bspchecksum)
+	{
+		aasworld = aascache_oldaas;
+		aasworld.bspchecksum = aascache_bspchecksum;
+		if (!AAS_WriteAASFile(filename))
+		{
+			Error("error writing %s\n", filename);
+		} //end if
+		aascache_oldaas = aasworld;
+		Com_Memset(&aasworld, 0, sizeof(aas_t));
+		//the areas didn't change
+		aascache_numareas = aascache_header.numareas;
+		aascache_areas = (aascache_item_t *) GetMemory(aascache_numareas * sizeof(aascache_item_t));
+		memcpy(aascache_areas, aascache_oldareas, aascache_numareas * sizeof(aascache_item_t));
+		AAS_WriteCompileCache(filename);
+	} //end if
+	return true;
+} //end of the function AAS_CompileCacheUpToDate
+//===========================================================================
+// the edge key doesn't depend on the direction of the edge
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+unsigned AAS_CacheEdgeKey(aas_t *aas, int edgenum)
+{
+	unsigned key1, key2;
+	aas_edge_t *edge;
+
+	edge = &aas->edges[abs(edgenum)];
+	key1 = AAS_CacheKeyVec(AASCACHE_KEYSTART, aas->vertexes[edge->v[0]]);
+	key2 = AAS_CacheKeyVec(AASCACHE_KEYSTART, aas->vertexes[edge->v[1]]);
+	if (key1 < key2) return AAS_CacheKey(key1, key2);
+	return AAS_CacheKey(key2, key1);
+} //end of the function AAS_CacheEdgeKey
+//===========================================================================
+// the face key doesn't depend on the order of the face edges
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+unsigned AAS_CacheFaceKey(aas_t *aas, int facenum)
+{
+	int i;
+	unsigned key, edgekey, sum, mix;
+	aas_face_t *face;
+	aas_plane_t *plane;
+
+	face = &aas->faces[abs(facenum)];
+	plane = &aas->planes[face->planenum];
+	key = AAS_CacheKeyVec(AASCACHE_KEYSTART, plane->normal);
+	key = AAS_CacheKeyFloat(key, plane->dist);
+	key = AAS_CacheKey(key, face->faceflags);
+	key = AAS_CacheKey(key, face->numedges);
+	sum = mix = 0;
+	for (i = 0; i < face->numedges; i++)
+	{
+		edgekey = AAS_CacheEdgeKey(aas, aas->edgeindex[face->firstedge + i]);
+		sum += edgekey;
+		mix ^= edgekey;
+	} //end for
+	key = AAS_CacheKey(key, sum);
+	return AAS_CacheKey(key, mix);
+} //end of the function AAS_CacheFaceKey
+//===========================================================================
+// the area key doesn't depend on the order of the area faces
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+unsigned AAS_CacheAreaKey(aas_t *aas, int areanum)
+{
+	int i, facenum;
+	unsigned key, facekey, sum, mix;
+	aas_area_t *area;
+	aas_areasettings_t *settings;
+
+	area = &aas->areas[areanum];
+	settings = &aas->areasettings[areanum];
+	key = AAS_CacheKey(AASCACHE_KEYSTART, settings->contents);
+	key = AAS_CacheKey(key, settings->areaflags);
+	key = AAS_CacheKey(key, settings->presencetype);
+	key = AAS_CacheKey(key, area->numfaces);
+	sum = mix = 0;
+	for (i = 0; i < area->numfaces; i++)
+	{
+		facenum = aas->faceindex[area->firstface + i];
+		facekey = AAS_CacheKey(AAS_CacheFaceKey(aas, facenum), facenum > 0);
+		sum += facekey;
+		mix ^= facekey;
+	} //end for
+	key = AAS_CacheKey(key, sum);
+	return AAS_CacheKey(key, mix);
+} //end of the function AAS_CacheAreaKey
+//===========================================================================
+// returns the new face with the geometry of the given face of the
+// previous compile
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+int AAS_CacheFindFace(int oldfacenum)
+{
+	int facenum;
+	unsigned key;
+	aas_face_t *face, *oldface;
+	aas_plane_t *plane, *oldplane;
+
+	oldface = &aascache_oldaas.faces[abs(oldfacenum)];
+	oldplane = &aascache_oldaas.planes[oldface->planenum];
+	key = AAS_CacheFaceKey(&aascache_oldaas, oldfacenum);
+	for (facenum = aascache_facehash[key & (AASCACHE_HASHSIZE-1)]; facenum; facenum = aascache_facechain[facenum])
+	{
+		if (aascache_facekeys[facenum] != key) continue;
+		face = &aasworld.faces[facenum];
+		plane = &aasworld.planes[face->planenum];
+		if (face->numedges != oldface->numedges) continue;
+		if (!VectorCompare(plane->normal, oldplane->normal) || plane->dist != oldplane->dist) continue;
+		return oldfacenum > 0 ? facenum : -facenum;
+	} //end for
+	return 0;
+} //end of the function AAS_CacheFindFace
+//===========================================================================
+// returns the new edge with the geometry of the given edge of the
+// previous compile
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+int AAS_CacheFindEdge(int oldedgenum)
+{
+	int edgenum;
+	unsigned key;
+	float *v1, *v2, *oldv1, *oldv2;
+
+	oldv1 = aascache_oldaas.vertexes[aascache_oldaas.edges[abs(oldedgenum)].v[0]];
+	oldv2 = aascache_oldaas.vertexes[aascache_oldaas.edges[abs(oldedgenum)].v[1]];
+	key = AAS_CacheEdgeKey(&aascache_oldaas, oldedgenum);
+	for (edgenum = aascache_edgehash[key & (AASCACHE_HASHSIZE-1)]; edgenum; edgenum = aascache_edgechain[edgenum])
+	{
+		v1 = aasworld.vertexes[aasworld.edges[edgenum].v[0]];
+		v2 = aasworld.vertexes[aasworld.edges[edgenum].v[1]];
+		if (VectorCompare(v1, oldv1) && VectorCompare(v2, oldv2))
+		{
+			return oldedgenum > 0 ? edgenum : -edgenum;
+		} //end if
+		if (VectorCompare(v1, oldv2) && VectorCompare(v2, oldv1))
+		{
+			return oldedgenum > 0 ? -edgenum : edgenum;
+		} //end if
+	} //end for
+	return 0;
+} //end of the function AAS_CacheFindEdge
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_CacheHashFacesAndEdges(void)
+{
+	int i, hash;
+
+	aascache_facekeys = (unsigned *) GetClearedMemory(aasworld.numfaces * sizeof(unsigned));
+	aascache_facehash = (int *) GetClearedMemory(AASCACHE_HASHSIZE * sizeof(int));
+	aascache_facechain = (int *) GetClearedMemory(aasworld.numfaces * sizeof(int));
+	//face and edge zero are dummies so zero ends the chains
+	for (i = aasworld.numfaces - 1; i > 0; i--)
+	{
+		aascache_facekeys[i] = AAS_CacheFaceKey(&aasworld, i);
+		hash = aascache_facekeys[i] & (AASCACHE_HASHSIZE-1);
+		aascache_facechain[i] = aascache_facehash[hash];
+		aascache_facehash[hash] = i;
+	} //end for
+	aascache_edgehash = (int *) GetClearedMemory(AASCACHE_HASHSIZE * sizeof(int));
+	aascache_edgechain = (int *) GetClearedMemory(aasworld.numedges * sizeof(int));
+	for (i = aasworld.numedges - 1; i > 0; i--)
+	{
+		hash = AAS_CacheEdgeKey(&aasworld, i) & (AASCACHE_HASHSIZE-1);
+		aascache_edgechain[i] = aascache_edgehash[hash];
+		aascache_edgehash[hash] = i;
+	} //end for
+} //end of the function AAS_CacheHashFacesAndEdges
+//===========================================================================
+// gets the range of region columns overlapping the given bounds
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_CacheRegionRange(vec3_t mins, vec3_t maxs, int *first, int *last)
+{
+	int i;
+
+	for (i = 0; i < 2; i++)
+	{
+		first[i] = (int) floor(mins[i] / AASCACHE_REGIONSIZE) - aascache_gridmins[i];
+		last[i] = (int) floor(maxs[i] / AASCACHE_REGIONSIZE) - aascache_gridmins[i];
+		if (first[i] < 0) first[i] = 0;
+		if (last[i] >= aascache_gridsize[i]) last[i] = aascache_gridsize[i] - 1;
+	} //end for
+} //end of the function AAS_CacheRegionRange
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_CacheMarkRegions(vec3_t mins, vec3_t maxs)
+{
+	int x, y, first[2], last[2];
+
+	AAS_CacheRegionRange(mins, maxs, first, last);
+	for (y = first[1]; y <= last[1]; y++)
+	{
+		for (x = first[0]; x <= last[0]; x++)
+		{
+			aascache_dirty[y * aascache_gridsize[0] + x] = 1;
+		} //end for
+	} //end for
+} //end of the function AAS_CacheMarkRegions
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+qboolean AAS_CacheRegionsChanged(vec3_t mins, vec3_t maxs)
+{
+	int x, y, first[2], last[2];
+
+	AAS_CacheRegionRange(mins, maxs, first, last);
+	for (y = first[1]; y <= last[1]; y++)
+	{
+		for (x = first[0]; x <= last[0]; x++)
+		{
+			if (aascache_dirty[y * aascache_gridsize[0] + x]) return true;
+		} //end for
+	} //end for
+	return false;
+} //end of the function AAS_CacheRegionsChanged
+//===========================================================================
+// marks all regions within the given number of regions from a changed region
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_CacheGrowRegions(int range)
+{
+	int i, x, y, d, axis, pos, size, step;
+	byte *grown;
+
+	grown = (byte *) GetClearedMemory(aascache_gridsize[0] * aascache_gridsize[1]);
+	//grow along the x-axis and then along the y-axis
+	for (axis = 0; axis < 2; axis++)
+	{
+		size = aascache_gridsize[axis];
+		step = axis ? aascache_gridsize[0] : 1;
+		for (y = 0; y < aascache_gridsize[1]; y++)
+		{
+			for (x = 0; x < aascache_gridsize[0]; x++)
+			{
+				i = y * aascache_gridsize[0] + x;
+				pos = axis ? y : x;
+				grown[i] = 0;
+				for (d = -range; d <= range && !grown[i]; d++)
+				{
+					if (pos + d < 0 || pos + d >= size) continue;
+					grown[i] = aascache_dirty[i + d * step];
+				} //end for
+			} //end for
+		} //end for
+		memcpy(aascache_dirty, grown, aascache_gridsize[0] * aascache_gridsize[1]);
+	} //end for
+	FreeMemory(grown);
+} //end of the function AAS_CacheGrowRegions
+//===========================================================================
+// marks the regions with brushes and areas that changed since the previous
+// compile, reachabilities are calculated from columns of regions so areas
+// above or below the changes are always recalculated
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_CacheRegions(void)
+{
+	int i, j, cmp, numregions, numchanged;
+	vec3_t mins, maxs;
+
+	ClearBounds(mins, maxs);
+	for (i = 1; i < aasworld.numareas; i++)
+	{
+		AddPointToBounds(aasworld.areas[i].mins, mins, maxs);
+		AddPointToBounds(aasworld.areas[i].maxs, mins, maxs);
+	} //end for
+	for (i = 0; i < 2; i++)
+	{
+		aascache_gridmins[i] = (int) floor(mins[i] / AASCACHE_REGIONSIZE);
+		aascache_gridsize[i] = (int) floor(maxs[i] / AASCACHE_REGIONSIZE) - aascache_gridmins[i] + 1;
+		if (aascache_gridsize[i] < 1) aascache_gridsize[i] = 1;
+	} //end for
+	numregions = aascache_gridsize[0] * aascache_gridsize[1];
+	aascache_dirty = (byte *) GetClearedMemory(numregions);
+	//brushes that were added, removed or changed
+	i = j = 0;
+	while(i < aascache_numbrushes || j < aascache_header.numbrushes)
+	{
+		if (i >= aascache_numbrushes) cmp = 1;
+		else if (j >= aascache_header.numbrushes) cmp = -1;
+		else cmp = AAS_CacheCompareItems(&aascache_brushes[i], &aascache_oldbrushes[j]);
+		//
+		if (cmp < 0) AAS_CacheMarkRegions(aascache_brushes[i].mins, aascache_brushes[i].maxs);
+		if (cmp > 0) AAS_CacheMarkRegions(aascache_oldbrushes[j].mins, aascache_oldbrushes[j].maxs);
+		if (cmp <= 0) i++;
+		if (cmp >= 0) j++;
+	} //end while
+	//areas that don't exist in both compiles
+	for (i = 1; i < aascache_numareas; i++)
+	{
+		if (!aascache_areamap[i]) AAS_CacheMarkRegions(aascache_areas[i].mins, aascache_areas[i].maxs);
+	} //end for
+	for (i = 1; i < aascache_header.numareas; i++)
+	{
+		if (!aascache_oldareamap[i]) AAS_CacheMarkRegions(aascache_oldareas[i].mins, aascache_oldareas[i].maxs);
+	} //end for
+	numchanged = 0;
+	for (i = 0; i < numregions; i++) numchanged += aascache_dirty[i];
+	Log_Print("%d of %d regions changed\n", numchanged, numregions);
+} //end of the function AAS_CacheRegions
+//===========================================================================
+// marks the regions within reach of the changed regions, the physics
+// settings are only known once the reachability calculation started
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_CacheRegionsInReach(void)
+{
+	int i, numregions, numaffected;
+	float radius;
+
+	//the longest predicted jumps take 3 seconds at the maximum velocity
+	radius = 3 * aassettings.phys_maxvelocity;
+	//grapple hook reachabilities go up to 2000 units horizontally and
+	//trace 500 units into the wall
+	if (calcgrapplereach && radius < 2500) radius = 2500;
+	//the player bounding box
+	radius += 64;
+	//also grow by one region because areas may be anywhere in a region
+	AAS_CacheGrowRegions((int) ceil(radius / AASCACHE_REGIONSIZE) + 1);
+	//
+	numregions = aascache_gridsize[0] * aascache_gridsize[1];
+	numaffected = 0;
+	for (i = 0; i < numregions; i++) numaffected += aascache_dirty[i];
+	Log_Print("%d of %d regions within reach of the changes\n", numaffected, numregions);
+	aascache_inreach = true;
+} //end of the function AAS_CacheRegionsInReach
+//===========================================================================
+// stores the keys of the new areas and matches them against the areas of
+// the previous compile, has to be called before the reachabilities are
+// calculated
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_CacheAreas(void)
+{
+	int i, j, hash, *areahash, *areachain;
+
+	aascache_numareas = aasworld.numareas;
+	aascache_areas = (aascache_item_t *) GetClearedMemory(aascache_numareas * sizeof(aascache_item_t));
+	for (i = 1; i < aasworld.numareas; i++)
+	{
+		aascache_areas[i].key = AAS_CacheAreaKey(&aasworld, i);
+		VectorCopy(aasworld.areas[i].mins, aascache_areas[i].mins);
+		VectorCopy(aasworld.areas[i].maxs, aascache_areas[i].maxs);
+	} //end for
+	if (!aascache_valid) return;
+	//match the areas with the same geometry, area zero is a dummy so
+	//zero ends the chains
+	aascache_areamap = (int *) GetClearedMemory(aascache_numareas * sizeof(int));
+	aascache_oldareamap = (int *) GetClearedMemory(aascache_header.numareas * sizeof(int));
+	areahash = (int *) GetClearedMemory(AASCACHE_HASHSIZE * sizeof(int));
+	areachain = (int *) GetClearedMemory(aascache_header.numareas * sizeof(int));
+	for (j = aascache_header.numareas - 1; j > 0; j--)
+	{
+		hash = aascache_oldareas[j].key & (AASCACHE_HASHSIZE-1);
+		areachain[j] = areahash[hash];
+		areahash[hash] = j;
+	} //end for
+	for (i = 1; i < aascache_numareas; i++)
+	{
+		hash = aascache_areas[i].key & (AASCACHE_HASHSIZE-1);
+		for (j = areahash[hash]; j; j = areachain[j])
+		{
+			if (aascache_oldareamap[j]) continue;
+			if (AAS_CacheCompareItems(&aascache_areas[i], &aascache_oldareas[j])) continue;
+			aascache_areamap[i] = j;
+			aascache_oldareamap[j] = i;
+			break;
+		} //end for
+	} //end for
+	FreeMemory(areahash);
+	FreeMemory(areachain);
+	//
+	AAS_CacheHashFacesAndEdges();
+	AAS_CacheRegions();
+} //end of the function AAS_CacheAreas
+//===========================================================================
+// returns the reachabilities of the area from the previous compile with
+// the area, face and edge numbers of the new compile, returns -1 if the
+// reachabilities have to be recalculated
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+int AAS_CachedReachability(int areanum, aas_reachability_t **reach)
+{
+	int i, oldareanum, numreach, traveltype;
+	aas_areasettings_t *settings;
+	aas_reachability_t *oldreach, *newreach;
+
+	if (!aascache_dirty) return -1;
+	if (!aascache_inreach) AAS_CacheRegionsInReach();
+	oldareanum = aascache_areamap[areanum];
+	if (!oldareanum) return -1;
+	//teleporter and jump pad areas are cheap and depend on the entities
+	if (aasworld.areasettings[areanum].contents & (AREACONTENTS_TELEPORTER|AREACONTENTS_JUMPPAD)) return -1;
+	if (AAS_CacheRegionsChanged(aasworld.areas[areanum].mins, aasworld.areas[areanum].maxs)) return -1;
+	//
+	settings = &aascache_oldaas.areasettings[oldareanum];
+	if (settings->numreachableareas > aascache_maxreach)
+	{
+		if (aascache_reach) FreeMemory(aascache_reach);
+		aascache_maxreach = settings->numreachableareas;
+		aascache_reach = (aas_reachability_t *) GetMemory(aascache_maxreach * sizeof(aas_reachability_t));
+	} //end if
+	numreach = 0;
+	for (i = 0; i < settings->numreachableareas; i++)
+	{
+		oldreach = &aascache_oldaas.reachability[settings->firstreachablearea + i];
+		//entity reachabilities are always recalculated for the whole map
+		traveltype = oldreach->traveltype & TRAVELTYPE_MASK;
+		if (traveltype == TRAVEL_TELEPORT || traveltype == TRAVEL_ELEVATOR ||
+			traveltype == TRAVEL_JUMPPAD || traveltype == TRAVEL_FUNCBOB) continue;
+		//
+		newreach = &aascache_reach[numreach];
+		memcpy(newreach, oldreach, sizeof(aas_reachability_t));
+		if (oldreach->areanum <= 0 || oldreach->areanum >= aascache_header.numareas) return -1;
+		newreach->areanum = aascache_oldareamap[oldreach->areanum];
+		if (!newreach->areanum) return -1;
+		//faces and edges not kept by the optimization are zero
+		if (oldreach->facenum)
+		{
+			newreach->facenum = AAS_CacheFindFace(oldreach->facenum);
+			if (!newreach->facenum) return -1;
+		} //end if
+		if (oldreach->edgenum)
+		{
+			newreach->edgenum = AAS_CacheFindEdge(oldreach->edgenum);
+			if (!newreach->edgenum) return -1;
+		} //end if
+		numreach++;
+	} //end for
+	aascache_numreused++;
+	*reach = aascache_reach;
+	return numreach;
+} //end of the function AAS_CachedReachability
+//===========================================================================
+// writes the cache for the AAS file that was just written
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_WriteCompileCache(char *filename)
+{
+	char cachename[MAX_PATH];
+	aascache_header_t header;
+	FILE *fp;
+
+	if (aascache_dirty)
+	{
+		Log_Print("reused the reachabilities of %d of %d areas\n", aascache_numreused, aascache_numareas - 1);
+	} //end if
+	AAS_CacheFileName(filename, cachename);
+	Log_Print("writing %s\n", cachename);
+	header.ident = LittleLong(AASCACHE_IDENT);
+	header.version = LittleLong(AASCACHE_VERSION);
+	header.settingskey = LittleLong(aascache_settingskey);
+	header.entitykey = LittleLong(aascache_entitykey);
+	header.aaskey = LittleLong(AAS_CacheFileKey(filename));
+	header.numbrushes = LittleLong(aascache_numbrushes);
+	header.numareas = LittleLong(aascache_numareas);
+	fp = SafeOpenWrite(cachename);
+	SafeWrite(fp, &header, sizeof(aascache_header_t));
+	AAS_CacheSwapItems(aascache_brushes, aascache_numbrushes);
+	SafeWrite(fp, aascache_brushes, aascache_numbrushes * sizeof(aascache_item_t));
+	AAS_CacheSwapItems(aascache_brushes, aascache_numbrushes);
+	AAS_CacheSwapItems(aascache_areas, aascache_numareas);
+	SafeWrite(fp, aascache_areas, aascache_numareas * sizeof(aascache_item_t));
+	AAS_CacheSwapItems(aascache_areas, aascache_numareas);
+	fclose(fp);
+} //end of the function AAS_WriteCompileCache
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void AAS_FreeCompileCache(void)
+{
+	if (aascache_brushes) FreeMemory(aascache_brushes);
+	if (aascache_areas) FreeMemory(aascache_areas);
+	if (aascache_buffer) FreeMemory(aascache_buffer);
+	if (aascache_areamap) FreeMemory(aascache_areamap);
+	if (aascache_oldareamap) FreeMemory(aascache_oldareamap);
+	if (aascache_facekeys) FreeMemory(aascache_facekeys);
+	if (aascache_facehash) FreeMemory(aascache_facehash);
+	if (aascache_facechain) FreeMemory(aascache_facechain);
+	if (aascache_edgehash) FreeMemory(aascache_edgehash);
+	if (aascache_edgechain) FreeMemory(aascache_edgechain);
+	if (aascache_dirty) FreeMemory(aascache_dirty);
+	if (aascache_reach) FreeMemory(aascache_reach);
+	//the previous AAS file
+	if (aascache_oldaas.bboxes) FreeMemory(aascache_oldaas.bboxes);
+	if (aascache_oldaas.vertexes) FreeMemory(aascache_oldaas.vertexes);
+	if (aascache_oldaas.planes) FreeMemory(aascache_oldaas.planes);
+	if (aascache_oldaas.edges) FreeMemory(aascache_oldaas.edges);
+	if (aascache_oldaas.edgeindex) FreeMemory(aascache_oldaas.edgeindex);
+	if (aascache_oldaas.faces) FreeMemory(aascache_oldaas.faces);
+	if (aascache_oldaas.faceindex) FreeMemory(aascache_oldaas.faceindex);
+	if (aascache_oldaas.areas) FreeMemory(aascache_oldaas.areas);
+	if (aascache_oldaas.areasettings) FreeMemory(aascache_oldaas.areasettings);
+	if (aascache_oldaas.reachability) FreeMemory(aascache_oldaas.reachability);
+	if (aascache_oldaas.nodes) FreeMemory(aascache_oldaas.nodes);
+	if (aascache_oldaas.portals) FreeMemory(aascache_oldaas.portals);
+	if (aascache_oldaas.portalindex) FreeMemory(aascache_oldaas.portalindex);
+	if (aascache_oldaas.clusters) FreeMemory(aascache_oldaas.clusters);
+	Com_Memset(&aascache_oldaas, 0, sizeof(aas_t));
+	//
+	aascache_brushes = aascache_areas = NULL;
+	aascache_numbrushes = aascache_numareas = 0;
+	aascache_buffer = NULL;
+	aascache_oldbrushes = aascache_oldareas = NULL;
+	aascache_areamap = aascache_oldareamap = NULL;
+	aascache_facekeys = NULL;
+	aascache_facehash = aascache_facechain = NULL;
+	aascache_edgehash = aascache_edgechain = NULL;
+	aascache_dirty = NULL;
+	aascache_inreach = false;
+	aascache_reach = NULL;
+	aascache_maxreach = 0;
+	aascache_numreused = 0;
+	aascache_valid = false;
+} //end of the function AAS_FreeCompileCache
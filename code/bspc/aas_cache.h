@@ -0,0 +1,64 @@
+/*
+===========================================================================
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of Spearmint Source Code.
+
+Spearmint Source Code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 3 of the License,
+or (at your option) any later version.
+
+Spearmint Source Code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Spearmint Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, Spearmint Source Code is also subject to certain additional terms.
+You should have received a copy of these additional terms immediately following
+the terms and conditions of the GNU General Public License.  If not, please
+request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional
+terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc.,
+Suite 120, Rockville, Maryland 20850 USA.
+===========================================================================
+*/
+
+//compile cache written next to the AAS file with -incremental
+#define AASCACHE_IDENT			(('C'<<24)+('S'<<16)+('A'<<8)+'A')	//AASC
+#define AASCACHE_VERSION		1
+
+typedef struct aascache_header_s
+{
+	int ident;
+	int version;
+	unsigned settingskey;		//bspc switches and cfg settings
+	unsigned entitykey;			//BSP entity string
+	unsigned aaskey;			//contents of the AAS file written with the cache
+	int numbrushes;				//number of collision brushes and patches
+	int numareas;				//number of areas in the AAS file
+} aascache_header_t;
+
+//a collision brush or patch of the BSP, or an area of the AAS file
+typedef struct aascache_item_s
+{
+	unsigned key;
+	vec3_t mins, maxs;
+} aascache_item_t;
+
+//loads the cache and AAS file of the previous compile
+void AAS_LoadCompileCache(struct quakefile_s *qf, char *filename);
+//returns true and refreshes the AAS file if the BSP didn't change
+qboolean AAS_CompileCacheUpToDate(char *filename);
+//matches the new areas against the previous compile
+void AAS_CacheAreas(void);
+//returns the number of reusable reachabilities of the area or -1
+int AAS_CachedReachability(int areanum, aas_reachability_t **reach);
+//writes the cache for the AAS file that was just written
+void AAS_WriteCompileCache(char *filename);
+//frees the cache
+void AAS_FreeCompileCache(void);
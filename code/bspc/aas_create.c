@@ -1103,6 +1103,10 @@ void AAS_Create(char *aasfile)
 	if (freetree) Tree_Free(tree);
 	//try to merge area faces
 	AAS_MergeAreaFaces();
+	//NOTE: the subdivision and merging below stay single threaded, they
+	//      split faces shared with neighbouring areas and add planes in
+	//      the order the areas are visited, and take a fraction of a
+	//      percent of the time the BSP tree and reachability take
 	//do gravitational subdivision
 	AAS_GravitationalSubdivision();
 	//merge faces if possible
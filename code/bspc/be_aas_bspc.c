@@ -28,6 +28,11 @@ Suite 120, Rockville, Maryland 20850 USA.
 ===========================================================================
 */
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
 #include "../qcommon/q_shared.h"
 #include "../bspc/l_log.h"
 #include "../bspc/l_qfiles.h"
@@ -76,7 +81,17 @@ void AAS_Error(char *fmt, ...)
 //===========================================================================
 int Sys_MilliSeconds(void)
 {
-	return clock() * 1000 / CLOCKS_PER_SEC;
+#ifdef _WIN32
+	return (int) GetTickCount();
+#else
+	//wall clock time, clock() adds up the time of all the threads
+	static time_t secbase;
+	struct timeval tp;
+
+	gettimeofday(&tp, NULL);
+	if (!secbase) secbase = tp.tv_sec;
+	return (tp.tv_sec - secbase) * 1000 + tp.tv_usec / 1000;
+#endif
 } //end of the function Sys_MilliSeconds
 //===========================================================================
 //
@@ -240,6 +255,7 @@ void AAS_InitBotImport(void)
 void AAS_CalcReachAndClusters(struct quakefile_s *qf)
 {
 	float time;
+	int start_time, reach_time;
 
 	Log_Print("loading collision map...\n");
 	//
@@ -266,7 +282,11 @@ void AAS_CalcReachAndClusters(struct quakefile_s *qf)
 	//calculate reachabilities
 	AAS_InitReachability();
 	time = 0;
+	start_time = Sys_MilliSeconds();
 	while(AAS_ContinueInitReachability(time)) time++;
+	reach_time = Sys_MilliSeconds() - start_time;
+	Log_Print("reachability of %d areas calculated in %d msec (%.0f areas/sec)\n",
+				aasworld.numareas - 1, reach_time, (aasworld.numareas - 1) * 1000.0 / (reach_time ? reach_time : 1));
 	//calculate clusters
 	AAS_InitClustering();
 } //end of the function AAS_CalcReachAndClusters
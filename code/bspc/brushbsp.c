@@ -1469,111 +1469,22 @@ node_t *BuildTree_r (node_t *node, bspbrush_t *brushes)
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
-node_t *firstnode;		//first node in the list
-node_t *lastnode;			//last node in the list
-int nodelistsize;			//number of nodes in the list
-int use_nodequeue = 0;	//use nodequeue, otherwise a node stack is used
-int numwaiting = 0;
+int use_nodequeue = 0;	//build breadth first, otherwise depth first
 
-void (*AddNodeToList)(node_t *node);
-
-//add the node to the front of the node list
-//(effectively using a node stack)
-void AddNodeToStack(node_t *node)
-{
-	ThreadLock();
-
-	node->next = firstnode;
-	firstnode = node;
-	if (!lastnode) lastnode = node;
-	nodelistsize++;
-
-	ThreadUnlock();
-	//
-	ThreadSemaphoreIncrease(1);
-} //end of the function AddNodeToStack
-//add the node to the end of the node list
-//(effectively using a node queue)
-void AddNodeToQueue(node_t *node)
-{
-	ThreadLock();
-
-	node->next = NULL;
-	if (lastnode) lastnode->next = node;
-	else firstnode = node;
-	lastnode = node;
-	nodelistsize++;
-
-	ThreadUnlock();
-	//
-	ThreadSemaphoreIncrease(1);
-} //end of the function AddNodeToQueue
-//get the first node from the front of the node list
-node_t *NextNodeFromList(void)
-{
-	node_t *node;
-
-	ThreadLock();
-	numwaiting++;
-	if (!firstnode)
-	{
-		if (numwaiting >= GetNumThreads()) ThreadSemaphoreIncrease(GetNumThreads());
-	} //end if
-	ThreadUnlock();
-
-	ThreadSemaphoreWait();
-
-	ThreadLock();
-
-	numwaiting--;
-
-	node = firstnode;
-	if (firstnode)
-	{
-		firstnode = firstnode->next;
-		nodelistsize--;
-	} //end if
-	if (!firstnode) lastnode = NULL;
-
-	ThreadUnlock();
-
-	return node;
-} //end of the function NextNodeFromList
-//returns the size of the node list
-int NodeListSize(void)
-{
-	int size;
-
-	ThreadLock();
-	size = nodelistsize;
-	ThreadUnlock();
-
-	return size;
-} //end of the function NodeListSize
-//
-void IncreaseNodeCounter(void)
-{
-	ThreadLock();
-	//if (verbose) printf("\r%6d", numrecurse++);
-	qprintf("\r%6d", numrecurse++);
-	//qprintf("\r%6d %d, %5d ", numrecurse++, GetNumThreads(), nodelistsize);
-	ThreadUnlock();
-} //end of the function IncreaseNodeCounter
-//thread function, gets nodes from the nodelist and processes them
-void BuildTreeThread(int threadid)
+//processes the node and the front children below it, the back children
+//are forked as new tasks
+void BuildTreeTask(int threadid, void *arg)
 {
 	node_t *newnode, *node;
 	side_t *bestside;
 	int i, totalmem;
 	bspbrush_t *brushes;
 
-	for (node = NextNodeFromList(); node; )
+	for (node = (node_t *) arg; node; )
 	{
-		//if the nodelist isn't empty try to add another thread
-		//if (NodeListSize() > 10) AddThread(BuildTreeThread);
 		//display the number of nodes processed so far
 		if (numthreads == 1)
-			IncreaseNodeCounter();
+			qprintf("\r%6d", numrecurse++);
 
 		brushes = node->brushlist;
 
@@ -1601,7 +1512,7 @@ void BuildTreeThread(int threadid)
 		{
 			//create a leaf out of the node
 			LeafNode(node, brushes);
-			if (node->contents & CONTENTS_SOLID) c_solidleafnodes++;
+			if (node->contents & CONTENTS_SOLID) ThreadAtomicAdd(&c_solidleafnodes, 1);
 			if (create_aas)
 			{
 				//free up memory!!!
@@ -1614,8 +1525,7 @@ void BuildTreeThread(int threadid)
 				FreeBrush(node->volume);
 				node->volume = NULL;
 			} //end if
-			node = NextNodeFromList();
-			continue;
+			break;
 		} //end if
 
 		// this is a splitplane node
@@ -1653,15 +1563,14 @@ void BuildTreeThread(int threadid)
 			FreeBrush(node->volume);
 			node->volume = NULL;
 		} //end if
-		//add both children to the node list
-		//AddNodeToList(node->children[0]);
-		AddNodeToList(node->children[1]);
+		//the children only depend on their own brushes so the tree comes
+		//out the same regardless of which thread builds which subtree
+		AddTask(threadid, BuildTreeTask, node->children[1]);
 		node = node->children[0];
 	} //end while
-	RemoveThread(threadid);
-} //end of the function BuildTreeThread
+} //end of the function BuildTreeTask
 //===========================================================================
-// build the bsp tree using a node list
+// build the bsp tree using work-stealing tasks
 //
 // Parameter:			-
 // Returns:				-
@@ -1669,32 +1578,12 @@ void BuildTreeThread(int threadid)
 //===========================================================================
 void BuildTree(tree_t *tree)
 {
-	int i;
-
-	firstnode = NULL;
-	lastnode = NULL;
-	//use a node queue or node stack
-	if (use_nodequeue) AddNodeToList = AddNodeToQueue;
-	else AddNodeToList = AddNodeToStack;
-	//setup thread locking
-	ThreadSetupLock();
-	ThreadSetupSemaphore();
-	numwaiting = 0;
-	//
 	Log_Print("%6d threads max\n", numthreads);
 	if (use_nodequeue) Log_Print("breadth first bsp building\n");
 	else Log_Print("depth first bsp building\n");
 	qprintf("%6d splits", 0);
-	//add the first node to the list
-	AddNodeToList(tree->headnode);
-	//start the threads
-	for (i = 0; i < numthreads; i++)
-		AddThread(BuildTreeThread);
-	//wait for all added threads to be finished
-	WaitForAllThreadsFinished();
-	//shutdown the thread locking
-	ThreadShutdownLock();
-	ThreadShutdownSemaphore();
+	//start with the head node
+	RunTasks(BuildTreeTask, tree->headnode, use_nodequeue);
 } //end of the function BuildTree
 //===========================================================================
 // The incoming brush list will be freed before exiting
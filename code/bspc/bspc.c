@@ -46,6 +46,7 @@ Suite 120, Rockville, Maryland 20850 USA.
 #include "aas_store.h"
 #include "aas_file.h"
 #include "aas_cfg.h"
+#include "aas_cache.h"
 #include "be_aas_bspc.h"
 
 extern	int use_nodequeue;		//brushbsp.c
@@ -70,6 +71,7 @@ qboolean	noshare;			//don't share bsp edges (faces.c)
 qboolean	nosubdiv;			//don't subdivide bsp node faces (faces.c)
 qboolean	notjunc;			//don't create tjunctions (edge melting) (faces.c)
 qboolean	optimize;			//enable optimisation
+qboolean	incremental;		//only recalculate what changed since the last compile
 qboolean	leaktest;			//perform a leak test
 qboolean	verboseentities;
 qboolean	freetree;			//free the bsp tree when not needed anymore
@@ -411,6 +413,11 @@ int main (int argc, char **argv)
 			Log_Print("grapplereach = false\n");
 		} //end else if
 #endif
+		else if (!stricmp(argv[i], "-incremental"))
+		{
+			incremental = true;
+			Log_Print("incremental = true\n");
+		} //end else if
 		else if (!stricmp(argv[i], "-nobrushmerge"))
 		{
 			nobrushmerge = true;
@@ -539,11 +546,24 @@ int main (int argc, char **argv)
 					//
 					Log_Print("bsp2aas: %s to %s\n", qf->origname, filename);
 					if (qf->type != QFILETYPE_BSP) Warning("%s is probably not a BSP file\n", qf->origname);
+					//compare with the previous compile
+					if (incremental)
+					{
+						AAS_LoadCompileCache(qf, filename);
+						if (AAS_CompileCacheUpToDate(filename))
+						{
+							Log_Print("%s is up to date\n", filename);
+							AAS_FreeCompileCache();
+							continue;
+						} //end if
+					} //end if
 					//set before map loading
 					create_aas = 1;
 					LoadMapFromBSP(qf);
 					//create the AAS file
 					AAS_Create(filename);
+					//match the areas against the previous compile
+					if (incremental) AAS_CacheAreas();
 					//calculate the reachabilities and clusters
 					AAS_CalcReachAndClusters(qf);
 					//
@@ -554,6 +574,11 @@ int main (int argc, char **argv)
 					{
 						Error("error writing %s\n", filename);
 					} //end if
+					if (incremental)
+					{
+						AAS_WriteCompileCache(filename);
+						AAS_FreeCompileCache();
+					} //end if
 					//deallocate memory
 					AAS_FreeMaxAAS();
 				} //end for
@@ -720,6 +745,7 @@ int main (int argc, char **argv)
 			"   threads  <X>                         = set number of threads to X\n"
 			"   cfg      <filename>                  = use this cfg file\n"
 			"   optimize                             = enable optimization\n"
+			"   incremental                          = reuse the last bsp2aas output\n"
 			"   noverbose                            = disable verbose output\n"
 			"   breadthfirst                         = breadth first bsp building\n"
 			"   nobrushmerge                         = don't merge brushes\n"
@@ -35,8 +35,6 @@ Suite 120, Rockville, Maryland 20850 USA.
 
 #define	MAX_THREADS	64
 
-//#define THREAD_DEBUG
-
 int dispatch;
 int workcount;
 int oldf;
@@ -123,24 +121,9 @@ void RunThreadsOnIndividual (int workcnt, qboolean showpacifier, void(*func)(int
 
 #include <windows.h>
 
-typedef struct thread_s
-{
-	HANDLE handle;
-	DWORD threadid;
-	DWORD id;
-	struct thread_s *next;
-} thread_t;
-
-thread_t *firstthread;
-thread_t *lastthread;
-int currentnumthreads;
-DWORD currentthreadid;
-
 int numthreads = 1;
 CRITICAL_SECTION crit;
-HANDLE semaphore;
 static int enter;
-static int numwaitingthreads = 0;
 
 //===========================================================================
 //
@@ -156,7 +139,7 @@ void ThreadSetDefault(void)
 	{
 		GetSystemInfo (&info);
 		numthreads = info.dwNumberOfProcessors;
-		if (numthreads < 1 || numthreads > 32)
+		if (numthreads < 1 || numthreads > MAX_THREADS)
 			numthreads = 1;
 	} //end if
 	qprintf ("%i threads\n", numthreads);
@@ -208,8 +191,6 @@ void ThreadSetupLock(void)
 	Log_Print("Win32 multi-threading\n");
 	InitializeCriticalSection(&crit);
 	threaded = true;	//Stupid me... forgot this!!!
-	currentnumthreads = 0;
-	currentthreadid = 0;
 } //end of the function ThreadInitLock
 //===========================================================================
 //
@@ -228,39 +209,30 @@ void ThreadShutdownLock(void)
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
-void ThreadSetupSemaphore(void)
-{
-	semaphore = CreateSemaphore(NULL, 0, 99999999, "bspc");
-} //end of the function ThreadSetupSemaphore
-//===========================================================================
-//
-// Parameter:			-
-// Returns:				-
-// Changes Globals:		-
-//===========================================================================
-void ThreadShutdownSemaphore(void)
+int ThreadAtomicAdd(volatile int *value, int add)
 {
-} //end of the function ThreadShutdownSemaphore
+	return InterlockedExchangeAdd((volatile LONG *) value, add) + add;
+} //end of the function ThreadAtomicAdd
 //===========================================================================
 //
 // Parameter:				-
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
-void ThreadSemaphoreWait(void)
+static int ThreadAtomicCompareExchange(volatile int *value, int compare, int exchange)
 {
-	WaitForSingleObject(semaphore, INFINITE);
-} //end of the function ThreadSemaphoreWait
+	return InterlockedCompareExchange((volatile LONG *) value, exchange, compare) == compare;
+} //end of the function ThreadAtomicCompareExchange
 //===========================================================================
 //
 // Parameter:				-
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
-void ThreadSemaphoreIncrease(int count)
+static void ThreadYield(void)
 {
-	ReleaseSemaphore(semaphore, count, NULL);
-} //end of the function ThreadSemaphoreIncrease
+	SwitchToThread();
+} //end of the function ThreadYield
 //===========================================================================
 //
 // Parameter:				-
@@ -291,15 +263,12 @@ void RunThreadsOn(int workcnt, qboolean showpacifier, void(*func)(int))
 	//
 	InitializeCriticalSection (&crit);
 
-	numwaitingthreads = 0;
-
 	if (numthreads == 1)
 	{	// use same thread
 		func (0);
 	} //end if
 	else
 	{
-//		printf("starting %d threads\n", numthreads);
 		for (i = 0; i < numthreads; i++)
 		{
 			threadhandle[i] = CreateThread(
@@ -309,11 +278,15 @@ void RunThreadsOn(int workcnt, qboolean showpacifier, void(*func)(int))
 			   (LPVOID)(intptr_t)i,	// LPVOID lpvThreadParm,
 			   0,			//   DWORD fdwCreate,
 			   &threadid[i]);
-//			printf("started thread %d\n", i);
+			if (!threadhandle[i])
+				Error ("CreateThread failed");
 		} //end for
 
 		for (i = 0; i < numthreads; i++)
+		{
 			WaitForSingleObject (threadhandle[i], INFINITE);
+			CloseHandle (threadhandle[i]);
+		} //end for
 	} //end else
 	DeleteCriticalSection (&crit);
 
@@ -321,163 +294,34 @@ void RunThreadsOn(int workcnt, qboolean showpacifier, void(*func)(int))
 	end = I_FloatTime ();
 	if (pacifier) printf (" (%i)\n", end-start);
 } //end of the function RunThreadsOn
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void AddThread(void (*func)(int))
-{
-	thread_t *thread;
-
-	if (numthreads == 1)
-	{
-		if (currentnumthreads >= numthreads) return;
-		currentnumthreads++;
-		func(-1);
-		currentnumthreads--;
-	} //end if
-	else
-	{
-		ThreadLock();
-		if (currentnumthreads >= numthreads)
-		{
-			ThreadUnlock();
-			return;
-		} //end if
-		//allocate new thread
-		thread = GetMemory(sizeof(thread_t));
-		if (!thread) Error("can't allocate memory for thread\n");
-
-		//
-		thread->threadid = currentthreadid;
-		thread->handle = CreateThread(
-				   NULL,	// LPSECURITY_ATTRIBUTES lpsa,
-				   0,		// DWORD cbStack,
-				   (LPTHREAD_START_ROUTINE)func,	// LPTHREAD_START_ROUTINE lpStartAddr,
-				   (LPVOID)(intptr_t)thread->threadid,			// LPVOID lpvThreadParm,
-					0,						// DWORD fdwCreate,
-					&thread->id);
-
-		//add the thread to the end of the list
-		thread->next = NULL;
-		if (lastthread) lastthread->next = thread;
-		else firstthread = thread;
-		lastthread = thread;
-		//
-#ifdef THREAD_DEBUG
-		qprintf("added thread with id %d\n", thread->threadid);
-#endif //THREAD_DEBUG
-		//
-		currentnumthreads++;
-		currentthreadid++;
-		//
-		ThreadUnlock();
-	} //end else
-} //end of the function AddThread
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void RemoveThread(int threadid)
-{
-	thread_t *thread, *last;
-
-	//if a single thread
-	if (threadid == -1) return;
-	//
-	ThreadLock();
-	last = NULL;
-	for (thread = firstthread; thread; thread = thread->next)
-	{
-		if (thread->threadid == threadid)
-		{
-			if (last) last->next = thread->next;
-			else firstthread = thread->next;
-			if (!thread->next) lastthread = last;
-			//
-			FreeMemory(thread);
-			currentnumthreads--;
-#ifdef THREAD_DEBUG
-			qprintf("removed thread with id %d\n", threadid);
-#endif //THREAD_DEBUG
-			break;
-		} //end if
-		last = thread;
-	} //end if
-	if (!thread) Error("couldn't find thread with id %d", threadid);
-	ThreadUnlock();
-} //end of the function RemoveThread
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void WaitForAllThreadsFinished(void)
-{
-	HANDLE handle;
-
-	ThreadLock();
-	while(firstthread)
-	{
-		handle = firstthread->handle;
-		ThreadUnlock();
-
-		WaitForSingleObject(handle, INFINITE);
-
-		ThreadLock();
-	} //end while
-	ThreadUnlock();
-} //end of the function WaitForAllThreadsFinished
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-int GetNumThreads(void)
-{
-	return currentnumthreads;
-} //end of the function GetNumThreads
 
 #endif //_WIN32
 
 
 //===================================================================
 //
-// OSF1
+// POSIX THREADS
 //
 //===================================================================
 
-#if defined(__osf__)
+#if !defined(USED) && (defined(__unix__) || defined(__APPLE__))
 
 #define	USED
 
 #include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
 
-typedef struct thread_s
+typedef struct threadstart_s
 {
 	pthread_t thread;
-	size_t threadid;
-	int id;
-	struct thread_s *next;
-} thread_t;
-
-thread_t *firstthread;
-thread_t *lastthread;
-int currentnumthreads;
-size_t currentthreadid;
+	void (*func)(int);
+	int threadid;
+} threadstart_t;
 
 int numthreads = 1;
-pthread_mutex_t my_mutex;
-pthread_attr_t	attrib;
+pthread_mutex_t my_mutex = PTHREAD_MUTEX_INITIALIZER;
 static int enter;
-static int numwaitingthreads = 0;
-
 
 //===========================================================================
 //
@@ -489,7 +333,9 @@ void ThreadSetDefault(void)
 {
 	if (numthreads == -1)	// not set manually
 	{
-		numthreads = 1;
+		numthreads = sysconf(_SC_NPROCESSORS_ONLN);
+		if (numthreads < 1 || numthreads > MAX_THREADS)
+			numthreads = 1;
 	} //end if
 	qprintf("%i threads\n", numthreads);
 } //end of the function ThreadSetDefault
@@ -506,10 +352,7 @@ void ThreadLock(void)
 		Error("ThreadLock: !threaded");
 		return;
 	} //end if
-	if (my_mutex)
-	{
-		pthread_mutex_lock(my_mutex);
-	} //end if
+	pthread_mutex_lock(&my_mutex);
 	if (enter)
 		Error("Recursive ThreadLock\n");
 	enter = 1;
@@ -530,10 +373,7 @@ void ThreadUnlock(void)
 	if (!enter)
 		Error("ThreadUnlock without lock\n");
 	enter = 0;
-	if (my_mutex)
-	{
-		pthread_mutex_unlock(my_mutex);
-	} //end if
+	pthread_mutex_unlock(&my_mutex);
 } //end of the function ThreadUnlock
 //===========================================================================
 //
@@ -543,29 +383,9 @@ void ThreadUnlock(void)
 //===========================================================================
 void ThreadSetupLock(void)
 {
-	pthread_mutexattr_t mattrib;
-
 	Log_Print("pthread multi-threading\n");
 
-	if (!my_mutex)
-	{
-		my_mutex = GetMemory(sizeof(*my_mutex));
-		if (pthread_mutexattr_create (&mattrib) == -1)
-			Error ("pthread_mutex_attr_create failed");
-		if (pthread_mutexattr_setkind_np (&mattrib, MUTEX_FAST_NP) == -1)
-			Error ("pthread_mutexattr_setkind_np failed");
-		if (pthread_mutex_init (my_mutex, mattrib) == -1)
-			Error ("pthread_mutex_init failed");
-	}
-
-	if (pthread_attr_create (&attrib) == -1)
-		Error ("pthread_attr_create failed");
-	if (pthread_attr_setstacksize (&attrib, 0x100000) == -1)
-		Error ("pthread_attr_setstacksize failed");
-
 	threaded = true;
-	currentnumthreads = 0;
-	currentthreadid = 0;
 } //end of the function ThreadInitLock
 //===========================================================================
 //
@@ -583,219 +403,114 @@ void ThreadShutdownLock(void)
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
-void RunThreadsOn(int workcnt, qboolean showpacifier, void(*func)(int))
+int ThreadAtomicAdd(volatile int *value, int add)
 {
-	int		i;
-	pthread_t	work_threads[MAX_THREADS];
-	pthread_addr_t	status;
-	pthread_attr_t	attrib;
-	pthread_mutexattr_t	mattrib;
-	int		start, end;
-
-	Log_Print("pthread multi-threading\n");
-
-	start = I_FloatTime ();
-	dispatch = 0;
-	workcount = workcnt;
-	oldf = -1;
-	pacifier = showpacifier;
-	threaded = true;
-
-	if (numthreads < 1 || numthreads > MAX_THREADS) numthreads = 1;
-
-	if (pacifier)
-		setbuf (stdout, NULL);
-
-	if (!my_mutex)
-	{
-		my_mutex = GetMemory(sizeof(*my_mutex));
-		if (pthread_mutexattr_create (&mattrib) == -1)
-			Error ("pthread_mutex_attr_create failed");
-		if (pthread_mutexattr_setkind_np (&mattrib, MUTEX_FAST_NP) == -1)
-			Error ("pthread_mutexattr_setkind_np failed");
-		if (pthread_mutex_init (my_mutex, mattrib) == -1)
-			Error ("pthread_mutex_init failed");
-	}
-
-	if (pthread_attr_create (&attrib) == -1)
-		Error ("pthread_attr_create failed");
-	if (pthread_attr_setstacksize (&attrib, 0x100000) == -1)
-		Error ("pthread_attr_setstacksize failed");
-	
-	for (i=0 ; i<numthreads ; i++)
-	{
-  		if (pthread_create(&work_threads[i], attrib
-		, (pthread_startroutine_t)func, (pthread_addr_t)i) == -1)
-			Error ("pthread_create failed");
-	}
-		
-	for (i=0 ; i<numthreads ; i++)
-	{
-		if (pthread_join (work_threads[i], &status) == -1)
-			Error ("pthread_join failed");
-	}
-
-	threaded = false;
-
-	end = I_FloatTime ();
-	if (pacifier)
-		printf (" (%i)\n", end-start);
-} //end of the function RunThreadsOn
+	return __atomic_add_fetch(value, add, __ATOMIC_ACQ_REL);
+} //end of the function ThreadAtomicAdd
 //===========================================================================
 //
 // Parameter:				-
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
-void AddThread(void (*func)(int))
+static int ThreadAtomicCompareExchange(volatile int *value, int compare, int exchange)
 {
-	thread_t *thread;
-
-	if (numthreads == 1)
-	{
-		if (currentnumthreads >= numthreads) return;
-		currentnumthreads++;
-		func(-1);
-		currentnumthreads--;
-	} //end if
-	else
-	{
-		ThreadLock();
-		if (currentnumthreads >= numthreads)
-		{
-			ThreadUnlock();
-			return;
-		} //end if
-		//allocate new thread
-		thread = GetMemory(sizeof(thread_t));
-		if (!thread) Error("can't allocate memory for thread\n");
-		//
-		thread->threadid = currentthreadid;
-
-		if (pthread_create(&thread->thread, attrib, (pthread_startroutine_t)func, (pthread_addr_t)thread->threadid) == -1)
-			Error ("pthread_create failed");
-
-		//add the thread to the end of the list
-		thread->next = NULL;
-		if (lastthread) lastthread->next = thread;
-		else firstthread = thread;
-		lastthread = thread;
-		//
-#ifdef THREAD_DEBUG
-		qprintf("added thread with id %d\n", thread->threadid);
-#endif //THREAD_DEBUG
-		//
-		currentnumthreads++;
-		currentthreadid++;
-		//
-		ThreadUnlock();
-	} //end else
-} //end of the function AddThread
+	return __atomic_compare_exchange_n(value, &compare, exchange, false,
+										__ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+} //end of the function ThreadAtomicCompareExchange
 //===========================================================================
 //
 // Parameter:				-
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
-void RemoveThread(int threadid)
+static void ThreadYield(void)
 {
-	thread_t *thread, *last;
-
-	//if a single thread
-	if (threadid == -1) return;
-	//
-	ThreadLock();
-	last = NULL;
-	for (thread = firstthread; thread; thread = thread->next)
-	{
-		if (thread->threadid == threadid)
-		{
-			if (last) last->next = thread->next;
-			else firstthread = thread->next;
-			if (!thread->next) lastthread = last;
-			//
-			FreeMemory(thread);
-			currentnumthreads--;
-#ifdef THREAD_DEBUG
-			qprintf("removed thread with id %d\n", threadid);
-#endif //THREAD_DEBUG
-			break;
-		} //end if
-		last = thread;
-	} //end if
-	if (!thread) Error("couldn't find thread with id %d", threadid);
-	ThreadUnlock();
-} //end of the function RemoveThread
+	sched_yield();
+} //end of the function ThreadYield
 //===========================================================================
 //
 // Parameter:				-
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
-void WaitForAllThreadsFinished(void)
+static void *ThreadStart(void *arg)
 {
-	pthread_t *thread;
-	pthread_addr_t	status;
-
-	ThreadLock();
-	while(firstthread)
-	{
-		thread = &firstthread->thread;
-		ThreadUnlock();
+	threadstart_t *start = (threadstart_t *) arg;
 
-		if (pthread_join(*thread, &status) == -1)
-			Error("pthread_join failed");
-
-		ThreadLock();
-	} //end while
-	ThreadUnlock();
-} //end of the function WaitForAllThreadsFinished
+	start->func(start->threadid);
+	return NULL;
+} //end of the function ThreadStart
 //===========================================================================
 //
 // Parameter:				-
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
-int GetNumThreads(void)
+void RunThreadsOn(int workcnt, qboolean showpacifier, void(*func)(int))
 {
-	return currentnumthreads;
-} //end of the function GetNumThreads
+	int			i;
+	threadstart_t	work_threads[MAX_THREADS];
+	int		start, end;
 
-#endif
+	Log_Print("pthread multi-threading\n");
 
-//===================================================================
-//
-// LINUX
-//
-//===================================================================
+	start = I_FloatTime ();
+	dispatch = 0;
+	workcount = workcnt;
+	oldf = -1;
+	pacifier = showpacifier;
+	threaded = true;
 
-#ifdef __linux__
+	if (numthreads == -1)
+		ThreadSetDefault ();
 
-#define	USED
+	if (numthreads < 1 || numthreads > MAX_THREADS) numthreads = 1;
 
-#include <pthread.h>
-#include <semaphore.h>
+	if (pacifier)
+		setbuf (stdout, NULL);
 
-typedef struct thread_s
-{
-	pthread_t thread;
-	size_t threadid;
-	int id;
-	struct thread_s *next;
-} thread_t;
+	if (numthreads == 1)
+	{	// use same thread
+		func (0);
+	} //end if
+	else
+	{
+		for (i=0 ; i<numthreads ; i++)
+		{
+			work_threads[i].func = func;
+			work_threads[i].threadid = i;
+			if (pthread_create(&work_threads[i].thread, NULL, ThreadStart, &work_threads[i]) != 0)
+				Error ("pthread_create failed");
+		}
 
-thread_t *firstthread;
-thread_t *lastthread;
-int currentnumthreads;
-size_t currentthreadid;
+		for (i=0 ; i<numthreads ; i++)
+		{
+			if (pthread_join(work_threads[i].thread, NULL) != 0)
+				Error ("pthread_join failed");
+		}
+	} //end else
 
-int numthreads = 1;
-pthread_mutex_t my_mutex = PTHREAD_MUTEX_INITIALIZER;
-pthread_attr_t	attrib;
-sem_t semaphore;
-static int enter;
+	threaded = false;
+
+	end = I_FloatTime ();
+	if (pacifier)
+		printf (" (%i)\n", end-start);
+} //end of the function RunThreadsOn
+
+#endif //POSIX THREADS
 
 
+//=======================================================================
+//
+// SINGLE THREAD
+//
+//=======================================================================
+
+#ifndef USED
+
+int numthreads = 1;
+
 //===========================================================================
 //
 // Parameter:				-
@@ -804,11 +519,7 @@ static int enter;
 //===========================================================================
 void ThreadSetDefault(void)
 {
-	if (numthreads == -1)	// not set manually
-	{
-		numthreads = 1;
-	} //end if
-	qprintf("%i threads\n", numthreads);
+	numthreads = 1;
 } //end of the function ThreadSetDefault
 //===========================================================================
 //
@@ -818,15 +529,6 @@ void ThreadSetDefault(void)
 //===========================================================================
 void ThreadLock(void)
 {
-	if (!threaded)
-	{
-		Error("ThreadLock: !threaded");
-		return;
-	} //end if
-	pthread_mutex_lock(&my_mutex);
-	if (enter)
-		Error("Recursive ThreadLock\n");
-	enter = 1;
 } //end of the function ThreadLock
 //===========================================================================
 //
@@ -836,15 +538,6 @@ void ThreadLock(void)
 //===========================================================================
 void ThreadUnlock(void)
 {
-	if (!threaded)
-	{
-		Error("ThreadUnlock: !threaded");
-		return;
-	} //end if
-	if (!enter)
-		Error("ThreadUnlock without lock\n");
-	enter = 0;
-	pthread_mutex_unlock(&my_mutex);
 } //end of the function ThreadUnlock
 //===========================================================================
 //
@@ -854,11 +547,7 @@ void ThreadUnlock(void)
 //===========================================================================
 void ThreadSetupLock(void)
 {
-	Log_Print("pthread multi-threading\n");
-
-	threaded = true;
-	currentnumthreads = 0;
-	currentthreadid = 0;
+	Log_Print("no multi-threading\n");
 } //end of the function ThreadInitLock
 //===========================================================================
 //
@@ -868,53 +557,39 @@ void ThreadSetupLock(void)
 //===========================================================================
 void ThreadShutdownLock(void)
 {
-	threaded = false;
 } //end of the function ThreadShutdownLock
 //===========================================================================
 //
-// Parameter:			-
-// Returns:				-
-// Changes Globals:		-
-//===========================================================================
-void ThreadSetupSemaphore(void)
-{
-	sem_init(&semaphore, 0, 0);
-} //end of the function ThreadSetupSemaphore
-//===========================================================================
-//
-// Parameter:			-
-// Returns:				-
+// Parameter:				-
+// Returns:					-
 // Changes Globals:		-
 //===========================================================================
-void ThreadShutdownSemaphore(void)
+int ThreadAtomicAdd(volatile int *value, int add)
 {
-	sem_destroy(&semaphore);
-} //end of the function ThreadShutdownSemaphore
+	*value += add;
+	return *value;
+} //end of the function ThreadAtomicAdd
 //===========================================================================
 //
-// Parameter:			-
-// Returns:				-
+// Parameter:				-
+// Returns:					-
 // Changes Globals:		-
 //===========================================================================
-void ThreadSemaphoreWait(void)
+static int ThreadAtomicCompareExchange(volatile int *value, int compare, int exchange)
 {
-	sem_wait(&semaphore);
-} //end of the function ThreadSemaphoreWait
+	if (*value != compare) return false;
+	*value = exchange;
+	return true;
+} //end of the function ThreadAtomicCompareExchange
 //===========================================================================
 //
-// Parameter:			-
-// Returns:				-
+// Parameter:				-
+// Returns:					-
 // Changes Globals:		-
 //===========================================================================
-void ThreadSemaphoreIncrease(int count)
+static void ThreadYield(void)
 {
-	int i;
-
-	for (i = 0; i < count; i++)
-	{
-		sem_post(&semaphore);
-	} //end for
-} //end of the function ThreadSemaphoreIncrease
+} //end of the function ThreadYield
 //===========================================================================
 //
 // Parameter:				-
@@ -923,198 +598,58 @@ void ThreadSemaphoreIncrease(int count)
 //===========================================================================
 void RunThreadsOn(int workcnt, qboolean showpacifier, void(*func)(int))
 {
-	size_t		i;
-	pthread_t	work_threads[MAX_THREADS];
-	void *pthread_return;
-	int		start, end;
-
-	Log_Print("pthread multi-threading\n");
+	int start, end;
 
-	start = I_FloatTime ();
+	Log_Print("no multi-threading\n");
 	dispatch = 0;
 	workcount = workcnt;
 	oldf = -1;
 	pacifier = showpacifier;
-	threaded = true;
-
-	if (numthreads < 1 || numthreads > MAX_THREADS) numthreads = 1;
-
+	start = I_FloatTime (); 
+#ifdef NeXT
 	if (pacifier)
 		setbuf (stdout, NULL);
-
-	for (i=0 ; i<numthreads ; i++)
-	{
-		if (pthread_create(&work_threads[i], NULL, (void *)func, (void *)i) == -1)
-			Error ("pthread_create failed");
-	}
-		
-	for (i=0 ; i<numthreads ; i++)
-	{
-		if (pthread_join(work_threads[i], &pthread_return) == -1)
-			Error ("pthread_join failed");
-	}
-
-	threaded = false;
+#endif
+	func(0);
 
 	end = I_FloatTime ();
 	if (pacifier)
 		printf (" (%i)\n", end-start);
 } //end of the function RunThreadsOn
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void AddThread(void (*func)(int))
-{
-	thread_t *thread;
 
-	if (numthreads == 1)
-	{
-		if (currentnumthreads >= numthreads) return;
-		currentnumthreads++;
-		func(-1);
-		currentnumthreads--;
-	} //end if
-	else
-	{
-		ThreadLock();
-		if (currentnumthreads >= numthreads)
-		{
-			ThreadUnlock();
-			return;
-		} //end if
-		//allocate new thread
-		thread = GetMemory(sizeof(thread_t));
-		if (!thread) Error("can't allocate memory for thread\n");
-		//
-		thread->threadid = currentthreadid;
-
-		if (pthread_create(&thread->thread, NULL, (void *)func, (void *)thread->threadid) == -1)
-			Error ("pthread_create failed");
-
-		//add the thread to the end of the list
-		thread->next = NULL;
-		if (lastthread) lastthread->next = thread;
-		else firstthread = thread;
-		lastthread = thread;
-		//
-#ifdef THREAD_DEBUG
-		qprintf("added thread with id %d\n", thread->threadid);
-#endif //THREAD_DEBUG
-		//
-		currentnumthreads++;
-		currentthreadid++;
-		//
-		ThreadUnlock();
-	} //end else
-} //end of the function AddThread
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void RemoveThread(int threadid)
-{
-	thread_t *thread, *last;
-
-	//if a single thread
-	if (threadid == -1) return;
-	//
-	ThreadLock();
-	last = NULL;
-	for (thread = firstthread; thread; thread = thread->next)
-	{
-		if (thread->threadid == threadid)
-		{
-			if (last) last->next = thread->next;
-			else firstthread = thread->next;
-			if (!thread->next) lastthread = last;
-			//
-			FreeMemory(thread);
-			currentnumthreads--;
-#ifdef THREAD_DEBUG
-			qprintf("removed thread with id %d\n", threadid);
-#endif //THREAD_DEBUG
-			break;
-		} //end if
-		last = thread;
-	} //end if
-	if (!thread) Error("couldn't find thread with id %d", threadid);
-	ThreadUnlock();
-} //end of the function RemoveThread
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void WaitForAllThreadsFinished(void)
-{
-	pthread_t *thread;
-	void *pthread_return;
-
-	ThreadLock();
-	while(firstthread)
-	{
-		thread = &firstthread->thread;
-		ThreadUnlock();
-
-		if (pthread_join(*thread, &pthread_return) == -1)
-			Error("pthread_join failed");
-
-		ThreadLock();
-	} //end while
-	ThreadUnlock();
-} //end of the function WaitForAllThreadsFinished
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-int GetNumThreads(void)
-{
-	return currentnumthreads;
-} //end of the function GetNumThreads
-
-#endif //__linux__
+#endif //USED
 
 
 //===================================================================
 //
-// IRIX
+// WORK-STEALING TASKS
+//
+// every thread owns a task queue, it pushes the tasks it forks to the
+// bottom and takes them back from the bottom, a thread that runs out
+// of tasks steals the oldest task from the top of another queue
 //
 //===================================================================
 
-#ifdef _MIPS_ISA 
-
-#define	USED
+#define MAX_QUEUEDTASKS		1024		//must be a power of two
 
-#include <task.h>
-#include <abi_mutex.h>
-#include <sys/types.h>
-#include <sys/prctl.h>
-
-typedef struct thread_s
+typedef struct task_s
 {
-	size_t threadid;
-	int id;
-	struct thread_s *next;
-} thread_t;
-
-thread_t *firstthread;
-thread_t *lastthread;
-int currentnumthreads;
-size_t currentthreadid;
+	void (*func)(int threadid, void *arg);
+	void *arg;
+} task_t;
 
-int numthreads = 1;
-static int enter;
-static int numwaitingthreads = 0;
+typedef struct taskqueue_s
+{
+	volatile int lock;
+	int top;							//tasks are stolen from the top
+	int bottom;							//and pushed and popped at the bottom
+	task_t tasks[MAX_QUEUEDTASKS];
+} taskqueue_t;
 
-abilock_t		lck;
+static taskqueue_t *taskqueues;
+static int numtaskqueues;
+static volatile int numpendingtasks;
+static qboolean breadthfirsttasks;
 
 //===========================================================================
 //
@@ -1122,392 +657,127 @@ abilock_t		lck;
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
-void ThreadSetDefault (void)
-{
-	if (numthreads == -1)
-		numthreads = prctl(PR_MAXPPROCS);
-	printf ("%i threads\n", numthreads);
-//@@
-	usconfig (CONF_INITUSERS, numthreads);
-} //end of the function ThreadSetDefault
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void ThreadLock (void)
-{
-	spin_lock (&lck);
-} //end of the function ThreadLock
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void ThreadUnlock (void)
+static void TaskQueueLock(taskqueue_t *queue)
 {
-	release_lock(&lck);
-} //end of the function ThreadUnlock
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void ThreadSetupLock(void)
-{
-	init_lock (&lck);
-
-	Log_Print("IRIX multi-threading\n");
-
-	threaded = true;
-	currentnumthreads = 0;
-	currentthreadid = 0;
-} //end of the function ThreadInitLock
+	while(!ThreadAtomicCompareExchange(&queue->lock, 0, 1))
+	{
+		ThreadYield();
+	} //end while
+} //end of the function TaskQueueLock
 //===========================================================================
 //
 // Parameter:				-
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
-void ThreadShutdownLock(void)
+static void TaskQueueUnlock(taskqueue_t *queue)
 {
-	threaded = false;
-} //end of the function ThreadShutdownLock
+	ThreadAtomicAdd(&queue->lock, -1);
+} //end of the function TaskQueueUnlock
 //===========================================================================
 //
 // Parameter:				-
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
-void RunThreadsOn (int workcnt, qboolean showpacifier, void(*func)(int))
+static qboolean TaskQueueTake(taskqueue_t *queue, qboolean top, task_t *task)
 {
-	int		i;
-	int		pid[MAX_THREADS];
-	int		start, end;
-
-	start = I_FloatTime ();
-	dispatch = 0;
-	workcount = workcnt;
-	oldf = -1;
-	pacifier = showpacifier;
-	threaded = true;
-
-	if (numthreads < 1 || numthreads > MAX_THREADS) numthreads = 1;
-
-	if (pacifier)
-		setbuf (stdout, NULL);
-
-	init_lock (&lck);
-
-	for (i=0 ; i<numthreads-1 ; i++)
+	TaskQueueLock(queue);
+	if (queue->top == queue->bottom)
 	{
-		pid[i] = sprocsp ( (void (*)(void *, size_t))func, PR_SALL, (void *)i
-			, NULL, 0x100000);
-//		pid[i] = sprocsp ( (void (*)(void *, size_t))func, PR_SALL, (void *)i
-//			, NULL, 0x80000);
-		if (pid[i] == -1)
-		{
-			perror ("sproc");
-			Error ("sproc failed");
-		}
-	}
-		
-	func(i);
-			
-	for (i=0 ; i<numthreads-1 ; i++)
-		wait (NULL);
-
-	threaded = false;
-
-	end = I_FloatTime ();
-	if (pacifier)
-		printf (" (%i)\n", end-start);
-} //end of the function RunThreadsOn
+		TaskQueueUnlock(queue);
+		return false;
+	} //end if
+	if (top) *task = queue->tasks[queue->top++ & (MAX_QUEUEDTASKS - 1)];
+	else *task = queue->tasks[--queue->bottom & (MAX_QUEUEDTASKS - 1)];
+	TaskQueueUnlock(queue);
+	return true;
+} //end of the function TaskQueueTake
 //===========================================================================
 //
 // Parameter:				-
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
-void AddThread(void (*func)(int))
+void AddTask(int threadid, void (*func)(int threadid, void *arg), void *arg)
 {
-	thread_t *thread;
+	taskqueue_t *queue;
+	task_t *task;
 
-	if (numthreads == 1)
+	queue = &taskqueues[threadid];
+	TaskQueueLock(queue);
+	if (queue->bottom - queue->top >= MAX_QUEUEDTASKS)
 	{
-		if (currentnumthreads >= numthreads) return;
-		currentnumthreads++;
-		func(-1);
-		currentnumthreads--;
+		TaskQueueUnlock(queue);
+		//the queue is full so just run the task right away
+		func(threadid, arg);
+		return;
 	} //end if
-	else
-	{
-		ThreadLock();
-		if (currentnumthreads >= numthreads)
-		{
-			ThreadUnlock();
-			return;
-		} //end if
-		//allocate new thread
-		thread = GetMemory(sizeof(thread_t));
-		if (!thread) Error("can't allocate memory for thread\n");
-		//
-		thread->threadid = currentthreadid;
-
-		thread->id = sprocsp ( (void (*)(void *, size_t))func, PR_SALL, (void *)thread->threadid, NULL, 0x100000);
-		if (thread->id == -1)
-		{
-			perror ("sproc");
-			Error ("sproc failed");
-		}
-
-		//add the thread to the end of the list
-		thread->next = NULL;
-		if (lastthread) lastthread->next = thread;
-		else firstthread = thread;
-		lastthread = thread;
-		//
-#ifdef THREAD_DEBUG
-		qprintf("added thread with id %d\n", thread->threadid);
-#endif //THREAD_DEBUG
-		//
-		currentnumthreads++;
-		currentthreadid++;
-		//
-		ThreadUnlock();
-	} //end else
-} //end of the function AddThread
+	//count the task before anyone can take it
+	ThreadAtomicAdd(&numpendingtasks, 1);
+	task = &queue->tasks[queue->bottom & (MAX_QUEUEDTASKS - 1)];
+	task->func = func;
+	task->arg = arg;
+	queue->bottom++;
+	TaskQueueUnlock(queue);
+} //end of the function AddTask
 //===========================================================================
 //
 // Parameter:				-
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
-void RemoveThread(int threadid)
+static void TaskThread(int threadid)
 {
-	thread_t *thread, *last;
+	int i;
+	task_t task;
 
-	//if a single thread
-	if (threadid == -1) return;
-	//
-	ThreadLock();
-	last = NULL;
-	for (thread = firstthread; thread; thread = thread->next)
+	while(1)
 	{
-		if (thread->threadid == threadid)
+		//run our own tasks first
+		if (!TaskQueueTake(&taskqueues[threadid], breadthfirsttasks, &task))
 		{
-			if (last) last->next = thread->next;
-			else firstthread = thread->next;
-			if (!thread->next) lastthread = last;
-			//
-			FreeMemory(thread);
-			currentnumthreads--;
-#ifdef THREAD_DEBUG
-			qprintf("removed thread with id %d\n", threadid);
-#endif //THREAD_DEBUG
-			break;
+			//steal from the other threads
+			for (i = 1; i < numtaskqueues; i++)
+			{
+				if (TaskQueueTake(&taskqueues[(threadid + i) % numtaskqueues], true, &task))
+					break;
+			} //end for
+			if (i >= numtaskqueues)
+			{
+				//done when no task is queued or still running anywhere
+				if (ThreadAtomicAdd(&numpendingtasks, 0) <= 0)
+					break;
+				ThreadYield();
+				continue;
+			} //end if
 		} //end if
-		last = thread;
-	} //end if
-	if (!thread) Error("couldn't find thread with id %d", threadid);
-	ThreadUnlock();
-} //end of the function RemoveThread
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void WaitForAllThreadsFinished(void)
-{
-	ThreadLock();
-	while(firstthread)
-	{
-		ThreadUnlock();
-
-		//wait (NULL);
-
-		ThreadLock();
+		task.func(threadid, task.arg);
+		//the task is finished after the tasks it forked were counted
+		ThreadAtomicAdd(&numpendingtasks, -1);
 	} //end while
-	ThreadUnlock();
-} //end of the function WaitForAllThreadsFinished
+} //end of the function TaskThread
 //===========================================================================
 //
 // Parameter:				-
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
-int GetNumThreads(void)
+void RunTasks(void (*func)(int threadid, void *arg), void *arg, qboolean breadthfirst)
 {
-	return currentnumthreads;
-} //end of the function GetNumThreads
-
-#endif //_MIPS_ISA
-
-
-//=======================================================================
-//
-// SINGLE THREAD
-//
-//=======================================================================
-
-#ifndef USED
-
-int numthreads = 1;
-int currentnumthreads = 0;
-
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void ThreadSetDefault(void)
-{
-	numthreads = 1;
-} //end of the function ThreadSetDefault
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void ThreadLock(void)
-{
-} //end of the function ThreadLock
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void ThreadUnlock(void)
-{
-} //end of the function ThreadUnlock
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void ThreadSetupLock(void)
-{
-	Log_Print("no multi-threading\n");
-} //end of the function ThreadInitLock
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void ThreadShutdownLock(void)
-{
-} //end of the function ThreadShutdownLock
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void ThreadSetupSemaphore(void)
-{
-} //end of the function ThreadSetupSemaphore
-//===========================================================================
-//
-// Parameter:			-
-// Returns:				-
-// Changes Globals:		-
-//===========================================================================
-void ThreadShutdownSemaphore(void)
-{
-} //end of the function ThreadShutdownSemaphore
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void ThreadSemaphoreWait(void)
-{
-} //end of the function ThreadSemaphoreWait
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void ThreadSemaphoreIncrease(int count)
-{
-} //end of the function ThreadSemaphoreIncrease
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void RunThreadsOn(int workcnt, qboolean showpacifier, void(*func)(int))
-{
-	int start, end;
-
-	Log_Print("no multi-threading\n");
-	dispatch = 0;
-	workcount = workcnt;
-	oldf = -1;
-	pacifier = showpacifier;
-	start = I_FloatTime (); 
-#ifdef NeXT
-	if (pacifier)
-		setbuf (stdout, NULL);
-#endif
-	func(0);
-
-	end = I_FloatTime ();
-	if (pacifier)
-		printf (" (%i)\n", end-start);
-} //end of the function RunThreadsOn
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void AddThread(void (*func)(int))
-{
-	if (currentnumthreads >= numthreads) return;
-	currentnumthreads++;
-	func(-1);
-	currentnumthreads--;
-} //end of the function AddThread
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void RemoveThread(int threadid)
-{
-} //end of the function RemoveThread
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-void WaitForAllThreadsFinished(void)
-{
-} //end of the function WaitForAllThreadsFinished
-//===========================================================================
-//
-// Parameter:				-
-// Returns:					-
-// Changes Globals:		-
-//===========================================================================
-int GetNumThreads(void)
-{
-	return currentnumthreads;
-} //end of the function GetNumThreads
+	if (numthreads == -1)
+		ThreadSetDefault();
+	if (numthreads < 1 || numthreads > MAX_THREADS) numthreads = 1;
 
-#endif //USED
+	numtaskqueues = numthreads;
+	taskqueues = GetClearedMemory(numtaskqueues * sizeof(taskqueue_t));
+	numpendingtasks = 0;
+	breadthfirsttasks = breadthfirst;
+	//queue the first task for thread 0
+	AddTask(0, func, arg);
+	//run until all the tasks forked from it are done too
+	RunThreadsOn(0, false, TaskThread);
+	FreeMemory(taskqueues);
+	taskqueues = NULL;
+	numtaskqueues = 0;
+} //end of the function RunTasks
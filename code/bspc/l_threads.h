@@ -40,14 +40,9 @@ void ThreadSetupLock(void);
 void ThreadShutdownLock(void);
 void ThreadLock (void);
 void ThreadUnlock (void);
-//semaphore
-void ThreadSetupSemaphore(void);
-void ThreadShutdownSemaphore(void);
-void ThreadSemaphoreWait(void);
-void ThreadSemaphoreIncrease(int count);
-//add/remove threads
-void AddThread(void (*func)(int));
-void RemoveThread(int threadid);
-void WaitForAllThreadsFinished(void);
-int GetNumThreads(void);
-
+//returns the new value
+int ThreadAtomicAdd(volatile int *value, int add);
+//work-stealing tasks, runs func and all the tasks forked with AddTask
+//from it, returns when they are all finished
+void RunTasks(void (*func)(int threadid, void *arg), void *arg, qboolean breadthfirst);
+void AddTask(int threadid, void (*func)(int threadid, void *arg), void *arg);
@@ -35,6 +35,30 @@ Suite 120, Rockville, Maryland 20850 USA.
 
 #define MAX_RIFF_CHUNKS 16
 
+// encoded video frames that can wait for the writer thread
+#define AVI_FRAME_BUFFERS 3
+
+// chunks that can wait for the writer thread
+#define AVI_MAX_JOBS 16
+
+#define PCM_BUFFER_SIZE 44100
+
+typedef enum
+{
+  AVI_JOB_VIDEO,
+  AVI_JOB_AUDIO,
+  AVI_JOB_QUIT
+} aviJobType_t;
+
+typedef struct aviJob_s
+{
+  aviJobType_t  type;
+  byte          header[ 8 ];
+  const byte    *data;
+  int           size;
+  byte          index[ 16 ];
+} aviJob_t;
+
 typedef struct audioFormat_s
 {
   int rate;
@@ -64,6 +88,7 @@ typedef struct aviFileData_s
   int           numVideoFrames;
   int           maxRecordSize;
   qboolean      motionJpeg;
+  int           jpegQuality;
 
   qboolean      audio;
   audioFormat_t a;
@@ -72,7 +97,29 @@ typedef struct aviFileData_s
   int           chunkStack[ MAX_RIFF_CHUNKS ];
   int           chunkStackTop;
 
-  byte          *cBuffer, *eBuffer;
+  // frames are captured bottom-up RGB without line padding,
+  // then encoded into one of the frame buffers
+  byte          *cBuffer;
+  byte          *frameBuffers;
+  int           frameSize;
+  int           nextFrame;
+  byte          *audioBuffers;
+  qboolean      fileFull;
+
+  // chunks are encoded and laid out on the main thread, the writer thread
+  // only writes them to the files, which it owns while it runs. jobs are
+  // queued in order, so frame and audio buffers are freed in the order
+  // they were used
+  sysThread_t     *thread;
+  sysSemaphore_t  *jobsQueued;
+  sysSemaphore_t  *jobsFree;
+  sysSemaphore_t  *framesFree;
+  aviJob_t        jobs[ AVI_MAX_JOBS ];
+  int             jobHead;
+  int             jobTail;
+
+  // set by the writer thread, reported by the main thread
+  volatile qboolean writeError;
 } aviFileData_t;
 
 static aviFileData_t afd;
@@ -93,6 +140,22 @@ static ID_INLINE void SafeFS_Write( const void *buffer, int len, fileHandle_t f
     Com_Error( ERR_DROP, "Failed to write avi file" );
 }
 
+/*
+===============
+CL_AVIWrite
+
+SafeFS_Write for the writer thread, which can't drop to the console itself
+===============
+*/
+static void CL_AVIWrite( const void *data, int len, fileHandle_t f )
+{
+  if( afd.writeError || len <= 0 )
+    return;
+
+  if( FS_ThreadWrite( data, len, f ) < len )
+    afd.writeError = qtrue;
+}
+
 /*
 ===============
 WRITE_STRING
@@ -321,6 +384,312 @@ void CL_WriteAVIHeader( void )
   }
 }
 
+/*
+===============
+CL_CheckFileSize
+
+Returns qtrue if the chunk doesn't fit in the file,
+CL_CheckAVIWriter then continues with a new one
+===============
+*/
+static qboolean CL_CheckFileSize( int bytesToAdd )
+{
+  unsigned int newFileSize;
+
+  if( afd.fileFull )
+    return qtrue;
+
+  newFileSize =
+    afd.fileSize +                // Current file size
+    bytesToAdd +                  // What we want to add
+    ( afd.numIndices * 16 ) +     // The index
+    4;                            // The index size
+
+  // I assume all the operating systems
+  // we target can handle a 2Gb file
+  if( newFileSize > INT_MAX )
+  {
+    afd.fileFull = qtrue;
+    return qtrue;
+  }
+
+  return qfalse;
+}
+
+/*
+===============
+CL_RunAVIJob
+
+Writes a chunk and its index entry, this is all the writer thread does
+===============
+*/
+static void CL_RunAVIJob( const aviJob_t *job )
+{
+  byte  padding[ 4 ] = { 0 };
+
+  CL_AVIWrite( job->header, sizeof( job->header ), afd.f );
+  CL_AVIWrite( job->data, job->size, afd.f );
+  CL_AVIWrite( padding, PADLEN( job->size, 2 ), afd.f );
+  CL_AVIWrite( job->index, sizeof( job->index ), afd.idxF );
+
+  if( job->type == AVI_JOB_VIDEO && afd.thread )
+    Sys_SemaphorePost( afd.framesFree );
+}
+
+/*
+===============
+CL_AVIWriterThread
+===============
+*/
+static int CL_AVIWriterThread( void *data )
+{
+  aviJob_t *job;
+
+  while( 1 )
+  {
+    Sys_SemaphoreWait( afd.jobsQueued );
+
+    job = &afd.jobs[ afd.jobTail ];
+    if( job->type == AVI_JOB_QUIT )
+      break;
+
+    CL_RunAVIJob( job );
+
+    afd.jobTail = ( afd.jobTail + 1 ) % AVI_MAX_JOBS;
+    Sys_SemaphorePost( afd.jobsFree );
+  }
+
+  return 0;
+}
+
+/*
+===============
+CL_AllocAVIJob
+
+Blocks if the writer thread has fallen too far behind
+===============
+*/
+static aviJob_t *CL_AllocAVIJob( aviJobType_t type )
+{
+  aviJob_t  *job;
+
+  if( afd.thread )
+    Sys_SemaphoreWait( afd.jobsFree );
+
+  job = &afd.jobs[ afd.jobHead ];
+  job->type = type;
+
+  return job;
+}
+
+/*
+===============
+CL_QueueAVIJob
+
+Hands a job from CL_AllocAVIJob to the writer thread.
+Without a writer thread the job is run right away.
+===============
+*/
+static void CL_QueueAVIJob( aviJob_t *job )
+{
+  if( !afd.thread )
+  {
+    CL_RunAVIJob( job );
+    return;
+  }
+
+  afd.jobHead = ( afd.jobHead + 1 ) % AVI_MAX_JOBS;
+  Sys_SemaphorePost( afd.jobsQueued );
+}
+
+/*
+===============
+CL_WriteAVIChunk
+
+Queues a chunk and its index entry, returns qfalse if it doesn't fit
+in the file. Audio data is copied, video frames have to be in one of
+the frame buffers.
+===============
+*/
+static qboolean CL_WriteAVIChunk( aviJobType_t type, const char *tag,
+    int flags, const byte *data, int size )
+{
+  int       chunkOffset = afd.fileSize - afd.moviOffset - 8;
+  int       chunkSize = 8 + size;
+  int       paddingSize = PADLEN(size, 2);
+  aviJob_t  *job;
+  byte      *copy;
+
+  // Chunk header + contents + padding
+  if( CL_CheckFileSize( 8 + size + 2 ) )
+    return qfalse;
+
+  job = CL_AllocAVIJob( type );
+
+  bufIndex = 0;
+  WRITE_STRING( tag );
+  WRITE_4BYTES( size );
+  Com_Memcpy( job->header, buffer, sizeof( job->header ) );
+
+  if( type == AVI_JOB_AUDIO && afd.thread )
+  {
+    copy = afd.audioBuffers + afd.jobHead * PCM_BUFFER_SIZE;
+    Com_Memcpy( copy, data, size );
+    job->data = copy;
+  }
+  else
+    job->data = data;
+
+  job->size = size;
+
+  // Index
+  bufIndex = 0;
+  WRITE_STRING( tag );              //dwIdentifier
+  WRITE_4BYTES( flags );            //dwFlags
+  WRITE_4BYTES( chunkOffset );      //dwOffset
+  WRITE_4BYTES( size );             //dwLength
+  Com_Memcpy( job->index, buffer, sizeof( job->index ) );
+
+  CL_QueueAVIJob( job );
+
+  afd.fileSize += ( chunkSize + paddingSize );
+  afd.moviSize += ( chunkSize + paddingSize );
+  afd.numIndices++;
+
+  return qtrue;
+}
+
+/*
+===============
+CL_WriteAVIVideoFrame
+===============
+*/
+static qboolean CL_WriteAVIVideoFrame( const byte *imageBuffer, int size )
+{
+  // all frames are KeyFrames
+  if( !CL_WriteAVIChunk( AVI_JOB_VIDEO, "00dc", 0x00000010, imageBuffer, size ) )
+    return qfalse;
+
+  afd.numVideoFrames++;
+
+  if( size > afd.maxRecordSize )
+    afd.maxRecordSize = size;
+
+  return qtrue;
+}
+
+/*
+===============
+CL_WriteAVIAudioChunk
+===============
+*/
+static void CL_WriteAVIAudioChunk( const byte *pcmBuffer, int size )
+{
+  if( !CL_WriteAVIChunk( AVI_JOB_AUDIO, "01wb", 0, pcmBuffer, size ) )
+    return;
+
+  afd.numAudioFrames++;
+  afd.a.totalBytes += size;
+}
+
+/*
+===============
+CL_EncodeAVIVideoFrame
+
+Turns the captured frame into the contents of a video chunk
+===============
+*/
+static int CL_EncodeAVIVideoFrame( byte *encoded )
+{
+  int         linelen = afd.width * 3;
+  int         avipadwidth = PAD( linelen, AVI_LINE_PADDING );
+  int         avipadlen = avipadwidth - linelen;
+  const byte  *srcptr, *lineend, *memend;
+  byte        *destptr;
+
+  if( afd.motionJpeg )
+  {
+    return re.SaveJPGToBuffer( encoded, linelen * afd.height,
+        afd.jpegQuality, afd.width, afd.height, afd.cBuffer, 0 );
+  }
+
+  srcptr = afd.cBuffer;
+  destptr = encoded;
+  memend = srcptr + linelen * afd.height;
+
+  // swap R and B and add line paddings
+  while( srcptr < memend )
+  {
+    lineend = srcptr + linelen;
+    while( srcptr < lineend )
+    {
+      *destptr++ = srcptr[2];
+      *destptr++ = srcptr[1];
+      *destptr++ = srcptr[0];
+      srcptr += 3;
+    }
+
+    Com_Memset( destptr, '\0', avipadlen );
+    destptr += avipadlen;
+  }
+
+  return avipadwidth * afd.height;
+}
+
+/*
+===============
+CL_StartAVIWriter
+
+Falls back to writing on the main thread if
+the writer thread can't be started
+===============
+*/
+static void CL_StartAVIWriter( void )
+{
+  afd.jobsQueued = Sys_CreateSemaphore( 0 );
+  afd.jobsFree = Sys_CreateSemaphore( AVI_MAX_JOBS );
+  afd.framesFree = Sys_CreateSemaphore( AVI_FRAME_BUFFERS );
+
+  if( afd.jobsQueued && afd.jobsFree && afd.framesFree )
+    afd.thread = Sys_CreateThread( CL_AVIWriterThread, NULL );
+
+  if( !afd.thread )
+  {
+    Com_Printf( S_COLOR_YELLOW "WARNING: Couldn't start video writer thread\n" );
+
+    if( afd.jobsQueued )
+      Sys_DestroySemaphore( afd.jobsQueued );
+    if( afd.jobsFree )
+      Sys_DestroySemaphore( afd.jobsFree );
+    if( afd.framesFree )
+      Sys_DestroySemaphore( afd.framesFree );
+
+    afd.jobsQueued = afd.jobsFree = afd.framesFree = NULL;
+  }
+}
+
+/*
+===============
+CL_StopAVIWriter
+
+Waits for all queued chunks to be written
+===============
+*/
+static void CL_StopAVIWriter( void )
+{
+  if( !afd.thread )
+    return;
+
+  CL_QueueAVIJob( CL_AllocAVIJob( AVI_JOB_QUIT ) );
+  Sys_WaitThread( afd.thread );
+  afd.thread = NULL;
+
+  Sys_DestroySemaphore( afd.jobsQueued );
+  Sys_DestroySemaphore( afd.jobsFree );
+  Sys_DestroySemaphore( afd.framesFree );
+  afd.jobsQueued = afd.jobsFree = afd.framesFree = NULL;
+}
+
 /*
 ===============
 CL_OpenAVIForWriting
@@ -365,14 +734,22 @@ qboolean CL_OpenAVIForWriting( const char *fileName )
   else
     afd.motionJpeg = qfalse;
 
-  // Capture buffer stores RGB pixels but OpenGL ES reads RGBA and converts to RGB in-place.
-  // Encode buffer only needs to store RGB pixels.
-  // Allocate a bit more space for the capture buffer to account for possible
-  // padding at the end of pixel lines, and padding for alignment
-  #define MAX_PACK_LEN 16
-  afd.cBuffer = Z_Malloc((afd.width * 4 + MAX_PACK_LEN - 1) * afd.height + MAX_PACK_LEN - 1);
+  afd.jpegQuality = Cvar_VariableIntegerValue( "r_aviMotionJpegQuality" );
+
+  // The frame buffers are too big to keep in the zone at high resolutions.
   // raw avi files have pixel lines start on 4-byte boundaries
-  afd.eBuffer = Z_Malloc(PAD(afd.width * 3, AVI_LINE_PADDING) * afd.height);
+  afd.frameSize = PAD( afd.width * 3, AVI_LINE_PADDING ) * afd.height;
+  afd.cBuffer = malloc( afd.width * 3 * afd.height );
+  afd.frameBuffers = malloc( AVI_FRAME_BUFFERS * afd.frameSize );
+  if( !afd.cBuffer || !afd.frameBuffers )
+  {
+    Com_Printf( S_COLOR_RED "ERROR: Couldn't allocate video frame buffers\n" );
+    free( afd.cBuffer );
+    free( afd.frameBuffers );
+    FS_FCloseFile( afd.f );
+    FS_FCloseFile( afd.idxF );
+    return qfalse;
+  }
 
   afd.a.rate = dma.speed;
   afd.a.format = WAV_FORMAT_PCM;
@@ -430,27 +807,31 @@ qboolean CL_OpenAVIForWriting( const char *fileName )
   afd.moviSize = 4; // For the "movi"
   afd.fileOpen = qtrue;
 
+  if( afd.audio )
+    afd.audioBuffers = Z_Malloc( AVI_MAX_JOBS * PCM_BUFFER_SIZE );
+
+  CL_StartAVIWriter( );
+
   return qtrue;
 }
 
 /*
 ===============
-CL_CheckFileSize
+CL_CheckAVIWriter
+
+Handles write errors reported by the writer thread and full
+files, returns qfalse if nothing should be queued this frame
 ===============
 */
-static qboolean CL_CheckFileSize( int bytesToAdd )
+static qboolean CL_CheckAVIWriter( void )
 {
-  unsigned int newFileSize;
-
-  newFileSize =
-    afd.fileSize +                // Current file size
-    bytesToAdd +                  // What we want to add
-    ( afd.numIndices * 16 ) +     // The index
-    4;                            // The index size
+  if( afd.writeError )
+  {
+    CL_CloseAVI( );
+    Com_Error( ERR_DROP, "Failed to write avi file" );
+  }
 
-  // I assume all the operating systems
-  // we target can handle a 2Gb file
-  if( newFileSize > INT_MAX )
+  if( afd.fileFull )
   {
     // Close the current file...
     CL_CloseAVI( );
@@ -458,59 +839,12 @@ static qboolean CL_CheckFileSize( int bytesToAdd )
     // ...And open a new one
     CL_OpenAVIForWriting( va( "%s_", afd.fileName ) );
 
-    return qtrue;
+    return qfalse;
   }
 
-  return qfalse;
-}
-
-/*
-===============
-CL_WriteAVIVideoFrame
-===============
-*/
-void CL_WriteAVIVideoFrame( const byte *imageBuffer, int size )
-{
-  int   chunkOffset = afd.fileSize - afd.moviOffset - 8;
-  int   chunkSize = 8 + size;
-  int   paddingSize = PADLEN(size, 2);
-  byte  padding[ 4 ] = { 0 };
-
-  if( !afd.fileOpen )
-    return;
-
-  // Chunk header + contents + padding
-  if( CL_CheckFileSize( 8 + size + 2 ) )
-    return;
-
-  bufIndex = 0;
-  WRITE_STRING( "00dc" );
-  WRITE_4BYTES( size );
-
-  SafeFS_Write( buffer, 8, afd.f );
-  SafeFS_Write( imageBuffer, size, afd.f );
-  SafeFS_Write( padding, paddingSize, afd.f );
-  afd.fileSize += ( chunkSize + paddingSize );
-
-  afd.numVideoFrames++;
-  afd.moviSize += ( chunkSize + paddingSize );
-
-  if( size > afd.maxRecordSize )
-    afd.maxRecordSize = size;
-
-  // Index
-  bufIndex = 0;
-  WRITE_STRING( "00dc" );           //dwIdentifier
-  WRITE_4BYTES( 0x00000010 );       //dwFlags (all frames are KeyFrames)
-  WRITE_4BYTES( chunkOffset );      //dwOffset
-  WRITE_4BYTES( size );             //dwLength
-  SafeFS_Write( buffer, 16, afd.idxF );
-
-  afd.numIndices++;
+  return qtrue;
 }
 
-#define PCM_BUFFER_SIZE 44100
-
 /*
 ===============
 CL_WriteAVIAudioFrame
@@ -527,8 +861,7 @@ void CL_WriteAVIAudioFrame( const byte *pcmBuffer, int size )
   if( !afd.fileOpen )
     return;
 
-  // Chunk header + contents + padding
-  if( CL_CheckFileSize( 8 + bytesInBuffer + size + 2 ) )
+  if( !CL_CheckAVIWriter( ) )
     return;
 
   if( bytesInBuffer + size > PCM_BUFFER_SIZE )
@@ -545,33 +878,7 @@ void CL_WriteAVIAudioFrame( const byte *pcmBuffer, int size )
   if( bytesInBuffer >= (int)ceil( (float)afd.a.rate / (float)afd.frameRate ) *
         afd.a.sampleSize )
   {
-    int   chunkOffset = afd.fileSize - afd.moviOffset - 8;
-    int   chunkSize = 8 + bytesInBuffer;
-    int   paddingSize = PADLEN(bytesInBuffer, 2);
-    byte  padding[ 4 ] = { 0 };
-
-    bufIndex = 0;
-    WRITE_STRING( "01wb" );
-    WRITE_4BYTES( bytesInBuffer );
-
-    SafeFS_Write( buffer, 8, afd.f );
-    SafeFS_Write( pcmCaptureBuffer, bytesInBuffer, afd.f );
-    SafeFS_Write( padding, paddingSize, afd.f );
-    afd.fileSize += ( chunkSize + paddingSize );
-
-    afd.numAudioFrames++;
-    afd.moviSize += ( chunkSize + paddingSize );
-    afd.a.totalBytes += bytesInBuffer;
-
-    // Index
-    bufIndex = 0;
-    WRITE_STRING( "01wb" );           //dwIdentifier
-    WRITE_4BYTES( 0 );                //dwFlags
-    WRITE_4BYTES( chunkOffset );      //dwOffset
-    WRITE_4BYTES( bytesInBuffer );    //dwLength
-    SafeFS_Write( buffer, 16, afd.idxF );
-
-    afd.numIndices++;
+    CL_WriteAVIAudioChunk( pcmCaptureBuffer, bytesInBuffer );
 
     bytesInBuffer = 0;
   }
@@ -588,8 +895,51 @@ void CL_TakeVideoFrame( void )
   if( !afd.fileOpen )
     return;
 
-  re.TakeVideoFrame( afd.width, afd.height,
-      afd.cBuffer, afd.eBuffer, afd.motionJpeg );
+  if( !CL_CheckAVIWriter( ) )
+    return;
+
+  re.TakeVideoFrame( afd.width, afd.height );
+}
+
+/*
+===============
+CL_BeginAVIVideoFrame
+
+Called by the renderer once a frame has been read back
+===============
+*/
+byte *CL_BeginAVIVideoFrame( int width, int height )
+{
+  if( !afd.fileOpen )
+    return NULL;
+
+  if( width != afd.width || height != afd.height )
+    return NULL;
+
+  return afd.cBuffer;
+}
+
+/*
+===============
+CL_EndAVIVideoFrame
+
+Encodes and queues the frame filled in after CL_BeginAVIVideoFrame,
+blocks if the writer thread has fallen too far behind
+===============
+*/
+void CL_EndAVIVideoFrame( void )
+{
+  byte  *frame;
+
+  if( afd.thread )
+    Sys_SemaphoreWait( afd.framesFree );
+
+  frame = afd.frameBuffers + afd.nextFrame * afd.frameSize;
+
+  if( CL_WriteAVIVideoFrame( frame, CL_EncodeAVIVideoFrame( frame ) ) )
+    afd.nextFrame = ( afd.nextFrame + 1 ) % AVI_FRAME_BUFFERS;
+  else if( afd.thread )
+    Sys_SemaphorePost( afd.framesFree );
 }
 
 /*
@@ -609,8 +959,21 @@ qboolean CL_CloseAVI( void )
   if( !afd.fileOpen )
     return qfalse;
 
+  // Collect the frames the renderer is still reading back and
+  // wait for everything to be written
+  if( re.FinishVideoFrames )
+    re.FinishVideoFrames( );
+
+  CL_StopAVIWriter( );
+
   afd.fileOpen = qfalse;
 
+  if( afd.writeError )
+  {
+    Com_Printf( S_COLOR_YELLOW "WARNING: Couldn't write all frames to %s\n",
+        afd.fileName );
+  }
+
   FS_Seek( afd.idxF, 4, FS_SEEK_SET );
   bufIndex = 0;
   WRITE_4BYTES( indexSize );
@@ -657,8 +1020,10 @@ qboolean CL_CloseAVI( void )
 
   SafeFS_Write( buffer, bufIndex, afd.f );
 
-  Z_Free( afd.cBuffer );
-  Z_Free( afd.eBuffer );
+  free( afd.cBuffer );
+  free( afd.frameBuffers );
+  if( afd.audioBuffers )
+    Z_Free( afd.audioBuffers );
   FS_FCloseFile( afd.f );
 
   Com_Printf( "[skipnotify]Wrote %d:%d frames to %s\n", afd.numVideoFrames, afd.numAudioFrames, afd.fileName );
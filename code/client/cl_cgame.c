@@ -558,6 +558,7 @@ void LAN_LoadCachedServers( void ) {
 		}
 		FS_FCloseFile(fileIn);
 	}
+	CL_InvalidateServerHash();
 }
 
 /*
@@ -615,7 +616,7 @@ LAN_AddServer
 ====================
 */
 static int LAN_AddServer(int source, const char *name, const char *address) {
-	int max, *count, i;
+	int max, *count;
 	netadr_t adr;
 	serverInfo_t *servers = NULL;
 	max = MAX_OTHER_SERVERS;
@@ -638,16 +639,12 @@ static int LAN_AddServer(int source, const char *name, const char *address) {
 	}
 	if (servers && *count < max) {
 		NET_StringToAdr( address, &adr, NA_UNSPEC );
-		for ( i = 0; i < *count; i++ ) {
-			if (NET_CompareAdr(servers[i].adr, adr)) {
-				break;
-			}
-		}
-		if (i >= *count) {
+		if (CL_FindServer(source, &adr) == -1) {
 			servers[*count].adr = adr;
 			Q_strncpyz(servers[*count].hostName, name, sizeof(servers[*count].hostName));
 			servers[*count].visible = qtrue;
 			(*count)++;
+			CL_LinkServer(source, *count - 1);
 			return 1;
 		}
 		return 0;
@@ -689,6 +686,7 @@ static void LAN_RemoveServer(int source, const char *addr) {
 					j++;
 				}
 				(*count)--;
+				CL_InvalidateServerHash();
 				break;
 			}
 		}
@@ -2060,6 +2058,19 @@ void CL_FirstSnapshot( void ) {
 
 	clc.timeDemoBaseTime = cl.snap.serverTime;
 
+	if ( clc.demoplaying ) {
+		if ( !clc.demoFirstServerTime ) {
+			clc.demoFirstServerTime = cl.snap.serverTime;
+		}
+
+		// after restoring a keyframe, read ahead to where demoseek asked for
+		if ( clc.demoSeekTime > cl.snap.serverTime ) {
+			cl.serverTimeDelta = clc.demoSeekTime - cls.realtime;
+			clc.timeDemoBaseTime = clc.demoSeekTime;
+		}
+		clc.demoSeekTime = 0;
+	}
+
 	// if this is the first frame of active play,
 	// execute the contents of activeAction now
 	// this is to allow scripting a timedemo to start right
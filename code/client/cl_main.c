@@ -77,6 +77,7 @@ cvar_t	*cl_showSend;
 cvar_t	*cl_timedemo;
 cvar_t	*cl_timedemoLog;
 cvar_t	*cl_autoRecordDemo;
+cvar_t	*cl_demoKeyframeInterval;
 cvar_t	*cl_aviFrameRate;
 cvar_t	*cl_aviMotionJpeg;
 cvar_t	*cl_forceavidemo;
@@ -99,6 +100,9 @@ cvar_t	*cl_inGameVideo;
 
 cvar_t	*cl_serverStatusResendTime;
 
+cvar_t	*cl_pingRate;
+cvar_t	*cl_pingBurst;
+
 cvar_t	*cl_lanForcePackets;
 
 cvar_t	*cl_guidServerUniq;
@@ -692,6 +696,228 @@ void CL_WriteDemoMessage ( msg_t *msg, int headerBytes ) {
 }
 
 
+/*
+====================
+CL_WriteDemoGamestate
+
+Writes the current configstrings and baselines as a gamestate message
+====================
+*/
+static void CL_WriteDemoGamestate( fileHandle_t f, int sequence ) {
+	byte		bufData[MAX_MSGLEN];
+	msg_t		buf;
+	int			i;
+	int			len;
+	sharedEntityState_t	*ent;
+	char		*s;
+
+	MSG_Init (&buf, bufData, sizeof(bufData));
+	MSG_Bitstream(&buf);
+
+	// NOTE, MRE: all server->client messages now acknowledge
+	MSG_WriteLong( &buf, clc.reliableSequence );
+
+	MSG_WriteByte (&buf, svc_gamestate);
+	MSG_WriteLong (&buf, clc.serverCommandSequence );
+
+	// configstrings
+	for ( i = 0 ; i < MAX_CONFIGSTRINGS ; i++ ) {
+		if ( !cl.gameState.stringOffsets[i] ) {
+			continue;
+		}
+		s = cl.gameState.stringData + cl.gameState.stringOffsets[i];
+		MSG_WriteByte (&buf, svc_configstring);
+		MSG_WriteShort (&buf, i);
+		MSG_WriteBigString (&buf, s);
+	}
+
+	MSG_WriteByte( &buf, svc_EOF );
+
+	for ( i = 0; i < MAX_SPLITVIEW; i++ ) {
+		MSG_WriteLong(&buf, clc.playerNums[i]);
+	}
+
+	// finished writing the gamestate stuff
+
+	// write initial baselines
+	for ( i = 0; i < MAX_GENTITIES ; i++ ) {
+		ent = (sharedEntityState_t *)DA_ElementPointer( cl.entityBaselines, i );
+		if ( !ent->number ) {
+			continue;
+		}
+		MSG_WriteByte (&buf, svc_baseline);		
+		MSG_WriteDeltaEntity (&buf, NULL, ent, qtrue );
+	}
+
+	// finished writing the client packet
+	MSG_WriteByte( &buf, svc_EOF );
+
+	// write it to the demo file
+	len = LittleLong( sequence );
+	FS_Write (&len, 4, f);
+
+	len = LittleLong (buf.cursize);
+	FS_Write (&len, 4, f);
+	FS_Write (buf.data, buf.cursize, f);
+}
+
+/*
+====================
+CL_WriteDemoSnapshot
+
+Writes a snapshot message delta compressed from an older one, or from the
+baselines if from is NULL, the same way the server would have sent it
+====================
+*/
+static void CL_WriteDemoSnapshot( fileHandle_t f, clSnapshot_t *from, clSnapshot_t *to ) {
+	byte		bufData[MAX_MSGLEN];
+	msg_t		buf;
+	sharedEntityState_t	*oldent, *newent;
+	int			oldindex, newindex;
+	int			oldnum, newnum;
+	int			fromNumEntities;
+	int			i, len;
+
+	MSG_Init( &buf, bufData, sizeof( bufData ) );
+	MSG_Bitstream( &buf );
+
+	MSG_WriteLong( &buf, clc.reliableSequence );
+
+	MSG_WriteByte( &buf, svc_snapshot );
+	MSG_WriteLong( &buf, to->serverTime );
+	MSG_WriteByte( &buf, from ? to->messageNum - from->messageNum : 0 );
+	MSG_WriteByte( &buf, to->snapFlags );
+
+	MSG_WriteByte( &buf, to->numPSs );
+	for ( i = 0; i < MAX_SPLITVIEW; i++ ) {
+		MSG_WriteByte( &buf, to->localPlayerIndex[i] );
+		MSG_WriteByte( &buf, to->playerNums[i] );
+
+		MSG_WriteByte( &buf, sizeof( to->areamask[i] ) );
+		MSG_WriteData( &buf, to->areamask[i], sizeof( to->areamask[i] ) );
+	}
+
+	for ( i = 0; i < MAX_SPLITVIEW; i++ ) {
+		if ( to->localPlayerIndex[i] == -1 ) {
+			continue;
+		}
+
+		if ( from && from->localPlayerIndex[i] != -1 ) {
+			MSG_WriteDeltaPlayerstate( &buf, DA_ElementPointer( from->playerStates, from->localPlayerIndex[i] ),
+											DA_ElementPointer( to->playerStates, to->localPlayerIndex[i] ) );
+		} else {
+			MSG_WriteDeltaPlayerstate( &buf, NULL, DA_ElementPointer( to->playerStates, to->localPlayerIndex[i] ) );
+		}
+	}
+
+	// same as SV_EmitPacketEntities
+	fromNumEntities = from ? from->numEntities : 0;
+	newent = oldent = NULL;
+	newindex = oldindex = 0;
+	while ( newindex < to->numEntities || oldindex < fromNumEntities ) {
+		if ( newindex >= to->numEntities ) {
+			newnum = 9999;
+		} else {
+			newent = CL_ParseEntityState( to->parseEntitiesNum + newindex );
+			newnum = newent->number;
+		}
+
+		if ( oldindex >= fromNumEntities ) {
+			oldnum = 9999;
+		} else {
+			oldent = CL_ParseEntityState( from->parseEntitiesNum + oldindex );
+			oldnum = oldent->number;
+		}
+
+		if ( newnum == oldnum ) {
+			MSG_WriteDeltaEntity( &buf, oldent, newent, qfalse );
+			oldindex++;
+			newindex++;
+		} else if ( newnum < oldnum ) {
+			MSG_WriteDeltaEntity( &buf, DA_ElementPointer( cl.entityBaselines, newnum ), newent, qtrue );
+			newindex++;
+		} else {
+			MSG_WriteDeltaEntity( &buf, oldent, NULL, qtrue );
+			oldindex++;
+		}
+	}
+
+	MSG_WriteBits( &buf, (MAX_GENTITIES-1), GENTITYNUM_BITS );
+
+	MSG_WriteByte( &buf, svc_EOF );
+
+	len = LittleLong( to->messageNum );
+	FS_Write( &len, 4, f );
+
+	len = LittleLong( buf.cursize );
+	FS_Write( &len, 4, f );
+	FS_Write( buf.data, buf.cursize, f );
+}
+
+/*
+====================
+CL_WriteDemoKeyframe
+
+Called after a message has been written to the demo. Every
+cl_demoKeyframeInterval seconds the current state is written to the demo
+index so playback can seek here without replaying everything before it.
+
+All valid snapshots still in the backup are written, the oldest without
+delta compression, so the deltas in the messages that follow in the demo
+can find their source frames.
+====================
+*/
+void CL_WriteDemoKeyframe( void ) {
+	clSnapshot_t	*snap, *prev;
+	int				i, value;
+
+	if ( !clc.demoIndexFile || cl_demoKeyframeInterval->value <= 0 ) {
+		return;
+	}
+
+	// only when this message carried a new snapshot
+	if ( !cl.snap.valid || cl.snap.messageNum != clc.serverMessageSequence
+		|| ( cl.snap.snapFlags & SNAPFLAG_NOT_ACTIVE ) ) {
+		return;
+	}
+
+	if ( clc.demoNextKeyframeTime && cl.snap.serverTime < clc.demoNextKeyframeTime ) {
+		return;
+	}
+
+	clc.demoNextKeyframeTime = cl.snap.serverTime + cl_demoKeyframeInterval->value * 1000;
+
+	value = LittleLong( cl.snap.serverTime );
+	FS_Write( &value, 4, clc.demoIndexFile );
+	value = LittleLong( FS_FTell( clc.demofile ) );
+	FS_Write( &value, 4, clc.demoIndexFile );
+
+	prev = NULL;
+	for ( i = cl.snap.messageNum - PACKET_BACKUP + 1; i <= cl.snap.messageNum; i++ ) {
+		snap = &cl.snapshots[i & PACKET_MASK];
+
+		if ( !snap->valid || snap->messageNum != i ) {
+			continue;
+		}
+
+		// entities already overwritten in the parse buffer
+		if ( cl.parseEntitiesNum - snap->parseEntitiesNum > cl.parseEntities.maxElements - MAX_SNAPSHOT_ENTITIES * CL_MAX_SPLITVIEW ) {
+			continue;
+		}
+
+		if ( !prev ) {
+			CL_WriteDemoGamestate( clc.demoIndexFile, i - 1 );
+		}
+
+		CL_WriteDemoSnapshot( clc.demoIndexFile, prev, snap );
+		prev = snap;
+	}
+
+	value = -1;
+	FS_Write( &value, 4, clc.demoIndexFile );
+	FS_Write( &value, 4, clc.demoIndexFile );
+}
+
 /*
 ====================
 CL_StopRecording_f
@@ -737,6 +963,12 @@ void CL_StopRecord_f( void ) {
 
 	FS_FCloseFile (clc.demofile);
 	clc.demofile = 0;
+
+	if ( clc.demoIndexFile ) {
+		FS_FCloseFile( clc.demoIndexFile );
+		clc.demoIndexFile = 0;
+	}
+
 	clc.demorecording = qfalse;
 	Com_Printf ("Stopped demo.\n");
 }
@@ -776,11 +1008,6 @@ Begins recording a demo from the current position
 static char		demoName[MAX_QPATH];	// compiler bug workaround
 void CL_Record_f( void ) {
 	char		name[MAX_OSPATH];
-	byte		bufData[MAX_MSGLEN];
-	msg_t	buf;
-	int			i;
-	int			len;
-	sharedEntityState_t	*ent;
 	char		*s;
 	demoHeader_t	header;
 	qtime_t			now;
@@ -865,54 +1092,19 @@ void CL_Record_f( void ) {
 	FS_Write (&header, sizeof(header), clc.demofile);
 
 	// write out the gamestate message
-	MSG_Init (&buf, bufData, sizeof(bufData));
-	MSG_Bitstream(&buf);
-
-	// NOTE, MRE: all server->client messages now acknowledge
-	MSG_WriteLong( &buf, clc.reliableSequence );
-
-	MSG_WriteByte (&buf, svc_gamestate);
-	MSG_WriteLong (&buf, clc.serverCommandSequence );
-
-	// configstrings
-	for ( i = 0 ; i < MAX_CONFIGSTRINGS ; i++ ) {
-		if ( !cl.gameState.stringOffsets[i] ) {
-			continue;
-		}
-		s = cl.gameState.stringData + cl.gameState.stringOffsets[i];
-		MSG_WriteByte (&buf, svc_configstring);
-		MSG_WriteShort (&buf, i);
-		MSG_WriteBigString (&buf, s);
-	}
+	CL_WriteDemoGamestate( clc.demofile, clc.serverMessageSequence - 1 );
 
-	MSG_WriteByte( &buf, svc_EOF );
+	// keyframes for seeking go to a file next to the demo
+	clc.demoIndexFile = FS_FOpenFileWrite( va( "%s.idx", name ) );
+	if ( clc.demoIndexFile ) {
+		demoIndexHeader_t	indexHeader;
 
-	for ( i = 0; i < MAX_SPLITVIEW; i++ ) {
-		MSG_WriteLong(&buf, clc.playerNums[i]);
-	}
-
-	// finished writing the gamestate stuff
-
-	// write initial baselines
-	for ( i = 0; i < MAX_GENTITIES ; i++ ) {
-		ent = (sharedEntityState_t *)DA_ElementPointer( cl.entityBaselines, i );
-		if ( !ent->number ) {
-			continue;
-		}
-		MSG_WriteByte (&buf, svc_baseline);		
-		MSG_WriteDeltaEntity (&buf, NULL, ent, qtrue );
+		Com_Memcpy( indexHeader.magic, DEMO_INDEX_MAGIC, sizeof ( indexHeader.magic ) );
+		indexHeader.version = LittleLong( DEMO_INDEX_VERSION );
+		indexHeader.protocol = header.protocol;
+		FS_Write( &indexHeader, sizeof( indexHeader ), clc.demoIndexFile );
 	}
-
-	// finished writing the client packet
-	MSG_WriteByte( &buf, svc_EOF );
-
-	// write it to the demo file
-	len = LittleLong( clc.serverMessageSequence - 1 );
-	FS_Write (&len, 4, clc.demofile);
-
-	len = LittleLong (buf.cursize);
-	FS_Write (&len, 4, clc.demofile);
-	FS_Write (buf.data, buf.cursize, clc.demofile);
+	clc.demoNextKeyframeTime = 0;
 
 	// the rest of the demo file will be copied from net messages
 }
@@ -1033,14 +1225,18 @@ void CL_ReadDemoMessage( void ) {
 	msg_t		buf;
 	byte		bufData[ MAX_MSGLEN ];
 	int			s;
+	fileHandle_t	f;
 
 	if ( !clc.demofile ) {
 		CL_DemoCompleted ();
 		return;
 	}
 
+	// a restored keyframe is read from the index before going on with the demo
+	f = clc.demoReadingKeyframe ? clc.demoIndexFile : clc.demofile;
+
 	// get the sequence number
-	r = FS_Read( &s, 4, clc.demofile);
+	r = FS_Read( &s, 4, f);
 	if ( r != 4 ) {
 		CL_DemoCompleted ();
 		return;
@@ -1051,20 +1247,25 @@ void CL_ReadDemoMessage( void ) {
 	MSG_Init( &buf, bufData, sizeof( bufData ) );
 
 	// get the length
-	r = FS_Read (&buf.cursize, 4, clc.demofile);
+	r = FS_Read (&buf.cursize, 4, f);
 	if ( r != 4 ) {
 		CL_DemoCompleted ();
 		return;
 	}
 	buf.cursize = LittleLong( buf.cursize );
 	if ( buf.cursize == -1 ) {
+		if ( clc.demoReadingKeyframe ) {
+			clc.demoReadingKeyframe = qfalse;
+			CL_ReadDemoMessage();
+			return;
+		}
 		CL_DemoCompleted ();
 		return;
 	}
 	if ( buf.cursize > buf.maxsize ) {
 		Com_Error (ERR_DROP, "CL_ReadDemoMessage: demoMsglen > MAX_MSGLEN");
 	}
-	r = FS_Read( buf.data, buf.cursize, clc.demofile );
+	r = FS_Read( buf.data, buf.cursize, f );
 	if ( r != buf.cursize ) {
 		Com_Printf( "Demo file was truncated.\n");
 		CL_DemoCompleted ();
@@ -1200,19 +1401,215 @@ qboolean CL_ValidDemoFile( const char *demoName, int *pProtocol, int *pLength, f
 
 /*
 ====================
-CL_CompleteDemoName
+CL_CompleteDemoName
+====================
+*/
+static void CL_CompleteDemoName( char *args, int argNum )
+{
+	if( argNum == 2 )
+	{
+		char dotdemoext[MAX_QPATH];
+
+		Com_sprintf( dotdemoext, sizeof (dotdemoext), ".%s", com_demoext->string );
+
+		Field_CompleteFilename( "demos", dotdemoext, qtrue, qtrue );
+	}
+}
+
+/*
+=======================================================================
+
+DEMO SEEKING
+
+=======================================================================
+*/
+
+#define MAX_DEMO_KEYFRAMES	4096
+
+typedef struct {
+	int		serverTime;
+	int		demoOffset;		// where the demo continues after the keyframe
+	int		indexOffset;	// start of the keyframe messages in the index
+} demoKeyframe_t;
+
+static demoKeyframe_t	demoKeyframes[MAX_DEMO_KEYFRAMES];
+static int				numDemoKeyframes;
+
+/*
+====================
+CL_OpenDemoIndex
+
+Opens the keyframe index next to the demo being played, if there is one,
+and reads the keyframe positions
+====================
+*/
+static void CL_OpenDemoIndex( const char *demoName, int protocol ) {
+	char				name[MAX_OSPATH];
+	char				dotdemoext[MAX_QPATH];
+	demoIndexHeader_t	header;
+	demoKeyframe_t		*key;
+	int					values[2];
+	int					length;
+
+	numDemoKeyframes = 0;
+	clc.demoIndexFile = 0;
+
+	if ( Sys_PathIsAbsolute( demoName ) ) {
+		length = FS_System_FOpenFileRead( va( "%s.idx", demoName ), &clc.demoIndexFile );
+	} else {
+		Com_sprintf( name, sizeof(name), "demos/%s", demoName );
+		Com_sprintf( dotdemoext, sizeof(dotdemoext), ".%s", com_demoext->string );
+		COM_DefaultExtension( name, sizeof(name), dotdemoext );
+		Q_strcat( name, sizeof(name), ".idx" );
+		length = FS_FOpenFileRead( name, &clc.demoIndexFile, qtrue );
+	}
+
+	if ( !clc.demoIndexFile ) {
+		return;
+	}
+
+	if ( length < sizeof( header ) || FS_Read( &header, sizeof( header ), clc.demoIndexFile ) != sizeof( header )
+		|| memcmp( header.magic, DEMO_INDEX_MAGIC, sizeof( header.magic ) )
+		|| LittleLong( header.version ) != DEMO_INDEX_VERSION || LittleLong( header.protocol ) != protocol ) {
+		Com_Printf( "Ignoring invalid demo index\n" );
+		FS_FCloseFile( clc.demoIndexFile );
+		clc.demoIndexFile = 0;
+		return;
+	}
+
+	while ( numDemoKeyframes < MAX_DEMO_KEYFRAMES ) {
+		if ( FS_Read( values, sizeof( values ), clc.demoIndexFile ) != sizeof( values ) ) {
+			break;
+		}
+
+		key = &demoKeyframes[numDemoKeyframes];
+		key->serverTime = LittleLong( values[0] );
+		key->demoOffset = LittleLong( values[1] );
+		key->indexOffset = FS_FTell( clc.demoIndexFile );
+
+		// skip the messages
+		while ( 1 ) {
+			if ( FS_Read( values, sizeof( values ), clc.demoIndexFile ) != sizeof( values ) ) {
+				values[1] = -2;
+				break;
+			}
+			values[1] = LittleLong( values[1] );
+			if ( values[1] < 0 || values[1] > MAX_MSGLEN ) {
+				break;
+			}
+			FS_Seek( clc.demoIndexFile, values[1], FS_SEEK_CUR );
+		}
+
+		// a keyframe cut short by a crash isn't usable
+		if ( values[1] != -1 || key->demoOffset < clc.demoMessagesOffset || key->demoOffset > clc.demoLength ) {
+			break;
+		}
+
+		numDemoKeyframes++;
+	}
+
+	Com_DPrintf( "Demo index has %d keyframes\n", numDemoKeyframes );
+}
+
+/*
+====================
+CL_DemoSeek
+
+Seeks the playing demo to serverTime. Going back, or past the next keyframe,
+restores the nearest keyframe before serverTime (or restarts the demo if
+there is none) and fast forwards the rest of the way.
+====================
+*/
+static void CL_DemoSeek( int serverTime ) {
+	demoKeyframe_t	*key;
+	int				i;
+
+	key = NULL;
+	for ( i = 0; i < numDemoKeyframes; i++ ) {
+		if ( demoKeyframes[i].serverTime > serverTime ) {
+			break;
+		}
+		key = &demoKeyframes[i];
+	}
+
+	// close enough to just read ahead
+	if ( serverTime >= cl.serverTime && ( !key || key->serverTime <= cl.snap.serverTime ) ) {
+		cl.serverTimeDelta += serverTime - cl.serverTime;
+		clc.timeDemoBaseTime += serverTime - cl.serverTime;
+		return;
+	}
+
+	if ( key ) {
+		FS_Seek( clc.demoIndexFile, key->indexOffset, FS_SEEK_SET );
+		FS_Seek( clc.demofile, key->demoOffset, FS_SEEK_SET );
+		clc.demoReadingKeyframe = qtrue;
+	} else {
+		FS_Seek( clc.demofile, clc.demoMessagesOffset, FS_SEEK_SET );
+		clc.demoReadingKeyframe = qfalse;
+	}
+
+	// CL_FirstSnapshot moves the time ahead to here
+	clc.demoSeekTime = serverTime;
+
+	// same as starting the demo, the gamestate reloads the cgame
+	clc.state = CA_CONNECTED;
+	while ( clc.state >= CA_CONNECTED && clc.state < CA_PRIMED ) {
+		CL_ReadDemoMessage();
+	}
+	clc.firstDemoFrameSkipped = qfalse;
+}
+
+/*
+====================
+CL_DemoSeek_f
+
+demoseek [+|-]<seconds|minutes:seconds>
+
+Absolute times are from the start of the demo
 ====================
 */
-static void CL_CompleteDemoName( char *args, int argNum )
-{
-	if( argNum == 2 )
-	{
-		char dotdemoext[MAX_QPATH];
+void CL_DemoSeek_f( void ) {
+	const char	*s;
+	int			time, sign;
 
-		Com_sprintf( dotdemoext, sizeof (dotdemoext), ".%s", com_demoext->string );
+	if ( Cmd_Argc() != 2 ) {
+		Com_Printf( "demoseek [+|-]<seconds|minutes:seconds>\n" );
+		return;
+	}
 
-		Field_CompleteFilename( "demos", dotdemoext, qtrue, qtrue );
+	if ( !clc.demoplaying || clc.state != CA_ACTIVE ) {
+		Com_Printf( "Not playing a demo.\n" );
+		return;
+	}
+
+	s = Cmd_Argv( 1 );
+
+	sign = 0;
+	if ( *s == '+' ) {
+		sign = 1;
+		s++;
+	} else if ( *s == '-' ) {
+		sign = -1;
+		s++;
 	}
+
+	if ( strchr( s, ':' ) ) {
+		time = ( atoi( s ) * 60 + atof( strchr( s, ':' ) + 1 ) ) * 1000;
+	} else {
+		time = atof( s ) * 1000;
+	}
+
+	if ( sign ) {
+		time = cl.serverTime + sign * time;
+	} else {
+		time += clc.demoFirstServerTime;
+	}
+
+	if ( time < clc.demoFirstServerTime ) {
+		time = clc.demoFirstServerTime;
+	}
+
+	CL_DemoSeek( time );
 }
 
 /*
@@ -1250,6 +1647,10 @@ void CL_PlayDemo( const char *demoName ) {
 
 	Com_Printf( "Loading demo '%s' recorded from %s to %s (%d seconds)\n", demoName, startTime, endTime, runTime / 1000 );
 
+	// CL_ValidDemoFile leaves the file at the first message
+	clc.demoMessagesOffset = FS_FTell( clc.demofile );
+	CL_OpenDemoIndex( demoName, protocol );
+
 	Q_strncpyz( clc.demoName, demoName, sizeof( clc.demoName ) );
 
 	Con_Close();
@@ -1676,6 +2077,12 @@ void CL_Disconnect( qboolean showMainMenu ) {
 		clc.demofile = 0;
 	}
 
+	if ( clc.demoIndexFile ) {
+		FS_FCloseFile( clc.demoIndexFile );
+		clc.demoIndexFile = 0;
+	}
+	numDemoKeyframes = 0;
+
 	if ( cgvm && showMainMenu ) {
 		CL_ShowMainMenu();
 	}
@@ -2580,6 +2987,243 @@ void CL_MotdPacket( netadr_t from ) {
 #endif
 }
 
+/*
+=======================================================================
+
+SERVER ADDRESS HASH
+
+Maps a server address to its entries in the local, favorite and global
+server lists so ping and info responses don't scan thousands of servers.
+Each entry is identified by a server id that encodes its source and index.
+
+=======================================================================
+*/
+
+#define SERVER_HASH_SIZE	8192	// must be a power of two
+#define MAX_SERVER_IDS		( MAX_OTHER_SERVERS * 2 + MAX_GLOBAL_SERVERS )
+
+static int		cl_serverHash[SERVER_HASH_SIZE];		// first server id in each bucket, -1 if empty
+static int		cl_serverHashNext[MAX_SERVER_IDS];
+static int		cl_serverHashCount[AS_NUM_SOURCES];		// servers linked from each list
+static qboolean	cl_serverHashValid;
+
+static const int cl_serverIdBase[AS_NUM_SOURCES] = {
+	0,							// AS_LOCAL
+	MAX_OTHER_SERVERS,			// AS_FAVORITES
+	MAX_OTHER_SERVERS * 2		// AS_GLOBAL
+};
+
+/*
+===================
+CL_ServerList
+
+Returns the server list for a source and the number of entries in use
+===================
+*/
+static serverInfo_t *CL_ServerList( int source, int *count ) {
+	switch ( source ) {
+		case AS_LOCAL:
+			*count = cls.numlocalservers;
+			return cls.localServers;
+		case AS_FAVORITES:
+			*count = cls.numfavoriteservers;
+			return cls.favoriteServers;
+		case AS_GLOBAL:
+			*count = cls.numglobalservers;
+			return cls.globalServers;
+		default:
+			*count = 0;
+			return NULL;
+	}
+}
+
+/*
+===================
+CL_ServerForId
+===================
+*/
+static serverInfo_t *CL_ServerForId( int id ) {
+	serverInfo_t	*servers;
+	int				source, count;
+
+	for ( source = AS_NUM_SOURCES - 1; source >= 0; source-- ) {
+		if ( id >= cl_serverIdBase[source] ) {
+			break;
+		}
+	}
+
+	servers = CL_ServerList( source, &count );
+	if ( !servers || id - cl_serverIdBase[source] >= count ) {
+		// stale id left from a list that has since shrunk
+		return NULL;
+	}
+
+	return &servers[id - cl_serverIdBase[source]];
+}
+
+/*
+===================
+CL_HashServerAddress
+===================
+*/
+static int CL_HashServerAddress( const netadr_t *adr ) {
+	unsigned	hash;
+	int			i;
+
+	hash = adr->type;
+
+	// must agree with NET_CompareAdr, which ignores everything
+	// but the type for non-IP addresses
+	if ( adr->type == NA_IP ) {
+		for ( i = 0; i < sizeof( adr->ip ); i++ ) {
+			hash = hash * 31 + adr->ip[i];
+		}
+		hash = hash * 31 + adr->port;
+	} else if ( adr->type == NA_IP6 ) {
+		for ( i = 0; i < sizeof( adr->ip6 ); i++ ) {
+			hash = hash * 31 + adr->ip6[i];
+		}
+		hash = hash * 31 + adr->port;
+	}
+
+	hash ^= hash >> 15;
+	hash *= 0x2c1b3c6d;
+	hash ^= hash >> 12;
+
+	return hash & ( SERVER_HASH_SIZE - 1 );
+}
+
+/*
+===================
+CL_InvalidateServerHash
+
+Call after entries were removed, reordered or had their address
+replaced; the hash is rebuilt on the next lookup
+===================
+*/
+void CL_InvalidateServerHash( void ) {
+	cl_serverHashValid = qfalse;
+}
+
+/*
+===================
+CL_RebuildServerHash
+===================
+*/
+static void CL_RebuildServerHash( void ) {
+	serverInfo_t	*servers;
+	int				source, count, i, id, hash;
+
+	for ( i = 0; i < SERVER_HASH_SIZE; i++ ) {
+		cl_serverHash[i] = -1;
+	}
+
+	for ( source = 0; source < AS_NUM_SOURCES; source++ ) {
+		servers = CL_ServerList( source, &count );
+
+		for ( i = 0; i < count; i++ ) {
+			id = cl_serverIdBase[source] + i;
+			hash = CL_HashServerAddress( &servers[i].adr );
+			cl_serverHashNext[id] = cl_serverHash[hash];
+			cl_serverHash[hash] = id;
+		}
+
+		cl_serverHashCount[source] = MAX( count, 0 );
+	}
+
+	cl_serverHashValid = qtrue;
+}
+
+/*
+===================
+CL_LinkServer
+
+Adds a server that was just appended to the end of a list
+===================
+*/
+void CL_LinkServer( int source, int index ) {
+	serverInfo_t	*servers;
+	int				count, id, hash;
+
+	if ( !cl_serverHashValid ) {
+		// it will be picked up by the rebuild
+		return;
+	}
+
+	servers = CL_ServerList( source, &count );
+	if ( !servers || index != cl_serverHashCount[source] || index >= count ) {
+		// the list changed behind our back
+		cl_serverHashValid = qfalse;
+		return;
+	}
+
+	id = cl_serverIdBase[source] + index;
+	hash = CL_HashServerAddress( &servers[index].adr );
+	cl_serverHashNext[id] = cl_serverHash[hash];
+	cl_serverHash[hash] = id;
+
+	cl_serverHashCount[source]++;
+}
+
+/*
+===================
+CL_FirstServerId
+
+Returns the first server id in the bucket for an address, walk the
+chain with cl_serverHashNext and compare addresses
+===================
+*/
+static int CL_FirstServerId( const netadr_t *adr ) {
+	int source, count;
+
+	if ( cl_serverHashValid ) {
+		// lists can also be cleared without notice
+		for ( source = 0; source < AS_NUM_SOURCES; source++ ) {
+			CL_ServerList( source, &count );
+			if ( MAX( count, 0 ) != cl_serverHashCount[source] ) {
+				cl_serverHashValid = qfalse;
+				break;
+			}
+		}
+	}
+
+	if ( !cl_serverHashValid ) {
+		CL_RebuildServerHash();
+	}
+
+	return cl_serverHash[CL_HashServerAddress( adr )];
+}
+
+/*
+===================
+CL_FindServer
+
+Returns the index of the server with the address in the list
+for source, or -1 if it isn't there
+===================
+*/
+int CL_FindServer( int source, const netadr_t *adr ) {
+	serverInfo_t	*server;
+	int				id;
+
+	if ( source < 0 || source >= AS_NUM_SOURCES ) {
+		return -1;
+	}
+
+	for ( id = CL_FirstServerId( adr ); id != -1; id = cl_serverHashNext[id] ) {
+		if ( id < cl_serverIdBase[source] || ( source + 1 < AS_NUM_SOURCES && id >= cl_serverIdBase[source + 1] ) ) {
+			continue;
+		}
+
+		server = CL_ServerForId( id );
+		if ( server && NET_CompareAdr( server->adr, *adr ) ) {
+			return id - cl_serverIdBase[source];
+		}
+	}
+
+	return -1;
+}
+
 /*
 ===================
 CL_InitServerInfo
@@ -2609,7 +3253,7 @@ CL_ServersResponsePacket
 ===================
 */
 void CL_ServersResponsePacket( const netadr_t* from, msg_t *msg, qboolean extended ) {
-	int				i, j, count, total;
+	int				i, count, total;
 	netadr_t addresses[MAX_SERVERSPERPACKET];
 	int				numservers;
 	byte*			buffptr;
@@ -2693,18 +3337,13 @@ void CL_ServersResponsePacket( const netadr_t* from, msg_t *msg, qboolean extend
 		// Tequila: It's possible to have sent many master server requests. Then
 		// we may receive many times the same addresses from the master server.
 		// We just avoid to add a server if it is still in the global servers list.
-		for (j = 0; j < count; j++)
-		{
-			if (NET_CompareAdr(cls.globalServers[j].adr, addresses[i]))
-				break;
-		}
-
-		if (j < count)
+		if (CL_FindServer(AS_GLOBAL, &addresses[i]) != -1)
 			continue;
 
 		CL_InitServerInfo( server, &addresses[i] );
 		// advance to next slot
-		count++;
+		cls.numglobalservers = ++count;
+		CL_LinkServer( AS_GLOBAL, count - 1 );
 	}
 
 	// if getting the global list
@@ -2969,6 +3608,7 @@ void CL_PacketEvent( netadr_t from, msg_t *msg ) {
 	//
 	if ( clc.demorecording && !clc.demowaiting ) {
 		CL_WriteDemoMessage( msg, headerBytes );
+		CL_WriteDemoKeyframe();
 	}
 }
 
@@ -3356,7 +3996,8 @@ void CL_InitRef( void ) {
 	ri.CIN_PlayCinematic = CIN_PlayCinematic;
 	ri.CIN_RunCinematic = CIN_RunCinematic;
   
-	ri.CL_WriteAVIVideoFrame = CL_WriteAVIVideoFrame;
+	ri.CL_BeginAVIVideoFrame = CL_BeginAVIVideoFrame;
+	ri.CL_EndAVIVideoFrame = CL_EndAVIVideoFrame;
 	ri.CL_MaxSplitView = CL_MaxSplitView;
 	ri.CL_GetMapTitle = CL_GetMapTitle;
 	ri.CL_GetLocalPlayerLocation = CL_GetLocalPlayerLocation;
@@ -3532,6 +4173,7 @@ void CL_Init( void ) {
 	cl_timedemo = Cvar_Get ("timedemo", "0", 0);
 	cl_timedemoLog = Cvar_Get ("cl_timedemoLog", "", CVAR_ARCHIVE);
 	cl_autoRecordDemo = Cvar_Get ("cl_autoRecordDemo", "0", CVAR_ARCHIVE);
+	cl_demoKeyframeInterval = Cvar_Get ("cl_demoKeyframeInterval", "10", CVAR_ARCHIVE);
 	cl_aviFrameRate = Cvar_Get ("cl_aviFrameRate", "25", CVAR_ARCHIVE);
 	cl_aviMotionJpeg = Cvar_Get ("cl_aviMotionJpeg", "1", CVAR_ARCHIVE);
 	cl_forceavidemo = Cvar_Get ("cl_forceavidemo", "0", 0);
@@ -3579,6 +4221,8 @@ void CL_Init( void ) {
 	cl_motdString = Cvar_Get( "cl_motdString", "", CVAR_ROM );
 
 	Cvar_Get( "cl_maxPing", "800", CVAR_ARCHIVE );
+	cl_pingRate = Cvar_Get( "cl_pingRate", "200", CVAR_ARCHIVE );
+	cl_pingBurst = Cvar_Get( "cl_pingBurst", "32", CVAR_ARCHIVE );
 
 	cl_lanForcePackets = Cvar_Get ("cl_lanForcePackets", "1", CVAR_ARCHIVE);
 
@@ -3643,6 +4287,7 @@ void CL_Init( void ) {
 	Cmd_AddCommand ("demo", CL_PlayDemo_f);
 	Cmd_SetCommandCompletionFunc( "demo", CL_CompleteDemoName );
 	Cmd_AddCommand ("stoprecord", CL_StopRecord_f);
+	Cmd_AddCommand ("demoseek", CL_DemoSeek_f);
 	Cmd_AddCommand ("connect", CL_Connect_f);
 	Cmd_AddCommand ("reconnect", CL_Reconnect_f);
 	Cmd_AddCommand ("localservers", CL_LocalServers_f);
@@ -3771,26 +4416,178 @@ static void CL_SetServerInfo(serverInfo_t *server, const char *info, int ping) {
 }
 
 static void CL_SetServerInfoByAddress(netadr_t from, const char *info, int ping) {
-	int i;
+	serverInfo_t *server;
+	int id;
+
+	// the same address can be in more than one list
+	for (id = CL_FirstServerId(&from); id != -1; id = cl_serverHashNext[id]) {
+		server = CL_ServerForId(id);
+		if (server && NET_CompareAdr(from, server->adr)) {
+			CL_SetServerInfo(server, info, ping);
+		}
+	}
+}
 
-	for (i = 0; i < MAX_OTHER_SERVERS; i++) {
-		if (NET_CompareAdr(from, cls.localServers[i].adr)) {
-			CL_SetServerInfo(&cls.localServers[i], info, ping);
+/*
+=======================================================================
+
+BROWSER PINGS
+
+Pings sent by CL_UpdateVisiblePings_f. They are kept apart from
+cl_pinglist, which the cgame polls slot by slot, so many more can be
+in flight at once. Sending is rate limited so refreshing thousands of
+servers goes out in steady bursts instead of flooding the connection.
+
+=======================================================================
+*/
+
+#define MAX_BROWSER_PINGS		256
+#define BROWSER_PING_HASH_SIZE	512		// must be a power of two
+
+typedef struct {
+	netadr_t	adr;			// port is 0 if the slot is free
+	int			start;
+	int			hashNext;		// slot + 1, 0 ends the chain
+} browserPing_t;
+
+static browserPing_t	cl_browserPings[MAX_BROWSER_PINGS];
+static int				cl_browserPingHash[BROWSER_PING_HASH_SIZE];	// slot + 1, 0 if empty
+static int				cl_numBrowserPings;
+
+static int				cl_pingCredit;			// pings that may be sent now, in 1/1000ths
+static int				cl_pingCreditTime;
+
+/*
+===================
+CL_FindBrowserPing
+===================
+*/
+static int CL_FindBrowserPing( const netadr_t *adr ) {
+	int slot;
+
+	slot = cl_browserPingHash[CL_HashServerAddress( adr ) & ( BROWSER_PING_HASH_SIZE - 1 )] - 1;
+	for ( ; slot != -1; slot = cl_browserPings[slot].hashNext - 1 ) {
+		if ( NET_CompareAdr( cl_browserPings[slot].adr, *adr ) ) {
+			return slot;
 		}
 	}
 
-	for (i = 0; i < MAX_GLOBAL_SERVERS; i++) {
-		if (NET_CompareAdr(from, cls.globalServers[i].adr)) {
-			CL_SetServerInfo(&cls.globalServers[i], info, ping);
+	return -1;
+}
+
+/*
+===================
+CL_SendBrowserPing
+===================
+*/
+static void CL_SendBrowserPing( const netadr_t *adr ) {
+	browserPing_t	*ping;
+	int				slot, hash;
+
+	for ( slot = 0; slot < MAX_BROWSER_PINGS; slot++ ) {
+		if ( !cl_browserPings[slot].adr.port ) {
+			break;
 		}
 	}
 
-	for (i = 0; i < MAX_OTHER_SERVERS; i++) {
-		if (NET_CompareAdr(from, cls.favoriteServers[i].adr)) {
-			CL_SetServerInfo(&cls.favoriteServers[i], info, ping);
+	if ( slot == MAX_BROWSER_PINGS ) {
+		return;
+	}
+
+	ping = &cl_browserPings[slot];
+	ping->adr = *adr;
+	ping->start = Sys_Milliseconds();
+
+	hash = CL_HashServerAddress( adr ) & ( BROWSER_PING_HASH_SIZE - 1 );
+	ping->hashNext = cl_browserPingHash[hash];
+	cl_browserPingHash[hash] = slot + 1;
+	cl_numBrowserPings++;
+
+	NET_OutOfBandPrint( NS_CLIENT, *adr, "getinfo xxx" );
+}
+
+/*
+===================
+CL_FreeBrowserPing
+===================
+*/
+static void CL_FreeBrowserPing( int slot ) {
+	browserPing_t	*ping;
+	int				*link;
+
+	ping = &cl_browserPings[slot];
+
+	link = &cl_browserPingHash[CL_HashServerAddress( &ping->adr ) & ( BROWSER_PING_HASH_SIZE - 1 )];
+	for ( ; *link; link = &cl_browserPings[*link - 1].hashNext ) {
+		if ( *link == slot + 1 ) {
+			*link = ping->hashNext;
+			break;
+		}
+	}
+
+	ping->adr.port = 0;
+	cl_numBrowserPings--;
+}
+
+/*
+===================
+CL_ExpireBrowserPings
+
+Servers that didn't answer within cl_maxPing get a ping of 0
+===================
+*/
+static qboolean CL_ExpireBrowserPings( void ) {
+	qboolean	expired;
+	int			i, now, maxPing;
+
+	if ( !cl_numBrowserPings ) {
+		return qfalse;
+	}
+
+	now = Sys_Milliseconds();
+	maxPing = Cvar_VariableIntegerValue( "cl_maxPing" );
+	if( maxPing < 100 ) {
+		maxPing = 100;
+	}
+
+	expired = qfalse;
+	for ( i = 0; i < MAX_BROWSER_PINGS; i++ ) {
+		if ( cl_browserPings[i].adr.port && now - cl_browserPings[i].start >= maxPing ) {
+			CL_SetServerInfoByAddress( cl_browserPings[i].adr, NULL, 0 );
+			CL_FreeBrowserPing( i );
+			expired = qtrue;
 		}
 	}
 
+	return expired;
+}
+
+/*
+===================
+CL_RefillPingCredit
+
+Token bucket, cl_pingRate pings per second up to cl_pingBurst at once
+===================
+*/
+static void CL_RefillPingCredit( void ) {
+	int now, elapsed, rate, burst;
+
+	rate = Com_Clamp( 1, 10000, cl_pingRate->integer );
+	burst = Com_Clamp( 1, MAX_BROWSER_PINGS, cl_pingBurst->integer );
+
+	now = Sys_Milliseconds();
+	elapsed = now - cl_pingCreditTime;
+	cl_pingCreditTime = now;
+
+	if ( elapsed < 0 || elapsed > burst * 1000 / rate ) {
+		cl_pingCredit = burst * 1000;
+	} else {
+		cl_pingCredit += elapsed * rate;
+	}
+
+	if ( cl_pingCredit > burst * 1000 ) {
+		cl_pingCredit = burst * 1000;
+	}
 }
 
 /*
@@ -3799,12 +4596,13 @@ CL_ServerInfoPacket
 ===================
 */
 void CL_ServerInfoPacket( netadr_t from, msg_t *msg ) {
-	int		i, type;
+	int		i, type, time;
 	char	info[MAX_INFO_STRING];
 	char	*infoString;
 	int		prot;
 	char	*gamename;
 	qboolean gameMismatch;
+	qboolean answered;
 
 	infoString = MSG_ReadString( msg );
 
@@ -3831,6 +4629,26 @@ void CL_ServerInfoPacket( netadr_t from, msg_t *msg ) {
 		return;
 	}
 
+	// tack on the net type
+	// NOTE: make sure these types are in sync with the netnames strings in the UI
+	switch (from.type)
+	{
+		case NA_BROADCAST:
+		case NA_IP:
+			type = 1;
+			break;
+		case NA_IP6:
+			type = 2;
+			break;
+		default:
+			type = 0;
+			break;
+	}
+	Q_strncpyz( info, infoString, sizeof( info ) );
+	Info_SetValueForKey( info, "nettype", va("%d", type) );
+
+	answered = qfalse;
+
 	// iterate servers waiting for ping response
 	for (i=0; i<MAX_PINGREQUESTS; i++)
 	{
@@ -3841,28 +4659,33 @@ void CL_ServerInfoPacket( netadr_t from, msg_t *msg ) {
 			Com_DPrintf( "ping time %dms from %s\n", cl_pinglist[i].time, NET_AdrToString( from ) );
 
 			// save of info
-			Q_strncpyz( cl_pinglist[i].info, infoString, sizeof( cl_pinglist[i].info ) );
+			Q_strncpyz( cl_pinglist[i].info, info, sizeof( cl_pinglist[i].info ) );
+			CL_SetServerInfoByAddress(from, info, cl_pinglist[i].time);
 
-			// tack on the net type
-			// NOTE: make sure these types are in sync with the netnames strings in the UI
-			switch (from.type)
-			{
-				case NA_BROADCAST:
-				case NA_IP:
-					type = 1;
-					break;
-				case NA_IP6:
-					type = 2;
-					break;
-				default:
-					type = 0;
-					break;
-			}
-			Info_SetValueForKey( cl_pinglist[i].info, "nettype", va("%d", type) );
-			CL_SetServerInfoByAddress(from, infoString, cl_pinglist[i].time);
+			answered = qtrue;
+			break;
+		}
+	}
 
-			return;
+	// the server browser's pings
+	i = CL_FindBrowserPing( &from );
+	if ( i != -1 )
+	{
+		time = Sys_Milliseconds() - cl_browserPings[i].start;
+		if ( time < 1 ) {
+			// a ping of 0 means the server didn't answer
+			time = 1;
 		}
+		Com_DPrintf( "ping time %dms from %s\n", time, NET_AdrToString( from ) );
+
+		CL_SetServerInfoByAddress(from, info, time);
+		CL_FreeBrowserPing( i );
+
+		answered = qtrue;
+	}
+
+	if ( answered ) {
+		return;
 	}
 
 	// if not just sent a local broadcast or pinging local servers
@@ -3890,6 +4713,7 @@ void CL_ServerInfoPacket( netadr_t from, msg_t *msg ) {
 	// add this to the list
 	cls.numlocalservers = i+1;
 	CL_InitServerInfo( &cls.localServers[i], &from );
+	CL_LinkServer( AS_LOCAL, i );
 
 	Q_strncpyz( info, MSG_ReadString( msg ), MAX_INFO_STRING );
 	if (strlen(info)) {
@@ -4323,6 +5147,9 @@ int CL_GetPingQueueCount( void )
 		}
 	}
 
+	// include the server browser's pings still in flight
+	count += cl_numBrowserPings;
+
 	return (count);
 }
 
@@ -4439,10 +5266,10 @@ CL_UpdateVisiblePings_f
 ==================
 */
 qboolean CL_UpdateVisiblePings_f(int source) {
-	int			slots, i;
+	serverInfo_t *server;
+	int			i, max;
 	char		buff[MAX_STRING_CHARS];
 	int			pingTime;
-	int			max;
 	qboolean status = qfalse;
 
 	if (source < 0 || source >= AS_NUM_SOURCES) {
@@ -4451,76 +5278,49 @@ qboolean CL_UpdateVisiblePings_f(int source) {
 
 	cls.pingUpdateSource = source;
 
-	slots = CL_GetPingQueueCount();
-	if (slots < MAX_PINGREQUESTS) {
-		serverInfo_t *server = NULL;
+	if (CL_ExpireBrowserPings()) {
+		status = qtrue;
+	}
+
+	CL_RefillPingCredit();
 
-		switch (source) {
-			case AS_LOCAL :
-				server = &cls.localServers[0];
-				max = cls.numlocalservers;
-			break;
-			case AS_GLOBAL :
-				server = &cls.globalServers[0];
-				max = cls.numglobalservers;
-			break;
-			case AS_FAVORITES :
-				server = &cls.favoriteServers[0];
-				max = cls.numfavoriteservers;
-			break;
-			default:
-				return qfalse;
-		}
-		for (i = 0; i < max; i++) {
-			if (server[i].visible) {
-				if (server[i].ping == -1) {
-					int j;
+	server = CL_ServerList(source, &max);
+	for (i = 0; i < max; i++) {
+		if (server[i].visible) {
+			if (server[i].ping == -1) {
+				status = qtrue;
 
-					if (slots >= MAX_PINGREQUESTS) {
-						break;
-					}
-					for (j = 0; j < MAX_PINGREQUESTS; j++) {
-						if (!cl_pinglist[j].adr.port) {
-							continue;
-						}
-						if (NET_CompareAdr( cl_pinglist[j].adr, server[i].adr)) {
-							// already on the list
-							break;
-						}
-					}
-					if (j >= MAX_PINGREQUESTS) {
-						status = qtrue;
-						for (j = 0; j < MAX_PINGREQUESTS; j++) {
-							if (!cl_pinglist[j].adr.port) {
-								break;
-							}
-						}
-						memcpy(&cl_pinglist[j].adr, &server[i].adr, sizeof(netadr_t));
-						cl_pinglist[j].start = Sys_Milliseconds();
-						cl_pinglist[j].time = 0;
-						NET_OutOfBandPrint( NS_CLIENT, cl_pinglist[j].adr, "getinfo xxx" );
-						slots++;
-					}
+				if (cl_pingCredit < 1000 || cl_numBrowserPings >= MAX_BROWSER_PINGS) {
+					// sent next time around
+					continue;
+				}
+				if (CL_FindBrowserPing(&server[i].adr) != -1) {
+					// already on the list
+					continue;
 				}
-				// if the server has a ping higher than cl_maxPing or
-				// the ping packet got lost
-				else if (server[i].ping == 0) {
-					// if we are updating global servers
-					if (source == AS_GLOBAL) {
-						//
-						if ( cls.numGlobalServerAddresses > 0 ) {
-							// overwrite this server with one from the additional global servers
-							cls.numGlobalServerAddresses--;
-							CL_InitServerInfo(&server[i], &cls.globalServerAddresses[cls.numGlobalServerAddresses]);
-							// NOTE: the server[i].visible flag stays untouched
-						}
+
+				CL_SendBrowserPing(&server[i].adr);
+				cl_pingCredit -= 1000;
+			}
+			// if the server has a ping higher than cl_maxPing or
+			// the ping packet got lost
+			else if (server[i].ping == 0) {
+				// if we are updating global servers
+				if (source == AS_GLOBAL) {
+					//
+					if ( cls.numGlobalServerAddresses > 0 ) {
+						// overwrite this server with one from the additional global servers
+						cls.numGlobalServerAddresses--;
+						CL_InitServerInfo(&server[i], &cls.globalServerAddresses[cls.numGlobalServerAddresses]);
+						CL_InvalidateServerHash();
+						// NOTE: the server[i].visible flag stays untouched
 					}
 				}
 			}
 		}
-	} 
+	}
 
-	if (slots) {
+	if (CL_GetPingQueueCount()) {
 		status = qtrue;
 	}
 	for (i = 0; i < MAX_PINGREQUESTS; i++) {
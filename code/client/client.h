@@ -245,6 +245,13 @@ typedef struct {
 	int			demoLength;		// size of playback demo
 	int			demoRecordStartTime;
 
+	fileHandle_t	demoIndexFile;	// keyframes written next to the demo, see CL_WriteDemoKeyframe
+	int			demoNextKeyframeTime;	// serverTime the next keyframe is due while recording
+	qboolean	demoReadingKeyframe;	// feeding a restored keyframe from demoIndexFile
+	int			demoMessagesOffset;		// file offset of the first message after the header
+	int			demoFirstServerTime;	// demoseek times are relative to the first snapshot
+	int			demoSeekTime;			// fast forward to this serverTime once active
+
 	int			timeDemoFrames;		// counter of rendered frames
 	int			timeDemoStart;		// cls.realtime before first frame
 	int			timeDemoBaseTime;	// each frame will be at this time + frameNum * 50
@@ -378,21 +385,18 @@ extern	qboolean	cl_oldGameSet;
 
 //=============================================================================
 
-// note: there is implicitly a '\0' byte added to the string literal
-#define DEMO_MAGIC "SPEARMINT_DEMO"
+// demos/<name>.<ext>.idx holds a header followed by keyframes. Each keyframe is
+// its serverTime, the demo file offset to continue from and a run of regular
+// demo messages (a gamestate then a chain of snapshots starting from a
+// non-delta one) ended by a -1 sequence and length.
+#define DEMO_INDEX_MAGIC	"SMDI"
+#define DEMO_INDEX_VERSION	1
 
 typedef struct {
-	char	magic[15];
-	byte	padding; // align to 4-byte boundary, this in uninitialized data in older demos
-	int		headerSize;
+	char	magic[4];
+	int		version;
 	int		protocol;
-
-	// treated as optional, assumed to exist based on headerSize
-	char	startTime[20]; // "YYYY-MM-DD HH:MM:SS" with null byte
-	char	endTime[20]; // "YYYY-MM-DD HH:MM:SS" with null byte
-	int		runTime; // Run time in milliseconds. Note: assumed to be directly after endTime when saving demo
-
-} demoHeader_t;
+} demoIndexHeader_t;
 
 //=============================================================================
 
@@ -435,6 +439,7 @@ extern	cvar_t	*cl_inGameVideo;
 
 extern	cvar_t	*cl_lanForcePackets;
 extern	cvar_t	*cl_autoRecordDemo;
+extern	cvar_t	*cl_demoKeyframeInterval;
 
 extern	cvar_t	*cl_consoleKeys;
 
@@ -486,6 +491,7 @@ void CL_DemoName( char *buffer, int size );
 int CL_DemoLength( void );
 void CL_ReadDemoMessage( void );
 void CL_StopRecord_f(void);
+void CL_WriteDemoKeyframe( void );
 
 void CL_InitDownloads(void);
 void CL_NextDownload(void);
@@ -495,6 +501,10 @@ void CL_GetPingInfo( int n, char *buf, int buflen );
 void CL_ClearPing( int n );
 int CL_GetPingQueueCount( void );
 
+void CL_InvalidateServerHash( void );
+void CL_LinkServer( int source, int index );
+int CL_FindServer( int source, const netadr_t *adr );
+
 void CL_InitRef( void );
 int CL_ServerStatus( char *serverAddress, char *serverStatusString, int maxLen );
 
@@ -614,7 +624,8 @@ qboolean CL_Netchan_Process( netchan_t *chan, msg_t *msg );
 //
 qboolean CL_OpenAVIForWriting( const char *filename );
 void CL_TakeVideoFrame( void );
-void CL_WriteAVIVideoFrame( const byte *imageBuffer, int size );
+byte *CL_BeginAVIVideoFrame( int width, int height );
+void CL_EndAVIVideoFrame( void );
 void CL_WriteAVIAudioFrame( const byte *pcmBuffer, int size );
 qboolean CL_CloseAVI( void );
 qboolean CL_VideoRecording( void );
@@ -328,3 +328,69 @@ void S_AdpcmEncodeSound( sfx_t *sfx, short *samples ) {
 		count -= n;
 	}
 }
+
+/*
+====================
+S_AdpcmCompressSound
+
+Re-encodes a resident 16 bit mono sound in place. Each run of
+chunks is freed before its adpcm chunk is allocated, so this never
+needs more sound memory than it gives back.
+====================
+*/
+void S_AdpcmCompressSound( sfx_t *sfx ) {
+	adpcm_state_t	state;
+	short			samples[SND_CHUNK_SIZE_BYTE*2];
+	int				count;
+	int				n, got, part;
+	sndBuffer		*chunk, *next, *newchunk, *last;
+
+	chunk = sfx->soundData;
+	if ( !chunk ) {
+		return;
+	}
+
+	count = sfx->soundLength;
+	state.index = 0;
+	state.sample = chunk->sndChunk[0];
+
+	sfx->soundData = NULL;
+	last = NULL;
+
+	while( count > 0 && chunk ) {
+		n = count;
+		if( n > SND_CHUNK_SIZE_BYTE*2 ) {
+			n = SND_CHUNK_SIZE_BYTE*2;
+		}
+
+		// gather the 16 bit chunks this adpcm chunk replaces
+		for( got = 0; got < n && chunk; got += part ) {
+			part = n - got;
+			if( part > SND_CHUNK_SIZE ) {
+				part = SND_CHUNK_SIZE;
+			}
+			Com_Memcpy( samples + got, chunk->sndChunk, part * sizeof(short) );
+
+			next = chunk->next;
+			SND_free( chunk );
+			chunk = next;
+		}
+
+		newchunk = SND_malloc();
+		if( last ) {
+			last->next = newchunk;
+		} else {
+			sfx->soundData = newchunk;
+		}
+		last = newchunk;
+
+		newchunk->adpcm.index  = state.index;
+		newchunk->adpcm.sample = state.sample;
+
+		S_AdpcmEncode( samples, (char *)newchunk->sndChunk, got, &state );
+
+		count -= got;
+	}
+
+	sfx->soundCompressionMethod = 1;
+}
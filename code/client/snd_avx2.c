@@ -0,0 +1,143 @@
+/*
+===========================================================================
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of Spearmint Source Code.
+
+Spearmint Source Code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 3 of the License,
+or (at your option) any later version.
+
+Spearmint Source Code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Spearmint Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, Spearmint Source Code is also subject to certain additional terms.
+You should have received a copy of these additional terms immediately following
+the terms and conditions of the GNU General Public License.  If not, please
+request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional
+terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc.,
+Suite 120, Rockville, Maryland 20850 USA.
+===========================================================================
+*/
+
+/* AVX2 mixing kernels for the DMA sound mixer, picked at runtime by
+   S_InitMixKernels. This file is compiled with -mavx2, so nothing in it may
+   run before the CPU has been checked. */
+
+#include "client.h"
+#include "snd_local.h"
+
+#if id386 || idx64
+
+#include <immintrin.h>
+
+/*
+===================
+S_MixAVX2
+
+Adds (d * vol) >> 8 for eight samples, widened to 32 bits, to eight ints of
+the paint buffer
+===================
+*/
+static ID_INLINE void S_MixAVX2( int *out, __m128i d, __m256i vol ) {
+	__m256i		a;
+
+	a = _mm256_srai_epi32( _mm256_mullo_epi32( _mm256_cvtepi16_epi32( d ), vol ), 8 );
+	_mm256_storeu_si256( (__m256i *)out, _mm256_add_epi32( _mm256_loadu_si256( (__m256i *)out ), a ) );
+}
+
+/*
+===================
+S_MixMono16_avx2
+===================
+*/
+void S_MixMono16_avx2( portable_samplepair_t *samp, const short *samples, int count, int leftvol, int rightvol ) {
+	__m256i		vol;
+	__m128i		d;
+	int			*out;
+	int			i, data;
+
+	vol = _mm256_setr_epi32( leftvol, rightvol, leftvol, rightvol, leftvol, rightvol, leftvol, rightvol );
+	out = (int *)samp;
+
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		d = _mm_loadu_si128( (const __m128i *)( samples + i ) );
+
+		// each sample goes to both channels
+		S_MixAVX2( out + i * 2, _mm_unpacklo_epi16( d, d ), vol );
+		S_MixAVX2( out + i * 2 + 8, _mm_unpackhi_epi16( d, d ), vol );
+	}
+
+	for ( ; i < count; i++ ) {
+		data = samples[i];
+		samp[i].left += ( data * leftvol ) >> 8;
+		samp[i].right += ( data * rightvol ) >> 8;
+	}
+}
+
+/*
+===================
+S_MixStereo16_avx2
+
+count is in sample pairs
+===================
+*/
+void S_MixStereo16_avx2( portable_samplepair_t *samp, const short *samples, int count, int leftvol, int rightvol ) {
+	__m256i		vol;
+	int			*out;
+	int			i;
+
+	vol = _mm256_setr_epi32( leftvol, rightvol, leftvol, rightvol, leftvol, rightvol, leftvol, rightvol );
+	out = (int *)samp;
+
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		S_MixAVX2( out + i * 2, _mm_loadu_si128( (const __m128i *)( samples + i * 2 ) ), vol );
+		S_MixAVX2( out + i * 2 + 8, _mm_loadu_si128( (const __m128i *)( samples + i * 2 + 8 ) ), vol );
+	}
+
+	for ( ; i < count; i++ ) {
+		samp[i].left += ( samples[i*2] * leftvol ) >> 8;
+		samp[i].right += ( samples[i*2+1] * rightvol ) >> 8;
+	}
+}
+
+/*
+===================
+S_ClipStereo16_avx2
+
+Same as S_WriteLinearBlastStereo16, count is in samples
+===================
+*/
+void S_ClipStereo16_avx2( short *out, const int *in, int count ) {
+	__m256i		a, b;
+	int			i, val;
+
+	for ( i = 0; i + 16 <= count; i += 16 ) {
+		a = _mm256_srai_epi32( _mm256_loadu_si256( (const __m256i *)( in + i ) ), 8 );
+		b = _mm256_srai_epi32( _mm256_loadu_si256( (const __m256i *)( in + i + 8 ) ), 8 );
+
+		// packs works per 128-bit lane, put the quarters back in order
+		a = _mm256_permute4x64_epi64( _mm256_packs_epi32( a, b ), _MM_SHUFFLE( 3, 1, 2, 0 ) );
+		_mm256_storeu_si256( (__m256i *)( out + i ), a );
+	}
+
+	for ( ; i < count; i++ ) {
+		val = in[i] >> 8;
+		if ( val > 0x7fff ) {
+			val = 0x7fff;
+		} else if ( val < -32768 ) {
+			val = -32768;
+		}
+		out[i] = val;
+	}
+}
+
+#endif
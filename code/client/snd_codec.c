@@ -199,6 +199,84 @@ int S_CodecReadStream(snd_stream_t *stream, int bytes, void *buffer)
 	return stream->codec->read(stream, bytes, buffer);
 }
 
+/*
+=================
+S_CodecStreamReadAhead
+
+Switches an open stream over to reading from readAhead, after which
+S_CodecReadStream may be called from another thread as long as the
+main thread keeps calling S_CodecFillReadAhead. Returns qfalse for
+codecs that can't decode away from the main thread.
+=================
+*/
+qboolean S_CodecStreamReadAhead(snd_stream_t *stream, snd_readahead_t *readAhead)
+{
+#ifdef USE_CODEC_MP3
+	// the mp3 decoder grows its buffers from the zone while reading
+	if(stream->codec == &mp3_codec)
+		return qfalse;
+#endif
+
+	readAhead->filled = readAhead->used = FS_FTell(stream->file);
+	readAhead->eof = qfalse;
+	readAhead->abort = qfalse;
+
+	// forget posts left over from the last stream
+	while(Sys_SemaphoreTryWait(readAhead->posted))
+		;
+
+	stream->readAhead = readAhead;
+	S_CodecFillReadAhead(stream);
+
+	return qtrue;
+}
+
+/*
+=================
+S_CodecFillReadAhead
+
+Reads the file as far ahead of the decoder as the buffer allows,
+main thread only
+=================
+*/
+void S_CodecFillReadAhead(snd_stream_t *stream)
+{
+	snd_readahead_t *ra = stream->readAhead;
+	int start, filled, space, ofs, chunk, r;
+
+	if(!ra || ra->eof)
+		return;
+
+	start = filled = ra->filled;
+	space = STREAM_READAHEAD_SIZE - (filled - Sys_AtomicLoad(&ra->used));
+
+	while(space > 0)
+	{
+		ofs = filled & (STREAM_READAHEAD_SIZE - 1);
+		chunk = MIN(space, STREAM_READAHEAD_SIZE - ofs);
+
+		r = FS_Read(&ra->data[ofs], chunk, stream->file);
+		if(r > 0)
+		{
+			filled += r;
+			space -= r;
+		}
+
+		if(r < chunk)
+		{
+			Sys_AtomicStore(&ra->filled, filled);
+			Sys_AtomicStore(&ra->eof, qtrue);
+			break;
+		}
+	}
+
+	Sys_AtomicStore(&ra->filled, filled);
+
+	// a waiting decoder always has room for more
+	if(filled != start || ra->eof)
+		Sys_SemaphorePost(ra->posted);
+}
+
 //=======================================================================
 // Util functions (used by codecs)
 
@@ -246,3 +324,111 @@ void S_CodecUtilClose(snd_stream_t **stream)
 	Z_Free(*stream);
 	*stream = NULL;
 }
+
+/*
+=================
+S_CodecUtilRead
+
+FS_Read for codecs. With read-ahead this waits for the main
+thread rather than return short before the end of the file.
+=================
+*/
+int S_CodecUtilRead(snd_stream_t *stream, void *buffer, int len)
+{
+	snd_readahead_t *ra = stream->readAhead;
+	int total, used, filled, ofs, chunk;
+
+	if(!ra)
+		return FS_Read(buffer, len, stream->file);
+
+	total = 0;
+	used = ra->used;
+
+	while(total < len)
+	{
+		filled = Sys_AtomicLoad(&ra->filled);
+		if(filled == used)
+		{
+			if(Sys_AtomicLoad(&ra->eof))
+			{
+				// the last read may have landed since filled was loaded
+				if(Sys_AtomicLoad(&ra->filled) == used)
+					break;
+				continue;
+			}
+
+			if(Sys_AtomicLoad(&ra->abort))
+				break;
+
+			Sys_SemaphoreWait(ra->posted);
+			continue;
+		}
+
+		ofs = used & (STREAM_READAHEAD_SIZE - 1);
+		chunk = MIN(len - total, filled - used);
+		chunk = MIN(chunk, STREAM_READAHEAD_SIZE - ofs);
+
+		Com_Memcpy((byte *)buffer + total, &ra->data[ofs], chunk);
+		total += chunk;
+		used += chunk;
+
+		// hand the space back right away, the rest may not be read yet
+		Sys_AtomicStore(&ra->used, used);
+	}
+
+	return total;
+}
+
+/*
+=================
+S_CodecUtilSeek
+
+FS_Seek for codecs. With read-ahead only the bytes that
+are still buffered ahead of the decoder can be reached.
+=================
+*/
+int S_CodecUtilSeek(snd_stream_t *stream, long offset, int origin)
+{
+	snd_readahead_t *ra = stream->readAhead;
+	int target;
+
+	if(!ra)
+		return FS_Seek(stream->file, offset, origin);
+
+	switch(origin)
+	{
+		case FS_SEEK_SET:
+			target = offset;
+			break;
+
+		case FS_SEEK_CUR:
+			target = ra->used + offset;
+			break;
+
+		case FS_SEEK_END:
+			target = stream->length + offset;
+			break;
+
+		default:
+			return -1;
+	}
+
+	if(target < ra->used || target > Sys_AtomicLoad(&ra->filled))
+		return -1;
+
+	Sys_AtomicStore(&ra->used, target);
+	return 0;
+}
+
+/*
+=================
+S_CodecUtilTell
+=================
+*/
+int S_CodecUtilTell(snd_stream_t *stream)
+{
+	if(!stream->readAhead)
+		return FS_FTell(stream->file);
+
+	return stream->readAhead->used;
+}
@@ -47,6 +47,21 @@ typedef struct snd_info_s
 
 typedef struct snd_codec_s snd_codec_t;
 
+// Compressed bytes read ahead of a stream's decoder. The main thread fills
+// it from the file so the decoder can run on another thread without going
+// near the filesystem. Positions are file offsets.
+#define STREAM_READAHEAD_SIZE	(64*1024)	// must be a power of two
+
+typedef struct snd_readahead_s
+{
+	byte data[STREAM_READAHEAD_SIZE];
+	volatile int filled;		// read from the file up to here, main thread
+	volatile int used;			// handed to the codec up to here, decoder
+	volatile int eof;			// the file has been read to the end
+	volatile int abort;			// the decoder should stop waiting for data
+	sysSemaphore_t *posted;		// posted whenever one of the above changes
+} snd_readahead_t;
+
 typedef struct snd_stream_s
 {
 	snd_codec_t *codec;
@@ -55,6 +70,7 @@ typedef struct snd_stream_s
 	int length;
 	int pos;
 	void *ptr;
+	snd_readahead_t *readAhead;	// set while the codec reads from memory
 } snd_stream_t;
 
 // Codec functions
@@ -83,9 +99,15 @@ snd_stream_t *S_CodecOpenStream(const char *filename);
 void S_CodecCloseStream(snd_stream_t *stream);
 int S_CodecReadStream(snd_stream_t *stream, int bytes, void *buffer);
 
+qboolean S_CodecStreamReadAhead(snd_stream_t *stream, snd_readahead_t *readAhead);
+void S_CodecFillReadAhead(snd_stream_t *stream);
+
 // Util functions (used by codecs)
 snd_stream_t *S_CodecUtilOpen(const char *filename, snd_codec_t *codec);
 void S_CodecUtilClose(snd_stream_t **stream);
+int S_CodecUtilRead(snd_stream_t *stream, void *buffer, int len);
+int S_CodecUtilSeek(snd_stream_t *stream, long offset, int origin);
+int S_CodecUtilTell(snd_stream_t *stream);
 
 // WAV Codec
 extern snd_codec_t wav_codec;
@@ -52,6 +52,30 @@ static float	s_backgroundLoopVolume[MAX_STREAMING_SOUNDS];
 static int		s_backgroundEntityNum[MAX_STREAMING_SOUNDS];
 static int		s_backgroundPlayCount[MAX_STREAMING_SOUNDS];
 
+// streams are decoded on their own thread into these, the main
+// thread only copies finished samples into s_rawsamples
+#define		STREAM_PCM_SIZE		(128*1024)	// bytes, must be a power of two
+#define		STREAM_DECODE_CHUNK	(16*1024)
+
+typedef struct {
+	snd_readahead_t	readAhead;
+	snd_stream_t	*stream;		// set while the decoder owns the stream
+	sysMutex_t		*busy;			// held by the decoder while it reads
+	byte			pcm[STREAM_PCM_SIZE];
+	volatile int	pcmHead;		// bytes decoded
+	volatile int	pcmTail;		// bytes copied out by the main thread
+	volatile int	decodeEnd;		// the codec has nothing left
+	qboolean		started;		// samples have been copied out
+	int				underruns;		// frames the decoder fell behind
+} streamDecode_t;
+
+static streamDecode_t	s_streamDecode[MAX_STREAMING_SOUNDS];
+
+cvar_t					*s_streamThread;
+static sysThread_t		*s_streamThreadHandle;
+static sysSemaphore_t	*s_streamWake;
+static volatile int		s_streamThreadQuit;
+
 
 // =======================================================================
 // Internal sound data & structures
@@ -98,12 +122,110 @@ int						s_rawend[MAX_RAW_STREAMS];
 portable_samplepair_t s_rawsamples[MAX_RAW_STREAMS][MAX_RAW_SAMPLES];
 
 
+// =======================================================================
+// Mixer thread
+// =======================================================================
+
+#define		MAX_SOUND_COMMANDS	4096	// must be a power of two
+#define		MIX_THREAD_MSEC		5
+
+typedef enum {
+	SC_START_SOUND,
+	SC_STOP_LOOPING,
+	SC_CLEAR_LOOPING,
+	SC_ADD_LOOPING,
+	SC_ADD_REAL_LOOPING,
+	SC_UPDATE_ENTITY,
+	SC_RESPATIALIZE,
+	SC_END_FRAME
+} soundCommandType_t;
+
+typedef struct {
+	soundCommandType_t	type;
+	int			entityNum;
+	int			channel;
+	sfx_t		*sfx;
+	qboolean	flag;			// local sound, killall or first person
+	qboolean	hasOrigin;
+	int			inwater;
+	int			framecount;
+	vec3_t		origin;
+	vec3_t		velocity;
+	vec3_t		axis[3];
+} soundCommand_t;
+
+// The main thread fills slots from s_commandPending on and publishes them
+// all at once by storing s_commandHead at the end of the frame.  Whoever
+// holds s_mixMutex consumes up to the published head and hands the slots
+// back through s_commandTail, so the main thread never waits on the mixer
+// just to start a sound.
+static soundCommand_t	s_commands[MAX_SOUND_COMMANDS];
+static volatile int		s_commandHead;
+static volatile int		s_commandTail;
+static int				s_commandPending;
+
+// listener state belongs to the mixer, it's aged at the start of the
+// next frame's commands so raw streams can still spatialize against it
+static qboolean			s_listenersStale;
+
+cvar_t					*s_mixThread;
+static sysThread_t		*s_mixThreadHandle;
+static sysMutex_t		*s_mixMutex;
+static volatile int		s_mixThreadQuit;
+static int				s_droppedSounds;
+
+static void S_RunCommands( void );
+static void S_ClearMixer( void );
+
+static void S_LockMixer( void ) {
+	if ( s_mixMutex ) {
+		Sys_LockMutex( s_mixMutex );
+	}
+}
+
+static void S_UnlockMixer( void ) {
+	if ( s_mixMutex ) {
+		Sys_UnlockMutex( s_mixMutex );
+	}
+}
+
+/*
+=================
+S_QueueCommand
+
+Returns a slot to fill in, it goes to the mixer with the rest of the frame.
+If the mixer is a whole ring behind, the queued commands are run here.
+=================
+*/
+static soundCommand_t *S_QueueCommand( soundCommandType_t type ) {
+	soundCommand_t	*cmd;
+	int				next;
+
+	next = ( s_commandPending + 1 ) & ( MAX_SOUND_COMMANDS - 1 );
+
+	if ( next == Sys_AtomicLoad( &s_commandTail ) ) {
+		S_LockMixer();
+		Sys_AtomicStore( &s_commandHead, s_commandPending );
+		S_RunCommands();
+		S_UnlockMixer();
+	}
+
+	cmd = &s_commands[ s_commandPending ];
+	cmd->type = type;
+	s_commandPending = next;
+
+	return cmd;
+}
+
+
 // ====================================================================
 // User-setable variables
 // ====================================================================
 
 
 void S_Base_SoundInfo(void) {	
+	int i;
+
 	Com_Printf("----- Sound Info -----\n" );
 	if (!s_soundStarted) {
 		Com_Printf ("sound system not started\n");
@@ -115,6 +237,11 @@ void S_Base_SoundInfo(void) {
 		Com_Printf("%5d speed\n", dma.speed);
 		Com_Printf("%p dma buffer\n", dma.buffer);
 
+		for (i = 0; i < MAX_STREAMING_SOUNDS; i++) {
+			if (s_streamDecode[i].underruns) {
+				Com_Printf("%5d underruns on stream %d\n", s_streamDecode[i].underruns, i);
+			}
+		}
 	}
 	Com_Printf("----------------------\n" );
 }
@@ -198,7 +325,7 @@ channel_t*	S_ChannelMalloc( void ) {
 	}
 	v = freelist;
 	freelist = *(channel_t **)freelist;
-	v->allocTime = Com_Milliseconds();
+	v->allocTime = Sys_Milliseconds();
 	return v;
 }
 
@@ -216,7 +343,6 @@ void S_ChannelSetup( void ) {
 	
 	*(channel_t **)q = NULL;
 	freelist = p + MAX_CHANNELS - 1;
-	Com_DPrintf("Channel memory manager started\n");
 }
 
 
@@ -345,7 +471,10 @@ are no longer valid.
 */
 void S_Base_DisableSounds( void ) {
 	S_Base_StopAllSounds();
+
+	S_LockMixer();
 	s_soundMuted = qtrue;
+	S_UnlockMixer();
 }
 
 /*
@@ -411,7 +540,9 @@ S_BeginRegistration
 =====================
 */
 void S_Base_BeginRegistration( void ) {
+	S_LockMixer();
 	s_soundMuted = qfalse;		// we can play again
+	S_UnlockMixer();
 
 	if (s_numSfx == 0) {
 		int default_sfx;
@@ -523,44 +654,34 @@ void S_SpatializeOrigin (vec3_t origin, int master_vol, int *left_vol, int *righ
 
 /*
 ====================
-S_Base_StartSoundEx
+S_MixerStartSound
 
-Validates the parms and ques the sound up
-if origin is NULL, the sound will be dynamically sourced from the entity
+Picks a channel for a queued sound, runs on the mixer
 Entchannel 0 will never override a playing sound
 ====================
 */
-static void S_Base_StartSoundEx( vec3_t origin, int entityNum, int entchannel, sfxHandle_t sfxHandle, qboolean localSound ) {
+static void S_MixerStartSound( const soundCommand_t *cmd ) {
 	channel_t	*ch;
 	sfx_t		*sfx;
 	int			i, oldest, chosen, time;
 	int			inplay, allowed;
 	qboolean	fullVolume;
-
-	if ( !s_soundStarted || s_soundMuted ) {
+	qboolean	localSound;
+	int			entityNum, entchannel;
+	const float	*origin;
+
+	sfx = cmd->sfx;
+	entityNum = cmd->entityNum;
+	entchannel = cmd->channel;
+	localSound = cmd->flag;
+	origin = cmd->hasOrigin ? cmd->origin : NULL;
+
+	// freed to make room for another sound since it was queued
+	if ( !sfx->inMemory ) {
 		return;
 	}
 
-	if ( !origin && ( entityNum < 0 || entityNum >= MAX_GENTITIES ) ) {
-		Com_Error( ERR_DROP, "S_StartSound: bad entitynum %i", entityNum );
-	}
-
-	if ( sfxHandle < 0 || sfxHandle >= s_numSfx ) {
-		Com_Printf( S_COLOR_YELLOW "S_StartSound: handle %i out of range\n", sfxHandle );
-		return;
-	}
-
-	sfx = &s_knownSfx[ sfxHandle ];
-
-	if (sfx->inMemory == qfalse) {
-		S_memoryLoad(sfx);
-	}
-
-	if ( s_show->integer == 1 ) {
-		Com_Printf( "%i : %s\n", s_paintedtime, sfx->soundName );
-	}
-
-	time = Com_Milliseconds();
+	time = Sys_Milliseconds();
 
 //	Com_Printf("playing %s\n", sfx->soundName);
 	// pick a channel to play on
@@ -631,7 +752,7 @@ static void S_Base_StartSoundEx( vec3_t origin, int entityNum, int entchannel, s
 					}
 				}
 				if (chosen == -1) {
-					Com_Printf("dropping sound\n");
+					s_droppedSounds++;
 					return;
 				}
 			}
@@ -658,6 +779,52 @@ static void S_Base_StartSoundEx( vec3_t origin, int entityNum, int entchannel, s
 	ch->fullVolume = fullVolume;
 }
 
+/*
+====================
+S_Base_StartSoundEx
+
+Validates the parms and ques the sound up
+if origin is NULL, the sound will be dynamically sourced from the entity
+====================
+*/
+static void S_Base_StartSoundEx( vec3_t origin, int entityNum, int entchannel, sfxHandle_t sfxHandle, qboolean localSound ) {
+	soundCommand_t	*cmd;
+	sfx_t			*sfx;
+
+	if ( !s_soundStarted || s_soundMuted ) {
+		return;
+	}
+
+	if ( !origin && ( entityNum < 0 || entityNum >= MAX_GENTITIES ) ) {
+		Com_Error( ERR_DROP, "S_StartSound: bad entitynum %i", entityNum );
+	}
+
+	if ( sfxHandle < 0 || sfxHandle >= s_numSfx ) {
+		Com_Printf( S_COLOR_YELLOW "S_StartSound: handle %i out of range\n", sfxHandle );
+		return;
+	}
+
+	sfx = &s_knownSfx[ sfxHandle ];
+
+	if (sfx->inMemory == qfalse) {
+		S_memoryLoad(sfx);
+	}
+
+	if ( s_show->integer == 1 ) {
+		Com_Printf( "%i : %s\n", s_paintedtime, sfx->soundName );
+	}
+
+	cmd = S_QueueCommand( SC_START_SOUND );
+	cmd->entityNum = entityNum;
+	cmd->channel = entchannel;
+	cmd->sfx = sfx;
+	cmd->flag = localSound;
+	cmd->hasOrigin = ( origin != NULL );
+	if ( origin ) {
+		VectorCopy( origin, cmd->origin );
+	}
+}
+
 /*
 ====================
 S_StartSound
@@ -690,17 +857,14 @@ void S_Base_StartLocalSound( sfxHandle_t sfxHandle, int channelNum ) {
 
 /*
 ==================
-S_ClearSoundBuffer
+S_ClearMixer
 
-If we are about to perform file access, clear the buffer
-so sound doesn't stutter.
+Stops every channel and silences the dma buffer, the caller
+must hold the mixer lock.
 ==================
 */
-void S_Base_ClearSoundBuffer( void ) {
+static void S_ClearMixer( void ) {
 	int		clear;
-		
-	if (!s_soundStarted)
-		return;
 
 	// stop looping sounds
 	activeLoopSounds = NULL;
@@ -723,6 +887,27 @@ void S_Base_ClearSoundBuffer( void ) {
 	SNDDMA_Submit ();
 }
 
+/*
+==================
+S_ClearSoundBuffer
+
+If we are about to perform file access, clear the buffer
+so sound doesn't stutter.
+==================
+*/
+void S_Base_ClearSoundBuffer( void ) {
+	if (!s_soundStarted)
+		return;
+
+	// everything queued so far is stopped anyway, but listener
+	// updates have to survive the clear
+	S_LockMixer();
+	Sys_AtomicStore( &s_commandHead, s_commandPending );
+	S_RunCommands();
+	S_ClearMixer();
+	S_UnlockMixer();
+}
+
 /*
 ==================
 S_StopAllSounds
@@ -747,7 +932,7 @@ continuous looping sounds are added each frame
 ==============================================================
 */
 
-void S_Base_StopLoopingSound(int entityNum) {
+static void S_MixerStopLoopingSound(int entityNum) {
 //	loopSounds[entityNum].sfx = 0;
 	loopSounds[entityNum].kill = qfalse;
 
@@ -768,55 +953,49 @@ void S_Base_StopLoopingSound(int entityNum) {
 	loopSounds[entityNum].next = NULL;
 }
 
+void S_Base_StopLoopingSound(int entityNum) {
+	S_QueueCommand( SC_STOP_LOOPING )->entityNum = entityNum;
+}
+
 /*
 ==================
 S_ClearLoopingSounds
 
 ==================
 */
-void S_Base_ClearLoopingSounds( qboolean killall ) {
+static void S_MixerClearLoopingSounds( qboolean killall ) {
 	loopSound_t *loop, *next;
 	for ( loop = activeLoopSounds ; loop != NULL ; loop = next ) {
 		next = loop->next;
 		if (killall || loop->kill == qtrue || (loop->sfx && loop->sfx->soundLength == 0)) {
-			S_Base_StopLoopingSound( (int)(loop - loopSounds) );
+			S_MixerStopLoopingSound( (int)(loop - loopSounds) );
 		}
 	}
 	numLoopChannels = 0;
 }
 
+void S_Base_ClearLoopingSounds( qboolean killall ) {
+	S_QueueCommand( SC_CLEAR_LOOPING )->flag = killall;
+}
+
 /*
 ==================
-S_AddLoopingSound
+S_MixerAddLoopingSound
 
-Called during entity generation for a frame
-Include velocity in case I get around to doing doppler...
+Runs on the mixer, works out the doppler shift against the closest listener
 ==================
 */
-void S_Base_AddLoopingSound( int entityNum, const vec3_t origin, const vec3_t velocity, sfxHandle_t sfxHandle ) {
+static void S_MixerAddLoopingSound( const soundCommand_t *cmd ) {
 	sfx_t *sfx;
 	int listener;
+	int entityNum;
+	const float *velocity;
 
-	if ( !s_soundStarted || s_soundMuted ) {
-		return;
-	}
-
-	if ( sfxHandle < 0 || sfxHandle >= s_numSfx ) {
-		Com_Printf( S_COLOR_YELLOW "S_AddLoopingSound: handle %i out of range\n", sfxHandle );
-		return;
-	}
-
-	sfx = &s_knownSfx[ sfxHandle ];
+	sfx = cmd->sfx;
+	entityNum = cmd->entityNum;
+	velocity = cmd->velocity;
 
-	if (sfx->inMemory == qfalse) {
-		S_memoryLoad(sfx);
-	}
-
-	if ( !sfx->soundLength ) {
-		Com_Error( ERR_DROP, "%s has length 0", sfx->soundName );
-	}
-
-	VectorCopy( origin, loopSounds[entityNum].origin );
+	VectorCopy( cmd->origin, loopSounds[entityNum].origin );
 	VectorCopy( velocity, loopSounds[entityNum].velocity );
 	loopSounds[entityNum].kill = qtrue;
 	loopSounds[entityNum].doppler = qfalse;
@@ -834,7 +1013,7 @@ void S_Base_AddLoopingSound( int entityNum, const vec3_t origin, const vec3_t ve
 		lena = DistanceSquared(listeners[listener].origin, loopSounds[entityNum].origin);
 		VectorAdd(loopSounds[entityNum].origin, loopSounds[entityNum].velocity, out);
 		lenb = DistanceSquared(listeners[listener].origin, out);
-		if ((loopSounds[entityNum].framenum+1) != cls.framecount) {
+		if ((loopSounds[entityNum].framenum+1) != cmd->framecount) {
 			loopSounds[entityNum].oldDopplerScale = 1.0;
 		} else {
 			loopSounds[entityNum].oldDopplerScale = loopSounds[entityNum].dopplerScale;
@@ -847,7 +1026,7 @@ void S_Base_AddLoopingSound( int entityNum, const vec3_t origin, const vec3_t ve
 		}
 	}
 
-	loopSounds[entityNum].framenum = cls.framecount;
+	loopSounds[entityNum].framenum = cmd->framecount;
 
 	// already in active list
 	if ( activeLoopSounds == &loopSounds[entityNum] || loopSounds[entityNum].next || loopSounds[entityNum].prev ) {
@@ -865,13 +1044,44 @@ void S_Base_AddLoopingSound( int entityNum, const vec3_t origin, const vec3_t ve
 
 /*
 ==================
-S_AddLoopingSound
+S_MixerAddRealLoopingSound
+==================
+*/
+static void S_MixerAddRealLoopingSound( const soundCommand_t *cmd ) {
+	int entityNum;
 
-Called during entity generation for a frame
-Include velocity in case I get around to doing doppler...
+	entityNum = cmd->entityNum;
+
+	VectorCopy( cmd->origin, loopSounds[entityNum].origin );
+	VectorCopy( cmd->velocity, loopSounds[entityNum].velocity );
+	loopSounds[entityNum].sfx = cmd->sfx;
+	loopSounds[entityNum].kill = qfalse;
+	loopSounds[entityNum].doppler = qfalse;
+
+	// already in active list
+	if ( activeLoopSounds == &loopSounds[entityNum] || loopSounds[entityNum].next || loopSounds[entityNum].prev ) {
+		return;
+	}
+
+	// add to active list
+	if ( activeLoopSounds ) {
+		activeLoopSounds->prev = &loopSounds[entityNum];
+	}
+	loopSounds[entityNum].next = activeLoopSounds;
+	loopSounds[entityNum].prev = NULL;
+	activeLoopSounds = &loopSounds[entityNum];
+}
+
+/*
+==================
+S_QueueLoopingSound
+
+Validates a looping sound on the main thread, where
+the sound can still be loaded and errors can be raised
 ==================
 */
-void S_Base_AddRealLoopingSound( int entityNum, const vec3_t origin, const vec3_t velocity, sfxHandle_t sfxHandle ) {
+static void S_QueueLoopingSound( soundCommandType_t type, int entityNum, const vec3_t origin, const vec3_t velocity, sfxHandle_t sfxHandle ) {
+	soundCommand_t *cmd;
 	sfx_t *sfx;
 
 	if ( !s_soundStarted || s_soundMuted ) {
@@ -879,7 +1089,8 @@ void S_Base_AddRealLoopingSound( int entityNum, const vec3_t origin, const vec3_
 	}
 
 	if ( sfxHandle < 0 || sfxHandle >= s_numSfx ) {
-		Com_Printf( S_COLOR_YELLOW "S_AddRealLoopingSound: handle %i out of range\n", sfxHandle );
+		Com_Printf( S_COLOR_YELLOW "%s: handle %i out of range\n",
+			type == SC_ADD_LOOPING ? "S_AddLoopingSound" : "S_AddRealLoopingSound", sfxHandle );
 		return;
 	}
 
@@ -892,24 +1103,34 @@ void S_Base_AddRealLoopingSound( int entityNum, const vec3_t origin, const vec3_
 	if ( !sfx->soundLength ) {
 		Com_Error( ERR_DROP, "%s has length 0", sfx->soundName );
 	}
-	VectorCopy( origin, loopSounds[entityNum].origin );
-	VectorCopy( velocity, loopSounds[entityNum].velocity );
-	loopSounds[entityNum].sfx = sfx;
-	loopSounds[entityNum].kill = qfalse;
-	loopSounds[entityNum].doppler = qfalse;
 
-	// already in active list
-	if ( activeLoopSounds == &loopSounds[entityNum] || loopSounds[entityNum].next || loopSounds[entityNum].prev ) {
-		return;
-	}
+	cmd = S_QueueCommand( type );
+	cmd->entityNum = entityNum;
+	cmd->sfx = sfx;
+	cmd->framecount = cls.framecount;
+	VectorCopy( origin, cmd->origin );
+	VectorCopy( velocity, cmd->velocity );
+}
 
-	// add to active list
-	if ( activeLoopSounds ) {
-		activeLoopSounds->prev = &loopSounds[entityNum];
-	}
-	loopSounds[entityNum].next = activeLoopSounds;
-	loopSounds[entityNum].prev = NULL;
-	activeLoopSounds = &loopSounds[entityNum];
+/*
+==================
+S_AddLoopingSound
+
+Called during entity generation for a frame
+Include velocity in case I get around to doing doppler...
+==================
+*/
+void S_Base_AddLoopingSound( int entityNum, const vec3_t origin, const vec3_t velocity, sfxHandle_t sfxHandle ) {
+	S_QueueLoopingSound( SC_ADD_LOOPING, entityNum, origin, velocity, sfxHandle );
+}
+
+/*
+==================
+S_AddRealLoopingSound
+==================
+*/
+void S_Base_AddRealLoopingSound( int entityNum, const vec3_t origin, const vec3_t velocity, sfxHandle_t sfxHandle ) {
+	S_QueueLoopingSound( SC_ADD_REAL_LOOPING, entityNum, origin, velocity, sfxHandle );
 }
 
 
@@ -933,7 +1154,7 @@ void S_AddLoopSounds (void) {
 
 	numLoopChannels = 0;
 
-	time = Com_Milliseconds();
+	time = Sys_Milliseconds();
 
 	loopFrame++;
 	for ( loop = activeLoopSounds ; loop != NULL ; loop = loop->next ) {
@@ -1045,6 +1266,10 @@ void S_Base_RawSamples( int stream, int samples, int rate, int width, int s_chan
 		return;
 	}
 
+	// catch the listeners up with everything the mixer has been handed
+	S_LockMixer();
+	S_RunCommands();
+
 	rawsamples = s_rawsamples[stream];
 
 	if ( s_muted->integer ) {
@@ -1146,6 +1371,8 @@ void S_Base_RawSamples( int stream, int samples, int rate, int width, int s_chan
 	if ( s_rawend[stream] > s_soundtime + MAX_RAW_SAMPLES ) {
 		Com_DPrintf( "S_Base_RawSamples: overflowed %i > %i\n", s_rawend[stream], s_soundtime );
 	}
+
+	S_UnlockMixer();
 }
 
 //=============================================================================
@@ -1158,10 +1385,15 @@ let the sound system know where an entity currently is
 ======================
 */
 void S_Base_UpdateEntityPosition( int entityNum, const vec3_t origin ) {
+	soundCommand_t *cmd;
+
 	if ( entityNum < 0 || entityNum >= MAX_GENTITIES ) {
 		Com_Error( ERR_DROP, "S_UpdateEntityPosition: bad entitynum %i", entityNum );
 	}
-	VectorCopy( origin, loopSounds[entityNum].origin );
+
+	cmd = S_QueueCommand( SC_UPDATE_ENTITY );
+	cmd->entityNum = entityNum;
+	VectorCopy( origin, cmd->origin );
 }
 
 
@@ -1173,12 +1405,18 @@ Change the volumes of all the playing sounds for changes in their positions
 ============
 */
 void S_Base_Respatialize( int entityNum, const vec3_t origin, vec3_t axis[3], int inwater, qboolean firstPerson ) {
+	soundCommand_t *cmd;
+
 	if ( !s_soundStarted || s_soundMuted ) {
 		return;
 	}
 
-	S_UpdateListener(entityNum, origin, (const vec3_t *)axis, inwater, firstPerson);
-	respatialize = qtrue;
+	cmd = S_QueueCommand( SC_RESPATIALIZE );
+	cmd->entityNum = entityNum;
+	cmd->inwater = inwater;
+	cmd->flag = firstPerson;
+	VectorCopy( origin, cmd->origin );
+	AxisCopy( axis, cmd->axis );
 }
 
 
@@ -1221,22 +1459,16 @@ qboolean S_ScanChannelStarts( void ) {
 
 /*
 ============
-S_Update
+S_MixerEndFrame
 
-Called once each time through the main loop
+Change the volumes of all the playing sounds for changes in their positions
 ============
 */
-void S_Base_Update( void ) {
+static void S_MixerEndFrame( void ) {
 	int			i;
 	vec3_t		origin;
-	int			total;
 	channel_t	*ch;
 
-	if ( !s_soundStarted || s_soundMuted ) {
-//		Com_DPrintf ("not started or muted\n");
-		return;
-	}
-
 	// update spatialization for dynamic sounds
 	if (respatialize) {
 		respatialize = qfalse;
@@ -1266,27 +1498,189 @@ void S_Base_Update( void ) {
 		S_AddLoopSounds ();
 	}
 
+	s_listenersStale = qtrue;
+}
+
+/*
+============
+S_RunCommands
+
+Applies everything the main thread has published,
+the caller must hold the mixer lock
+============
+*/
+static void S_RunCommands( void ) {
+	soundCommand_t	*cmd;
+	int				head, tail;
+
+	head = Sys_AtomicLoad( &s_commandHead );
+	tail = s_commandTail;
+
+	for ( ; tail != head ; tail = ( tail + 1 ) & ( MAX_SOUND_COMMANDS - 1 ) ) {
+		cmd = &s_commands[ tail ];
+
+		if ( s_listenersStale ) {
+			S_ListenersEndFrame();
+			s_listenersStale = qfalse;
+		}
+
+		switch ( cmd->type ) {
+		case SC_START_SOUND:
+			S_MixerStartSound( cmd );
+			break;
+		case SC_STOP_LOOPING:
+			S_MixerStopLoopingSound( cmd->entityNum );
+			break;
+		case SC_CLEAR_LOOPING:
+			S_MixerClearLoopingSounds( cmd->flag );
+			break;
+		case SC_ADD_LOOPING:
+			S_MixerAddLoopingSound( cmd );
+			break;
+		case SC_ADD_REAL_LOOPING:
+			S_MixerAddRealLoopingSound( cmd );
+			break;
+		case SC_UPDATE_ENTITY:
+			VectorCopy( cmd->origin, loopSounds[ cmd->entityNum ].origin );
+			break;
+		case SC_RESPATIALIZE:
+			S_UpdateListener( cmd->entityNum, cmd->origin, (const vec3_t *)cmd->axis, cmd->inwater, cmd->flag );
+			respatialize = qtrue;
+			break;
+		case SC_END_FRAME:
+			S_MixerEndFrame();
+			break;
+		}
+	}
+
+	Sys_AtomicStore( &s_commandTail, tail );
+}
+
+/*
+============
+S_MixThread
+
+Mixes ahead into the dma buffer on its own schedule, so a long
+frame on the main thread doesn't starve the device
+============
+*/
+static int S_MixThread( void *data ) {
+	while ( !Sys_AtomicLoad( &s_mixThreadQuit ) ) {
+		Sys_LockMutex( s_mixMutex );
+
+		// video capture paces the mix by frames, see S_GetSoundtime
+		if ( !CL_VideoRecording() ) {
+			S_RunCommands();
+			S_Update_();
+		}
+
+		Sys_UnlockMutex( s_mixMutex );
+
+		Sys_Sleep( MIX_THREAD_MSEC );
+	}
+
+	return 0;
+}
+
+/*
+============
+S_StartMixThread
+============
+*/
+static void S_StartMixThread( void ) {
+	s_mixMutex = Sys_CreateMutex();
+	if ( !s_mixMutex ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: couldn't create sound mixer lock, mixing on the main thread\n" );
+		return;
+	}
+
+	s_mixThreadQuit = 0;
+	s_mixThreadHandle = Sys_CreateThread( S_MixThread, NULL );
+	if ( !s_mixThreadHandle ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: couldn't start sound mixer thread, mixing on the main thread\n" );
+		Sys_DestroyMutex( s_mixMutex );
+		s_mixMutex = NULL;
+	}
+}
+
+/*
+============
+S_StopMixThread
+============
+*/
+static void S_StopMixThread( void ) {
+	if ( s_mixThreadHandle ) {
+		Sys_AtomicStore( &s_mixThreadQuit, 1 );
+		Sys_WaitThread( s_mixThreadHandle );
+		s_mixThreadHandle = NULL;
+	}
+
+	if ( s_mixMutex ) {
+		Sys_DestroyMutex( s_mixMutex );
+		s_mixMutex = NULL;
+	}
+
+	s_commandHead = s_commandTail = s_commandPending = 0;
+	s_listenersStale = qfalse;
+}
+
+/*
+============
+S_Update
+
+Called once each time through the main loop
+============
+*/
+void S_Base_Update( void ) {
+	int			i;
+	int			total;
+	channel_t	*ch;
+
+	if ( !s_soundStarted || s_soundMuted ) {
+//		Com_DPrintf ("not started or muted\n");
+		return;
+	}
+
+	// hand the frame to the mixer
+	S_QueueCommand( SC_END_FRAME );
+	Sys_AtomicStore( &s_commandHead, s_commandPending );
+
 	//
 	// debugging output
 	//
-	if ( s_show->integer == 2 ) {
-		total = 0;
-		ch = s_channels;
-		for (i=0 ; i<MAX_CHANNELS; i++, ch++) {
-			if (ch->thesfx && (ch->leftvol || ch->rightvol) ) {
-				Com_Printf ("%d %d %s\n", ch->leftvol, ch->rightvol, ch->thesfx->soundName);
-				total++;
+	if ( s_show->integer == 2 || s_droppedSounds ) {
+		S_LockMixer();
+
+		if ( s_show->integer == 2 ) {
+			total = 0;
+			ch = s_channels;
+			for (i=0 ; i<MAX_CHANNELS; i++, ch++) {
+				if (ch->thesfx && (ch->leftvol || ch->rightvol) ) {
+					Com_Printf ("%d %d %s\n", ch->leftvol, ch->rightvol, ch->thesfx->soundName);
+					total++;
+				}
 			}
+
+			Com_Printf ("----(%i)---- painted: %i\n", total, s_paintedtime);
 		}
-		
-		Com_Printf ("----(%i)---- painted: %i\n", total, s_paintedtime);
+
+		for ( ; s_droppedSounds > 0 ; s_droppedSounds-- ) {
+			Com_Printf("dropping sound\n");
+		}
+
+		S_UnlockMixer();
 	}
 
 	// add raw data from streamed samples
 	S_UpdateStreamingSounds();
 
-	// mix some sound
-	S_Update_();
+	// mix some sound, the mixer thread does this on its own
+	if ( !s_mixThreadHandle || CL_VideoRecording() ) {
+		S_LockMixer();
+		S_RunCommands();
+		S_Update_();
+		S_UnlockMixer();
+	}
 }
 
 void S_GetSoundtime(void)
@@ -1318,7 +1712,7 @@ void S_GetSoundtime(void)
 		{	// time to chop things off to avoid 32 bit limits
 			buffers = 0;
 			s_paintedtime = dma.fullsamples;
-			S_Base_StopAllSounds ();
+			S_ClearMixer ();
 		}
 	}
 	oldsamplepos = samplepos;
@@ -1353,7 +1747,7 @@ void S_Update_(void) {
 		return;
 	}
 
-	thisTime = Com_Milliseconds();
+	thisTime = Sys_Milliseconds();
 
 	// Updates s_soundtime
 	S_GetSoundtime();
@@ -1411,6 +1805,210 @@ background music functions
 ===============================================================================
 */
 
+/*
+======================
+S_DecodeStream
+
+Runs on the decode thread, decodes until the stream's pcm buffer is full
+======================
+*/
+static void S_DecodeStream( streamDecode_t *sd ) {
+	snd_stream_t	*stream = sd->stream;
+	int				head, space, ofs, bytes, r;
+
+	head = sd->pcmHead;
+
+	while ( !Sys_AtomicLoad( &sd->readAhead.abort ) ) {
+		space = STREAM_PCM_SIZE - ( head - Sys_AtomicLoad( &sd->pcmTail ) );
+		ofs = head & ( STREAM_PCM_SIZE - 1 );
+
+		bytes = MIN( space, STREAM_PCM_SIZE - ofs );
+		bytes = MIN( bytes, STREAM_DECODE_CHUNK );
+		bytes -= bytes % ( stream->info.width * stream->info.channels );
+		if ( bytes <= 0 ) {
+			break;
+		}
+
+		r = S_CodecReadStream( stream, bytes, &sd->pcm[ ofs ] );
+		if ( r <= 0 ) {
+			Sys_AtomicStore( &sd->decodeEnd, qtrue );
+			break;
+		}
+
+		head += r;
+		Sys_AtomicStore( &sd->pcmHead, head );
+	}
+}
+
+/*
+======================
+S_StreamThread
+======================
+*/
+static int S_StreamThread( void *data ) {
+	streamDecode_t	*sd;
+	int				i;
+
+	for ( ;; ) {
+		Sys_SemaphoreWait( s_streamWake );
+
+		if ( Sys_AtomicLoad( &s_streamThreadQuit ) ) {
+			break;
+		}
+
+		for ( i = 0, sd = s_streamDecode; i < MAX_STREAMING_SOUNDS; i++, sd++ ) {
+			Sys_LockMutex( sd->busy );
+			if ( sd->stream && !sd->decodeEnd ) {
+				S_DecodeStream( sd );
+			}
+			Sys_UnlockMutex( sd->busy );
+		}
+	}
+
+	return 0;
+}
+
+/*
+======================
+S_ReadDecodedStream
+
+Copies out up to bytes of decoded samples, main thread only
+======================
+*/
+static int S_ReadDecodedStream( streamDecode_t *sd, int bytes, byte *buffer ) {
+	int		tail, ofs, chunk;
+
+	tail = sd->pcmTail;
+	bytes = MIN( bytes, Sys_AtomicLoad( &sd->pcmHead ) - tail );
+
+	ofs = tail & ( STREAM_PCM_SIZE - 1 );
+	chunk = MIN( bytes, STREAM_PCM_SIZE - ofs );
+	Com_Memcpy( buffer, &sd->pcm[ ofs ], chunk );
+	Com_Memcpy( buffer + chunk, sd->pcm, bytes - chunk );
+
+	Sys_AtomicStore( &sd->pcmTail, tail + bytes );
+
+	return bytes;
+}
+
+/*
+======================
+S_StartStreamDecode
+
+Hands a freshly opened stream to the decode thread
+======================
+*/
+static void S_StartStreamDecode( int stream ) {
+	streamDecode_t	*sd = &s_streamDecode[ stream ];
+
+	if ( !s_streamThreadHandle ) {
+		return;
+	}
+
+	Sys_LockMutex( sd->busy );
+
+	if ( S_CodecStreamReadAhead( s_backgroundStream[ stream ], &sd->readAhead ) ) {
+		sd->pcmHead = sd->pcmTail = 0;
+		sd->decodeEnd = qfalse;
+		sd->started = qfalse;
+		sd->stream = s_backgroundStream[ stream ];
+	}
+
+	Sys_UnlockMutex( sd->busy );
+
+	Sys_SemaphorePost( s_streamWake );
+}
+
+/*
+======================
+S_StopStreamDecode
+
+Takes a stream back from the decode thread before it's closed
+======================
+*/
+static void S_StopStreamDecode( int stream ) {
+	streamDecode_t	*sd = &s_streamDecode[ stream ];
+
+	if ( !sd->stream ) {
+		return;
+	}
+
+	// wake the decoder if it's waiting on the file
+	Sys_AtomicStore( &sd->readAhead.abort, qtrue );
+	Sys_SemaphorePost( sd->readAhead.posted );
+
+	Sys_LockMutex( sd->busy );
+	sd->stream->readAhead = NULL;
+	sd->stream = NULL;
+	Sys_UnlockMutex( sd->busy );
+}
+
+/*
+======================
+S_StartStreamThread
+======================
+*/
+static void S_StartStreamThread( void ) {
+	streamDecode_t	*sd;
+	int				i;
+
+	s_streamWake = Sys_CreateSemaphore( 0 );
+
+	for ( i = 0, sd = s_streamDecode; s_streamWake && i < MAX_STREAMING_SOUNDS; i++, sd++ ) {
+		sd->busy = Sys_CreateMutex();
+		sd->readAhead.posted = Sys_CreateSemaphore( 0 );
+		if ( !sd->busy || !sd->readAhead.posted ) {
+			break;
+		}
+	}
+
+	if ( i == MAX_STREAMING_SOUNDS ) {
+		s_streamThreadQuit = 0;
+		s_streamThreadHandle = Sys_CreateThread( S_StreamThread, NULL );
+	}
+
+	if ( !s_streamThreadHandle ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: couldn't start stream decode thread, decoding on the main thread\n" );
+	}
+}
+
+/*
+======================
+S_StopStreamThread
+======================
+*/
+static void S_StopStreamThread( void ) {
+	streamDecode_t	*sd;
+	int				i;
+
+	for ( i = 0; i < MAX_STREAMING_SOUNDS; i++ ) {
+		S_StopStreamDecode( i );
+	}
+
+	if ( s_streamThreadHandle ) {
+		Sys_AtomicStore( &s_streamThreadQuit, 1 );
+		Sys_SemaphorePost( s_streamWake );
+		Sys_WaitThread( s_streamThreadHandle );
+		s_streamThreadHandle = NULL;
+	}
+
+	for ( i = 0, sd = s_streamDecode; i < MAX_STREAMING_SOUNDS; i++, sd++ ) {
+		if ( sd->busy ) {
+			Sys_DestroyMutex( sd->busy );
+			sd->busy = NULL;
+		}
+		if ( sd->readAhead.posted ) {
+			Sys_DestroySemaphore( sd->readAhead.posted );
+			sd->readAhead.posted = NULL;
+		}
+	}
+
+	if ( s_streamWake ) {
+		Sys_DestroySemaphore( s_streamWake );
+		s_streamWake = NULL;
+	}
+}
+
 /*
 ======================
 S_StopStreamingSound
@@ -1421,6 +2019,7 @@ void S_Base_StopStreamingSound( int stream ) {
 		return;
 	if(!s_backgroundStream[stream])
 		return;
+	S_StopStreamDecode(stream);
 	S_CodecCloseStream(s_backgroundStream[stream]);
 	s_backgroundStream[stream] = NULL;
 	s_rawend[stream] = 0;
@@ -1445,6 +2044,7 @@ void S_Base_OpenStream( int stream, const char *filename ) {
 	// if restarting the same back ground track
 	if(s_backgroundStream[stream])
 	{
+		S_StopStreamDecode(stream);
 		S_CodecCloseStream(s_backgroundStream[stream]);
 		s_backgroundStream[stream] = NULL;
 	}
@@ -1459,6 +2059,8 @@ void S_Base_OpenStream( int stream, const char *filename ) {
 	if(s_backgroundStream[stream]->info.channels != 2 || (s_backgroundStream[stream]->info.rate != 22050 && s_backgroundStream[stream]->info.rate != 44100)) {
 		Com_DPrintf(S_COLOR_YELLOW "WARNING: music file %s is not 22kHz or 44.1kHz stereo\n", filename );
 	}
+
+	S_StartStreamDecode(stream);
 }
 
 /*
@@ -1561,12 +2163,22 @@ void S_UpdateStreamingSounds( void ) {
 	int		fileBytes;
 	int		r;
 	int		stream;
+	qboolean	decodeEnd;
+	streamDecode_t	*sd;
 
 	for ( stream = 0; stream < MAX_STREAMING_SOUNDS; stream++ ) {
 		if(!s_backgroundStream[stream]) {
 			continue;
 		}
 
+		sd = &s_streamDecode[stream];
+
+		// keep the decoder fed even while it isn't being listened
+		// to, it may be waiting on the file
+		if ( sd->stream ) {
+			S_CodecFillReadAhead( sd->stream );
+		}
+
 		// don't bother playing anything if musicvolume is 0
 		if ( s_musicVolume->value <= 0 ) {
 			continue;
@@ -1594,7 +2206,23 @@ void S_UpdateStreamingSounds( void ) {
 			}
 
 			// Read
-			r = S_CodecReadStream(s_backgroundStream[stream], fileBytes, raw);
+			if ( sd->stream ) {
+				decodeEnd = Sys_AtomicLoad( &sd->decodeEnd );
+				r = S_ReadDecodedStream( sd, fileBytes, raw );
+
+				if ( r <= 0 && !decodeEnd ) {
+					// try again next frame
+					if ( sd->started ) {
+						sd->underruns++;
+					}
+					break;
+				}
+
+				sd->started = qtrue;
+			} else {
+				r = S_CodecReadStream(s_backgroundStream[stream], fileBytes, raw);
+			}
+
 			if(r < fileBytes)
 			{
 				fileSamples = r / (s_backgroundStream[stream]->info.width * s_backgroundStream[stream]->info.channels);
@@ -1628,6 +2256,10 @@ void S_UpdateStreamingSounds( void ) {
 
 		}
 	}
+
+	if ( s_streamThreadHandle ) {
+		Sys_SemaphorePost( s_streamWake );
+	}
 }
 
 
@@ -1642,9 +2274,36 @@ void S_FreeOldestSound( void ) {
 	sfx_t	*sfx;
 	sndBuffer	*buffer, *nbuffer;
 
-	oldest = Com_Milliseconds();
+	oldest = Sys_Milliseconds();
 	used = 0;
 
+	// a queued sound may still be playing from it
+	S_LockMixer();
+
+	// squeeze the least recently used 16 bit mono sound down to adpcm
+	// before throwing anything away, it can still play without a reload
+	for (i=1 ; i < s_numSfx ; i++) {
+		sfx = &s_knownSfx[i];
+		if (sfx->inMemory && sfx->lastTimeUsed<oldest && sfx->soundCompressionMethod == 0
+			&& sfx->soundChannels == 1 && sfx->soundLength > SND_CHUNK_SIZE) {
+			used = i;
+			oldest = sfx->lastTimeUsed;
+		}
+	}
+
+	if (used) {
+		sfx = &s_knownSfx[used];
+
+		Com_DPrintf("S_FreeOldestSound: compressing sound %s\n", sfx->soundName);
+
+		S_AdpcmCompressSound(sfx);
+
+		S_UnlockMixer();
+		return;
+	}
+
+	oldest = Sys_Milliseconds();
+
 	for (i=1 ; i < s_numSfx ; i++) {
 		sfx = &s_knownSfx[i];
 		if (sfx->inMemory && sfx->lastTimeUsed<oldest) {
@@ -1665,6 +2324,8 @@ void S_FreeOldestSound( void ) {
 	}
 	sfx->inMemory = qfalse;
 	sfx->soundData = NULL;
+
+	S_UnlockMixer();
 }
 
 // =======================================================================
@@ -1676,6 +2337,9 @@ void S_Base_Shutdown( void ) {
 		return;
 	}
 
+	S_StopMixThread();
+	S_StopStreamThread();
+
 	SNDDMA_Shutdown();
 	SND_shutdown();
 
@@ -1701,6 +2365,10 @@ qboolean S_Base_Init( soundInterface_t *si ) {
 	s_mixPreStep = Cvar_Get ("s_mixPreStep", "0.05", CVAR_ARCHIVE);
 	s_show = Cvar_Get ("s_show", "0", CVAR_CHEAT);
 	s_testsound = Cvar_Get ("s_testsound", "0", CVAR_CHEAT);
+	s_mixThread = Cvar_Get ("s_mixThread", "1", CVAR_ARCHIVE);
+	s_streamThread = Cvar_Get ("s_streamThread", "1", CVAR_ARCHIVE);
+
+	S_InitMixKernels();
 
 	r = SNDDMA_Init();
 
@@ -1717,6 +2385,14 @@ qboolean S_Base_Init( soundInterface_t *si ) {
 		respatialize = 0;
 
 		S_Base_StopAllSounds( );
+
+		if ( s_mixThread->integer ) {
+			S_StartMixThread( );
+		}
+
+		if ( s_streamThread->integer ) {
+			S_StartStreamThread( );
+		}
 	} else {
 		return qfalse;
 	}
@@ -189,7 +189,7 @@ typedef struct
 extern listener_t listeners[MAX_LISTENERS];
 
 void S_ListenersInit(void);
-void S_ListenersEndFrame(void);
+void S_ListenersEndFrame(void);	// backends call this once a frame is spatialized
 qboolean S_HearingThroughEntity( int entityNum );
 qboolean S_EntityIsListener(int entityNum);
 int S_ClosestListener(const vec3_t origin);
@@ -261,6 +261,7 @@ void		SND_free(sndBuffer *v);
 sndBuffer*	SND_malloc( void );
 void		SND_setup( void );
 void		SND_shutdown(void);
+short		*SND_DecodedChunk( sndBuffer *chunk );
 
 void S_PaintChannels(int endtime);
 
@@ -272,6 +273,7 @@ void S_Spatialize(channel_t *ch);
 // adpcm functions
 int  S_AdpcmMemoryNeeded( const wavinfo_t *info );
 void S_AdpcmEncodeSound( sfx_t *sfx, short *samples );
+void S_AdpcmCompressSound( sfx_t *sfx );
 void S_AdpcmGetSamples(sndBuffer *chunk, short *to);
 
 // wavelet function
@@ -312,3 +314,15 @@ qboolean S_AL_Init( soundInterface_t *si );
 #ifdef idppc_altivec
 void S_PaintChannelFrom16_altivec( portable_samplepair_t paintbuffer[PAINTBUFFER_SIZE], int snd_vol, channel_t *ch, const sfx_t *sc, int count, int sampleOffset, int bufferOffset );
 #endif
+
+void S_InitMixKernels( void );
+
+#if id386 || idx64
+void S_MixMono16_sse2( portable_samplepair_t *samp, const short *samples, int count, int leftvol, int rightvol );
+void S_MixStereo16_sse2( portable_samplepair_t *samp, const short *samples, int count, int leftvol, int rightvol );
+void S_ClipStereo16_sse2( short *out, const int *in, int count );
+
+void S_MixMono16_avx2( portable_samplepair_t *samp, const short *samples, int count, int leftvol, int rightvol );
+void S_MixStereo16_avx2( portable_samplepair_t *samp, const short *samples, int count, int leftvol, int rightvol );
+void S_ClipStereo16_avx2( short *out, const int *in, int count );
+#endif
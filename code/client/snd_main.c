@@ -568,8 +568,6 @@ void S_Update( void )
 	if( si.Update ) {
 		si.Update( );
 	}
-
-	S_ListenersEndFrame();
 }
 
 /*
@@ -59,7 +59,28 @@ short *sfxScratchBuffer = NULL;
 sfx_t *sfxScratchPointer = NULL;
 int	   sfxScratchIndex = 0;
 
+// adpcm chunks decoded for the mixer, the least recently used is replaced
+#define	DECODED_CHUNKS	64
+
+typedef struct {
+	sndBuffer	*chunk;
+	int			lastUsed;
+	short		samples[SND_CHUNK_SIZE_BYTE*2];
+} decodedChunk_t;
+
+static decodedChunk_t	*decodedChunks = NULL;
+static int				decodedUses = 0;
+
 void	SND_free(sndBuffer *v) {
+	int		i;
+
+	// the chunk may come back holding a different sound
+	for (i = 0; i < DECODED_CHUNKS; i++) {
+		if (decodedChunks[i].chunk == v) {
+			decodedChunks[i].chunk = NULL;
+		}
+	}
+
 	*(sndBuffer **)v = freelist;
 	freelist = (sndBuffer*)v;
 	inUse += sizeof(sndBuffer);
@@ -96,6 +117,9 @@ void SND_setup(void) {
 	sfxScratchBuffer = malloc(SND_CHUNK_SIZE * sizeof(short) * 4);	//Hunk_Alloc(SND_CHUNK_SIZE * sizeof(short) * 4);
 	sfxScratchPointer = NULL;
 
+	decodedChunks = calloc(DECODED_CHUNKS, sizeof(decodedChunk_t));
+	decodedUses = 0;
+
 	inUse = scs*sizeof(sndBuffer);
 	p = buffer;;
 	q = p + scs;
@@ -110,10 +134,43 @@ void SND_setup(void) {
 
 void SND_shutdown(void)
 {
+		free(decodedChunks);
 		free(sfxScratchBuffer);
 		free(buffer);
 }
 
+/*
+================
+SND_DecodedChunk
+
+Returns the samples of an adpcm chunk, decoding it in place of
+the least recently used one if it isn't already decoded
+================
+*/
+short *SND_DecodedChunk(sndBuffer *chunk) {
+	decodedChunk_t	*dc, *lru;
+	int				i;
+
+	decodedUses++;
+
+	lru = decodedChunks;
+	for (i = 0, dc = decodedChunks; i < DECODED_CHUNKS; i++, dc++) {
+		if (dc->chunk == chunk) {
+			dc->lastUsed = decodedUses;
+			return dc->samples;
+		}
+		if (dc->lastUsed < lru->lastUsed) {
+			lru = dc;
+		}
+	}
+
+	S_AdpcmGetSamples(chunk, lru->samples);
+	lru->chunk = chunk;
+	lru->lastUsed = decodedUses;
+
+	return lru->samples;
+}
+
 /*
 ================
 ResampleSfx
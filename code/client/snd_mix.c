@@ -39,6 +39,84 @@ int*     snd_p;
 int      snd_linear_count;
 short*   snd_out;
 
+/*
+===============================================================================
+
+MIX KERNELS
+
+The inner loops of channel painting and of the 16-bit stereo transfer,
+with SSE2 and AVX2 versions in snd_sse2.c and snd_avx2.c.
+
+===============================================================================
+*/
+
+typedef void (*mixKernel_t)( portable_samplepair_t *samp, const short *samples, int count, int leftvol, int rightvol );
+typedef void (*clipKernel_t)( short *out, const int *in, int count );
+
+static mixKernel_t	S_MixMono16;
+static mixKernel_t	S_MixStereo16;
+static clipKernel_t	S_ClipStereo16;
+
+static void S_MixMono16_scalar( portable_samplepair_t *samp, const short *samples, int count, int leftvol, int rightvol ) {
+	int		i, data;
+
+	for ( i=0 ; i<count ; i++ ) {
+		data = samples[i];
+		samp[i].left += (data * leftvol)>>8;
+		samp[i].right += (data * rightvol)>>8;
+	}
+}
+
+// count is in sample pairs
+static void S_MixStereo16_scalar( portable_samplepair_t *samp, const short *samples, int count, int leftvol, int rightvol ) {
+	int		i;
+
+	for ( i=0 ; i<count ; i++ ) {
+		samp[i].left += (samples[i*2] * leftvol)>>8;
+		samp[i].right += (samples[i*2+1] * rightvol)>>8;
+	}
+}
+
+/*
+===================
+S_InitMixKernels
+
+Picks the fastest kernels the CPU supports, like Com_DetectSSE
+===================
+*/
+void S_InitMixKernels( void ) {
+	cvar_t			*s_mixSIMD;
+#if id386 || idx64
+	cpuFeatures_t	feat;
+#endif
+
+	S_MixMono16 = S_MixMono16_scalar;
+	S_MixStereo16 = S_MixStereo16_scalar;
+	S_ClipStereo16 = NULL;	// S_WriteLinearBlastStereo16
+
+	s_mixSIMD = Cvar_Get( "s_mixSIMD", "1", CVAR_ARCHIVE );
+
+	if ( !s_mixSIMD->integer ) {
+		return;
+	}
+
+#if id386 || idx64
+	feat = Sys_GetProcessorFeatures();
+
+	if ( feat & CF_AVX2 ) {
+		S_MixMono16 = S_MixMono16_avx2;
+		S_MixStereo16 = S_MixStereo16_avx2;
+		S_ClipStereo16 = S_ClipStereo16_avx2;
+		Com_Printf( "Sound mixing uses AVX2\n" );
+	} else if ( idx64 || ( feat & CF_SSE2 ) ) {
+		S_MixMono16 = S_MixMono16_sse2;
+		S_MixStereo16 = S_MixStereo16_sse2;
+		S_ClipStereo16 = S_ClipStereo16_sse2;
+		Com_Printf( "Sound mixing uses SSE2\n" );
+	}
+#endif
+}
+
 #if	!id386                                        // if configured not to use asm
 
 void S_WriteLinearBlastStereo16 (void)
@@ -138,7 +216,11 @@ void S_TransferStereo16 (unsigned long *pbuf, int endtime)
 		snd_linear_count <<= 1; // snd_linear_count *= dma.channels
 
 	// write a linear blast of samples
-		S_WriteLinearBlastStereo16 ();
+		if ( S_ClipStereo16 ) {
+			S_ClipStereo16( snd_out, snd_p, snd_linear_count );
+		} else {
+			S_WriteLinearBlastStereo16 ();
+		}
 
 		snd_p += snd_linear_count;
 		ls_paintedtime += (snd_linear_count>>1); // snd_linear_count / dma.channels
@@ -265,9 +347,9 @@ CHANNEL MIXING
 */
 
 static void S_PaintChannelFrom16_scalar( channel_t *ch, const sfx_t *sc, int count, int sampleOffset, int bufferOffset ) {
-	int						data, aoff, boff;
+	int						aoff, boff;
 	int						leftvol, rightvol;
-	int						i, j;
+	int						i, j, run;
 	portable_samplepair_t	*samp;
 	sndBuffer				*chunk;
 	short					*samples;
@@ -304,14 +386,17 @@ static void S_PaintChannelFrom16_scalar( channel_t *ch, const sfx_t *sc, int cou
 		leftvol = ch->leftvol*snd_vol;
 		rightvol = ch->rightvol*snd_vol;
 		samples = chunk->sndChunk;
-		for ( i=0 ; i<count ; i++ ) {
-			data  = samples[sampleOffset++];
-			samp[i].left += (data * leftvol)>>8;
-
+		// mix the runs up to each chunk boundary
+		for ( i=0 ; i<count ; i+=run ) {
 			if ( sc->soundChannels == 2 ) {
-				data = samples[sampleOffset++];
+				run = MIN( count - i, (SND_CHUNK_SIZE - sampleOffset) / 2 );
+				S_MixStereo16( samp + i, samples + sampleOffset, run, leftvol, rightvol );
+				sampleOffset += run * 2;
+			} else {
+				run = MIN( count - i, SND_CHUNK_SIZE - sampleOffset );
+				S_MixMono16( samp + i, samples + sampleOffset, run, leftvol, rightvol );
+				sampleOffset += run;
 			}
-			samp[i].right += (data * rightvol)>>8;
 
 			if (sampleOffset == SND_CHUNK_SIZE) {
 				chunk = chunk->next;
@@ -371,9 +456,8 @@ static void S_PaintChannelFrom16( channel_t *ch, const sfx_t *sc, int count, int
 }
 
 void S_PaintChannelFromWavelet( channel_t *ch, sfx_t *sc, int count, int sampleOffset, int bufferOffset ) {
-	int						data;
 	int						leftvol, rightvol;
-	int						i;
+	int						i, run;
 	portable_samplepair_t	*samp;
 	sndBuffer				*chunk;
 	short					*samples;
@@ -398,10 +482,10 @@ void S_PaintChannelFromWavelet( channel_t *ch, sfx_t *sc, int count, int sampleO
 
 	samples = sfxScratchBuffer;
 
-	for ( i=0 ; i<count ; i++ ) {
-		data  = samples[sampleOffset++];
-		samp[i].left += (data * leftvol)>>8;
-		samp[i].right += (data * rightvol)>>8;
+	for ( i=0 ; i<count ; i+=run ) {
+		run = MIN( count - i, SND_CHUNK_SIZE*2 - sampleOffset );
+		S_MixMono16( samp + i, samples + sampleOffset, run, leftvol, rightvol );
+		sampleOffset += run;
 
 		if (sampleOffset == SND_CHUNK_SIZE*2) {
 			chunk = chunk->next;
@@ -413,9 +497,8 @@ void S_PaintChannelFromWavelet( channel_t *ch, sfx_t *sc, int count, int sampleO
 }
 
 void S_PaintChannelFromADPCM( channel_t *ch, sfx_t *sc, int count, int sampleOffset, int bufferOffset ) {
-	int						data;
 	int						leftvol, rightvol;
-	int						i;
+	int						i, run;
 	portable_samplepair_t	*samp;
 	sndBuffer				*chunk;
 	short					*samples;
@@ -423,7 +506,6 @@ void S_PaintChannelFromADPCM( channel_t *ch, sfx_t *sc, int count, int sampleOff
 	leftvol = ch->leftvol*snd_vol;
 	rightvol = ch->rightvol*snd_vol;
 
-	i = 0;
 	samp = &paintbuffer[ bufferOffset ];
 	chunk = sc->soundData;
 
@@ -434,27 +516,19 @@ void S_PaintChannelFromADPCM( channel_t *ch, sfx_t *sc, int count, int sampleOff
 	while (sampleOffset>=(SND_CHUNK_SIZE*4)) {
 		chunk = chunk->next;
 		sampleOffset -= (SND_CHUNK_SIZE*4);
-		i++;
-	}
-
-	if (i!=sfxScratchIndex || sfxScratchPointer != sc) {
-		S_AdpcmGetSamples( chunk, sfxScratchBuffer );
-		sfxScratchIndex = i;
-		sfxScratchPointer = sc;
 	}
 
-	samples = sfxScratchBuffer;
+	samples = SND_DecodedChunk( chunk );
 
-	for ( i=0 ; i<count ; i++ ) {
-		data  = samples[sampleOffset++];
-		samp[i].left += (data * leftvol)>>8;
-		samp[i].right += (data * rightvol)>>8;
+	for ( i=0 ; i<count ; i+=run ) {
+		run = MIN( count - i, SND_CHUNK_SIZE*4 - sampleOffset );
+		S_MixMono16( samp + i, samples + sampleOffset, run, leftvol, rightvol );
+		sampleOffset += run;
 
-		if (sampleOffset == SND_CHUNK_SIZE*4) {
+		if (sampleOffset == SND_CHUNK_SIZE*4 && i + run < count) {
 			chunk = chunk->next;
-			S_AdpcmGetSamples( chunk, sfxScratchBuffer);
+			samples = SND_DecodedChunk( chunk );
 			sampleOffset = 0;
-			sfxScratchIndex++;
 		}
 	}
 }
@@ -462,10 +536,11 @@ void S_PaintChannelFromADPCM( channel_t *ch, sfx_t *sc, int count, int sampleOff
 void S_PaintChannelFromMuLaw( channel_t *ch, sfx_t *sc, int count, int sampleOffset, int bufferOffset ) {
 	int						data;
 	int						leftvol, rightvol;
-	int						i;
+	int						i, j, run;
 	portable_samplepair_t	*samp;
 	sndBuffer				*chunk;
 	byte					*samples;
+	short					decoded[SND_CHUNK_SIZE*2];
 	float					ooff;
 
 	leftvol = ch->leftvol*snd_vol;
@@ -483,12 +558,15 @@ void S_PaintChannelFromMuLaw( channel_t *ch, sfx_t *sc, int count, int sampleOff
 
 	if (!ch->doppler) {
 		samples = (byte *)chunk->sndChunk + sampleOffset;
-		for ( i=0 ; i<count ; i++ ) {
-			data  = mulawToShort[*samples];
-			samp[i].left += (data * leftvol)>>8;
-			samp[i].right += (data * rightvol)>>8;
-			samples++;
-			if (chunk != NULL && samples == (byte *)chunk->sndChunk+(SND_CHUNK_SIZE*2)) {
+		// decode up to each chunk boundary and mix that
+		for ( i=0 ; i<count ; i+=run ) {
+			run = MIN( count - i, (byte *)chunk->sndChunk+(SND_CHUNK_SIZE*2) - samples );
+			for ( j=0 ; j<run ; j++ ) {
+				decoded[j] = mulawToShort[samples[j]];
+			}
+			S_MixMono16( samp + i, decoded, run, leftvol, rightvol );
+			samples += run;
+			if (samples == (byte *)chunk->sndChunk+(SND_CHUNK_SIZE*2)) {
 				chunk = chunk->next;
 				samples = (byte *)chunk->sndChunk;
 			}
@@ -2311,6 +2311,8 @@ void S_AL_Update( void )
 	s_musicVolume->modified = qfalse;
 	s_alMinDistance->modified = qfalse;
 	s_alRolloff->modified = qfalse;
+
+	S_ListenersEndFrame();
 }
 
 /*
@@ -0,0 +1,151 @@
+/*
+===========================================================================
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of Spearmint Source Code.
+
+Spearmint Source Code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 3 of the License,
+or (at your option) any later version.
+
+Spearmint Source Code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Spearmint Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, Spearmint Source Code is also subject to certain additional terms.
+You should have received a copy of these additional terms immediately following
+the terms and conditions of the GNU General Public License.  If not, please
+request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional
+terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc.,
+Suite 120, Rockville, Maryland 20850 USA.
+===========================================================================
+*/
+
+/* SSE2 mixing kernels for the DMA sound mixer, picked at runtime by
+   S_InitMixKernels. SSE2 is always there on x86_64; 32-bit x86 builds
+   compile this file with -msse2 and only call it when the CPU has it. */
+
+#include "client.h"
+#include "snd_local.h"
+
+#if id386 || idx64
+
+#include <emmintrin.h>
+
+/*
+===================
+S_MixSSE2
+
+Adds (d * vol) >> 8 for eight 16-bit samples to eight ints of the paint buffer.
+vol is split into high and low bytes so the products fit 16x16 multiplies,
+(d * vol) >> 8 == d * (vol >> 8) + ((d * (vol & 255)) >> 8).
+===================
+*/
+static ID_INLINE void S_MixSSE2( int *out, __m128i d, __m128i volHigh, __m128i volLow ) {
+	__m128i		lo, hi, a, b;
+
+	lo = _mm_mullo_epi16( d, volHigh );
+	hi = _mm_mulhi_epi16( d, volHigh );
+	a = _mm_unpacklo_epi16( lo, hi );
+	b = _mm_unpackhi_epi16( lo, hi );
+
+	lo = _mm_mullo_epi16( d, volLow );
+	hi = _mm_mulhi_epi16( d, volLow );
+	a = _mm_add_epi32( a, _mm_srai_epi32( _mm_unpacklo_epi16( lo, hi ), 8 ) );
+	b = _mm_add_epi32( b, _mm_srai_epi32( _mm_unpackhi_epi16( lo, hi ), 8 ) );
+
+	_mm_storeu_si128( (__m128i *)out, _mm_add_epi32( _mm_loadu_si128( (__m128i *)out ), a ) );
+	_mm_storeu_si128( (__m128i *)( out + 4 ), _mm_add_epi32( _mm_loadu_si128( (__m128i *)( out + 4 ) ), b ) );
+}
+
+/*
+===================
+S_MixMono16_sse2
+===================
+*/
+void S_MixMono16_sse2( portable_samplepair_t *samp, const short *samples, int count, int leftvol, int rightvol ) {
+	__m128i		volHigh, volLow, d;
+	int			*out;
+	int			i, data;
+
+	volHigh = _mm_set1_epi32( ( ( rightvol >> 8 ) << 16 ) | ( ( leftvol >> 8 ) & 0xffff ) );
+	volLow = _mm_set1_epi32( ( ( rightvol & 255 ) << 16 ) | ( leftvol & 255 ) );
+	out = (int *)samp;
+
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		d = _mm_loadu_si128( (const __m128i *)( samples + i ) );
+
+		// each sample goes to both channels
+		S_MixSSE2( out + i * 2, _mm_unpacklo_epi16( d, d ), volHigh, volLow );
+		S_MixSSE2( out + i * 2 + 8, _mm_unpackhi_epi16( d, d ), volHigh, volLow );
+	}
+
+	for ( ; i < count; i++ ) {
+		data = samples[i];
+		samp[i].left += ( data * leftvol ) >> 8;
+		samp[i].right += ( data * rightvol ) >> 8;
+	}
+}
+
+/*
+===================
+S_MixStereo16_sse2
+
+count is in sample pairs
+===================
+*/
+void S_MixStereo16_sse2( portable_samplepair_t *samp, const short *samples, int count, int leftvol, int rightvol ) {
+	__m128i		volHigh, volLow;
+	int			*out;
+	int			i;
+
+	volHigh = _mm_set1_epi32( ( ( rightvol >> 8 ) << 16 ) | ( ( leftvol >> 8 ) & 0xffff ) );
+	volLow = _mm_set1_epi32( ( ( rightvol & 255 ) << 16 ) | ( leftvol & 255 ) );
+	out = (int *)samp;
+
+	for ( i = 0; i + 4 <= count; i += 4 ) {
+		S_MixSSE2( out + i * 2, _mm_loadu_si128( (const __m128i *)( samples + i * 2 ) ), volHigh, volLow );
+	}
+
+	for ( ; i < count; i++ ) {
+		samp[i].left += ( samples[i*2] * leftvol ) >> 8;
+		samp[i].right += ( samples[i*2+1] * rightvol ) >> 8;
+	}
+}
+
+/*
+===================
+S_ClipStereo16_sse2
+
+Same as S_WriteLinearBlastStereo16, count is in samples
+===================
+*/
+void S_ClipStereo16_sse2( short *out, const int *in, int count ) {
+	__m128i		a, b;
+	int			i, val;
+
+	for ( i = 0; i + 8 <= count; i += 8 ) {
+		a = _mm_srai_epi32( _mm_loadu_si128( (const __m128i *)( in + i ) ), 8 );
+		b = _mm_srai_epi32( _mm_loadu_si128( (const __m128i *)( in + i + 4 ) ), 8 );
+		_mm_storeu_si128( (__m128i *)( out + i ), _mm_packs_epi32( a, b ) );
+	}
+
+	for ( ; i < count; i++ ) {
+		val = in[i] >> 8;
+		if ( val > 0x7fff ) {
+			val = 0x7fff;
+		} else if ( val < -32768 ) {
+			val = -32768;
+		}
+		out[i] = val;
+	}
+}
+
+#endif
@@ -38,7 +38,7 @@ Suite 120, Rockville, Maryland 20850 USA.
 // ZTM: FIXME: There is no way for the VM to know what the engine support API is
 //             so there is no way to add more system calls.
 #define	GAME_API_MAJOR_VERSION	1
-#define	GAME_API_MINOR_VERSION	0
+#define	GAME_API_MINOR_VERSION	2
 
 
 // entity->svFlags
@@ -288,6 +288,14 @@ typedef enum {
 	G_CLIPTOENTITIES, // ( trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask );
 	G_CLIPTOENTITIESCAPSULE, // ( trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask );
 
+	G_R_LERPTAGS, // ( orientation_t *tags, int maxTags, qhandle_t handle, qhandle_t frameModel, int startFrame, qhandle_t endFrameModel, int endFrame, float frac,
+	              //   const vec3_t *torsoAxis, qhandle_t torsoFrameModel, int torsoFrame, qhandle_t oldTorsoFrameModel, int oldTorsoFrame, float torsoFrac );
+	// Returns the number of tags set, tags[ i ] is the tag with tag index i (see G_R_LERPTAG_FRAMEMODEL).
+
+	G_MICROSECONDS,	// ( void );
+	// like G_MILLISECONDS, for the bot library frame budget (botlib_import_t MicroSeconds)
+	// the value wraps around, only use the difference between two calls
+
 } gameImport_t;
 
 
@@ -154,6 +154,14 @@ typedef struct {
 #define	SURFACE_CLIP_EPSILON	(0.125)
 
 extern	clipMap_t	cm;
+
+#ifdef BSPC
+// bspc traces from multiple threads, every trace needs its own check count
+int ThreadAtomicAdd(volatile int *value, int add);
+#define CM_NextCheckCount()		ThreadAtomicAdd( &cm.checkcount, 1 )
+#else
+#define CM_NextCheckCount()		( ++cm.checkcount )
+#endif
 extern	int			c_pointcontents;
 extern	int			c_traces, c_brush_traces, c_patch_traces;
 extern	cvar_t		*cm_noAreas;
@@ -194,6 +202,7 @@ typedef struct {
 	sphere_t	sphere;		// sphere for oriendted capsule collision
 	biSphere_t	biSphere;
 	qboolean	testLateralCollision; // whether or not to test for lateral collision
+	int			checkcount;	// cm.checkcount of this trace for multi-check avoidance
 } traceWork_t;
 
 typedef struct leafList_s {
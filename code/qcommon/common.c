@@ -109,6 +109,7 @@ cvar_t	*com_legacyprotocol;
 #endif
 cvar_t  *com_homepath;
 cvar_t	*com_busyWait;
+cvar_t	*com_framePacing;
 #ifndef DEDICATED
 cvar_t  *con_autochat;
 #endif
@@ -145,6 +146,7 @@ char	com_errorMessage[MAXPRINTMSG];
 int		com_playVideo = 0;
 
 void Com_WriteConfig_f( void );
+void Com_FrameJitter_f( void );
 void CIN_CloseAllVideos( void );
 
 //============================================================================
@@ -2970,6 +2972,7 @@ void Com_Init( char *commandLine ) {
 	Cmd_AddCommand ("writeconfig", Com_WriteConfig_f );
 	Cmd_SetCommandCompletionFunc( "writeconfig", Cmd_CompleteCfgName );
 	Cmd_AddCommand("game_restart", Com_GameRestart_f);
+	Cmd_AddCommand("frameJitter", Com_FrameJitter_f);
 
 	Com_ExecuteCfg();
 
@@ -3030,6 +3033,7 @@ void Com_Init( char *commandLine ) {
 	com_maxfpsMinimized = Cvar_Get( "com_maxfpsMinimized", "0", CVAR_ARCHIVE );
 	com_abnormalExit = Cvar_Get( "com_abnormalExit", "0", CVAR_ROM );
 	com_busyWait = Cvar_Get("com_busyWait", "0", CVAR_ARCHIVE);
+	com_framePacing = Cvar_Get("com_framePacing", "1", CVAR_ARCHIVE);
 	Cvar_Get("com_errorMessage", "", CVAR_ROM | CVAR_NORESTART);
 
 	com_productName = Cvar_Get( "com_productName", PRODUCT_NAME, CVAR_ROM );
@@ -3328,6 +3332,7 @@ void Com_InitRef( refimport_t *ri ) {
 	ri->FS_FreeFileList = FS_FreeFileList;
 	ri->FS_ListFiles = FS_ListFiles;
 	ri->FS_FileExists = FS_FileExists;
+	ri->FS_FilePakChecksum = FS_FilePakChecksum;
 	ri->Cvar_Get = Cvar_Get;
 	ri->Cvar_Set = Cvar_Set;
 	ri->Cvar_SetValue = Cvar_SetValue;
@@ -3477,6 +3482,89 @@ int Com_ModifyMsec( int msec ) {
 	return msec;
 }
 
+/*
+=================
+Frame start jitter
+
+How late dedicated server frames start compared to when they were due.
+=================
+*/
+
+#define JITTER_BUCKETS 9
+
+static const int jitterBucketMax[JITTER_BUCKETS - 1] = { 50, 100, 250, 500, 1000, 2000, 5000, 10000 };
+
+static struct {
+	int		count;
+	int		buckets[JITTER_BUCKETS];
+	int64_t	total;
+	int		max;
+} frameJitter;
+
+/*
+=================
+Com_RecordFrameJitter
+=================
+*/
+static void Com_RecordFrameJitter( int usec ) {
+	int i;
+
+	if ( usec < 0 ) {
+		usec = 0;
+	}
+
+	for ( i = 0; i < JITTER_BUCKETS - 1; i++ ) {
+		if ( usec < jitterBucketMax[i] ) {
+			break;
+		}
+	}
+
+	frameJitter.buckets[i]++;
+	frameJitter.count++;
+	frameJitter.total += usec;
+
+	if ( usec > frameJitter.max ) {
+		frameJitter.max = usec;
+	}
+}
+
+/*
+=================
+Com_FrameJitter_f
+
+Prints the frame start jitter histogram, "frameJitter reset" clears it
+=================
+*/
+void Com_FrameJitter_f( void ) {
+	int		i, lo;
+
+	if ( !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+		Com_Memset( &frameJitter, 0, sizeof( frameJitter ) );
+		return;
+	}
+
+	if ( !frameJitter.count ) {
+		Com_Printf( "No frames recorded, frame jitter is only tracked on dedicated servers.\n" );
+		return;
+	}
+
+	Com_Printf( "%i frames, mean %i usec, max %i usec, %s pacing\n", frameJitter.count,
+		(int)( frameJitter.total / frameJitter.count ), frameJitter.max,
+		com_framePacing->integer ? "timer" : "select" );
+
+	lo = 0;
+	for ( i = 0; i < JITTER_BUCKETS; i++ ) {
+		if ( i < JITTER_BUCKETS - 1 ) {
+			Com_Printf( "%6i - %6i usec: %8i (%5.1f%%)\n", lo, jitterBucketMax[i], frameJitter.buckets[i],
+				100.0f * frameJitter.buckets[i] / frameJitter.count );
+			lo = jitterBucketMax[i];
+		} else {
+			Com_Printf( "%6i+         usec: %8i (%5.1f%%)\n", lo, frameJitter.buckets[i],
+				100.0f * frameJitter.buckets[i] / frameJitter.count );
+		}
+	}
+}
+
 /*
 =================
 Com_TimeVal
@@ -3507,6 +3595,8 @@ void Com_Frame( void ) {
 	int		msec, minMsec;
 	int		timeVal, timeValSV;
 	static int	lastTime = 0, bias = 0;
+	int64_t	frameDeadline;
+	qboolean	pacing;
  
 	int		timeBeforeFirstEvents;
 	int		timeBeforeServer;
@@ -3565,6 +3655,11 @@ void Com_Frame( void ) {
 	else
 		minMsec = 1;
 
+	// dedicated servers wake exactly on the millisecond the next frame
+	// is due instead of polling through the last one
+	pacing = com_dedicated->integer && com_framePacing->integer && !com_timedemo->integer && !com_busyWait->integer;
+	frameDeadline = (int64_t)(com_frameTime + minMsec) * 1000;
+
 	do
 	{
 		if(com_sv_running->integer)
@@ -3578,12 +3673,26 @@ void Com_Frame( void ) {
 		}
 		else
 			timeVal = Com_TimeVal(minMsec);
+
+		if(pacing)
+		{
+			if(timeVal < Com_TimeVal(minMsec))
+				pacing = NET_SleepUntil(Sys_Microseconds() + timeVal * 1000);
+			else
+				pacing = NET_SleepUntil(frameDeadline);
+
+			if(pacing)
+				continue;
+		}
 		
 		if(com_busyWait->integer || timeVal < 1)
 			NET_Sleep(0);
 		else
 			NET_Sleep(timeVal - 1);
 	} while(Com_TimeVal(minMsec));
+
+	if(com_dedicated->integer && !com_timedemo->integer)
+		Com_RecordFrameJitter(Sys_Microseconds() - frameDeadline);
 	
 	IN_Frame();
 
@@ -3614,6 +3723,9 @@ void Com_Frame( void ) {
 
 	SV_Frame( msec );
 
+	// get the snapshots out before the client frame
+	NET_FlushSendBatch();
+
 	// if "dedicated" has been modified, start up
 	// or shut down the client system.
 	// Do this after the server may have started,
@@ -3665,6 +3777,7 @@ void Com_Frame( void ) {
 
 
 	NET_FlushPacketQueue();
+	NET_EndFrame();
 
 	//
 	// report timing information
@@ -1548,6 +1548,38 @@ long FS_FOpenFileRead(const char *filename, fileHandle_t *file, qboolean uniqueF
 	}
 }
 
+/*
+===========
+FS_FilePakChecksum
+
+Finds the file in the search path, sets checksum to the checksum of
+the pk3 file it would be read from or 0 if it is not in a pk3 file.
+Returns qfalse if the file does not exist.
+===========
+*/
+qboolean FS_FilePakChecksum( const char *filename, int *checksum )
+{
+	searchpath_t *search;
+
+	if(!fs_searchpaths)
+		Com_Error(ERR_FATAL, "Filesystem call made without initialization");
+
+	*checksum = 0;
+
+	for(search = fs_searchpaths; search; search = search->next)
+	{
+		if(FS_FOpenFileReadDir(filename, search, NULL, qfalse, qfalse) > 0)
+		{
+			if(search->pack)
+				*checksum = search->pack->checksum;
+
+			return qtrue;
+		}
+	}
+
+	return qfalse;
+}
+
 /*
 =================
 FS_FindVM
@@ -1886,6 +1918,46 @@ int FS_Write( const void *buffer, int len, fileHandle_t h ) {
 	return len;
 }
 
+/*
+=================
+FS_ThreadWrite
+
+FS_Write for threads other than the main thread, it doesn't print or drop.
+The handle has to be opened by the main thread, which mustn't use or close
+it while the thread writes to it. Returns the number of bytes written
+=================
+*/
+int FS_ThreadWrite( const void *buffer, int len, fileHandle_t h ) {
+	int		block, written;
+	byte	*buf;
+	FILE	*f;
+
+	if ( h < 1 || h >= MAX_FILE_HANDLES || fsh[h].zipFile ) {
+		return 0;
+	}
+
+	f = fsh[h].handleFiles.file.o;
+	if ( !f || !buffer || len < 1 ) {
+		return 0;
+	}
+
+	buf = (byte *)buffer;
+
+	written = 0;
+	while ( written < len ) {
+		block = fwrite( buf + written, 1, len - written, f );
+		if ( block <= 0 ) {
+			break;
+		}
+
+		written += block;
+	}
+	if ( fsh[h].handleSync ) {
+		fflush( f );
+	}
+	return written;
+}
+
 void QDECL FS_Printf( fileHandle_t h, const char *fmt, ... ) {
 	va_list		argptr;
 	char		msg[MAXPRINTMSG];
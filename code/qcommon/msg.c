@@ -868,6 +868,115 @@ void MSG_ShutdownNetFields( void ) {
 	MSG_FreeNetFields( &msg_playerStateFields );
 }
 
+/*
+==================
+MSG_NetFieldsToJSON
+
+Writes the non-zero fields of an entity or player state as JSON members
+keyed by field index, arrays as JSON arrays. Returns qfalse if buf is too
+small.
+==================
+*/
+qboolean MSG_NetFieldsToJSON( const void *state, qboolean playerState, char *buf, int bufSize ) {
+	netFields_t	*stateFields;
+	netField_t	*field;
+	const int	*value;
+	int			i, n, len;
+	qboolean	zero;
+
+	stateFields = playerState ? &msg_playerStateFields : &msg_entityStateFields;
+
+	len = 0;
+	buf[0] = '\0';
+
+	for ( i = 0, field = stateFields->fields; i < stateFields->numFields; i++, field++ ) {
+		value = (const int *)( (const byte *)state + field->offset );
+
+		zero = qtrue;
+		for ( n = 0; n < field->numElements; n++ ) {
+			if ( value[n] ) {
+				zero = qfalse;
+				break;
+			}
+		}
+
+		if ( zero ) {
+			continue;
+		}
+
+		len += Com_sprintf( buf + len, bufSize - len, "%s\"%d\":%s", len ? "," : "", i,
+							field->numElements > 1 ? "[" : "" );
+
+		for ( n = 0; n < field->numElements && len < bufSize; n++ ) {
+			if ( field->bits == 0 ) {
+				len += Com_sprintf( buf + len, bufSize - len, "%s%g", n ? "," : "", *(const float *)&value[n] );
+			} else {
+				len += Com_sprintf( buf + len, bufSize - len, "%s%d", n ? "," : "", value[n] );
+			}
+		}
+
+		if ( field->numElements > 1 && len < bufSize ) {
+			len += Com_sprintf( buf + len, bufSize - len, "]" );
+		}
+
+		if ( len >= bufSize ) {
+			return qfalse;
+		}
+	}
+
+	return qtrue;
+}
+
+/*
+==================
+MSG_MaxDeltaBits
+
+Returns the most bits a delta entity, including its number, or a delta
+playerstate can write before Huffman coding
+==================
+*/
+int MSG_MaxDeltaBits( qboolean playerState ) {
+	netFields_t	*stateFields;
+	netField_t	*field;
+	int			i, bits;
+
+	stateFields = playerState ? &msg_playerStateFields : &msg_entityStateFields;
+
+	// # of changes, entities also have their number, removed and delta bits
+	bits = playerState ? 8 : GENTITYNUM_BITS + 2 + 8;
+
+	for ( i = 0, field = stateFields->fields; i < stateFields->numFields; i++, field++ ) {
+		bits += field->numElementArrays;
+
+		if ( field->numElements > 1 ) {
+			bits += field->numElements;
+		}
+
+		if ( field->bits == 0 ) {
+			// zero and small integer bits, full float
+			bits += field->numElements * ( 2 + 32 );
+		} else {
+			bits += field->numElements * ( 1 + abs( field->bits ) );
+		}
+	}
+
+	return bits;
+}
+
+// longest code of the Huffman tree built from msg_hData
+#define	MAX_HUFF_CODE_BITS	11
+
+/*
+==================
+MSG_BitstreamSize
+
+Returns the most bytes writing this many bits to a bitstream message can take
+==================
+*/
+int MSG_BitstreamSize( int bits ) {
+	return ( bits * MAX_HUFF_CODE_BITS + 63 ) / 64 + 1;
+}
+
 /*
 ==================
 MSG_LastChangedField
@@ -28,6 +28,11 @@ Suite 120, Rockville, Maryland 20850 USA.
 ===========================================================================
 */
 
+#ifdef __linux__
+	// for recvmmsg and sendmmsg
+#	define _GNU_SOURCE
+#endif
+
 #include "../qcommon/q_shared.h"
 #include "../qcommon/qcommon.h"
 
@@ -97,6 +102,15 @@ typedef int SOCKET;
 typedef int	ioctlarg_t;
 #	define socketError			errno
 
+#	ifdef __linux__
+		// drain sockets with recvmmsg and batch a frame's sends into sendmmsg
+#		define USE_NET_MMSG
+		// wait for packets or the next frame with epoll and a timerfd
+#		define USE_NET_EPOLL
+#		include <sys/epoll.h>
+#		include <sys/timerfd.h>
+#	endif
+
 #endif
 
 static qboolean usingSocks = qfalse;
@@ -119,6 +133,9 @@ static cvar_t	*net_mcast6iface;
 
 static cvar_t	*net_dropsim;
 
+static cvar_t	*net_batch;
+static cvar_t	*net_showSyscalls;
+
 static struct sockaddr	socksRelayAddr;
 
 static SOCKET	ip_socket = INVALID_SOCKET;
@@ -126,6 +143,14 @@ static SOCKET	ip6_socket = INVALID_SOCKET;
 static SOCKET	socks_socket = INVALID_SOCKET;
 static SOCKET	multicast6_socket = INVALID_SOCKET;
 
+#ifdef USE_NET_EPOLL
+static int		epoll_fd = -1;
+static int		timer_fd = -1;
+static qboolean	epollFailed = qfalse;
+// sockets currently registered with epoll_fd
+static SOCKET	epoll_sockets[2] = { INVALID_SOCKET, INVALID_SOCKET };
+#endif
+
 // Keep track of currently joined multicast group.
 static struct ipv6_mreq curgroup;
 // And the currently bound address.
@@ -521,6 +546,146 @@ qboolean	NET_IsLocalAddress( netadr_t adr ) {
 
 //=============================================================================
 
+//=============================================================================
+
+// socket syscalls made since the last report, shown with net_showSyscalls
+static struct {
+	int		frames;
+	int		wait;
+	int		recv;
+	int		send;
+	int		packetsIn;
+	int		packetsOut;
+	int		lastReport;
+} netSyscalls;
+
+#ifdef USE_NET_MMSG
+#define	NET_RECV_BATCH	16
+
+// packets pulled off one socket by a single recvmmsg and handed out one at a
+// time by NET_RecvFrom
+typedef struct {
+	SOCKET					sock;
+	int						count;
+	int						current;
+	qboolean				drained;	// last recvmmsg came back short
+
+	struct mmsghdr			hdrs[NET_RECV_BATCH];
+	struct iovec			iovecs[NET_RECV_BATCH];
+	struct sockaddr_storage	addrs[NET_RECV_BATCH];
+	byte					data[NET_RECV_BATCH][MAX_MSGLEN + 1];
+} netRecvBatch_t;
+
+static netRecvBatch_t	recvBatch;
+
+/*
+==================
+NET_ResetRecvBatch
+==================
+*/
+static void NET_ResetRecvBatch( void ) {
+	recvBatch.sock = INVALID_SOCKET;
+	recvBatch.count = 0;
+	recvBatch.current = 0;
+	recvBatch.drained = qfalse;
+}
+#endif
+
+/*
+==================
+NET_RecvPending
+
+Returns qtrue if packets already read from a socket are still waiting to be
+handed out, so NET_Event must keep going even if the last one was rejected.
+==================
+*/
+static qboolean NET_RecvPending( void ) {
+#ifdef USE_NET_MMSG
+	return recvBatch.current < recvBatch.count;
+#else
+	return qfalse;
+#endif
+}
+
+/*
+==================
+NET_RecvFrom
+
+Reads one datagram from sock. On Linux the socket is drained with recvmmsg
+and the packets are returned from the batch; once a short batch has been
+used up the socket is cleared from fdr instead of asking the kernel again
+just to get EAGAIN.
+==================
+*/
+static int NET_RecvFrom( SOCKET sock, msg_t *net_message, struct sockaddr_storage *from, socklen_t *fromlen, fd_set *fdr ) {
+#ifdef USE_NET_MMSG
+	int		i, len, ret;
+
+	if ( recvBatch.sock != sock ) {
+		NET_ResetRecvBatch();
+		recvBatch.sock = sock;
+	}
+
+	if ( recvBatch.current >= recvBatch.count ) {
+		if ( recvBatch.drained ) {
+			FD_CLR( sock, fdr );
+			NET_ResetRecvBatch();
+			errno = EAGAIN;
+			return SOCKET_ERROR;
+		}
+
+		for ( i = 0; i < NET_RECV_BATCH; i++ ) {
+			recvBatch.iovecs[i].iov_base = recvBatch.data[i];
+			recvBatch.iovecs[i].iov_len = sizeof( recvBatch.data[i] );
+
+			memset( &recvBatch.hdrs[i], 0, sizeof( recvBatch.hdrs[i] ) );
+			recvBatch.hdrs[i].msg_hdr.msg_name = &recvBatch.addrs[i];
+			recvBatch.hdrs[i].msg_hdr.msg_namelen = sizeof( recvBatch.addrs[i] );
+			recvBatch.hdrs[i].msg_hdr.msg_iov = &recvBatch.iovecs[i];
+			recvBatch.hdrs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		ret = recvmmsg( sock, recvBatch.hdrs, NET_RECV_BATCH, MSG_DONTWAIT, NULL );
+		netSyscalls.recv++;
+
+		if ( ret <= 0 ) {
+			FD_CLR( sock, fdr );
+			NET_ResetRecvBatch();
+			if ( ret == 0 )
+				errno = EAGAIN;
+			return SOCKET_ERROR;
+		}
+
+		recvBatch.count = ret;
+		recvBatch.current = 0;
+		recvBatch.drained = ( ret < NET_RECV_BATCH ) ? qtrue : qfalse;
+	}
+
+	i = recvBatch.current++;
+	len = recvBatch.hdrs[i].msg_len;
+
+	if ( len > net_message->maxsize )
+		len = net_message->maxsize;
+
+	Com_Memcpy( net_message->data, recvBatch.data[i], len );
+	Com_Memcpy( from, &recvBatch.addrs[i], recvBatch.hdrs[i].msg_hdr.msg_namelen );
+	*fromlen = recvBatch.hdrs[i].msg_hdr.msg_namelen;
+
+	netSyscalls.packetsIn++;
+	return len;
+#else
+	int		ret;
+
+	ret = recvfrom( sock, (void *)net_message->data, net_message->maxsize, 0, (struct sockaddr *) from, fromlen );
+	netSyscalls.recv++;
+
+	if ( ret != SOCKET_ERROR )
+		netSyscalls.packetsIn++;
+
+	return ret;
+#endif
+}
+
 /*
 ==================
 NET_GetPacket
@@ -538,7 +703,7 @@ qboolean NET_GetPacket(netadr_t *net_from, msg_t *net_message, fd_set *fdr)
 	if(ip_socket != INVALID_SOCKET && FD_ISSET(ip_socket, fdr))
 	{
 		fromlen = sizeof(from);
-		ret = recvfrom( ip_socket, (void *)net_message->data, net_message->maxsize, 0, (struct sockaddr *) &from, &fromlen );
+		ret = NET_RecvFrom( ip_socket, net_message, &from, &fromlen, fdr );
 		
 		if (ret == SOCKET_ERROR)
 		{
@@ -582,7 +747,7 @@ qboolean NET_GetPacket(netadr_t *net_from, msg_t *net_message, fd_set *fdr)
 	if(ip6_socket != INVALID_SOCKET && FD_ISSET(ip6_socket, fdr))
 	{
 		fromlen = sizeof(from);
-		ret = recvfrom(ip6_socket, (void *)net_message->data, net_message->maxsize, 0, (struct sockaddr *) &from, &fromlen);
+		ret = NET_RecvFrom( ip6_socket, net_message, &from, &fromlen, fdr );
 		
 		if (ret == SOCKET_ERROR)
 		{
@@ -610,7 +775,7 @@ qboolean NET_GetPacket(netadr_t *net_from, msg_t *net_message, fd_set *fdr)
 	if(multicast6_socket != INVALID_SOCKET && multicast6_socket != ip6_socket && FD_ISSET(multicast6_socket, fdr))
 	{
 		fromlen = sizeof(from);
-		ret = recvfrom(multicast6_socket, (void *)net_message->data, net_message->maxsize, 0, (struct sockaddr *) &from, &fromlen);
+		ret = NET_RecvFrom( multicast6_socket, net_message, &from, &fromlen, fdr );
 		
 		if (ret == SOCKET_ERROR)
 		{
@@ -643,6 +808,137 @@ qboolean NET_GetPacket(netadr_t *net_from, msg_t *net_message, fd_set *fdr)
 
 static char socksBuf[4096];
 
+/*
+==================
+NET_SendError
+==================
+*/
+static void NET_SendError( netadrtype_t type ) {
+	int err = socketError;
+
+	// wouldblock is silent
+	if( err == EAGAIN ) {
+		return;
+	}
+
+	// some PPP links do not allow broadcasts and return an error
+	if( ( err == EADDRNOTAVAIL ) && ( ( type == NA_BROADCAST ) ) ) {
+		return;
+	}
+
+	Com_Printf( "Sys_SendPacket: %s\n", NET_ErrorString() );
+}
+
+#ifdef USE_NET_MMSG
+#define	NET_SEND_BATCH			64
+#define	NET_SEND_BATCH_BYTES	( 64 * 1024 )
+
+// outgoing packets for one socket, written with a single sendmmsg by
+// NET_FlushSendBatch
+typedef struct {
+	int						count;
+	int						bytes;
+	netadrtype_t			types[NET_SEND_BATCH];
+
+	struct mmsghdr			hdrs[NET_SEND_BATCH];
+	struct iovec			iovecs[NET_SEND_BATCH];
+	struct sockaddr_storage	addrs[NET_SEND_BATCH];
+	byte					data[NET_SEND_BATCH_BYTES];
+} netSendBatch_t;
+
+// one for ip_socket and one for ip6_socket
+static netSendBatch_t	sendBatch[2];
+
+/*
+==================
+NET_FlushBatch
+==================
+*/
+static void NET_FlushBatch( netSendBatch_t *batch, SOCKET sock ) {
+	int		i, ret;
+
+	if ( !batch->count ) {
+		return;
+	}
+
+	if ( sock != INVALID_SOCKET ) {
+		for ( i = 0; i < batch->count; ) {
+			ret = sendmmsg( sock, &batch->hdrs[i], batch->count - i, 0 );
+			netSyscalls.send++;
+
+			if ( ret == SOCKET_ERROR ) {
+				// only the first packet failed, skip it and carry on
+				NET_SendError( batch->types[i] );
+				i++;
+			} else {
+				i += ret;
+			}
+		}
+	}
+
+	batch->count = 0;
+	batch->bytes = 0;
+}
+
+/*
+==================
+NET_QueuePacket
+
+Returns qfalse if the packet has to go out with sendto right away
+==================
+*/
+static qboolean NET_QueuePacket( SOCKET sock, int length, const void *data, netadrtype_t type, const struct sockaddr_storage *addr, socklen_t addrlen ) {
+	netSendBatch_t	*batch;
+	int				i;
+
+	if ( !net_batch || !net_batch->integer || !com_sv_running || !com_sv_running->integer ) {
+		return qfalse;
+	}
+
+	if ( length > NET_SEND_BATCH_BYTES ) {
+		return qfalse;
+	}
+
+	batch = &sendBatch[ sock == ip_socket ? 0 : 1 ];
+
+	if ( batch->count == NET_SEND_BATCH || batch->bytes + length > NET_SEND_BATCH_BYTES ) {
+		NET_FlushBatch( batch, sock );
+	}
+
+	i = batch->count++;
+	Com_Memcpy( &batch->data[batch->bytes], data, length );
+	Com_Memcpy( &batch->addrs[i], addr, addrlen );
+	batch->types[i] = type;
+
+	batch->iovecs[i].iov_base = &batch->data[batch->bytes];
+	batch->iovecs[i].iov_len = length;
+
+	memset( &batch->hdrs[i], 0, sizeof( batch->hdrs[i] ) );
+	batch->hdrs[i].msg_hdr.msg_name = &batch->addrs[i];
+	batch->hdrs[i].msg_hdr.msg_namelen = addrlen;
+	batch->hdrs[i].msg_hdr.msg_iov = &batch->iovecs[i];
+	batch->hdrs[i].msg_hdr.msg_iovlen = 1;
+
+	batch->bytes += length;
+	return qtrue;
+}
+#endif
+
+/*
+==================
+NET_FlushSendBatch
+
+Writes out the packets queued by Sys_SendPacket while net_batch is on.
+Called after the server frame and before sleeping on the sockets.
+==================
+*/
+void NET_FlushSendBatch( void ) {
+#ifdef USE_NET_MMSG
+	NET_FlushBatch( &sendBatch[0], ip_socket );
+	NET_FlushBatch( &sendBatch[1], ip6_socket );
+#endif
+}
+
 /*
 ==================
 Sys_SendPacket
@@ -670,6 +966,8 @@ void Sys_SendPacket( int length, const void *data, netadr_t to ) {
 	memset(&addr, 0, sizeof(addr));
 	NetadrToSockadr( &to, (struct sockaddr *) &addr );
 
+	netSyscalls.packetsOut++;
+
 	if( usingSocks && to.type == NA_IP ) {
 		socksBuf[0] = 0;	// reserved
 		socksBuf[1] = 0;
@@ -682,24 +980,26 @@ void Sys_SendPacket( int length, const void *data, netadr_t to ) {
 	}
 	else {
 		if(addr.ss_family == AF_INET)
+		{
+#ifdef USE_NET_MMSG
+			if( NET_QueuePacket( ip_socket, length, data, to.type, &addr, sizeof(struct sockaddr_in) ) )
+				return;
+#endif
 			ret = sendto( ip_socket, data, length, 0, (struct sockaddr *) &addr, sizeof(struct sockaddr_in) );
+		}
 		else if(addr.ss_family == AF_INET6)
+		{
+#ifdef USE_NET_MMSG
+			if( NET_QueuePacket( ip6_socket, length, data, to.type, &addr, sizeof(struct sockaddr_in6) ) )
+				return;
+#endif
 			ret = sendto( ip6_socket, data, length, 0, (struct sockaddr *) &addr, sizeof(struct sockaddr_in6) );
-	}
-	if( ret == SOCKET_ERROR ) {
-		int err = socketError;
-
-		// wouldblock is silent
-		if( err == EAGAIN ) {
-			return;
-		}
-
-		// some PPP links do not allow broadcasts and return an error
-		if( ( err == EADDRNOTAVAIL ) && ( ( to.type == NA_BROADCAST ) ) ) {
-			return;
 		}
+	}
+	netSyscalls.send++;
 
-		Com_Printf( "Sys_SendPacket: %s\n", NET_ErrorString() );
+	if( ret == SOCKET_ERROR ) {
+		NET_SendError( to.type );
 	}
 }
 
@@ -1537,6 +1837,16 @@ void NET_Config( qboolean enableNetworking ) {
 	}
 
 	if( stop ) {
+		// send anything still queued and forget packets read ahead
+		NET_FlushSendBatch();
+#ifdef USE_NET_MMSG
+		NET_ResetRecvBatch();
+#endif
+#ifdef USE_NET_EPOLL
+		// closing the sockets drops them from the epoll set
+		epoll_sockets[0] = epoll_sockets[1] = INVALID_SOCKET;
+#endif
+
 		if ( ip_socket != INVALID_SOCKET ) {
 			closesocket( ip_socket );
 			ip_socket = INVALID_SOCKET;
@@ -1592,6 +1902,10 @@ void NET_Init( void ) {
 	Com_Printf( "Winsock Initialized\n" );
 #endif
 
+	net_batch = Cvar_Get( "net_batch", "1", CVAR_ARCHIVE );
+	net_showSyscalls = Cvar_Get( "net_showSyscalls", "0", 0 );
+	netSyscalls.lastReport = Sys_Milliseconds();
+
 	NET_Config( qtrue );
 	
 	Cmd_AddCommand ("net_restart", NET_Restart_f);
@@ -1610,6 +1924,17 @@ void NET_Shutdown( void ) {
 
 	NET_Config( qfalse );
 
+#ifdef USE_NET_EPOLL
+	if( epoll_fd != -1 ) {
+		close( epoll_fd );
+		epoll_fd = -1;
+	}
+	if( timer_fd != -1 ) {
+		close( timer_fd );
+		timer_fd = -1;
+	}
+#endif
+
 #ifdef _WIN32
 	WSACleanup();
 	winsockInitialized = qfalse;
@@ -1648,9 +1973,12 @@ void NET_Event(fd_set *fdr)
 			else
 				CL_PacketEvent(from, &netmsg);
 		}
-		else
+		else if(!NET_RecvPending())
 			break;
 	}
+
+	// answer whatever the packets asked for right away
+	NET_FlushSendBatch();
 }
 
 /*
@@ -1670,6 +1998,9 @@ void NET_Sleep(int msec)
 	if(msec < 0)
 		msec = 0;
 
+	// don't sit on packets queued since the last flush
+	NET_FlushSendBatch();
+
 	FD_ZERO(&fdr);
 
 	if(ip_socket != INVALID_SOCKET)
@@ -1699,6 +2030,7 @@ void NET_Sleep(int msec)
 	timeout.tv_usec = (msec%1000)*1000;
 
 	retval = select(highestfd + 1, &fdr, NULL, NULL, &timeout);
+	netSyscalls.wait++;
 
 	if(retval == SOCKET_ERROR)
 		Com_Printf("Warning: select() syscall failed: %s\n", NET_ErrorString());
@@ -1706,6 +2038,184 @@ void NET_Sleep(int msec)
 		NET_Event(&fdr);
 }
 
+#ifdef USE_NET_EPOLL
+/*
+====================
+NET_SetupEpoll
+
+Creates the epoll set and frame timer on first use and keeps the
+registered sockets in step with NET_Config
+====================
+*/
+static qboolean NET_SetupEpoll(void)
+{
+	struct epoll_event ev;
+	SOCKET sockets[2];
+	int i;
+
+	if(epollFailed)
+		return qfalse;
+
+	if(epoll_fd == -1)
+	{
+		epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+		timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.fd = timer_fd;
+
+		if(epoll_fd == -1 || timer_fd == -1 || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &ev) == -1)
+		{
+			Com_Printf("WARNING: NET_SetupEpoll: %s, using select()\n", NET_ErrorString());
+
+			if(epoll_fd != -1)
+				close(epoll_fd);
+			if(timer_fd != -1)
+				close(timer_fd);
+
+			epoll_fd = timer_fd = -1;
+			epollFailed = qtrue;
+			return qfalse;
+		}
+	}
+
+	sockets[0] = ip_socket;
+	sockets[1] = ip6_socket;
+
+	for(i = 0; i < 2; i++)
+	{
+		if(sockets[i] == epoll_sockets[i])
+			continue;
+
+		if(epoll_sockets[i] != INVALID_SOCKET)
+			epoll_ctl(epoll_fd, EPOLL_CTL_DEL, epoll_sockets[i], NULL);
+
+		epoll_sockets[i] = INVALID_SOCKET;
+
+		if(sockets[i] != INVALID_SOCKET)
+		{
+			memset(&ev, 0, sizeof(ev));
+			ev.events = EPOLLIN;
+			ev.data.fd = sockets[i];
+
+			if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sockets[i], &ev) == -1)
+				Com_Printf("WARNING: NET_SetupEpoll: %s\n", NET_ErrorString());
+			else
+				epoll_sockets[i] = sockets[i];
+		}
+	}
+
+	return qtrue;
+}
+#endif
+
+/*
+====================
+NET_SleepUntil
+
+Sleeps until deadline (in Sys_Microseconds time) or until something happens
+on the network. The deadline is kept by a timerfd, so unlike NET_Sleep the
+wakeup is not rounded to whole milliseconds. Returns qfalse if this isn't
+available and NET_Sleep has to be used instead.
+====================
+*/
+qboolean NET_SleepUntil(int64_t deadline)
+{
+#ifdef USE_NET_EPOLL
+	struct epoll_event events[4];
+	struct itimerspec its;
+	fd_set fdr;
+	int64_t wait;
+	int i, n, timeout;
+	qboolean packets = qfalse;
+
+	if(!NET_SetupEpoll())
+		return qfalse;
+
+	// don't sit on packets queued since the last flush
+	NET_FlushSendBatch();
+
+	wait = deadline - Sys_Microseconds();
+
+	if(wait > 0)
+	{
+		// re-arming also clears an expiration we didn't read
+		memset(&its, 0, sizeof(its));
+		its.it_value.tv_sec = wait / 1000000;
+		its.it_value.tv_nsec = (wait % 1000000) * 1000;
+
+		timerfd_settime(timer_fd, 0, &its, NULL);
+		timeout = -1;
+	}
+	else
+		timeout = 0;
+
+	n = epoll_wait(epoll_fd, events, ARRAY_LEN(events), timeout);
+	netSyscalls.wait++;
+
+	if(n == SOCKET_ERROR)
+	{
+		if(errno != EINTR)
+			Com_Printf("Warning: epoll_wait() syscall failed: %s\n", NET_ErrorString());
+		return qtrue;
+	}
+
+	FD_ZERO(&fdr);
+
+	for(i = 0; i < n; i++)
+	{
+		if(events[i].data.fd == timer_fd)
+			continue;
+
+		FD_SET(events[i].data.fd, &fdr);
+		packets = qtrue;
+	}
+
+	if(packets)
+		NET_Event(&fdr);
+
+	return qtrue;
+#else
+	return qfalse;
+#endif
+}
+
+/*
+====================
+NET_EndFrame
+
+Flushes the send batch and, with net_showSyscalls, prints the average number
+of socket syscalls made per frame once a second.
+====================
+*/
+void NET_EndFrame( void )
+{
+	int now, frames;
+
+	NET_FlushSendBatch();
+
+	netSyscalls.frames++;
+
+	now = Sys_Milliseconds();
+	if(now - netSyscalls.lastReport < 1000)
+		return;
+
+	if(net_showSyscalls && net_showSyscalls->integer)
+	{
+		frames = netSyscalls.frames;
+
+		Com_Printf("net: %.1f syscalls/frame (wait %.1f recv %.1f send %.1f), %.1f packets in %.1f out\n",
+			(float)(netSyscalls.wait + netSyscalls.recv + netSyscalls.send) / frames,
+			(float)netSyscalls.wait / frames, (float)netSyscalls.recv / frames,
+			(float)netSyscalls.send / frames, (float)netSyscalls.packetsIn / frames,
+			(float)netSyscalls.packetsOut / frames);
+	}
+
+	Com_Memset(&netSyscalls, 0, sizeof(netSyscalls));
+	netSyscalls.lastReport = now;
+}
+
 /*
 ====================
 NET_Restart_f
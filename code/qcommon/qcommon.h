@@ -170,6 +170,9 @@ void MSG_ReadDeltaUsercmdKey( msg_t *msg, int key, usercmd_t *from, usercmd_t *t
 void MSG_SetNetFields( vmNetField_t *vmEntityFields, int numEntityFields, int entityStateSize, int entityNetworkSize,
 					   vmNetField_t *vmPlayerFields, int numPlayerFields, int playerStateSize, int playerNetworkSize );
 void MSG_ShutdownNetFields( void );
+qboolean MSG_NetFieldsToJSON( const void *state, qboolean playerState, char *buf, int bufSize );
+int MSG_MaxDeltaBits( qboolean playerState );
+int MSG_BitstreamSize( int bits );
 
 void MSG_WriteDeltaEntity( msg_t *msg, sharedEntityState_t *from, sharedEntityState_t *to,
 						   qboolean force );
@@ -259,6 +262,9 @@ qboolean	NET_GetLoopPacket (netsrc_t sock, netadr_t *net_from, msg_t *net_messag
 void		NET_JoinMulticast6(void);
 void		NET_LeaveMulticast6(void);
 void		NET_Sleep(int msec);
+qboolean	NET_SleepUntil(int64_t deadline);
+void		NET_FlushSendBatch(void);
+void		NET_EndFrame(void);
 
 
 #define	MAX_MSGLEN				32768		// max length of a message, which may
@@ -331,6 +337,22 @@ PROTOCOL
 // NOTE: that stuff only works with two digits protocols
 extern int demo_protocols[];
 
+// note: there is implicitly a '\0' byte added to the string literal
+#define DEMO_MAGIC "SPEARMINT_DEMO"
+
+typedef struct {
+	char	magic[15];
+	byte	padding; // align to 4-byte boundary, this in uninitialized data in older demos
+	int		headerSize;
+	int		protocol;
+
+	// treated as optional, assumed to exist based on headerSize
+	char	startTime[20]; // "YYYY-MM-DD HH:MM:SS" with null byte
+	char	endTime[20]; // "YYYY-MM-DD HH:MM:SS" with null byte
+	int		runTime; // Run time in milliseconds. Note: assumed to be directly after endTime when saving demo
+
+} demoHeader_t;
+
 //#define	UPDATE_SERVER_NAME	"update.quake3arena.com"
 // override on command line, config files etc.
 #ifndef MASTER_SERVER_NAME
@@ -441,6 +463,7 @@ void	VM_Debug( int level );
 
 void	*VM_ArgPtr( intptr_t intValue );
 void	*VM_ExplicitArgPtr( vm_t *vm, intptr_t intValue );
+void	VM_CheckBlock( intptr_t buf, size_t n, const char *fn );
 
 #define	VMA(x) VM_ArgPtr(args[x])
 #define	VMF(x)	IntAsFloat((int)args[x])
@@ -747,6 +770,9 @@ qboolean	FS_SV_RW_FileExists( const char *filename );
 fileHandle_t FS_SV_FOpenFileWrite( const char *filename );
 long		FS_SV_FOpenFileRead( const char *filename, fileHandle_t *fp );
 void	FS_SV_Rename( const char *from, const char *to, qboolean safe );
+qboolean	FS_FilePakChecksum( const char *qpath, int *checksum );
+// sets checksum to the pk3 the file would be read from, 0 if it's not in a pk3
+
 long		FS_FOpenFileRead( const char *qpath, fileHandle_t *file, qboolean uniqueFILE );
 // if uniqueFILE is true, then a new FILE will be fopened even if the file
 // is found in an already open pak file.  If uniqueFILE is false, you must call
@@ -759,6 +785,9 @@ long FS_System_FOpenFileRead(const char *ospath, fileHandle_t *fp);
 int     FS_Delete( char *filename );    // only works inside the 'save' directory (for deleting savegames/images)
 
 int		FS_Write( const void *buffer, int len, fileHandle_t f );
+int		FS_ThreadWrite( const void *buffer, int len, fileHandle_t f );
+// FS_Write without printing or dropping, for threads that write to a handle
+// the main thread opened
 
 int		FS_Read( void *buffer, int len, fileHandle_t f );
 // properly handles partial reads and reads from other dlls
@@ -913,7 +942,8 @@ typedef enum
   CF_3DNOW_EXT  = 1 << 4,
   CF_SSE        = 1 << 5,
   CF_SSE2       = 1 << 6,
-  CF_ALTIVEC    = 1 << 7
+  CF_ALTIVEC    = 1 << 7,
+  CF_AVX2       = 1 << 8
 } cpuFeatures_t;
 
 // centralized and cleaned, that's the max string you can send to a Com_Printf / Com_DPrintf (above gets truncated)
@@ -1266,6 +1296,7 @@ void	Sys_Print( const char *msg );
 // Sys_Milliseconds should only be used for profiling purposes,
 // any game related timing information should come from event timestamps
 int		Sys_Milliseconds (void);
+int64_t	Sys_Microseconds (void);
 
 qboolean Sys_RandomBytes( byte *string, int len );
 
@@ -1307,6 +1338,33 @@ char **Sys_ListFiles( const char *directory, const char *extension, char *filter
 void	Sys_FreeFileList( char **list );
 void	Sys_Sleep(int msec);
 
+// threads for work that must not block the main thread. thread functions must
+// not call Com_Error, Com_Printf, the zone or hunk allocators or anything else
+// that touches shared engine state without its own locking
+typedef struct sysThread_s sysThread_t;
+typedef struct sysMutex_s sysMutex_t;
+typedef struct sysSemaphore_s sysSemaphore_t;
+typedef int (*sysThreadFunc_t)( void *data );
+
+sysThread_t *Sys_CreateThread( sysThreadFunc_t func, void *data );
+int		Sys_WaitThread( sysThread_t *thread );
+
+sysMutex_t *Sys_CreateMutex( void );
+void	Sys_DestroyMutex( sysMutex_t *mutex );
+void	Sys_LockMutex( sysMutex_t *mutex );
+void	Sys_UnlockMutex( sysMutex_t *mutex );
+
+sysSemaphore_t *Sys_CreateSemaphore( int value );
+void	Sys_DestroySemaphore( sysSemaphore_t *sem );
+void	Sys_SemaphoreWait( sysSemaphore_t *sem );
+qboolean Sys_SemaphoreTryWait( sysSemaphore_t *sem );
+void	Sys_SemaphorePost( sysSemaphore_t *sem );
+
+// single-word loads and stores that order the memory accesses around them, for
+// handing data between exactly one producer and one consumer thread
+int		Sys_AtomicLoad( volatile int *value );
+void	Sys_AtomicStore( volatile int *value, int newValue );
+
 qboolean Sys_LowPhysicalMemory( void );
 
 void Sys_SetEnv(const char *name, const char *value);
@@ -1178,6 +1178,30 @@ void VM_BlockCopy(unsigned int dest, unsigned int src, size_t n)
 	Com_Memcpy(currentVM->dataBase + dest, currentVM->dataBase + src, n);
 }
 
+/*
+=================
+VM_CheckBlock
+Verifies that an n byte buffer passed by currentVM is within its data space
+=================
+*/
+
+void VM_CheckBlock( intptr_t buf, size_t n, const char *fn )
+{
+	unsigned int dataMask;
+
+	// native libraries use real pointers
+	if ( currentVM->entryPoint ) {
+		return;
+	}
+
+	dataMask = currentVM->dataMask;
+
+	if ( buf < 0 || (buf & dataMask) != buf || n > (size_t)dataMask + 1 - buf )
+	{
+		Com_Error( ERR_DROP, "%s: buffer out of range", fn );
+	}
+}
+
 /*
 =================
 VM_HeapMalloc
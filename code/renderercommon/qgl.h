@@ -58,6 +58,7 @@ extern void (APIENTRYP qglCompressedTexImage2DARB) (GLenum target, GLint level,
 							GLsizei width, GLsizei height,
 							GLint border, GLsizei imageSize,
 							const GLvoid *data);
+extern void (APIENTRYP qglGetCompressedTexImageARB) (GLenum target, GLint level, GLvoid *img);
 
 //===========================================================================
 
@@ -128,6 +129,7 @@ extern void (APIENTRYP qglCompressedTexImage2DARB) (GLenum target, GLint level,
 	GLE(void, ClearDepth, GLclampd depth) \
 	GLE(void, DepthRange, GLclampd near_val, GLclampd far_val) \
 	GLE(void, DrawBuffer, GLenum mode) \
+	GLE(void, GetTexImage, GLenum target, GLint level, GLenum format, GLenum type, GLvoid *pixels) \
 	GLE(void, GetTexLevelParameteriv, GLenum target, GLint level, GLenum pname, GLint *params) \
 	GLE(void, PolygonMode, GLenum face, GLenum mode) \
 
@@ -266,6 +268,8 @@ extern void (APIENTRYP qglCompressedTexImage2DARB) (GLenum target, GLint level,
 // OpenGL 3.0 specific
 #define QGL_3_0_PROCS \
 	GLE(const GLubyte *, GetStringi, GLenum name, GLuint index) \
+	GLE(void *, MapBufferRange, GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) \
+	GLE(GLboolean, UnmapBuffer, GLenum target) \
 
 // GL_ARB_framebuffer_object, built-in to OpenGL 3.0
 #define QGL_ARB_framebuffer_object_PROCS \
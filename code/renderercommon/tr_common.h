@@ -72,6 +72,11 @@ typedef struct image_s {
 	imgType_t   type;
 	imgFlags_t  flags;
 
+	// streaming, a pending image only has a placeholder texture
+	qboolean	pending;
+	int			requestFrame;		// tr.frameCount the image was last requested
+	float		requestDistance;	// closest distance it was requested from that frame
+
 	struct image_s*	next;
 } image_t;
 
@@ -153,6 +158,9 @@ extern cvar_t *r_stereoEnabled;
 extern	cvar_t	*r_saveFontData;
 extern	cvar_t	*r_fontBorderWidth;
 extern	cvar_t	*r_fontForceAutoHint;
+extern	cvar_t	*r_fontCache;
+
+extern	cvar_t	*r_shaderCache;
 
 qboolean	R_GetModeInfo( int *width, int *height, float *windowAspect, int mode );
 
@@ -164,6 +172,14 @@ void	R_LoadImage( const char *name, int *numLevels, textureLevel_t **pic );
 image_t	*R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags );
 image_t *R_CreateImage( const char *name, byte *pic, int width, int height, imgType_t type, imgFlags_t flags, int internalFormat );
 image_t *R_CreateImage2( const char *name, int numTexLevels, const textureLevel_t *pic, imgType_t type, imgFlags_t flags, int internalFormat );
+void	R_UpdateImage( image_t *image, byte *pic, int width, int height );
+
+// images decoded on the worker threads ahead of R_LoadImage
+#define MAX_PREFETCH_IMAGES	64
+
+void	R_PrefetchImages( const char **names, int numNames );
+void	R_PrefetchShaderImages( const char **shaderNames, int numShaders );
+void	R_FreePrefetchedImages( void );
 
 void R_IssuePendingRenderCommands( void );
 qhandle_t		 RE_RegisterShaderEx( const char *name, int lightmapIndex, qboolean mipRawImage );
@@ -172,6 +188,11 @@ qhandle_t		 RE_RegisterShaderNoMip( const char *name );
 qhandle_t		 RE_RegisterShaderNoPicMip( const char *name );
 qhandle_t RE_RegisterShaderFromImage(const char *name, int lightmapIndex, image_t *image, qboolean mipRawImage);
 
+// shader text, the hash function is the renderer's shader name hash
+typedef long (*shaderTextHashFunc_t)( const char *name, const int size );
+
+char *R_LoadShaderText( const char *directory, char **filenames, int numFiles, shaderTextHashFunc_t hashFunc, char ***hashTable, int hashSize );
+
 // font stuff
 void R_InitFreeType( void );
 void R_DoneFreeType( void );
@@ -192,12 +213,45 @@ IMAGE LOADERS
 
 void R_LoadBMP( const char *name, int *numLevels, textureLevel_t **pic );
 void R_LoadDDS( const char *name, int *numLevels, textureLevel_t **pic );
+void R_LoadDDSFromBuffer( const char *name, void *buffer, int length, int *numLevels, textureLevel_t **pic );
+int R_WriteDDS( byte **data, int numLevels, const textureLevel_t *pic );
+qboolean R_CheckDDS( const void *data, int length );
 void R_LoadFTX( const char *name, int *numLevels, textureLevel_t **pic );
 void R_LoadJPG( const char *name, int *numLevels, textureLevel_t **pic );
 void R_LoadPCX( const char *name, int *numLevels, textureLevel_t **pic );
 void R_LoadPNG( const char *name, int *numLevels, textureLevel_t **pic );
 void R_LoadTGA( const char *name, int *numLevels, textureLevel_t **pic );
 
+// decoders for files that are already in memory, these may run on the worker
+// threads so they report errors in error instead of calling ri.Error
+
+typedef struct imageDecode_s imageDecode_t;
+
+typedef void (*imageDecoder_t)( imageDecode_t *decode );
+
+struct imageDecode_s {
+	const char		*name;
+	imageDecoder_t	decoder;
+	const byte		*buffer;
+	int				length;
+
+	int				numLevels;
+	textureLevel_t	*pic;
+	char			error[MAX_STRING_CHARS];	// raised with ERR_DROP on the main thread
+};
+
+void R_DecodeJPG( imageDecode_t *decode );
+void R_DecodePNG( imageDecode_t *decode );
+void R_DecodeTGA( imageDecode_t *decode );
+
+void R_DecodeImages( imageDecode_t *decodes, int numDecodes );
+void R_LoadImageWithDecoder( const char *name, imageDecoder_t decoder, int *numLevels, textureLevel_t **pic );
+
+void *R_DecodeMalloc( int size );
+void R_DecodeFree( void *ptr );
+void QDECL R_DecodePrintf( int printLevel, const char *fmt, ... ) __attribute__ ((format (printf, 2, 3)));
+void QDECL R_DecodeError( imageDecode_t *decode, const char *fmt, ... ) __attribute__ ((format (printf, 2, 3)));
+
 /*
 ====================================================================
 
@@ -219,4 +273,14 @@ void		GLimp_SetGamma( unsigned char red[256],
 
 qboolean	GLimp_ResizeWindow( int width, int height );
 
+// worker threads, func is called with ranges of [start, end)
+typedef void (*parallelFunc_t)( void *data, int start, int end );
+
+void		R_InitWorkers( void );
+void		R_ShutdownWorkers( void );
+void		R_ParallelFor( parallelFunc_t func, void *data, int count, int minPerJob );
+int			R_NumWorkerThreads( void );
+void		R_LockWorkers( void );
+void		R_UnlockWorkers( void );
+
 #endif
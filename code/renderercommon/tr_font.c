@@ -84,6 +84,60 @@ Suite 120, Rockville, Maryland 20850 USA.
 #define _TRUNC(x)  ((x) >> 6)
 
 FT_Library ftLibrary = NULL;  
+
+// glyphs of all dynamic fonts are packed into shared atlas pages, so text in
+// different fonts and sizes is drawn with the same shader
+#define MAX_FONT_ATLAS_PAGES 32
+
+typedef struct {
+	char		name[MAX_QPATH];
+	image_t		*image;
+	qhandle_t	shader;
+	byte		*pixels;			// NULL once the page is full
+	int			x, y, rowHeight;	// where the next glyph goes
+	qboolean	modified;
+} fontAtlasPage_t;
+
+static fontAtlasPage_t fontAtlasPages[MAX_FONT_ATLAS_PAGES];
+static int numFontAtlasPages = 0;
+static int fontAtlasSize = 0;
+
+// 32 bit bitmaps of a font's glyphs, in glyph order
+typedef struct {
+	byte	*data;
+	int		size;
+	int		used;
+} glyphBitmaps_t;
+
+// rendered glyphs are cached in the homepath so later sessions don't need
+// to render them again
+#define FONTCACHE_IDENT		(('C'<<24)+('T'<<16)+('N'<<8)+'F')
+#define FONTCACHE_VERSION	1
+
+typedef struct {
+	char		path[MAX_QPATH];
+	int			key;
+	qboolean	writable;
+} fontCacheKey_t;
+
+typedef struct {
+	int			ident;
+	int			version;
+	int			key;
+	float		glyphScale;
+	int			bitmapsLength;
+} fontCacheHeader_t;
+
+// followed by the bitmaps of all glyphs
+typedef struct {
+	int			height;
+	int			top;
+	int			left;
+	int			pitch;
+	int			xSkip;
+	int			imageWidth;
+	int			imageHeight;
+} fontCacheGlyph_t;
 #endif
 
 #define MAX_FONTS 12
@@ -463,8 +517,36 @@ static void WriteTGA (char *filename, byte *data, int width, int height) {
 	ri.Free (buffer);
 }
 
-// returns NULL if glyph does not fit in image
-static glyphInfo_t *RE_ConstructGlyphInfo(const char *fontName, int imageSize, unsigned char *imageOut, int *xOut, int *yOut, int *rowHeight, FT_Face face, unsigned long c, float borderWidth, qboolean forceAutoHint) {
+/*
+===============
+R_AllocGlyphBitmap
+
+Appends a cleared 32 bit glyph bitmap to the font's bitmaps
+===============
+*/
+static byte *R_AllocGlyphBitmap( glyphBitmaps_t *bitmaps, int size ) {
+	byte	*data;
+
+	if ( bitmaps->used + size > bitmaps->size ) {
+		bitmaps->size = MAX( bitmaps->size * 2, bitmaps->used + size );
+
+		data = ri.Malloc( bitmaps->size );
+		if ( bitmaps->data ) {
+			Com_Memcpy( data, bitmaps->data, bitmaps->used );
+			ri.Free( bitmaps->data );
+		}
+		bitmaps->data = data;
+	}
+
+	data = bitmaps->data + bitmaps->used;
+	bitmaps->used += size;
+
+	Com_Memset( data, 0, size );
+	return data;
+}
+
+// the glyph's bitmap is added to bitmaps, imageWidth and imageHeight give its size
+static glyphInfo_t *RE_ConstructGlyphInfo(const char *fontName, glyphBitmaps_t *bitmaps, FT_Face face, unsigned long c, float borderWidth, qboolean forceAutoHint) {
 	int i, loadFlags;
 	static glyphInfo_t glyph;
 	unsigned char *src, *dst;
@@ -494,29 +576,9 @@ static glyphInfo_t *RE_ConstructGlyphInfo(const char *fontName, int imageSize, u
 			return &glyph;
 		}
 
-		// we need to make sure we fit
-		if (*xOut + bitmap->width + 1 >= imageSize-1) {
-			*xOut = 0;
-			*yOut += *rowHeight + 1;
-			*rowHeight = 0;
-		}
-
-		if (*yOut + bitmap->rows + 1 >= imageSize-1) {
-			if (bitmap != &face->glyph->bitmap) {
-				ri.Free(bitmap->buffer);
-				ri.Free(bitmap);
-			}
-			return NULL;
-		}
-
-		// reserve vertical space in image
-		if (bitmap->rows > *rowHeight) {
-			*rowHeight = bitmap->rows;
-		}
-
 		// convert glyph image into a 32 bit RGBA image
 		src = bitmap->buffer;
-		dst = imageOut + (*yOut * imageSize * 4) + *xOut * 4;
+		dst = R_AllocGlyphBitmap(bitmaps, bitmap->width * bitmap->rows * 4);
 
 		if (bitmap->pixel_mode == FT_PIXEL_MODE_MONO) {
 			for (i = 0; i < bitmap->rows; i++) {
@@ -544,7 +606,7 @@ static glyphInfo_t *RE_ConstructGlyphInfo(const char *fontName, int imageSize, u
 				}
 
 				src += bitmap->pitch;
-				dst += imageSize * 4;
+				dst += bitmap->width * 4;
 			}
 		} else if (bitmap->pixel_mode == FT_PIXEL_MODE_GRAY) {
 			for (i = 0; i < bitmap->rows; i++) {
@@ -559,7 +621,7 @@ static glyphInfo_t *RE_ConstructGlyphInfo(const char *fontName, int imageSize, u
 					_dst += 4;
 				}
 				src += bitmap->pitch;
-				dst += imageSize * 4;
+				dst += bitmap->width * 4;
 			}
 		} else if (bitmap->pixel_mode == FT_PIXEL_MODE_BGRA) {
 			// swap BGRA src to RGBA dst
@@ -576,18 +638,13 @@ static glyphInfo_t *RE_ConstructGlyphInfo(const char *fontName, int imageSize, u
 					_dst += 4;
 				}
 				src += bitmap->pitch;
-				dst += imageSize * 4;
+				dst += bitmap->width * 4;
 			}
 		}
 
-		// store the pixel values in texture coords until the image height is known
-		glyph.s = *xOut;
-		glyph.t = *yOut;
 		glyph.imageWidth = bitmap->width;
 		glyph.imageHeight = bitmap->rows;
 
-		*xOut += bitmap->width + 1;
-
 		if (bitmap != &face->glyph->bitmap) {
 			ri.Free(bitmap->buffer);
 			ri.Free(bitmap);
@@ -596,6 +653,431 @@ static glyphInfo_t *RE_ConstructGlyphInfo(const char *fontName, int imageSize, u
 
 	return &glyph;
 }
+
+/*
+===============
+R_NewFontAtlasPage
+===============
+*/
+static fontAtlasPage_t *R_NewFontAtlasPage( void ) {
+	fontAtlasPage_t	*page;
+	int				size;
+
+	if ( numFontAtlasPages == MAX_FONT_ATLAS_PAGES ) {
+		ri.Printf( PRINT_WARNING, "RE_RegisterFont: MAX_FONT_ATLAS_PAGES hit\n" );
+		return NULL;
+	}
+
+	page = &fontAtlasPages[numFontAtlasPages];
+	Com_Memset( page, 0, sizeof ( *page ) );
+
+	size = fontAtlasSize * fontAtlasSize * 4;
+	page->pixels = ri.Malloc( size );
+	Com_Memset( page->pixels, 0, size );
+
+	Com_sprintf( page->name, sizeof ( page->name ), "*fontatlas%i", numFontAtlasPages );
+	page->image = R_CreateImage( page->name, page->pixels, fontAtlasSize, fontAtlasSize, IMGTYPE_COLORALPHA, IMGFLAG_CLAMPTOEDGE|IMGFLAG_MIPMAP, 0 );
+	page->shader = RE_RegisterShaderFromImage( page->name, LIGHTMAP_2D, page->image, qfalse );
+
+	numFontAtlasPages++;
+	return page;
+}
+
+/*
+===============
+R_PackFontGlyphs
+
+Copies the glyph bitmaps into the font atlas and sets the glyph shaders and
+texture coords. Returns the first atlas page with glyphs of the font, or -1
+if the atlas is full.
+===============
+*/
+static int R_PackFontGlyphs( fontInfo_t *font, const byte *bitmaps, float dpi ) {
+	fontAtlasPage_t	*page;
+	glyphInfo_t	*glyph;
+	const byte	*src;
+	byte		*dst;
+	int			firstPage;
+	int			i, row, width, height;
+
+	if ( !fontAtlasSize ) {
+		// scale page size based on screen height, use the next higher power of two
+		for ( fontAtlasSize = 1024; fontAtlasSize < 256.0f * dpi / 72.0f; fontAtlasSize <<= 1 );
+
+		// do not exceed maxTextureSize
+		if ( fontAtlasSize > glConfig.maxTextureSize ) {
+			fontAtlasSize = glConfig.maxTextureSize;
+		}
+	}
+
+	// continue filling the last page
+	if ( numFontAtlasPages ) {
+		page = &fontAtlasPages[numFontAtlasPages - 1];
+	} else {
+		page = R_NewFontAtlasPage();
+		if ( !page ) {
+			return -1;
+		}
+	}
+
+	firstPage = -1;
+	src = bitmaps;
+
+	for ( i = GLYPH_START; i <= GLYPH_END; i++ ) {
+		glyph = &font->glyphs[i];
+		width = glyph->imageWidth;
+		height = glyph->imageHeight;
+
+		glyph->s = glyph->t = glyph->s2 = glyph->t2 = 0;
+
+		if ( width + 2 >= fontAtlasSize || height + 2 >= fontAtlasSize ) {
+			ri.Printf( PRINT_WARNING, "RE_RegisterFont: Glyph %i of '%s' is too big for the font atlas\n", i, font->name );
+			src += width * height * 4;
+			glyph->imageWidth = glyph->imageHeight = 0;
+		} else if ( width > 0 && height > 0 ) {
+			// we need to make sure we fit
+			if ( page->x + width + 1 >= fontAtlasSize - 1 ) {
+				page->x = 0;
+				page->y += page->rowHeight + 1;
+				page->rowHeight = 0;
+			}
+
+			if ( page->y + height + 1 >= fontAtlasSize - 1 ) {
+				page = R_NewFontAtlasPage();
+				if ( !page ) {
+					return -1;
+				}
+			}
+
+			dst = page->pixels + ( page->y * fontAtlasSize + page->x ) * 4;
+			for ( row = 0; row < height; row++ ) {
+				Com_Memcpy( dst, src, width * 4 );
+				src += width * 4;
+				dst += fontAtlasSize * 4;
+			}
+
+			glyph->s = (float)page->x / fontAtlasSize;
+			glyph->t = (float)page->y / fontAtlasSize;
+			glyph->s2 = glyph->s + (float)width / fontAtlasSize;
+			glyph->t2 = glyph->t + (float)height / fontAtlasSize;
+
+			page->x += width + 1;
+			if ( height > page->rowHeight ) {
+				page->rowHeight = height;
+			}
+			page->modified = qtrue;
+
+			if ( firstPage == -1 ) {
+				firstPage = page - fontAtlasPages;
+			}
+		}
+
+		glyph->glyph = page->shader;
+		Q_strncpyz( glyph->shaderName, page->name, sizeof ( glyph->shaderName ) );
+	}
+
+	if ( firstPage == -1 ) {
+		firstPage = page - fontAtlasPages;
+	}
+
+	return firstPage;
+}
+
+/*
+===============
+R_FinishFontAtlas
+
+Uploads the pages with new glyphs, only the last page keeps its pixels
+for the next font
+===============
+*/
+static void R_FinishFontAtlas( void ) {
+	fontAtlasPage_t	*page;
+	byte	*pic;
+	int		i, size;
+
+	size = fontAtlasSize * fontAtlasSize * 4;
+
+	for ( i = 0; i < numFontAtlasPages; i++ ) {
+		page = &fontAtlasPages[i];
+
+		if ( !page->pixels ) {
+			continue;
+		}
+
+		if ( page->modified ) {
+			// uploading may change the pixels
+			pic = ri.Hunk_AllocateTempMemory( size );
+			Com_Memcpy( pic, page->pixels, size );
+			R_UpdateImage( page->image, pic, fontAtlasSize, fontAtlasSize );
+			ri.Hunk_FreeTempMemory( pic );
+
+			page->modified = qfalse;
+		}
+
+		if ( i < numFontAtlasPages - 1 ) {
+			ri.Free( page->pixels );
+			page->pixels = NULL;
+		}
+	}
+}
+
+/*
+===============
+R_FontImageName
+===============
+*/
+static void R_FontImageName( char *name, int nameSize, const char *strippedName, int imageNumber, int pointSize, float borderWidth ) {
+	if ( borderWidth != 0 ) {
+		Com_sprintf( name, nameSize, "%s_%i_%i_b%g.tga", strippedName, imageNumber, pointSize, borderWidth );
+	} else {
+		Com_sprintf( name, nameSize, "%s_%i_%i.tga", strippedName, imageNumber, pointSize );
+	}
+}
+
+/*
+===============
+R_SaveFontData
+
+Writes the atlas pages with the font's glyphs and the font data, so the font
+can be loaded as a pre-rendered font
+===============
+*/
+static void R_SaveFontData( const fontInfo_t *font, const char *strippedName, int pointSize, float borderWidth, int firstPage ) {
+	fontInfo_t	*saveFont;
+	char		imageName[MAX_QPATH];
+	int			i, j;
+
+	for ( i = firstPage; i < numFontAtlasPages; i++ ) {
+		R_FontImageName( imageName, sizeof ( imageName ), strippedName, i - firstPage, pointSize, borderWidth );
+		if ( !ri.FS_FileExists( imageName ) ) {
+			WriteTGA( imageName, fontAtlasPages[i].pixels, fontAtlasSize, fontAtlasSize );
+		}
+	}
+
+	if ( ri.FS_FileExists( font->name ) ) {
+		return;
+	}
+
+#if defined Q3_BIG_ENDIAN
+	Com_Printf( S_COLOR_YELLOW "WARNING: Cannot write font data on big endian systems\n" );
+#else
+	// glyphs use the images written above instead of the atlas
+	saveFont = ri.Malloc( sizeof ( fontInfo_t ) );
+	Com_Memcpy( saveFont, font, sizeof ( fontInfo_t ) );
+
+	for ( i = GLYPH_START; i <= GLYPH_END; i++ ) {
+		for ( j = firstPage; j < numFontAtlasPages - 1; j++ ) {
+			if ( fontAtlasPages[j].shader == saveFont->glyphs[i].glyph ) {
+				break;
+			}
+		}
+
+		R_FontImageName( imageName, sizeof ( imageName ), strippedName, j - firstPage, pointSize, borderWidth );
+		COM_StripExtension( imageName, saveFont->glyphs[i].shaderName, sizeof ( saveFont->glyphs[i].shaderName ) );
+	}
+
+	// ZTM: FIXME: need to swap for big endian systems
+	ri.FS_WriteFile( font->name, saveFont, sizeof ( fontInfo_t ) );
+	ri.Free( saveFont );
+#endif
+}
+
+/*
+===============
+R_FontCacheHash
+===============
+*/
+static unsigned R_FontCacheHash( unsigned hash, const void *data, int length ) {
+	const byte *p = data;
+	int i;
+
+	// FNV-1a
+	for ( i = 0; i < length; i++ ) {
+		hash = ( hash ^ p[i] ) * 16777619;
+	}
+
+	return hash;
+}
+
+/*
+===============
+R_FontCacheKey
+
+Returns qfalse if the font shouldn't be cached
+===============
+*/
+static qboolean R_FontCacheKey( const char *fontName, int pointSize, float borderWidth, qboolean forceAutoHint, float dpi, fontCacheKey_t *cacheKey ) {
+	int			checksum;
+	int			settings[3];
+	unsigned	key;
+
+	if ( !r_fontCache->integer ) {
+		return qfalse;
+	}
+
+	// loose files may change at any time
+	if ( !ri.FS_FilePakChecksum( fontName, &checksum ) || !checksum ) {
+		return qfalse;
+	}
+
+	settings[0] = pointSize;
+	settings[1] = forceAutoHint;
+	settings[2] = FREETYPE_MAJOR * 10000 + FREETYPE_MINOR * 100 + FREETYPE_PATCH;
+
+	key = 2166136261u;
+	key = R_FontCacheHash( key, &checksum, sizeof ( checksum ) );
+	key = R_FontCacheHash( key, fontName, strlen( fontName ) );
+	key = R_FontCacheHash( key, settings, sizeof ( settings ) );
+	key = R_FontCacheHash( key, &borderWidth, sizeof ( borderWidth ) );
+	key = R_FontCacheHash( key, &dpi, sizeof ( dpi ) );
+
+	if ( borderWidth != 0 ) {
+		Com_sprintf( cacheKey->path, sizeof ( cacheKey->path ), "fontcache/%s_%i_b%g.glyphs", fontName, pointSize, borderWidth );
+	} else {
+		Com_sprintf( cacheKey->path, sizeof ( cacheKey->path ), "fontcache/%s_%i.glyphs", fontName, pointSize );
+	}
+	cacheKey->key = key;
+
+	return qtrue;
+}
+
+/*
+===============
+R_LoadCachedFont
+
+Loads the glyph metrics and bitmaps rendered by a previous session
+===============
+*/
+static qboolean R_LoadCachedFont( fontCacheKey_t *cacheKey, fontInfo_t *font, glyphBitmaps_t *bitmaps ) {
+	union {
+		byte *b;
+		void *v;
+	} buffer;
+	fontCacheHeader_t	header;
+	fontCacheGlyph_t	cacheGlyph;
+	glyphInfo_t			*glyph;
+	int					length, tableLength, bitmapsLength;
+	int					i;
+
+	cacheKey->writable = qtrue;
+
+	length = ri.FS_ReadFile( cacheKey->path, &buffer.v );
+	if ( !buffer.b ) {
+		// files outside of pk3s can't be read on pure servers, don't keep rewriting it
+		if ( ri.FS_FileExists( cacheKey->path ) ) {
+			cacheKey->writable = qfalse;
+		}
+		return qfalse;
+	}
+
+	tableLength = ( GLYPHS_PER_FONT ) * sizeof ( fontCacheGlyph_t );
+
+	if ( length < sizeof ( header ) + tableLength ) {
+		ri.FS_FreeFile( buffer.v );
+		return qfalse;
+	}
+
+	Com_Memcpy( &header, buffer.b, sizeof ( header ) );
+	header.ident = LittleLong( header.ident );
+	header.version = LittleLong( header.version );
+	header.key = LittleLong( header.key );
+	header.glyphScale = LittleFloat( header.glyphScale );
+	header.bitmapsLength = LittleLong( header.bitmapsLength );
+
+	if ( header.ident != FONTCACHE_IDENT || header.version != FONTCACHE_VERSION
+		|| header.key != cacheKey->key || header.bitmapsLength != length - sizeof ( header ) - tableLength ) {
+		ri.FS_FreeFile( buffer.v );
+		return qfalse;
+	}
+
+	bitmapsLength = 0;
+
+	for ( i = GLYPH_START; i <= GLYPH_END; i++ ) {
+		Com_Memcpy( &cacheGlyph, buffer.b + sizeof ( header ) + ( i - GLYPH_START ) * sizeof ( cacheGlyph ), sizeof ( cacheGlyph ) );
+
+		glyph = &font->glyphs[i];
+		Com_Memset( glyph, 0, sizeof ( *glyph ) );
+		glyph->height = LittleLong( cacheGlyph.height );
+		glyph->top = LittleLong( cacheGlyph.top );
+		glyph->left = LittleLong( cacheGlyph.left );
+		glyph->pitch = LittleLong( cacheGlyph.pitch );
+		glyph->xSkip = LittleLong( cacheGlyph.xSkip );
+		glyph->imageWidth = LittleLong( cacheGlyph.imageWidth );
+		glyph->imageHeight = LittleLong( cacheGlyph.imageHeight );
+
+		if ( glyph->imageWidth < 0 || glyph->imageWidth > 4096 || glyph->imageHeight < 0 || glyph->imageHeight > 4096 ) {
+			ri.FS_FreeFile( buffer.v );
+			return qfalse;
+		}
+
+		bitmapsLength += glyph->imageWidth * glyph->imageHeight * 4;
+	}
+
+	if ( bitmapsLength != header.bitmapsLength ) {
+		ri.FS_FreeFile( buffer.v );
+		return qfalse;
+	}
+
+	if ( bitmapsLength ) {
+		Com_Memcpy( R_AllocGlyphBitmap( bitmaps, bitmapsLength ), buffer.b + sizeof ( header ) + tableLength, bitmapsLength );
+	}
+
+	font->glyphScale = header.glyphScale;
+
+	ri.FS_FreeFile( buffer.v );
+	return qtrue;
+}
+
+/*
+===============
+R_SaveCachedFont
+===============
+*/
+static void R_SaveCachedFont( const fontCacheKey_t *cacheKey, const fontInfo_t *font, const glyphBitmaps_t *bitmaps ) {
+	fontCacheHeader_t	*header;
+	fontCacheGlyph_t	*cacheGlyph;
+	const glyphInfo_t	*glyph;
+	byte	*buffer;
+	int		length, tableLength;
+	int		i;
+
+	if ( !cacheKey->writable ) {
+		return;
+	}
+
+	tableLength = ( GLYPHS_PER_FONT ) * sizeof ( fontCacheGlyph_t );
+	length = sizeof ( *header ) + tableLength + bitmaps->used;
+
+	buffer = ri.Hunk_AllocateTempMemory( length );
+
+	header = (fontCacheHeader_t *)buffer;
+	header->ident = LittleLong( FONTCACHE_IDENT );
+	header->version = LittleLong( FONTCACHE_VERSION );
+	header->key = LittleLong( cacheKey->key );
+	header->glyphScale = LittleFloat( font->glyphScale );
+	header->bitmapsLength = LittleLong( bitmaps->used );
+
+	cacheGlyph = (fontCacheGlyph_t *)( header + 1 );
+	for ( i = GLYPH_START; i <= GLYPH_END; i++, cacheGlyph++ ) {
+		glyph = &font->glyphs[i];
+		cacheGlyph->height = LittleLong( glyph->height );
+		cacheGlyph->top = LittleLong( glyph->top );
+		cacheGlyph->left = LittleLong( glyph->left );
+		cacheGlyph->pitch = LittleLong( glyph->pitch );
+		cacheGlyph->xSkip = LittleLong( glyph->xSkip );
+		cacheGlyph->imageWidth = LittleLong( glyph->imageWidth );
+		cacheGlyph->imageHeight = LittleLong( glyph->imageHeight );
+	}
+
+	if ( bitmaps->used ) {
+		Com_Memcpy( buffer + sizeof ( *header ) + tableLength, bitmaps->data, bitmaps->used );
+	}
+
+	ri.FS_WriteFile( cacheKey->path, buffer, length );
+
+	ri.Hunk_FreeTempMemory( buffer );
+}
 #endif
 
 static int fdOffset;
@@ -875,47 +1357,19 @@ unsigned long R_RemapGlyphCharacter( FT_Face face, int charIndex ) {
 
 /*
 ===============
-R_LoadDynamicFont
+R_RenderFontGlyphs
 
-Load an outline/bitmap font using Freetype for the current game window resolution.
+Renders the glyphs of an outline/bitmap font using Freetype.
 ===============
 */
-qboolean R_LoadDynamicFont( const char *fontName, int pointSize, float borderWidth, qboolean forceAutoHint, fontInfo_t *font ) {
+static qboolean R_RenderFontGlyphs( const char *fontName, int pointSize, float borderWidth, qboolean forceAutoHint, float dpi, fontInfo_t *font, glyphBitmaps_t *bitmaps ) {
 	FT_Face		face;
-	int			j, k, xOut, yOut, lastStart, imageNumber;
-	int			scaledSize, rowHeight;
-	unsigned char *out;
 	glyphInfo_t *glyph;
-	image_t		*image;
-	qhandle_t	h;
 	float		max;
-	int			imageSize;
-	float		dpi;
 	float		glyphScale;
-	void		*faceData;
-	int			i, len;
-	char		imageName[MAX_QPATH];
-	char		datName[MAX_QPATH];
-	char		strippedName[MAX_QPATH];
 	float		windowScale;
-	int			saveHeight;
-
-	if (ftLibrary == NULL) {
-		ri.Printf(PRINT_WARNING, "RE_RegisterFont: FreeType not initialized.\n");
-		return qfalse;
-	}
-
-	COM_StripExtension( fontName, strippedName, sizeof ( strippedName ) );
-
-	if (registeredFontCount >= MAX_FONTS) {
-		len = ri.FS_ReadFile(fontName, NULL);
-		if (len <= 0) {
-			ri.Printf(PRINT_DEVELOPER, "RE_RegisterFont: Unable to read font file '%s'\n", fontName);
-		} else {
-			ri.Printf(PRINT_WARNING, "RE_RegisterFont: No free slot to load font file '%s'\n", fontName);
-		}
-		return qfalse;
-	}
+	void		*faceData;
+	int			i, k, len;
 
 	len = ri.FS_ReadFile(fontName, &faceData);
 	if (!faceData) {
@@ -932,15 +1386,7 @@ qboolean R_LoadDynamicFont( const char *fontName, int pointSize, float borderWid
 
 	FT_Select_Charmap( face, ft_encoding_unicode );
 
-	// point sizes are for a virtual 640x480 window
-	if ( glConfig.vidWidth * 480 > glConfig.vidHeight * 640 ) {
-		windowScale = glConfig.vidHeight / 480.0f;
-	} else {
-		windowScale = glConfig.vidWidth / 640.0f;
-	}
-
-	// scale dpi based on window resolution
-	dpi = 72.0f * windowScale;
+	windowScale = dpi / 72.0f;
 
 	// change the scale to be relative to 1 based on 72 dpi ( so dpi of 144 means a scale of .5 )
 	glyphScale = 72.0f / dpi;
@@ -1001,114 +1447,98 @@ qboolean R_LoadDynamicFont( const char *fontName, int pointSize, float borderWid
 		}
 	}
 
-	//*font = &registeredFonts[registeredFontCount++];
-
-	// scale image size based on screen height, use the next higher power of two
-	for (imageSize = 256; imageSize < 256.0f * dpi / 72.0f; imageSize<<=1);
+	for ( i = GLYPH_START; i <= GLYPH_END; i++ ) {
+		glyph = RE_ConstructGlyphInfo(fontName, bitmaps, face, R_RemapGlyphCharacter( face, i ), borderWidth, forceAutoHint);
+		Com_Memcpy(&font->glyphs[i], glyph, sizeof(glyphInfo_t));
+	}
 
-	// do not exceed maxTextureSize
-	if (imageSize > glConfig.maxTextureSize) {
-		imageSize = glConfig.maxTextureSize;
+	// scale alpha
+	max = 0;
+	for ( k = 0; k < bitmaps->used; k += 4 ) {
+		if (max < bitmaps->data[k+3]) {
+			max = bitmaps->data[k+3];
+		}
 	}
 
-	// make a 256x256 image buffer, once it is full, register it, clean it and keep going 
-	// until all glyphs are rendered
+	if (max > 0) {
+		max = 255/max;
+	}
 
-	out = ri.Malloc(imageSize*imageSize*4);
-	if (out == NULL) {
-		ri.Printf(PRINT_WARNING, "RE_RegisterFont: ri.Malloc failure during output image creation.\n");
-		FT_Done_Face(face);
-		ri.FS_FreeFile(faceData);
-		return qfalse;
+	for ( k = 0; k < bitmaps->used; k += 4 ) {
+		bitmaps->data[k+3] = ((float)bitmaps->data[k+3] * max);
 	}
-	Com_Memset(out, 0, imageSize*imageSize*4);
 
-	rowHeight = 0;
-	xOut = 0;
-	yOut = 0;
-	i = GLYPH_START;
-	lastStart = i;
-	imageNumber = 0;
+	// we also need to adjust the scale based on point size relative to 48 points as the ui scaling is based on a 48 point font
+	glyphScale *= 48.0f / pointSize;
+
+	font->glyphScale = glyphScale;
 
-	while ( i <= GLYPH_END + 1 ) {
+	FT_Done_Face(face);
+	ri.FS_FreeFile(faceData);
+	return qtrue;
+}
 
-		if ( i == GLYPH_END + 1 ) {
-			// upload/save current image buffer
-			glyph = NULL;
-		} else {
-			glyph = RE_ConstructGlyphInfo(fontName, imageSize, out, &xOut, &yOut, &rowHeight, face, R_RemapGlyphCharacter( face, i ), borderWidth, forceAutoHint);
-		}
+/*
+===============
+R_LoadDynamicFont
 
-		if (!glyph)  {
-			// ran out of room
-			// we need to create an image from the bitmap, set all the handles in the glyphs to this point
-			// 
-
-			// scale alpha
-			scaledSize = imageSize*imageSize*4;
-			max = 0;
-			for ( k = 0; k < scaledSize; k += 4 ) {
-				if (max < out[k+3]) {
-					max = out[k+3];
-				}
-			}
+Load an outline/bitmap font using Freetype for the current game window resolution.
+===============
+*/
+qboolean R_LoadDynamicFont( const char *fontName, int pointSize, float borderWidth, qboolean forceAutoHint, fontInfo_t *font ) {
+	glyphBitmaps_t	bitmaps;
+	fontCacheKey_t	cacheKey;
+	qboolean	useCache;
+	int			firstPage;
+	float		dpi;
+	int			len;
+	char		datName[MAX_QPATH];
+	char		strippedName[MAX_QPATH];
+	float		windowScale;
 
-			if (max > 0) {
-				max = 255/max;
-			}
+	if (ftLibrary == NULL) {
+		ri.Printf(PRINT_WARNING, "RE_RegisterFont: FreeType not initialized.\n");
+		return qfalse;
+	}
 
-			for ( k = 0; k < scaledSize; k += 4 ) {
-				out[k+3] = ((float)out[k+3] * max);
-			}
+	COM_StripExtension( fontName, strippedName, sizeof ( strippedName ) );
 
-			// make sure last row doesn't get cut off when reducing image height
-			yOut += rowHeight + 1;
+	if (registeredFontCount >= MAX_FONTS) {
+		len = ri.FS_ReadFile(fontName, NULL);
+		if (len <= 0) {
+			ri.Printf(PRINT_DEVELOPER, "RE_RegisterFont: Unable to read font file '%s'\n", fontName);
+		} else {
+			ri.Printf(PRINT_WARNING, "RE_RegisterFont: No free slot to load font file '%s'\n", fontName);
+		}
+		return qfalse;
+	}
 
-			// check if image height can be reduced to a lower power of two
-			for ( saveHeight = 1; saveHeight < yOut; saveHeight <<= 1 );
+	// point sizes are for a virtual 640x480 window
+	if ( glConfig.vidWidth * 480 > glConfig.vidHeight * 640 ) {
+		windowScale = glConfig.vidHeight / 480.0f;
+	} else {
+		windowScale = glConfig.vidWidth / 640.0f;
+	}
 
-			if ( saveHeight > imageSize ) {
-				saveHeight = imageSize;
-			}
+	// scale dpi based on window resolution
+	dpi = 72.0f * windowScale;
 
-			if ( borderWidth != 0 ) {
-				Com_sprintf(imageName, sizeof(imageName), "%s_%i_%i_b%g.tga", strippedName, imageNumber++, pointSize, borderWidth);
-			} else {
-				Com_sprintf(imageName, sizeof(imageName), "%s_%i_%i.tga", strippedName, imageNumber++, pointSize);
-			}
-			if(r_saveFontData->integer && !ri.FS_FileExists(imageName)) {
-				WriteTGA(imageName, out, imageSize, saveHeight);
-			}
+	Com_Memset( &bitmaps, 0, sizeof ( bitmaps ) );
 
-			image = R_CreateImage(imageName, out, imageSize, saveHeight, IMGTYPE_COLORALPHA, IMGFLAG_CLAMPTOEDGE|IMGFLAG_MIPMAP, 0 );
-			h = RE_RegisterShaderFromImage(imageName, LIGHTMAP_2D, image, qfalse);
-			for (j = lastStart; j < i; j++) {
-				font->glyphs[j].glyph = h;
-				COM_StripExtension(imageName, font->glyphs[j].shaderName, sizeof(font->glyphs[j].shaderName));
-
-				// fill in the texture coords now that image height is known
-				font->glyphs[j].s = (float)font->glyphs[j].s / imageSize;
-				font->glyphs[j].t = (float)font->glyphs[j].t / saveHeight;
-				font->glyphs[j].s2 = font->glyphs[j].s + (float)font->glyphs[j].imageWidth / imageSize;
-				font->glyphs[j].t2 = font->glyphs[j].t + (float)font->glyphs[j].imageHeight / saveHeight;
+	useCache = R_FontCacheKey( fontName, pointSize, borderWidth, forceAutoHint, dpi, &cacheKey );
+	if ( !useCache || !R_LoadCachedFont( &cacheKey, font, &bitmaps ) ) {
+		if ( !R_RenderFontGlyphs( fontName, pointSize, borderWidth, forceAutoHint, dpi, font, &bitmaps ) ) {
+			if ( bitmaps.data ) {
+				ri.Free( bitmaps.data );
 			}
-			lastStart = i;
-			Com_Memset(out, 0, imageSize*imageSize*4);
-			xOut = 0;
-			yOut = 0;
-			rowHeight = 0;
-			if ( i == GLYPH_END + 1 )
-				i++;
-		} else {
-			Com_Memcpy(&font->glyphs[i], glyph, sizeof(glyphInfo_t));
-			i++;
+			return qfalse;
 		}
-	}
 
-	// we also need to adjust the scale based on point size relative to 48 points as the ui scaling is based on a 48 point font
-	glyphScale *= 48.0f / pointSize;
+		if ( useCache ) {
+			R_SaveCachedFont( &cacheKey, font, &bitmaps );
+		}
+	}
 
-	font->glyphScale = glyphScale;
 	font->pointSize = pointSize;
 	font->flags = FONTFLAG_CURSORS;
 
@@ -1122,21 +1552,24 @@ qboolean R_LoadDynamicFont( const char *fontName, int pointSize, float borderWid
 		Com_sprintf(datName, sizeof(datName), "%s_%i.dat", strippedName, pointSize);
 	}
 	Q_strncpyz(font->name, datName, sizeof(font->name));
-	Com_Memcpy(&registeredFont[registeredFontCount++], font, sizeof(fontInfo_t));
 
-	if(r_saveFontData->integer && !ri.FS_FileExists(datName)) {
-#if defined Q3_BIG_ENDIAN
-		Com_Printf( S_COLOR_YELLOW "WARNING: Cannot write font data on big endian systems\n" );
-#else
-		// ZTM: FIXME: need to swap for big endian systems
-		ri.FS_WriteFile(datName, font, sizeof(fontInfo_t));
-#endif
+	firstPage = R_PackFontGlyphs( font, bitmaps.data, dpi );
+
+	if ( bitmaps.data ) {
+		ri.Free( bitmaps.data );
 	}
 
-	ri.Free(out);
+	if ( firstPage != -1 && r_saveFontData->integer ) {
+		R_SaveFontData( font, strippedName, pointSize, borderWidth, firstPage );
+	}
 
-	FT_Done_Face(face);
-	ri.FS_FreeFile(faceData);
+	R_FinishFontAtlas();
+
+	if ( firstPage == -1 ) {
+		return qfalse;
+	}
+
+	Com_Memcpy(&registeredFont[registeredFontCount++], font, sizeof(fontInfo_t));
 	return qtrue;
 }
 #endif
@@ -1283,6 +1716,9 @@ void R_InitFreeType(void) {
 	if (FT_Init_FreeType( &ftLibrary )) {
 		ri.Printf(PRINT_WARNING, "R_InitFreeType: Unable to initialize FreeType.\n");
 	}
+
+	numFontAtlasPages = 0;
+	fontAtlasSize = 0;
 #endif
 
 	registeredFontCount = 0;
@@ -1291,10 +1727,22 @@ void R_InitFreeType(void) {
 
 void R_DoneFreeType(void) {
 #ifdef BUILD_FREETYPE
+	int i;
+
 	if (ftLibrary) {
 		FT_Done_FreeType( ftLibrary );
 		ftLibrary = NULL;
 	}
+
+	// the atlas images are freed with the other images
+	for ( i = 0; i < numFontAtlasPages; i++ ) {
+		if ( fontAtlasPages[i].pixels ) {
+			ri.Free( fontAtlasPages[i].pixels );
+		}
+	}
+
+	numFontAtlasPages = 0;
+	fontAtlasSize = 0;
 #endif
 
 	registeredFontCount = 0;
@@ -1308,5 +1756,8 @@ void R_FontList_f( void ) {
 	}
 
 	ri.Printf( PRINT_ALL, " ---------\n%2d fonts registered\n", registeredFontCount );
+#ifdef BUILD_FREETYPE
+	ri.Printf( PRINT_ALL, "%2d font atlas pages of %ix%i\n", numFontAtlasPages, fontAtlasSize, fontAtlasSize );
+#endif
 }
 
@@ -413,13 +413,14 @@ static void SetupLinear( textureLevel_t **pic, int width, int height, int depth,
 		lvl[i].size = size * sizeof(color4ub_t) * depth;
 		lvl[i].data = (byte *)out;
 
-		out += lvl[i].size;
+		out = (color4ub_t *)((byte *)out + lvl[i].size);
 
 		if( w > 1 ) w >>= 1;
 		if( h > 1 ) h >>= 1;
 	}
 
 	// ZTM: Tested and works with RGBA8 cubemap without mipmaps
+	// each face is stored with all of its mip levels
 	for( k = 0; k < depth; k++ ) {
 		for( i = 0; i < mipmaps; i++ ) {
 			uint64_t bits = 0;
@@ -428,7 +429,8 @@ static void SetupLinear( textureLevel_t **pic, int width, int height, int depth,
 			size = lvl[i].width * lvl[i].height;
 
 			out = (color4ub_t *)((byte *)lvl[i].data + k * size * sizeof(color4ub_t));
-			in = (color4ub_t *)((byte *)base + k * size * bitCount / 8);
+			in = (color4ub_t *)base;
+			base += size * bitCount / 8;
 
 			for( j = 0; j < size; j++ ) {
 				while( bitsStored < bitCount ) {
@@ -467,13 +469,40 @@ static void SetupLinear( textureLevel_t **pic, int width, int height, int depth,
 }
 
 void R_LoadDDS( const char *name, int *numTexLevels, textureLevel_t **pic )
+{
+	void *buffer;
+	int length;
+
+	*pic = NULL;
+	*numTexLevels = 0;
+
+	//
+	// load the file
+	//
+	length = ri.FS_ReadFile ( ( char * ) name, &buffer );
+	if ( !buffer || length < 0 ) {
+		return;
+	}
+
+	R_LoadDDSFromBuffer( name, buffer, length, numTexLevels, pic );
+
+	ri.FS_FreeFile (buffer);
+}
+
+/*
+=================
+R_LoadDDSFromBuffer
+
+The header in buffer is byte swapped in place
+=================
+*/
+void R_LoadDDSFromBuffer( const char *name, void *data, int length, int *numTexLevels, textureLevel_t **pic )
 {
 	union {
 		byte *b;
 		void *v;
 	} buffer;
 	DDS_HEADER *hdr;
-	int length;
 	GLuint glFormat;
 	int    mipmaps;
 	byte  *base;
@@ -482,13 +511,7 @@ void R_LoadDDS( const char *name, int *numTexLevels, textureLevel_t **pic )
 	*pic = NULL;
 	*numTexLevels = 0;
 
-	//
-	// load the file
-	//
-	length = ri.FS_ReadFile ( ( char * ) name, &buffer.v );
-	if ( !buffer.b || length < 0 ) {
-		return;
-	}
+	buffer.v = data;
 
 	if( length < 4 || Q_strncmp((char *)buffer.v, "DDS ", 4) ) {
 		ri.Error( ERR_DROP, "LoadDDS: Missing DDS signature (%s)", name );
@@ -853,8 +876,157 @@ void R_LoadDDS( const char *name, int *numTexLevels, textureLevel_t **pic )
 		RE_SaveTGA_EXT(filename, (*pic)[0].width, (*pic)[0].height, 4, (*pic)[0].data + (*pic)[0].width * (*pic)[0].height * 4 * i, 0);
 	}
 #endif
+}
+
+/*
+=================
+R_WriteDDS
+
+Builds a DDS file containing a mip chain of GL_RGBA8 or DXTn levels,
+returns the length of the ri.Malloc'd file in *data or 0 if the format
+can't be stored.
+=================
+*/
+int R_WriteDDS( byte **data, int numLevels, const textureLevel_t *pic )
+{
+	DDS_HEADER *ddsHeader;
+	byte *out;
+	int size, i;
+
+	*data = NULL;
+
+	size = 4 + sizeof(*ddsHeader);
+	for (i = 0; i < numLevels; i++) {
+		if (pic[i].format != pic[0].format) {
+			return 0;
+		}
+		size += pic[i].size;
+	}
+
+	out = ri.Malloc(size);
+
+	out[0] = 'D';
+	out[1] = 'D';
+	out[2] = 'S';
+	out[3] = ' ';
+
+	ddsHeader = (DDS_HEADER *)(out + 4);
+	memset(ddsHeader, 0, sizeof(*ddsHeader));
+
+	ddsHeader->dwSize = LittleLong(sizeof(*ddsHeader));
+	ddsHeader->dwHeaderFlags = LittleLong(DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT);
+	ddsHeader->dwHeight = LittleLong(pic[0].height);
+	ddsHeader->dwWidth = LittleLong(pic[0].width);
+	ddsHeader->dwMipMapCount = LittleLong(numLevels);
+	ddsHeader->ddspf.dwSize = LittleLong(sizeof(ddsHeader->ddspf));
+	ddsHeader->dwSurfaceFlags = LittleLong(DDSCAPS_COMPLEX | DDSCAPS_TEXTURE | DDSCAPS_MIPMAP);
+
+	switch (pic[0].format) {
+	case GL_RGBA8:
+		ddsHeader->ddspf.dwFlags = LittleLong(DDPF_RGB | DDPF_ALPHAPIXELS);
+		ddsHeader->ddspf.dwRGBBitCount = LittleLong(32);
+		ddsHeader->ddspf.dwRBitMask = LittleLong(0x000000ff);
+		ddsHeader->ddspf.dwGBitMask = LittleLong(0x0000ff00);
+		ddsHeader->ddspf.dwBBitMask = LittleLong(0x00ff0000);
+		ddsHeader->ddspf.dwABitMask = LittleLong(0xff000000);
+		break;
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+		ddsHeader->ddspf.dwFlags = LittleLong(DDPF_FOURCC);
+		ddsHeader->ddspf.dwFourCC = LittleLong(D3DFMT_DXT1);
+		break;
+	case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+		ddsHeader->ddspf.dwFlags = LittleLong(DDPF_FOURCC);
+		ddsHeader->ddspf.dwFourCC = LittleLong(D3DFMT_DXT3);
+		break;
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		ddsHeader->ddspf.dwFlags = LittleLong(DDPF_FOURCC);
+		ddsHeader->ddspf.dwFourCC = LittleLong(D3DFMT_DXT5);
+		break;
+	default:
+		ri.Free(out);
+		return 0;
+	}
+
+	size = 4 + sizeof(*ddsHeader);
+	for (i = 0; i < numLevels; i++) {
+		Com_Memcpy(out + size, pic[i].data, pic[i].size);
+		size += pic[i].size;
+	}
+
+	*data = out;
+	return size;
+}
+
+/*
+=================
+R_CheckDDS
+
+Returns qtrue if data is a complete DDS file in one of the formats written
+by R_WriteDDS, so R_LoadDDSFromBuffer can't fail on it.
+=================
+*/
+qboolean R_CheckDDS( const void *data, int length )
+{
+	DDS_HEADER hdr;
+	uint64_t size, w, h;
+	int blockSize;
+	unsigned int i, mipmaps;
+
+	if( length < 4 + (int)sizeof(hdr) || Q_strncmp((const char *)data, "DDS ", 4) ) {
+		return qfalse;
+	}
+
+	Com_Memcpy( &hdr, (const byte *)data + 4, sizeof(hdr) );
+	LL(hdr.dwSize);
+	LL(hdr.dwHeight);
+	LL(hdr.dwWidth);
+	LL(hdr.dwMipMapCount);
+	LL(hdr.ddspf.dwSize);
+	LL(hdr.ddspf.dwFlags);
+	LL(hdr.ddspf.dwFourCC);
+	LL(hdr.ddspf.dwRGBBitCount);
+	LL(hdr.dwCubemapFlags);
+
+	if( hdr.dwSize != sizeof(DDS_HEADER) || hdr.ddspf.dwSize != sizeof(DDS_PIXELFORMAT)
+	  || hdr.dwCubemapFlags || !hdr.dwWidth || !hdr.dwHeight || hdr.dwMipMapCount > 32 ) {
+		return qfalse;
+	}
+
+	if( hdr.ddspf.dwFlags & DDPF_FOURCC ) {
+		switch( hdr.ddspf.dwFourCC ) {
+		case D3DFMT_DXT1:
+			blockSize = 8;
+			break;
+		case D3DFMT_DXT3:
+		case D3DFMT_DXT5:
+			blockSize = 16;
+			break;
+		default:
+			return qfalse;
+		}
+	} else if( hdr.ddspf.dwRGBBitCount == 32 ) {
+		blockSize = 0;
+	} else {
+		return qfalse;
+	}
+
+	// all levels have to be there
+	mipmaps = hdr.dwMipMapCount > 0 ? hdr.dwMipMapCount : 1;
+	w = hdr.dwWidth;
+	h = hdr.dwHeight;
+	size = 0;
+	for( i = 0; i < mipmaps; i++ ) {
+		if( blockSize ) {
+			size += ( ( w + 3 ) / 4 ) * ( ( h + 3 ) / 4 ) * blockSize;
+		} else {
+			size += w * h * 4;
+		}
+
+		if( w > 1 ) w >>= 1;
+		if( h > 1 ) h >>= 1;
+	}
 
-	ri.FS_FreeFile (buffer.v);
+	return size <= (uint64_t)( length - 4 - (int)sizeof(hdr) );
 }
 
 // ZTM: TODO: Fix saving DDS for big endianess
@@ -69,7 +69,7 @@ static void R_JPGErrorExit(j_common_ptr cinfo)
   
   (*cinfo->err->format_message) (cinfo, buffer);
 
-  ri.Printf(PRINT_ALL, "Error: %s", buffer);
+  R_DecodePrintf(PRINT_ALL, "Error: %s", buffer);
 
   /* Return control to the setjmp point */
   longjmp(jerr->setjmp_buffer, 1);
@@ -83,10 +83,10 @@ static void R_JPGOutputMessage(j_common_ptr cinfo)
   (*cinfo->err->format_message) (cinfo, buffer);
   
   /* Send it to stderr, adding a newline */
-  ri.Printf(PRINT_ALL, "%s\n", buffer);
+  R_DecodePrintf(PRINT_ALL, "%s\n", buffer);
 }
 
-void R_LoadJPG(const char *filename, int *numTexLevels, textureLevel_t **pic)
+void R_DecodeJPG(imageDecode_t *decode)
 {
   /* This struct contains the JPEG decompression parameters and pointers to
    * working space (which is allocated as needed by the JPEG library).
@@ -111,23 +111,9 @@ void R_LoadJPG(const char *filename, int *numTexLevels, textureLevel_t **pic)
   unsigned int pixelcount, memcount;
   unsigned int sindex, dindex;
   byte *out;
-  int len;
-	union {
-		byte *b;
-		void *v;
-	} fbuffer;
   byte  *buf;
-
-  /* In this example we want to open the input file before doing anything else,
-   * so that the setjmp() error recovery below can assume the file is open.
-   * VERY IMPORTANT: use "b" option to fopen() if you are on a machine that
-   * requires it in order to read binary files.
-   */
-
-  len = ri.FS_ReadFile ( ( char * ) filename, &fbuffer.v);
-  if (!fbuffer.b || len < 0) {
-	return;
-  }
+  textureLevel_t *pic;
+  const char *filename = decode->name;
 
   /* Step 1: allocate and initialize JPEG decompression object */
 
@@ -147,10 +133,9 @@ void R_LoadJPG(const char *filename, int *numTexLevels, textureLevel_t **pic)
      * We need to clean up the JPEG object, close the input file, and return.
      */
     jpeg_destroy_decompress(&cinfo);
-    ri.FS_FreeFile(fbuffer.v);
 
     /* Append the filename to the error for easier debugging */
-    ri.Printf(PRINT_ALL, ", loading file %s\n", filename);
+    R_DecodePrintf(PRINT_ALL, ", loading file %s\n", filename);
     return;
   }
 
@@ -159,7 +144,7 @@ void R_LoadJPG(const char *filename, int *numTexLevels, textureLevel_t **pic)
 
   /* Step 2: specify data source (eg, a file) */
 
-  jpeg_mem_src(&cinfo, fbuffer.b, len);
+  jpeg_mem_src(&cinfo, (unsigned char *)decode->buffer, decode->length);
 
   /* Step 3: read file parameters with jpeg_read_header() */
 
@@ -201,23 +186,24 @@ void R_LoadJPG(const char *filename, int *numTexLevels, textureLevel_t **pic)
     )
   {
     // Free the memory to make sure we don't leak memory
-    ri.FS_FreeFile (fbuffer.v);
     jpeg_destroy_decompress(&cinfo);
   
-    ri.Error(ERR_DROP, "LoadJPG: %s has an invalid image format: %dx%d*4=%d, components: %d", filename,
+    R_DecodeError(decode, "LoadJPG: %s has an invalid image format: %dx%d*4=%d, components: %d", filename,
 		    cinfo.output_width, cinfo.output_height, pixelcount * 4, cinfo.output_components);
+    return;
   }
 
   memcount = pixelcount * 4;
   row_stride = cinfo.output_width * cinfo.output_components;
 
-  *pic = (textureLevel_t *)ri.Malloc(sizeof(textureLevel_t) + memcount);
-  (*pic)->format = GL_RGBA8;
-  (*pic)->width = cinfo.output_width;
-  (*pic)->height = cinfo.output_height;
-  (*pic)->size = memcount;
-  (*pic)->data = out = (byte *)(*pic + 1);
-  *numTexLevels = 1;
+  pic = (textureLevel_t *)R_DecodeMalloc(sizeof(textureLevel_t) + memcount);
+  pic->format = GL_RGBA8;
+  pic->width = cinfo.output_width;
+  pic->height = cinfo.output_height;
+  pic->size = memcount;
+  pic->data = out = (byte *)(pic + 1);
+  decode->pic = pic;
+  decode->numLevels = 1;
 
   /* Step 6: while (scan lines remain to be read) */
   /*           jpeg_read_scanlines(...); */
@@ -261,13 +247,6 @@ void R_LoadJPG(const char *filename, int *numTexLevels, textureLevel_t **pic)
   /* This is an important step since it will release a good deal of memory. */
   jpeg_destroy_decompress(&cinfo);
 
-  /* After finish_decompress, we can close the input file.
-   * Here we postpone it until after no more JPEG errors are possible,
-   * so as to simplify the setjmp error logic above.  (Actually, I don't
-   * think that jpeg_destroy can do an error exit, but why assume anything...)
-   */
-  ri.FS_FreeFile (fbuffer.v);
-
   /* At this point you may want to check to see whether any corrupt-data
    * warnings occurred (test whether jerr.pub.num_warnings is nonzero).
    */
@@ -275,6 +254,11 @@ void R_LoadJPG(const char *filename, int *numTexLevels, textureLevel_t **pic)
   /* And we're done! */
 }
 
+void R_LoadJPG(const char *filename, int *numTexLevels, textureLevel_t **pic)
+{
+  R_LoadImageWithDecoder(filename, R_DecodeJPG, numTexLevels, pic);
+}
+
 
 /* Expanded data destination object for stdio output */
 
@@ -221,22 +221,18 @@ struct BufferedFile
 };
 
 /*
- *  Read a file into a buffer.
+ *  Wrap a file that is already in memory.
  */
 
-static struct BufferedFile *ReadBufferedFile(const char *name)
+static struct BufferedFile *ReadBufferedFile(const byte *buffer, int length)
 {
 	struct BufferedFile *BF;
-	union {
-		byte *b;
-		void *v;
-	} buffer;
 
 	/*
 	 *  input verification
 	 */
 
-	if(!name)
+	if(!(buffer && (length > 0)))
 	{
 		return(NULL);
 	}
@@ -245,7 +241,7 @@ static struct BufferedFile *ReadBufferedFile(const char *name)
 	 *  Allocate control struct.
 	 */
 
-	BF = ri.Malloc(sizeof(struct BufferedFile));
+	BF = R_DecodeMalloc(sizeof(struct BufferedFile));
 	if(!BF)
 	{
 		return(NULL);
@@ -261,22 +257,11 @@ static struct BufferedFile *ReadBufferedFile(const char *name)
 	BF->BytesLeft = 0;
 
 	/*
-	 *  Read the file.
+	 *  The buffer belongs to the caller.
 	 */
 
-	BF->Length = ri.FS_ReadFile((char *) name, &buffer.v);
-	BF->Buffer = buffer.b;
-
-	/*
-	 *  Did we get it? Is it big enough?
-	 */
-
-	if(!(BF->Buffer && (BF->Length > 0)))
-	{
-		ri.Free(BF);
-
-		return(NULL);
-	}
+	BF->Length = length;
+	BF->Buffer = (byte *)buffer;
 
 	/*
 	 *  Set the pointers and counters.
@@ -296,12 +281,7 @@ static void CloseBufferedFile(struct BufferedFile *BF)
 {
 	if(BF)
 	{
-		if(BF->Buffer)
-		{
-			ri.FS_FreeFile(BF->Buffer);
-		}
-
-		ri.Free(BF);
+		R_DecodeFree(BF);
 	}
 }
 
@@ -635,7 +615,7 @@ static uint32_t DecompressIDATs(struct BufferedFile *BF, uint8_t **Buffer)
 
 	BufferedFileRewind(BF, BytesToRewind);
 
-	CompressedData = ri.Malloc(CompressedDataLength);
+	CompressedData = R_DecodeMalloc(CompressedDataLength);
 	if(!CompressedData)
 	{
 		return(-1);
@@ -656,7 +636,7 @@ static uint32_t DecompressIDATs(struct BufferedFile *BF, uint8_t **Buffer)
 		CH = BufferedFileRead(BF, PNG_ChunkHeader_Size);
 		if(!CH)
 		{
-			ri.Free(CompressedData); 
+			R_DecodeFree(CompressedData); 
 
 			return(-1);
 		}
@@ -690,14 +670,14 @@ static uint32_t DecompressIDATs(struct BufferedFile *BF, uint8_t **Buffer)
 			OrigCompressedData = BufferedFileRead(BF, Length);
 			if(!OrigCompressedData)
 			{
-				ri.Free(CompressedData); 
+				R_DecodeFree(CompressedData); 
 
 				return(-1);
 			}
 
 			if(!BufferedFileSkip(BF, PNG_ChunkCRC_Size))
 			{
-				ri.Free(CompressedData); 
+				R_DecodeFree(CompressedData); 
 
 				return(-1);
 			}
@@ -728,7 +708,7 @@ static uint32_t DecompressIDATs(struct BufferedFile *BF, uint8_t **Buffer)
 	puffResult = puff(puffDest, &puffDestLen, puffSrc, &puffSrcLen);
 	if(!((puffResult == 0) && (puffDestLen > 0)))
 	{
-		ri.Free(CompressedData);
+		R_DecodeFree(CompressedData);
 
 		return(-1);
 	}
@@ -737,10 +717,10 @@ static uint32_t DecompressIDATs(struct BufferedFile *BF, uint8_t **Buffer)
 	 *  Allocate the buffer for the uncompressed data.
 	 */
 
-	DecompressedData = ri.Malloc(puffDestLen);
+	DecompressedData = R_DecodeMalloc(puffDestLen);
 	if(!DecompressedData)
 	{
-		ri.Free(CompressedData);
+		R_DecodeFree(CompressedData);
 
 		return(-1);
 	}
@@ -763,7 +743,7 @@ static uint32_t DecompressIDATs(struct BufferedFile *BF, uint8_t **Buffer)
 	 *  The compressed data is not needed anymore.
 	 */
 
-	ri.Free(CompressedData);
+	R_DecodeFree(CompressedData);
 
 	/*
 	 *  Check if the last puff() was successful.
@@ -771,7 +751,7 @@ static uint32_t DecompressIDATs(struct BufferedFile *BF, uint8_t **Buffer)
 
 	if(!((puffResult == 0) && (puffDestLen > 0)))
 	{
-		ri.Free(DecompressedData);
+		R_DecodeFree(DecompressedData);
 
 		return(-1);
 	}
@@ -1912,8 +1892,10 @@ static qboolean DecodeImageInterlaced(struct PNG_Chunk_IHDR *IHDR,
  *  The PNG loader
  */
 
-void R_LoadPNG(const char *name, int *numTexLevels, textureLevel_t **pic)
+void R_DecodePNG(imageDecode_t *decode)
 {
+	const char *name = decode->name;
+	textureLevel_t *pic;
 	struct BufferedFile *ThePNG;
 	byte *OutBuffer;
 	uint8_t *Signature;
@@ -1943,26 +1925,10 @@ void R_LoadPNG(const char *name, int *numTexLevels, textureLevel_t **pic)
 	uint8_t TransparentColour[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
 
 	/*
-	 *  input verification
+	 *  Wrap the file.
 	 */
 
-	if(!(name && pic))
-	{
-		return;
-	}
-
-	/*
-	 *  Zero out return values.
-	 */
-
-	*pic = NULL;
-	*numTexLevels = 0;
-
-	/*
-	 *  Read the file.
-	 */
-
-	ThePNG = ReadBufferedFile(name);
+	ThePNG = ReadBufferedFile(decode->buffer, decode->length);
 	if(!ThePNG)
 	{
 		return;
@@ -2065,7 +2031,7 @@ void R_LoadPNG(const char *name, int *numTexLevels, textureLevel_t **pic)
 	{
 		CloseBufferedFile(ThePNG);
 
-		ri.Printf( PRINT_WARNING, "%s: invalid image size\n", name );
+		R_DecodePrintf( PRINT_WARNING, "%s: invalid image size\n", name );
 
 		return; 
 	}
@@ -2401,22 +2367,21 @@ void R_LoadPNG(const char *name, int *numTexLevels, textureLevel_t **pic)
 	 *  Allocate output buffer.
 	 */
 
-	*pic = (textureLevel_t *)ri.Malloc( sizeof(textureLevel_t) + IHDR_Width * IHDR_Height * Q3IMAGE_BYTESPERPIXEL );
+	pic = (textureLevel_t *)R_DecodeMalloc( sizeof(textureLevel_t) + IHDR_Width * IHDR_Height * Q3IMAGE_BYTESPERPIXEL );
 
-	if(!(*pic))
+	if(!pic)
 	{
-		ri.Free(DecompressedData); 
+		R_DecodeFree(DecompressedData); 
 		CloseBufferedFile(ThePNG);
 
 		return;  
 	}
 
-	(*pic)->format = GL_RGBA8;
-	(*pic)->width = IHDR_Width;
-	(*pic)->height = IHDR_Height;
-	(*pic)->size = IHDR_Width * IHDR_Height * Q3IMAGE_BYTESPERPIXEL;
-	(*pic)->data = OutBuffer = (byte *)(*pic + 1);
-	*numTexLevels = 1;
+	pic->format = GL_RGBA8;
+	pic->width = IHDR_Width;
+	pic->height = IHDR_Height;
+	pic->size = IHDR_Width * IHDR_Height * Q3IMAGE_BYTESPERPIXEL;
+	pic->data = OutBuffer = (byte *)(pic + 1);
 
 	/*
 	 *  Interlaced and Non-interlaced images need to be handled differently.
@@ -2428,8 +2393,8 @@ void R_LoadPNG(const char *name, int *numTexLevels, textureLevel_t **pic)
 		{
 			if(!DecodeImageNonInterlaced(IHDR, OutBuffer, DecompressedData, DecompressedDataLength, HasTransparentColour, TransparentColour, OutPal))
 			{
-				ri.Free(OutBuffer); 
-				ri.Free(DecompressedData); 
+				R_DecodeFree(pic); 
+				R_DecodeFree(DecompressedData); 
 				CloseBufferedFile(ThePNG);
 
 				return;
@@ -2442,8 +2407,8 @@ void R_LoadPNG(const char *name, int *numTexLevels, textureLevel_t **pic)
 		{
 			if(!DecodeImageInterlaced(IHDR, OutBuffer, DecompressedData, DecompressedDataLength, HasTransparentColour, TransparentColour, OutPal))
 			{
-				ri.Free(OutBuffer); 
-				ri.Free(DecompressedData); 
+				R_DecodeFree(pic); 
+				R_DecodeFree(DecompressedData); 
 				CloseBufferedFile(ThePNG);
 
 				return;
@@ -2454,8 +2419,8 @@ void R_LoadPNG(const char *name, int *numTexLevels, textureLevel_t **pic)
 
 		default :
 		{
-			ri.Free(OutBuffer); 
-			ri.Free(DecompressedData); 
+			R_DecodeFree(pic); 
+			R_DecodeFree(DecompressedData); 
 			CloseBufferedFile(ThePNG);
 
 			return;
@@ -2466,13 +2431,21 @@ void R_LoadPNG(const char *name, int *numTexLevels, textureLevel_t **pic)
 	 *  DecompressedData is not needed anymore.
 	 */
 
-	ri.Free(DecompressedData); 
+	R_DecodeFree(DecompressedData); 
 
 	/*
 	 *  We have all data, so close the file.
 	 */
 
 	CloseBufferedFile(ThePNG);
+
+	decode->pic = pic;
+	decode->numLevels = 1;
+}
+
+void R_LoadPNG(const char *name, int *numTexLevels, textureLevel_t **pic)
+{
+	R_LoadImageWithDecoder(name, R_DecodePNG, numTexLevels, pic);
 }
 
 /*
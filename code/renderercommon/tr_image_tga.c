@@ -46,39 +46,26 @@ typedef struct _TargaHeader {
 	unsigned char	pixel_size, attributes;
 } TargaHeader;
 
-void R_LoadTGA ( const char *name, int *numTexLevels, textureLevel_t **pic)
+void R_DecodeTGA( imageDecode_t *decode )
 {
 	unsigned	columns, rows, numPixels;
 	byte	*pixbuf;
 	int		row, column;
-	byte	*buf_p;
-	byte	*end;
-	union {
-		byte *b;
-		void *v;
-	} buffer;
+	const byte	*buf_p;
+	const byte	*end;
 	TargaHeader	targa_header;
 	byte		*targa_rgba;
-	int length;
+	textureLevel_t	*pic;
+	const char	*name = decode->name;
 
-	*pic = NULL;
-	*numTexLevels = 0;
-
-	//
-	// load the file
-	//
-	length = ri.FS_ReadFile ( ( char * ) name, &buffer.v);
-	if (!buffer.b || length < 0) {
-		return;
-	}
-
-	if(length < 18)
+	if(decode->length < 18)
 	{
-		ri.Error( ERR_DROP, "LoadTGA: header too short (%s)", name );
+		R_DecodeError( decode, "LoadTGA: header too short (%s)", name );
+		return;
 	}
 
-	buf_p = buffer.b;
-	end = buffer.b + length;
+	buf_p = decode->buffer;
+	end = decode->buffer + decode->length;
 
 	targa_header.id_length = buf_p[0];
 	targa_header.colormap_type = buf_p[1];
@@ -107,17 +94,27 @@ void R_LoadTGA ( const char *name, int *numTexLevels, textureLevel_t **pic)
 		&& targa_header.image_type!=10
 		&& targa_header.image_type != 3 ) 
 	{
-		ri.Error (ERR_DROP, "LoadTGA: Only type 2 (RGB), 3 (gray), and 10 (RGB) TGA images supported");
+		R_DecodeError( decode, "LoadTGA: Only type 2 (RGB), 3 (gray), and 10 (RGB) TGA images supported" );
+		return;
 	}
 
 	if ( targa_header.colormap_type != 0 )
 	{
-		ri.Error( ERR_DROP, "LoadTGA: colormaps not supported" );
+		R_DecodeError( decode, "LoadTGA: colormaps not supported" );
+		return;
 	}
 
 	if ( ( targa_header.pixel_size != 32 && targa_header.pixel_size != 24 ) && targa_header.image_type != 3 )
 	{
-		ri.Error (ERR_DROP, "LoadTGA: Only 32 or 24 bit images supported (no colormaps)");
+		R_DecodeError( decode, "LoadTGA: Only 32 or 24 bit images supported (no colormaps)" );
+		return;
+	}
+
+	// checked here so the pixel loops below don't have to fail part way
+	if ( targa_header.pixel_size != 32 && targa_header.pixel_size != 24 && targa_header.pixel_size != 8 )
+	{
+		R_DecodeError( decode, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
+		return;
 	}
 
 	columns = targa_header.width;
@@ -126,22 +123,27 @@ void R_LoadTGA ( const char *name, int *numTexLevels, textureLevel_t **pic)
 
 	if(!columns || !rows || numPixels > 0x7FFFFFFF || numPixels / columns / 4 != rows)
 	{
-		ri.Error (ERR_DROP, "LoadTGA: %s has an invalid image size", name);
+		R_DecodeError( decode, "LoadTGA: %s has an invalid image size", name );
+		return;
 	}
 
 
-	*pic = (textureLevel_t *)ri.Malloc( sizeof(textureLevel_t) + numPixels );
-	(*pic)->format = GL_RGBA8;
-	(*pic)->width = columns;
-	(*pic)->height = rows;
-	(*pic)->size = numPixels;
-	(*pic)->data = targa_rgba = (byte *)(*pic + 1);
-	*numTexLevels = 1;
+	pic = (textureLevel_t *)R_DecodeMalloc( sizeof(textureLevel_t) + numPixels );
+	pic->format = GL_RGBA8;
+	pic->width = columns;
+	pic->height = rows;
+	pic->size = numPixels;
+	pic->data = targa_rgba = (byte *)(pic + 1);
+	decode->pic = pic;
+	decode->numLevels = 1;
 
 	if (targa_header.id_length != 0)
 	{
 		if (buf_p + targa_header.id_length > end)
-			ri.Error( ERR_DROP, "LoadTGA: header too short (%s)", name );
+		{
+			R_DecodeError( decode, "LoadTGA: header too short (%s)", name );
+			return;
+		}
 
 		buf_p += targa_header.id_length;  // skip TARGA image comment
 	}
@@ -150,7 +152,8 @@ void R_LoadTGA ( const char *name, int *numTexLevels, textureLevel_t **pic)
 	{ 
 		if(buf_p + columns*rows*targa_header.pixel_size/8 > end)
 		{
-			ri.Error (ERR_DROP, "LoadTGA: file truncated (%s)", name);
+			R_DecodeError( decode, "LoadTGA: file truncated (%s)", name );
+			return;
 		}
 
 		// Uncompressed RGB or gray scale image
@@ -193,7 +196,6 @@ void R_LoadTGA ( const char *name, int *numTexLevels, textureLevel_t **pic)
 					*pixbuf++ = alphabyte;
 					break;
 				default:
-					ri.Error( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
 					break;
 				}
 			}
@@ -206,12 +208,12 @@ void R_LoadTGA ( const char *name, int *numTexLevels, textureLevel_t **pic)
 			pixbuf = targa_rgba + row*columns*4;
 			for(column=0; column<columns; ) {
 				if(buf_p + 1 > end)
-					ri.Error (ERR_DROP, "LoadTGA: file truncated (%s)", name);
+					goto truncated;
 				packetHeader= *buf_p++;
 				packetSize = 1 + (packetHeader & 0x7f);
 				if (packetHeader & 0x80) {        // run-length packet
 					if(buf_p + targa_header.pixel_size/8 > end)
-						ri.Error (ERR_DROP, "LoadTGA: file truncated (%s)", name);
+						goto truncated;
 					switch (targa_header.pixel_size) {
 						case 24:
 								blue = *buf_p++;
@@ -226,8 +228,7 @@ void R_LoadTGA ( const char *name, int *numTexLevels, textureLevel_t **pic)
 								alphabyte = *buf_p++;
 								break;
 						default:
-							ri.Error( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
-							break;
+							goto badpixelsize;
 					}
 	
 					for(j=0;j<packetSize;j++) {
@@ -249,7 +250,7 @@ void R_LoadTGA ( const char *name, int *numTexLevels, textureLevel_t **pic)
 				else {                            // non run-length packet
 
 					if(buf_p + targa_header.pixel_size/8*packetSize > end)
-						ri.Error (ERR_DROP, "LoadTGA: file truncated (%s)", name);
+						goto truncated;
 					for(j=0;j<packetSize;j++) {
 						switch (targa_header.pixel_size) {
 							case 24:
@@ -272,8 +273,7 @@ void R_LoadTGA ( const char *name, int *numTexLevels, textureLevel_t **pic)
 									*pixbuf++ = alphabyte;
 									break;
 							default:
-								ri.Error( ERR_DROP, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
-								break;
+								goto badpixelsize;
 						}
 						column++;
 						if (column==columns) { // pixel packet run spans across rows
@@ -311,10 +311,22 @@ void R_LoadTGA ( const char *name, int *numTexLevels, textureLevel_t **pic)
 #endif
   // instead we just print a warning
   if (targa_header.attributes & 0x20) {
-    ri.Printf( PRINT_WARNING, "WARNING: '%s' TGA file header declares top-down image, ignoring\n", name);
+    R_DecodePrintf( PRINT_WARNING, "WARNING: '%s' TGA file header declares top-down image, ignoring\n", name);
   }
 
-  ri.FS_FreeFile (buffer.v);
+  return;
+
+truncated:
+  R_DecodeError( decode, "LoadTGA: file truncated (%s)", name );
+  return;
+
+badpixelsize:
+  R_DecodeError( decode, "LoadTGA: illegal pixel_size '%d' in file '%s'", targa_header.pixel_size, name );
+}
+
+void R_LoadTGA( const char *name, int *numTexLevels, textureLevel_t **pic )
+{
+	R_LoadImageWithDecoder( name, R_DecodeTGA, numTexLevels, pic );
 }
 
 void RE_SaveTGA(char * filename, int image_width, int image_height, byte *image_buffer, int padding) {
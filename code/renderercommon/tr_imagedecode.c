@@ -0,0 +1,187 @@
+/*
+===========================================================================
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of Spearmint Source Code.
+
+Spearmint Source Code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 3 of the License,
+or (at your option) any later version.
+
+Spearmint Source Code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Spearmint Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, Spearmint Source Code is also subject to certain additional terms.
+You should have received a copy of these additional terms immediately following
+the terms and conditions of the GNU General Public License.  If not, please
+request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional
+terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc.,
+Suite 120, Rockville, Maryland 20850 USA.
+===========================================================================
+*/
+// tr_imagedecode.c -- decoding images on the worker threads
+#include "tr_common.h"
+
+/*
+
+The TGA, JPG and PNG decoders work on files that were already read into
+memory, since the file system isn't thread safe, so a batch of images can be
+decoded on the worker threads with R_DecodeImages. Decoders allocate with
+R_DecodeMalloc, print with R_DecodePrintf and report errors with
+R_DecodeError. The error is raised on the main thread by whoever uses the
+image, the same as if the image had been loaded by itself.
+
+*/
+
+/*
+================
+R_DecodeMalloc
+================
+*/
+void *R_DecodeMalloc( int size ) {
+	void *ptr;
+
+	R_LockWorkers();
+	ptr = ri.Malloc( size );
+	R_UnlockWorkers();
+
+	return ptr;
+}
+
+/*
+================
+R_DecodeFree
+================
+*/
+void R_DecodeFree( void *ptr ) {
+	R_LockWorkers();
+	ri.Free( ptr );
+	R_UnlockWorkers();
+}
+
+/*
+================
+R_DecodePrintf
+================
+*/
+void QDECL R_DecodePrintf( int printLevel, const char *fmt, ... ) {
+	va_list		argptr;
+	char		msg[MAX_STRING_CHARS];
+
+	va_start( argptr, fmt );
+	Q_vsnprintf( msg, sizeof ( msg ), fmt, argptr );
+	va_end( argptr );
+
+	R_LockWorkers();
+	ri.Printf( printLevel, "%s", msg );
+	R_UnlockWorkers();
+}
+
+/*
+================
+R_DecodeError
+
+Keeps the first error, the decoder should free its pic and return
+================
+*/
+void QDECL R_DecodeError( imageDecode_t *decode, const char *fmt, ... ) {
+	va_list		argptr;
+
+	if ( decode->error[0] ) {
+		return;
+	}
+
+	va_start( argptr, fmt );
+	Q_vsnprintf( decode->error, sizeof ( decode->error ), fmt, argptr );
+	va_end( argptr );
+}
+
+/*
+================
+R_DecodeImage
+================
+*/
+static void R_DecodeImage( imageDecode_t *decode ) {
+	decode->numLevels = 0;
+	decode->pic = NULL;
+	decode->error[0] = '\0';
+
+	decode->decoder( decode );
+
+	if ( decode->error[0] && decode->pic ) {
+		R_DecodeFree( decode->pic );
+		decode->pic = NULL;
+		decode->numLevels = 0;
+	}
+}
+
+/*
+================
+R_DecodeImageRange
+================
+*/
+static void R_DecodeImageRange( void *data, int start, int end ) {
+	imageDecode_t	*decodes = data;
+	int				i;
+
+	for ( i = start; i < end; i++ ) {
+		R_DecodeImage( &decodes[i] );
+	}
+}
+
+/*
+================
+R_DecodeImages
+
+Decodes the buffers on the worker threads, errors are left in the decodes
+================
+*/
+void R_DecodeImages( imageDecode_t *decodes, int numDecodes ) {
+	R_ParallelFor( R_DecodeImageRange, decodes, numDecodes, 1 );
+}
+
+/*
+================
+R_LoadImageWithDecoder
+
+Reads and decodes a single image on the calling thread
+================
+*/
+void R_LoadImageWithDecoder( const char *name, imageDecoder_t decoder, int *numLevels, textureLevel_t **pic ) {
+	imageDecode_t	decode;
+	union {
+		byte *b;
+		void *v;
+	} buffer;
+
+	*numLevels = 0;
+	*pic = NULL;
+
+	decode.length = ri.FS_ReadFile( name, &buffer.v );
+	if ( !buffer.b || decode.length < 0 ) {
+		return;
+	}
+
+	decode.name = name;
+	decode.decoder = decoder;
+	decode.buffer = buffer.b;
+
+	R_DecodeImage( &decode );
+
+	ri.FS_FreeFile( buffer.v );
+
+	if ( decode.error[0] ) {
+		ri.Error( ERR_DROP, "%s", decode.error );
+	}
+
+	*numLevels = decode.numLevels;
+	*pic = decode.pic;
+}
@@ -39,7 +39,7 @@ Suite 120, Rockville, Maryland 20850 USA.
   #include <zlib.h>
 #endif
 
-#define	REF_API_VERSION		9
+#define	REF_API_VERSION		12
 
 //
 // these are the functions exported by the refresh module
@@ -117,6 +117,9 @@ typedef struct {
 	int		(*LerpTag)( orientation_t *tag,  qhandle_t model, qhandle_t frameModel, int startFrame, qhandle_t endFrameModel, int endFrame,
 					 float frac, const char *tagName, int *tagIndex, const vec3_t *torsoAxis, qhandle_t torsoFrameModel, int torsoFrame,
 					 qhandle_t oldTorsoFrameModel, int oldTorsoFrame, float torsoFrac );
+	int		(*LerpTags)( orientation_t *tags, int maxTags, qhandle_t model, qhandle_t frameModel, int startFrame, qhandle_t endFrameModel, int endFrame,
+					 float frac, const vec3_t *torsoAxis, qhandle_t torsoFrameModel, int torsoFrame,
+					 qhandle_t oldTorsoFrameModel, int oldTorsoFrame, float torsoFrac );
 	int		(*ModelBounds)( qhandle_t model, vec3_t mins, vec3_t maxs, int startFrame, int endFrame, float frac );
 
 #ifdef __USEA3D
@@ -127,7 +130,12 @@ typedef struct {
 	qboolean (*GetEntityToken)( char *buffer, int size );
 	qboolean (*inPVS)( const vec3_t p1, const vec3_t p2 );
 
-	void (*TakeVideoFrame)( int h, int w, byte* captureBuffer, byte *encodeBuffer, qboolean motionJpeg );
+	// video frames are read back asynchronously and handed to
+	// CL_BeginAVIVideoFrame/CL_EndAVIVideoFrame a few frames later
+	void (*TakeVideoFrame)( int width, int height );
+	// hands over video frames that are still being read back
+	void (*FinishVideoFrames)( void );
+	size_t (*SaveJPGToBuffer)( byte *buffer, size_t bufSize, int quality, int width, int height, byte *imageBuffer, int padding );
 
 	void (*GetGlobalFog)( fogType_t *type, vec3_t color, float *depthForOpaque, float *density, float *farClip );
 	void (*GetViewFog)( const vec3_t origin, fogType_t *type, vec3_t color, float *depthForOpaque, float *density, float *farClip, qboolean inwater );
@@ -206,13 +214,16 @@ typedef struct {
 	void	(*FS_FreeFileList)( char **filelist );
 	void	(*FS_WriteFile)( const char *qpath, const void *buffer, int size );
 	qboolean (*FS_FileExists)( const char *file );
+	qboolean (*FS_FilePakChecksum)( const char *file, int *checksum );
 
 	// cinematic stuff
 	void	(*CIN_UploadCinematic)(int handle);
 	int		(*CIN_PlayCinematic)( const char *arg0, int xpos, int ypos, int width, int height, int bits);
 	e_status (*CIN_RunCinematic) (int handle);
 
-	void	(*CL_WriteAVIVideoFrame)( const byte *buffer, int size );
+	// returns a buffer for a bottom-up, unpadded RGB video frame or NULL if it isn't wanted
+	byte	*(*CL_BeginAVIVideoFrame)( int width, int height );
+	void	(*CL_EndAVIVideoFrame)( void );
 	int		(*CL_MaxSplitView)( void );
 
 	// input event handling
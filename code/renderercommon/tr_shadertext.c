@@ -0,0 +1,655 @@
+/*
+===========================================================================
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of Spearmint Source Code.
+
+Spearmint Source Code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 3 of the License,
+or (at your option) any later version.
+
+Spearmint Source Code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Spearmint Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, Spearmint Source Code is also subject to certain additional terms.
+You should have received a copy of these additional terms immediately following
+the terms and conditions of the GNU General Public License.  If not, please
+request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional
+terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc.,
+Suite 120, Rockville, Maryland 20850 USA.
+===========================================================================
+*/
+// tr_shadertext.c -- combined shader file text and the shader name index
+#include "tr_common.h"
+
+/*
+
+All shader files are combined into a single block of text, with a hash
+table pointing at the start of each shader in it. The files are read on the
+main thread since the file system isn't thread safe, then the worker threads
+check each file for missing braces, compress it and look up the shader names.
+
+With r_shaderCache enabled the combined text and the index are written to
+shadercache/ in the homepath. The cache key covers the names of the files
+and the checksums of the pk3s they are read from, or the contents of files
+outside of pk3s. When nothing changed the next renderer start (vid_restart,
+next session) uses the cached text and index without reading any shader
+files from pk3s or parsing anything.
+
+*/
+
+#define SHADERCACHE_IDENT	(('C'<<24)+('D'<<16)+('H'<<8)+'S')
+#define SHADERCACHE_VERSION	1
+
+typedef struct {
+	int			ident;
+	int			version;
+	int			key;
+	int			textLength;			// not including the trailing 0
+	int			numShaders;
+} shaderCacheHeader_t;
+
+typedef struct {
+	int			offset;				// shader name in the text
+	int			hash;
+} shaderTextEntry_t;
+
+typedef enum {
+	SHADERFILE_OK,
+	SHADERFILE_NO_OPENING_BRACE,
+	SHADERFILE_NO_CLOSING_BRACE
+} shaderFileError_t;
+
+typedef struct {
+	char		*buffer;			// compressed in place
+	int			length;
+	int			numShaders;
+	shaderTextEntry_t	*entries;	// offsets are relative to buffer
+
+	// why the file is ignored
+	shaderFileError_t	error;
+	char		shaderName[MAX_QPATH];
+	int			shaderLine;
+	char		foundToken[MAX_QPATH];
+	int			foundLine;
+} shaderTextFile_t;
+
+typedef struct {
+	shaderTextFile_t	*files;
+	shaderTextHashFunc_t	hashFunc;
+	int			hashSize;
+} shaderTextJob_t;
+
+/*
+================
+R_ShaderCacheHash
+================
+*/
+static unsigned R_ShaderCacheHash( unsigned hash, const void *data, int length ) {
+	const byte *p = data;
+	int i;
+
+	// FNV-1a
+	for ( i = 0; i < length; i++ ) {
+		hash = ( hash ^ p[i] ) * 16777619;
+	}
+
+	return hash;
+}
+
+/*
+================
+R_ShaderTextToken
+
+Same as COM_ParseExt( data_p, qtrue ) but can be used from the worker
+threads, lines is the line count so far and tokenLine is set to the line
+the token starts on
+================
+*/
+static char *R_ShaderTextToken( char **data_p, char *token, int *lines, int *tokenLine ) {
+	char	*data;
+	int		c, len;
+
+	data = *data_p;
+	len = 0;
+	token[0] = 0;
+
+	if ( !data ) {
+		return token;
+	}
+
+	while ( 1 ) {
+		// skip whitespace
+		while ( ( c = *data ) <= ' ' ) {
+			if ( !c ) {
+				*data_p = NULL;
+				return token;
+			}
+			if ( c == '\n' ) {
+				( *lines )++;
+			}
+			data++;
+		}
+
+		// skip double slash comments
+		if ( c == '/' && data[1] == '/' ) {
+			data += 2;
+			while ( *data && *data != '\n' ) {
+				data++;
+			}
+		}
+		// skip /* */ comments
+		else if ( c == '/' && data[1] == '*' ) {
+			data += 2;
+			while ( *data && ( *data != '*' || data[1] != '/' ) ) {
+				if ( *data == '\n' ) {
+					( *lines )++;
+				}
+				data++;
+			}
+			if ( *data ) {
+				data += 2;
+			}
+		} else {
+			break;
+		}
+	}
+
+	*tokenLine = *lines;
+
+	// handle quoted strings
+	if ( c == '\"' ) {
+		data++;
+		while ( 1 ) {
+			c = *data++;
+			if ( c == '\"' || !c ) {
+				token[len] = 0;
+				*data_p = data;
+				return token;
+			}
+			if ( c == '\n' ) {
+				( *lines )++;
+			}
+			if ( len < MAX_TOKEN_CHARS - 1 ) {
+				token[len] = c;
+				len++;
+			}
+		}
+	}
+
+	// parse a regular word
+	do {
+		if ( len < MAX_TOKEN_CHARS - 1 ) {
+			token[len] = c;
+			len++;
+		}
+		data++;
+		c = *data;
+	} while ( c > 32 );
+
+	token[len] = 0;
+	*data_p = data;
+	return token;
+}
+
+/*
+================
+R_SkipShaderTextBraces
+
+Same as SkipBracedSection but can be used from the worker threads
+================
+*/
+static qboolean R_SkipShaderTextBraces( char **data_p, int depth, int *lines ) {
+	char	token[MAX_TOKEN_CHARS];
+	int		tokenLine;
+
+	do {
+		R_ShaderTextToken( data_p, token, lines, &tokenLine );
+		if ( token[1] == 0 ) {
+			if ( token[0] == '{' ) {
+				depth++;
+			} else if ( token[0] == '}' ) {
+				depth--;
+			}
+		}
+	} while ( depth && *data_p );
+
+	return ( depth == 0 );
+}
+
+/*
+================
+R_CheckShaderTextFiles
+
+Does a simple check on the shader structure in each file to make sure one bad
+shader file cannot mess up all other shaders, then compresses the valid files
+================
+*/
+static void R_CheckShaderTextFiles( void *data, int start, int end ) {
+	shaderTextJob_t		*job = data;
+	shaderTextFile_t	*file;
+	char	token[MAX_TOKEN_CHARS];
+	char	*p;
+	int		i, lines, tokenLine;
+
+	for ( i = start; i < end; i++ ) {
+		file = &job->files[i];
+		file->error = SHADERFILE_OK;
+
+		p = file->buffer;
+		lines = 1;
+
+		while ( 1 ) {
+			R_ShaderTextToken( &p, token, &lines, &tokenLine );
+			if ( !token[0] ) {
+				break;
+			}
+
+			Q_strncpyz( file->shaderName, token, sizeof ( file->shaderName ) );
+			file->shaderLine = tokenLine;
+
+			R_ShaderTextToken( &p, token, &lines, &tokenLine );
+			if ( token[0] != '{' || token[1] != '\0' ) {
+				file->error = SHADERFILE_NO_OPENING_BRACE;
+				Q_strncpyz( file->foundToken, token, sizeof ( file->foundToken ) );
+				file->foundLine = tokenLine;
+				break;
+			}
+
+			if ( !R_SkipShaderTextBraces( &p, 1, &lines ) ) {
+				file->error = SHADERFILE_NO_CLOSING_BRACE;
+				break;
+			}
+		}
+
+		if ( file->error != SHADERFILE_OK ) {
+			continue;
+		}
+
+		file->length = COM_Compress( file->buffer );
+	}
+}
+
+/*
+================
+R_IndexShaderTextFiles
+
+Counts the shaders in each valid file, or stores their offsets and hashes if
+the entries are allocated
+================
+*/
+static void R_IndexShaderTextFiles( void *data, int start, int end ) {
+	shaderTextJob_t		*job = data;
+	shaderTextFile_t	*file;
+	char	token[MAX_TOKEN_CHARS];
+	char	*p, *oldp;
+	int		i, lines, tokenLine;
+
+	for ( i = start; i < end; i++ ) {
+		file = &job->files[i];
+
+		if ( file->error != SHADERFILE_OK ) {
+			continue;
+		}
+
+		file->numShaders = 0;
+		p = file->buffer;
+		lines = 1;
+
+		// look for shader names
+		while ( 1 ) {
+			oldp = p;
+			R_ShaderTextToken( &p, token, &lines, &tokenLine );
+			if ( !token[0] ) {
+				break;
+			}
+
+			if ( file->entries ) {
+				file->entries[file->numShaders].offset = oldp - file->buffer;
+				file->entries[file->numShaders].hash = job->hashFunc( token, job->hashSize );
+			}
+			file->numShaders++;
+
+			R_SkipShaderTextBraces( &p, 0, &lines );
+		}
+	}
+}
+
+/*
+================
+R_BuildShaderTextHashTable
+
+Entries must be in the order they are in the text, so the first shader in
+the text is found first
+================
+*/
+static void R_BuildShaderTextHashTable( char *text, const shaderTextEntry_t *entries, int numShaders, char ***hashTable, int hashSize ) {
+	int		*sizes;
+	char	**hashMem;
+	int		i;
+
+	sizes = ri.Hunk_AllocateTempMemory( hashSize * sizeof ( *sizes ) );
+	Com_Memset( sizes, 0, hashSize * sizeof ( *sizes ) );
+
+	for ( i = 0; i < numShaders; i++ ) {
+		sizes[entries[i].hash]++;
+	}
+
+	// each list is NULL terminated
+	hashMem = ri.Hunk_Alloc( ( numShaders + hashSize ) * sizeof ( char * ), h_low );
+
+	for ( i = 0; i < hashSize; i++ ) {
+		hashTable[i] = hashMem;
+		hashMem += sizes[i] + 1;
+	}
+
+	Com_Memset( sizes, 0, hashSize * sizeof ( *sizes ) );
+
+	for ( i = 0; i < numShaders; i++ ) {
+		hashTable[entries[i].hash][sizes[entries[i].hash]++] = text + entries[i].offset;
+	}
+
+	ri.Hunk_FreeTempMemory( sizes );
+}
+
+/*
+================
+R_LoadShaderTextCache
+
+Returns the combined text or NULL if the cache doesn't match
+================
+*/
+static char *R_LoadShaderTextCache( const char *path, int key, char ***hashTable, int hashSize, qboolean *writable ) {
+	union {
+		byte *b;
+		void *v;
+	} buffer;
+	shaderCacheHeader_t	header;
+	shaderTextEntry_t	*entries;
+	char	*text;
+	int		length, i;
+
+	*writable = qtrue;
+
+	length = ri.FS_ReadFile( path, &buffer.v );
+	if ( !buffer.b ) {
+		// files outside of pk3s can't be read on pure servers, don't keep rewriting it
+		if ( ri.FS_FileExists( path ) ) {
+			*writable = qfalse;
+		}
+		return NULL;
+	}
+
+	if ( length < sizeof ( header ) ) {
+		ri.FS_FreeFile( buffer.v );
+		return NULL;
+	}
+
+	Com_Memcpy( &header, buffer.b, sizeof ( header ) );
+	header.ident = LittleLong( header.ident );
+	header.version = LittleLong( header.version );
+	header.key = LittleLong( header.key );
+	header.textLength = LittleLong( header.textLength );
+	header.numShaders = LittleLong( header.numShaders );
+
+	if ( header.ident != SHADERCACHE_IDENT || header.version != SHADERCACHE_VERSION || header.key != key
+		|| header.textLength < 0 || header.numShaders < 0
+		|| length != sizeof ( header ) + header.textLength + 1 + header.numShaders * sizeof ( shaderTextEntry_t ) ) {
+		ri.FS_FreeFile( buffer.v );
+		return NULL;
+	}
+
+	entries = (shaderTextEntry_t *)( buffer.b + sizeof ( header ) + header.textLength + 1 );
+	for ( i = 0; i < header.numShaders; i++ ) {
+		entries[i].offset = LittleLong( entries[i].offset );
+		entries[i].hash = LittleLong( entries[i].hash );
+
+		if ( entries[i].offset < 0 || entries[i].offset >= header.textLength
+			|| entries[i].hash < 0 || entries[i].hash >= hashSize ) {
+			ri.FS_FreeFile( buffer.v );
+			return NULL;
+		}
+	}
+
+	text = ri.Hunk_Alloc( header.textLength + 1, h_low );
+	Com_Memcpy( text, buffer.b + sizeof ( header ), header.textLength );
+	text[header.textLength] = '\0';
+
+	// the entries are in the read buffer so it has to be freed afterward
+	R_BuildShaderTextHashTable( text, entries, header.numShaders, hashTable, hashSize );
+
+	ri.FS_FreeFile( buffer.v );
+
+	return text;
+}
+
+/*
+================
+R_SaveShaderTextCache
+================
+*/
+static void R_SaveShaderTextCache( const char *path, int key, const char *text, int textLength, const shaderTextEntry_t *entries, int numShaders ) {
+	shaderCacheHeader_t	*header;
+	shaderTextEntry_t	*out;
+	int		size, i;
+
+	size = sizeof ( *header ) + textLength + 1 + numShaders * sizeof ( *entries );
+
+	header = ri.Hunk_AllocateTempMemory( size );
+	header->ident = LittleLong( SHADERCACHE_IDENT );
+	header->version = LittleLong( SHADERCACHE_VERSION );
+	header->key = LittleLong( key );
+	header->textLength = LittleLong( textLength );
+	header->numShaders = LittleLong( numShaders );
+	Com_Memcpy( header + 1, text, textLength + 1 );
+
+	out = (shaderTextEntry_t *)( (byte *)( header + 1 ) + textLength + 1 );
+	for ( i = 0; i < numShaders; i++ ) {
+		out[i].offset = LittleLong( entries[i].offset );
+		out[i].hash = LittleLong( entries[i].hash );
+	}
+
+	ri.FS_WriteFile( path, header, size );
+
+	ri.Hunk_FreeTempMemory( header );
+}
+
+/*
+================
+R_ReadShaderTextFiles
+================
+*/
+static void R_ReadShaderTextFiles( char **filenames, shaderTextFile_t *files, int numFiles ) {
+	int i;
+
+	for ( i = 0; i < numFiles; i++ ) {
+		ri.Printf( PRINT_DEVELOPER, "...loading '%s'\n", filenames[i] );
+		ri.FS_ReadFile( filenames[i], (void **)&files[i].buffer );
+
+		if ( !files[i].buffer ) {
+			ri.Error( ERR_DROP, "Couldn't load %s", filenames[i] );
+		}
+	}
+}
+
+/*
+================
+R_LoadShaderText
+
+Loads all the shader files from directory and combines them into a single large block of
+text, later files come first in the text so that they override shaders in
+earlier files. hashTable is filled with NULL terminated lists of pointers to
+the shaders in the text. Returns the text.
+================
+*/
+char *R_LoadShaderText( const char *directory, char **filenames, int numFiles, shaderTextHashFunc_t hashFunc, char ***hashTable, int hashSize ) {
+	shaderTextFile_t	*files;
+	shaderTextEntry_t	*entries;
+	shaderTextJob_t		job;
+	char		cachePath[MAX_QPATH];
+	char		*text, *textEnd;
+	unsigned	key;
+	int			checksum;
+	int			textLength, numShaders;
+	int			i, startTime;
+	qboolean	filesRead, writable;
+
+	startTime = ri.Milliseconds();
+
+	files = ri.Hunk_AllocateTempMemory( numFiles * sizeof ( *files ) );
+	Com_Memset( files, 0, numFiles * sizeof ( *files ) );
+
+	key = 0;
+	filesRead = qfalse;
+	writable = qfalse;
+	text = NULL;
+
+	if ( r_shaderCache->integer ) {
+		key = 2166136261u;
+		key = R_ShaderCacheHash( key, &hashSize, sizeof ( hashSize ) );
+		key = R_ShaderCacheHash( key, &numFiles, sizeof ( numFiles ) );
+
+		for ( i = 0; i < numFiles; i++ ) {
+			if ( !ri.FS_FilePakChecksum( filenames[i], &checksum ) ) {
+				checksum = -1;
+			}
+
+			// loose files may change at any time, the contents are hashed below
+			if ( !checksum ) {
+				filesRead = qtrue;
+			}
+
+			key = R_ShaderCacheHash( key, filenames[i], strlen( filenames[i] ) + 1 );
+			key = R_ShaderCacheHash( key, &checksum, sizeof ( checksum ) );
+		}
+
+		if ( filesRead ) {
+			R_ReadShaderTextFiles( filenames, files, numFiles );
+
+			for ( i = 0; i < numFiles; i++ ) {
+				key = R_ShaderCacheHash( key, files[i].buffer, strlen( files[i].buffer ) );
+			}
+		}
+
+		Com_sprintf( cachePath, sizeof ( cachePath ), "shadercache/%s.idx", directory );
+
+		text = R_LoadShaderTextCache( cachePath, key, hashTable, hashSize, &writable );
+	}
+
+	if ( text ) {
+		ri.Printf( PRINT_DEVELOPER, "...loaded shader index from %s\n", cachePath );
+	} else {
+		if ( !filesRead ) {
+			R_ReadShaderTextFiles( filenames, files, numFiles );
+		}
+
+		job.files = files;
+		job.hashFunc = hashFunc;
+		job.hashSize = hashSize;
+
+		R_ParallelFor( R_CheckShaderTextFiles, &job, numFiles, 1 );
+
+		for ( i = 0; i < numFiles; i++ ) {
+			switch ( files[i].error ) {
+				case SHADERFILE_NO_OPENING_BRACE:
+					ri.Printf( PRINT_WARNING, "WARNING: Ignoring shader file %s. Shader \"%s\" on line %d missing opening brace",
+								filenames[i], files[i].shaderName, files[i].shaderLine );
+					if ( files[i].foundToken[0] ) {
+						ri.Printf( PRINT_WARNING, " (found \"%s\" on line %d)", files[i].foundToken, files[i].foundLine );
+					}
+					ri.Printf( PRINT_WARNING, ".\n" );
+					break;
+				case SHADERFILE_NO_CLOSING_BRACE:
+					ri.Printf( PRINT_WARNING, "WARNING: Ignoring shader file %s. Shader \"%s\" on line %d missing closing brace.\n",
+								filenames[i], files[i].shaderName, files[i].shaderLine );
+					break;
+				default:
+					break;
+			}
+		}
+
+		// count shaders, then store them
+		R_ParallelFor( R_IndexShaderTextFiles, &job, numFiles, 1 );
+
+		textLength = 0;
+		numShaders = 0;
+		for ( i = 0; i < numFiles; i++ ) {
+			if ( files[i].error != SHADERFILE_OK ) {
+				continue;
+			}
+			textLength += files[i].length + 1;
+			numShaders += files[i].numShaders;
+		}
+
+		entries = ri.Hunk_AllocateTempMemory( MAX( numShaders, 1 ) * sizeof ( *entries ) );
+
+		numShaders = 0;
+		for ( i = numFiles - 1; i >= 0; i-- ) {
+			if ( files[i].error != SHADERFILE_OK ) {
+				continue;
+			}
+			files[i].entries = entries + numShaders;
+			numShaders += files[i].numShaders;
+		}
+
+		R_ParallelFor( R_IndexShaderTextFiles, &job, numFiles, 1 );
+
+		// build single large buffer, each file followed by a newline
+		text = ri.Hunk_Alloc( textLength + 1, h_low );
+		textEnd = text;
+
+		for ( i = numFiles - 1; i >= 0; i-- ) {
+			int j, skip;
+
+			if ( files[i].error != SHADERFILE_OK ) {
+				continue;
+			}
+
+			// the newline after the previous file replaces leading whitespace
+			if ( textEnd != text && ( files[i].buffer[0] == '\n' || files[i].buffer[0] == ' ' ) ) {
+				skip = 1;
+			} else {
+				skip = 0;
+			}
+
+			for ( j = 0; j < files[i].numShaders; j++ ) {
+				files[i].entries[j].offset += textEnd - text - skip;
+			}
+
+			Com_Memcpy( textEnd, files[i].buffer + skip, files[i].length - skip );
+			textEnd += files[i].length - skip;
+			*textEnd++ = '\n';
+		}
+		*textEnd = '\0';
+		textLength = textEnd - text;
+
+		R_BuildShaderTextHashTable( text, entries, numShaders, hashTable, hashSize );
+
+		if ( writable ) {
+			R_SaveShaderTextCache( cachePath, key, text, textLength, entries, numShaders );
+		}
+
+		ri.Hunk_FreeTempMemory( entries );
+	}
+
+	// free in reverse order, so the temp files are all dumped
+	for ( i = numFiles - 1; i >= 0; i-- ) {
+		if ( files[i].buffer ) {
+			ri.FS_FreeFile( files[i].buffer );
+		}
+	}
+
+	ri.Hunk_FreeTempMemory( files );
+
+	ri.Printf( PRINT_DEVELOPER, "Loaded %d shader files in %d msec\n", numFiles, ri.Milliseconds() - startTime );
+
+	return text;
+}
@@ -83,6 +83,24 @@ static refEntity_t lastBoneEntity;
 
 static int totalrv, totalrt, totalv, totalt;    //----(SA)
 
+//-----------------------------------------------------------------------------
+// Pose cache, fully calculated skeletons for recently used model/frame/torso
+// combinations. Game code tends to request several tags on the same pose (such
+// as hit detection for multiple traces against a player) so keep them around
+// instead of recalculating the bones for each request.
+
+#define MDS_POSE_CACHE_SIZE 64
+
+typedef struct {
+	refEntity_t		refent;		// only fields checked by R_BonePosesMatch are set
+	int				numBones;	// 0 if unused
+	int				lastUsed;
+	mdsBoneFrame_t	bones[MDS_MAX_BONES];
+} mdsPose_t;
+
+static mdsPose_t poseCache[MDS_POSE_CACHE_SIZE];
+static int poseSequence;
+
 //-----------------------------------------------------------------------------
 
 #define MDS_FRAME( _header, _frame ) \
@@ -1214,7 +1232,7 @@ static void R_CalcBoneLerp( mdsFrame_t *frame, mdsFrame_t *oldFrame, int torsoPa
 
 /*
 ==============
-R_BonesStillValid
+R_BonePosesMatch
 
 	FIXME: optimization opportunity here, profile which values change most often and check for those first to get early outs
 
@@ -1223,42 +1241,51 @@ R_BonesStillValid
 	Another solution: bones cache on an entity basis?
 ==============
 */
-static qboolean R_BonesStillValid( const refEntity_t *refent ) {
-	if ( lastBoneEntity.hModel != refent->hModel ) {
+static qboolean R_BonePosesMatch( const refEntity_t *a, const refEntity_t *b ) {
+	if ( a->hModel != b->hModel ) {
 		return qfalse;
-	} else if ( lastBoneEntity.frame != refent->frame ) {
+	} else if ( a->frame != b->frame ) {
 		return qfalse;
-	} else if ( lastBoneEntity.oldframe != refent->oldframe ) {
+	} else if ( a->oldframe != b->oldframe ) {
 		return qfalse;
-	} else if ( lastBoneEntity.frameModel != refent->frameModel ) {
+	} else if ( a->frameModel != b->frameModel ) {
 		return qfalse;
-	} else if ( lastBoneEntity.oldframeModel != refent->oldframeModel ) {
+	} else if ( a->oldframeModel != b->oldframeModel ) {
 		return qfalse;
-	} else if ( lastBoneEntity.backlerp != refent->backlerp ) {
+	} else if ( a->backlerp != b->backlerp ) {
 		return qfalse;
-	} else if ( lastBoneEntity.torsoFrame != refent->torsoFrame ) {
+	} else if ( a->torsoFrame != b->torsoFrame ) {
 		return qfalse;
-	} else if ( lastBoneEntity.oldTorsoFrame != refent->oldTorsoFrame ) {
+	} else if ( a->oldTorsoFrame != b->oldTorsoFrame ) {
 		return qfalse;
-	} else if ( lastBoneEntity.torsoFrameModel != refent->torsoFrameModel ) {
+	} else if ( a->torsoFrameModel != b->torsoFrameModel ) {
 		return qfalse;
-	} else if ( lastBoneEntity.oldTorsoFrameModel != refent->oldTorsoFrameModel ) {
+	} else if ( a->oldTorsoFrameModel != b->oldTorsoFrameModel ) {
 		return qfalse;
-	} else if ( lastBoneEntity.torsoBacklerp != refent->torsoBacklerp ) {
+	} else if ( a->torsoBacklerp != b->torsoBacklerp ) {
 		return qfalse;
 /*
-	} else if ( lastBoneEntity.reFlags != refent->reFlags ) {
+	} else if ( a->reFlags != b->reFlags ) {
 		return qfalse;
 */
-	} else if ( !VectorCompare( lastBoneEntity.torsoAxis[0], refent->torsoAxis[0] ) ||
-				!VectorCompare( lastBoneEntity.torsoAxis[1], refent->torsoAxis[1] ) ||
-				!VectorCompare( lastBoneEntity.torsoAxis[2], refent->torsoAxis[2] ) ) {
+	} else if ( !VectorCompare( a->torsoAxis[0], b->torsoAxis[0] ) ||
+				!VectorCompare( a->torsoAxis[1], b->torsoAxis[1] ) ||
+				!VectorCompare( a->torsoAxis[2], b->torsoAxis[2] ) ) {
 		return qfalse;
 	}
 
 	return qtrue;
 }
 
+/*
+==============
+R_BonesStillValid
+==============
+*/
+static qboolean R_BonesStillValid( const refEntity_t *refent ) {
+	return R_BonePosesMatch( &lastBoneEntity, refent );
+}
+
 
 /*
 ==============
@@ -1837,19 +1864,116 @@ void RB_MDSSurfaceAnim( mdsSurface_t *surface ) {
 
 /*
 ===============
-R_RecursiveBoneListAdd
+R_ClearMDSPoseCache
+
+Must be called when model handles are reset
+===============
+*/
+void R_ClearMDSPoseCache( void ) {
+	Com_Memset( poseCache, 0, sizeof ( poseCache ) );
+	poseSequence = 0;
+
+	// R_CalcBones keeps the last entity's bones too
+	Com_Memset( &lastBoneEntity, 0, sizeof ( lastBoneEntity ) );
+}
+
+/*
+===============
+R_GetMDSPose
+
+Returns all bones for the pose described by refent, from the pose cache if
+possible. Returns NULL if the frame models are invalid.
 ===============
 */
-static void R_RecursiveBoneListAdd( int bi, int *boneList, int *numBones, mdsBoneInfo_t *boneInfoList ) {
+static const mdsPose_t *R_GetMDSPose( const refEntity_t *refent, const mdsHeader_t *header ) {
+	int			i;
+	int			boneList[ MDS_MAX_BONES ];
+	mdsPose_t	*pose, *oldest;
 
-	if ( boneInfoList[ bi ].parent >= 0 ) {
+	oldest = &poseCache[0];
 
-		R_RecursiveBoneListAdd( boneInfoList[ bi ].parent, boneList, numBones, boneInfoList );
+	for ( i = 0, pose = poseCache; i < MDS_POSE_CACHE_SIZE; i++, pose++ ) {
+		if ( !pose->numBones ) {
+			oldest = pose;
+			continue;
+		}
 
+		if ( R_BonePosesMatch( &pose->refent, refent ) ) {
+			pose->lastUsed = ++poseSequence;
+			return pose;
+		}
+
+		if ( oldest->numBones && pose->lastUsed < oldest->lastUsed ) {
+			oldest = pose;
+		}
+	}
+
+	if ( !R_GetFrameModelDataByHandle( refent, refent->frameModel )
+		|| !R_GetFrameModelDataByHandle( refent, refent->oldframeModel )
+		|| !R_GetFrameModelDataByHandle( refent, refent->torsoFrameModel )
+		|| !R_GetFrameModelDataByHandle( refent, refent->oldTorsoFrameModel ) ) {
+		return NULL;
 	}
 
-	boneList[ ( *numBones )++ ] = bi;
+	// calc all the bones so any tag can be read from the pose
+	for ( i = 0; i < header->numBones; i++ ) {
+		boneList[i] = i;
+	}
+
+	R_CalcBones( refent, boneList, header->numBones );
+
+	pose = oldest;
+	pose->refent = *refent;
+	pose->numBones = header->numBones;
+	pose->lastUsed = ++poseSequence;
+	Com_Memcpy( pose->bones, bones, sizeof ( bones[0] ) * header->numBones );
+
+	return pose;
+}
+
+/*
+===============
+R_SetupMDSTagEntity
+
+Set up a fake refent for getting tags
+===============
+*/
+static void R_SetupMDSTagEntity( refEntity_t *refent, const model_t *mod,
+					 qhandle_t frameModel, int startFrame,
+					 qhandle_t endFrameModel, int endFrame,
+					 float frac, const vec3_t *torsoAxis,
+					 qhandle_t torsoFrameModel, int torsoStartFrame,
+					 qhandle_t torsoEndFrameModel, int torsoEndFrame,
+					 float torsoFrac )
+{
+	Com_Memset( refent, 0, sizeof ( *refent ) );
+	refent->hModel = mod->index;
+	refent->frameModel = endFrameModel;
+	refent->oldframeModel = frameModel;
+	refent->frame = endFrame;
+	refent->oldframe = startFrame;
+	refent->backlerp = 1.0f - frac;
+
+	// use torso information if present
+	// ZTM: FIXME: casted away const to silence warning
+	if ( torsoAxis != NULL && !AxisEmpty( (vec3_t *)torsoAxis ) ) {
+		AxisCopy( (vec3_t *)torsoAxis, refent->torsoAxis );
+
+		refent->torsoFrameModel = torsoEndFrameModel;
+		refent->oldTorsoFrameModel = torsoFrameModel;
+		refent->torsoFrame = torsoEndFrame;
+		refent->oldTorsoFrame = torsoStartFrame;
+		refent->torsoBacklerp = 1.0f - torsoFrac;
+	} else {
+		// setup identify matrix
+		AxisCopy( axisDefault, refent->torsoAxis );
 
+		refent->torsoFrameModel = refent->frameModel;
+		refent->oldTorsoFrameModel = refent->oldframeModel;
+		refent->torsoFrame = refent->frame;
+		refent->oldTorsoFrame = refent->oldframe;
+		refent->torsoBacklerp = refent->backlerp;
+	}
 }
 
 /*
@@ -1869,9 +1993,7 @@ int R_GetMDSBoneTag( orientation_t *outTag, const model_t *mod,
 	int i;
 	mdsHeader_t *header;
 	mdsTag_t    *pTag;
-	mdsBoneInfo_t *boneInfoList;
-	int boneList[ MDS_MAX_BONES ];
-	int numBones;
+	const mdsPose_t *pose;
 	refEntity_t refent;
 
 	header = (mdsHeader_t *)mod->modelData;
@@ -1900,53 +2022,76 @@ int R_GetMDSBoneTag( orientation_t *outTag, const model_t *mod,
 		return i;
 	}
 
-	// now set up fake refent
+	R_SetupMDSTagEntity( &refent, mod, frameModel, startFrame, endFrameModel, endFrame, frac,
+			torsoAxis, torsoFrameModel, torsoStartFrame, torsoEndFrameModel, torsoEndFrame, torsoFrac );
 
-	Com_Memset( &refent, 0, sizeof ( refent ) );
-	refent.hModel = mod->index;
-	refent.frameModel = endFrameModel;
-	refent.oldframeModel = frameModel;
-	refent.frame = endFrame;
-	refent.oldframe = startFrame;
-	refent.backlerp = 1.0f - frac;
+	// calc the bones
 
-	// use torso information if present
-	// ZTM: FIXME: casted away const to silence warning
-	if ( torsoAxis != NULL && !AxisEmpty( (vec3_t *)torsoAxis ) ) {
-		AxisCopy( (vec3_t *)torsoAxis, refent.torsoAxis );
+	pose = R_GetMDSPose( &refent, header );
 
-		refent.torsoFrameModel = torsoEndFrameModel;
-		refent.oldTorsoFrameModel = torsoFrameModel;
-		refent.torsoFrame = torsoEndFrame;
-		refent.oldTorsoFrame = torsoStartFrame;
-		refent.torsoBacklerp = 1.0f - torsoFrac;
-	} else {
-		// setup identify matrix
-		AxisCopy( axisDefault, refent.torsoAxis );
-
-		refent.torsoFrameModel = refent.frameModel;
-		refent.oldTorsoFrameModel = refent.oldframeModel;
-		refent.torsoFrame = refent.frame;
-		refent.oldTorsoFrame = refent.oldframe;
-		refent.torsoBacklerp = refent.backlerp;
+	if ( !pose ) {
+		AxisClear( outTag->axis );
+		VectorClear( outTag->origin );
+		return i;
 	}
 
-	// now build the list of bones we need to calc to get this tag's bone information
+	// now extract the orientation for the bone that represents our tag
 
-	boneInfoList = ( mdsBoneInfo_t * )( (byte *)header + header->ofsBones );
-	numBones = 0;
+	memcpy( outTag->axis, pose->bones[ pTag->boneIndex ].matrix, sizeof( outTag->axis ) );
+	VectorCopy( pose->bones[ pTag->boneIndex ].translation, outTag->origin );
 
-	R_RecursiveBoneListAdd( pTag->boneIndex, boneList, &numBones, boneInfoList );
+	return i;
+}
 
-	// calc the bones
+/*
+===============
+R_GetMDSBoneTags
 
-	R_CalcBones( &refent, boneList, numBones );
+Get all tags for a pose, tags[ i ] is set to the tag with tag index i.
+Returns the number of tags set.
+===============
+*/
+int R_GetMDSBoneTags( orientation_t *outTags, int maxTags, const model_t *mod,
+					 qhandle_t frameModel, int startFrame,
+					 qhandle_t endFrameModel, int endFrame,
+					 float frac, const vec3_t *torsoAxis,
+					 qhandle_t torsoFrameModel, int torsoStartFrame,
+					 qhandle_t torsoEndFrameModel, int torsoEndFrame,
+					 float torsoFrac )
+{
+	int i;
+	int numTags;
+	mdsHeader_t *header;
+	mdsTag_t    *pTag;
+	const mdsPose_t *pose;
+	refEntity_t refent;
 
-	// now extract the orientation for the bone that represents our tag
+	header = (mdsHeader_t *)mod->modelData;
 
-	memcpy( outTag->axis, bones[ pTag->boneIndex ].matrix, sizeof( outTag->axis ) );
-	VectorCopy( bones[ pTag->boneIndex ].translation, outTag->origin );
+	numTags = MIN( header->numTags, maxTags );
 
-	return i;
+	if ( numTags <= 0 ) {
+		return 0;
+	}
+
+	R_SetupMDSTagEntity( &refent, mod, frameModel, startFrame, endFrameModel, endFrame, frac,
+			torsoAxis, torsoFrameModel, torsoStartFrame, torsoEndFrameModel, torsoEndFrame, torsoFrac );
+
+	pose = R_GetMDSPose( &refent, header );
+
+	pTag = ( mdsTag_t * )( (byte *)header + header->ofsTags );
+
+	for ( i = 0; i < numTags; i++, pTag++ ) {
+		if ( !pose ) {
+			AxisClear( outTags[i].axis );
+			VectorClear( outTags[i].origin );
+			continue;
+		}
+
+		memcpy( outTags[i].axis, pose->bones[ pTag->boneIndex ].matrix, sizeof( outTags[i].axis ) );
+		VectorCopy( pose->bones[ pTag->boneIndex ].translation, outTags[i].origin );
+	}
+
+	return numTags;
 }
 
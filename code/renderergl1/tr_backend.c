@@ -889,11 +889,13 @@ RB_StretchPic
 =============
 */
 const void *RB_StretchPic ( const void *data ) {
-	const stretchPicCommand_t	*cmd;
+	const stretchPicsCommand_t	*cmd;
+	const stretchPic_t	*pic;
 	shader_t *shader;
 	int		numVerts, numIndexes;
+	int		i;
 
-	cmd = (const stretchPicCommand_t *)data;
+	cmd = (const stretchPicsCommand_t *)data;
 
 	if ( !backEnd.projection2D ) {
 		RB_SetGL2D();
@@ -908,54 +910,56 @@ const void *RB_StretchPic ( const void *data ) {
 		RB_BeginSurface( shader, 0 );
 	}
 
-	RB_CHECKOVERFLOW( 4, 6 );
-	numVerts = tess.numVertexes;
-	numIndexes = tess.numIndexes;
+	for ( i = 0, pic = (const stretchPic_t *)( cmd + 1 ); i < cmd->numPics; i++, pic++ ) {
+		RB_CHECKOVERFLOW( 4, 6 );
+		numVerts = tess.numVertexes;
+		numIndexes = tess.numIndexes;
 
-	tess.numVertexes += 4;
-	tess.numIndexes += 6;
+		tess.numVertexes += 4;
+		tess.numIndexes += 6;
 
-	tess.indexes[ numIndexes ] = numVerts + 3;
-	tess.indexes[ numIndexes + 1 ] = numVerts + 0;
-	tess.indexes[ numIndexes + 2 ] = numVerts + 2;
-	tess.indexes[ numIndexes + 3 ] = numVerts + 2;
-	tess.indexes[ numIndexes + 4 ] = numVerts + 0;
-	tess.indexes[ numIndexes + 5 ] = numVerts + 1;
+		tess.indexes[ numIndexes ] = numVerts + 3;
+		tess.indexes[ numIndexes + 1 ] = numVerts + 0;
+		tess.indexes[ numIndexes + 2 ] = numVerts + 2;
+		tess.indexes[ numIndexes + 3 ] = numVerts + 2;
+		tess.indexes[ numIndexes + 4 ] = numVerts + 0;
+		tess.indexes[ numIndexes + 5 ] = numVerts + 1;
 
-	*(int *)tess.vertexColors[ numVerts ] =
-		*(int *)tess.vertexColors[ numVerts + 1 ] =
-		*(int *)tess.vertexColors[ numVerts + 2 ] =
-		*(int *)tess.vertexColors[ numVerts + 3 ] = *(int *)backEnd.color2D;
+		*(int *)tess.vertexColors[ numVerts ] =
+			*(int *)tess.vertexColors[ numVerts + 1 ] =
+			*(int *)tess.vertexColors[ numVerts + 2 ] =
+			*(int *)tess.vertexColors[ numVerts + 3 ] = *(int *)backEnd.color2D;
 
-	tess.xyz[ numVerts ][0] = cmd->x;
-	tess.xyz[ numVerts ][1] = cmd->y;
-	tess.xyz[ numVerts ][2] = 0;
+		tess.xyz[ numVerts ][0] = pic->x;
+		tess.xyz[ numVerts ][1] = pic->y;
+		tess.xyz[ numVerts ][2] = 0;
 
-	tess.texCoords[ numVerts ][0][0] = cmd->s1;
-	tess.texCoords[ numVerts ][0][1] = cmd->t1;
+		tess.texCoords[ numVerts ][0][0] = pic->s1;
+		tess.texCoords[ numVerts ][0][1] = pic->t1;
 
-	tess.xyz[ numVerts + 1 ][0] = cmd->x + cmd->w;
-	tess.xyz[ numVerts + 1 ][1] = cmd->y;
-	tess.xyz[ numVerts + 1 ][2] = 0;
+		tess.xyz[ numVerts + 1 ][0] = pic->x + pic->w;
+		tess.xyz[ numVerts + 1 ][1] = pic->y;
+		tess.xyz[ numVerts + 1 ][2] = 0;
 
-	tess.texCoords[ numVerts + 1 ][0][0] = cmd->s2;
-	tess.texCoords[ numVerts + 1 ][0][1] = cmd->t1;
+		tess.texCoords[ numVerts + 1 ][0][0] = pic->s2;
+		tess.texCoords[ numVerts + 1 ][0][1] = pic->t1;
 
-	tess.xyz[ numVerts + 2 ][0] = cmd->x + cmd->w;
-	tess.xyz[ numVerts + 2 ][1] = cmd->y + cmd->h;
-	tess.xyz[ numVerts + 2 ][2] = 0;
+		tess.xyz[ numVerts + 2 ][0] = pic->x + pic->w;
+		tess.xyz[ numVerts + 2 ][1] = pic->y + pic->h;
+		tess.xyz[ numVerts + 2 ][2] = 0;
 
-	tess.texCoords[ numVerts + 2 ][0][0] = cmd->s2;
-	tess.texCoords[ numVerts + 2 ][0][1] = cmd->t2;
+		tess.texCoords[ numVerts + 2 ][0][0] = pic->s2;
+		tess.texCoords[ numVerts + 2 ][0][1] = pic->t2;
 
-	tess.xyz[ numVerts + 3 ][0] = cmd->x;
-	tess.xyz[ numVerts + 3 ][1] = cmd->y + cmd->h;
-	tess.xyz[ numVerts + 3 ][2] = 0;
+		tess.xyz[ numVerts + 3 ][0] = pic->x;
+		tess.xyz[ numVerts + 3 ][1] = pic->y + pic->h;
+		tess.xyz[ numVerts + 3 ][2] = 0;
 
-	tess.texCoords[ numVerts + 3 ][0][0] = cmd->s1;
-	tess.texCoords[ numVerts + 3 ][0][1] = cmd->t2;
+		tess.texCoords[ numVerts + 3 ][0][0] = pic->s1;
+		tess.texCoords[ numVerts + 3 ][0][1] = pic->t2;
+	}
 
-	return (const void *)(cmd + 1);
+	return (const void *)pic;
 }
 
 /*
@@ -1465,6 +1465,37 @@ void R_MovePatchSurfacesToHunk(void) {
 	}
 }
 
+/*
+===============
+R_PrefetchSurfaceImages
+
+Prefetches the images of the shaders the next surfaces use, a shader per
+worker thread at a time so the decoded images don't pile up before they are
+uploaded. Returns the number of surfaces covered.
+===============
+*/
+static int R_PrefetchSurfaceImages( const dsurface_t *in, int count, byte *shaderPrefetched ) {
+	const char	*shaderNames[MAX_PREFETCH_IMAGES];
+	int			i, shaderNum, numShaders, maxShaders;
+
+	maxShaders = MIN( R_NumWorkerThreads(), MAX_PREFETCH_IMAGES );
+	numShaders = 0;
+
+	for ( i = 0; i < count && numShaders < maxShaders; i++, in++ ) {
+		shaderNum = LittleLong( in->shaderNum );
+		if ( shaderNum < 0 || shaderNum >= s_worldData.numShaders || shaderPrefetched[ shaderNum ] ) {
+			continue;
+		}
+
+		shaderPrefetched[ shaderNum ] = qtrue;
+		shaderNames[ numShaders++ ] = s_worldData.shaders[ shaderNum ].shader;
+	}
+
+	R_PrefetchShaderImages( shaderNames, numShaders );
+
+	return i;
+}
+
 /*
 ===============
 R_LoadSurfaces
@@ -1478,6 +1509,8 @@ static	void R_LoadSurfaces( const bspFile_t *bsp ) {
 	int			count;
 	int			numFaces, numMeshes, numTriSurfs, numFlares, numFoliage, numTerrain;
 	int			i;
+	byte		*shaderPrefetched;
+	int			prefetchEnd;
 
 	numFaces = 0;
 	numMeshes = 0;
@@ -1503,7 +1536,21 @@ static	void R_LoadSurfaces( const bspFile_t *bsp ) {
 	// as we go
 	R_InitSurfMemory();
 
+	// decode the images on the worker threads ahead of the surfaces that use
+	// them, streamed images are loaded later and cached images aren't decoded
+	if ( R_NumWorkerThreads() > 1 && !r_streamImages->integer && !r_imageCache->integer ) {
+		shaderPrefetched = ri.Hunk_AllocateTempMemory( s_worldData.numShaders );
+		Com_Memset( shaderPrefetched, 0, s_worldData.numShaders );
+	} else {
+		shaderPrefetched = NULL;
+	}
+	prefetchEnd = 0;
+
 	for ( i = 0 ; i < count ; i++, in++, out++ ) {
+		if ( shaderPrefetched && i == prefetchEnd ) {
+			prefetchEnd = i + R_PrefetchSurfaceImages( in, count - i, shaderPrefetched );
+		}
+
 		switch ( LittleLong( in->surfaceType ) ) {
 		case MST_PATCH:
 			ParseMesh ( in, dv, out );
@@ -1534,6 +1581,11 @@ static	void R_LoadSurfaces( const bspFile_t *bsp ) {
 		}
 	}
 
+	if ( shaderPrefetched ) {
+		R_FreePrefetchedImages();
+		ri.Hunk_FreeTempMemory( shaderPrefetched );
+	}
+
 #ifdef PATCH_STITCHING
 	R_StitchAllPatches();
 #endif
@@ -97,6 +97,7 @@ void R_IssueRenderCommands( qboolean runPerformanceCounters ) {
 
 	// clear it out, in case this is a sync and not a buffer flip
 	cmdList->used = 0;
+	cmdList->stretchPics = NULL;
 
 	if ( runPerformanceCounters ) {
 		R_PerformanceCounters();
@@ -308,7 +309,10 @@ RE_StretchPic
 */
 void RE_StretchPic ( float x, float y, float w, float h, 
 					  float s1, float t1, float s2, float t2, qhandle_t hShader ) {
-	stretchPicCommand_t	*cmd;
+	renderCommandList_t	*cmdList;
+	stretchPicsCommand_t	*cmd;
+	stretchPic_t	*pic;
+	shader_t	*shader;
 
 	if (!tr.registered) {
 		return;
@@ -316,20 +320,40 @@ void RE_StretchPic ( float x, float y, float w, float h,
 	if (R_ClipRegion(&x, &y, &w, &h, &s1, &t1, &s2, &t2)) {
 		return;
 	}
-	cmd = R_GetCommandBuffer( sizeof( *cmd ) );
-	if ( !cmd ) {
-		return;
-	}
-	cmd->commandId = RC_STRETCH_PIC;
-	cmd->shader = R_GetShaderByHandle( hShader );
-	cmd->x = x;
-	cmd->y = y;
-	cmd->w = w;
-	cmd->h = h;
-	cmd->s1 = s1;
-	cmd->t1 = t1;
-	cmd->s2 = s2;
-	cmd->t2 = t2;
+
+	cmdList = &backEndData->commands;
+	shader = R_GetShaderByHandle( hShader );
+	cmd = cmdList->stretchPics;
+
+	// add to the last command if it's still at the end of the list
+	if ( cmd && cmd->shader == shader
+		&& (byte *)( (stretchPic_t *)( cmd + 1 ) + cmd->numPics ) == cmdList->cmds + cmdList->used ) {
+		pic = R_GetCommandBuffer( sizeof( *pic ) );
+		if ( !pic ) {
+			return;
+		}
+		cmd->numPics++;
+	} else {
+		cmd = R_GetCommandBuffer( sizeof( *cmd ) + sizeof( *pic ) );
+		if ( !cmd ) {
+			return;
+		}
+		cmd->commandId = RC_STRETCH_PIC;
+		cmd->numPics = 1;
+		cmd->shader = shader;
+		cmdList->stretchPics = cmd;
+
+		pic = (stretchPic_t *)( cmd + 1 );
+	}
+
+	pic->x = x;
+	pic->y = y;
+	pic->w = w;
+	pic->h = h;
+	pic->s1 = s1;
+	pic->t1 = t1;
+	pic->s2 = s2;
+	pic->t2 = t2;
 }
 
 /*
@@ -691,6 +715,11 @@ void RE_BeginFrame( stereoFrame_t stereoFrame ) {
 		r_textureMode->modified = qfalse;
 	}
 
+	//
+	// load streamed images
+	//
+	R_StreamImages();
+
 	//
 	// gamma stuff
 	//
@@ -837,8 +866,7 @@ void RE_EndFrame( int *frontEndMsec, int *backEndMsec ) {
 RE_TakeVideoFrame
 =============
 */
-void RE_TakeVideoFrame( int width, int height,
-		byte *captureBuffer, byte *encodeBuffer, qboolean motionJpeg )
+void RE_TakeVideoFrame( int width, int height )
 {
 	videoFrameCommand_t	*cmd;
 
@@ -855,7 +883,19 @@ void RE_TakeVideoFrame( int width, int height,
 
 	cmd->width = width;
 	cmd->height = height;
-	cmd->captureBuffer = captureBuffer;
-	cmd->encodeBuffer = encodeBuffer;
-	cmd->motionJpeg = motionJpeg;
+}
+
+/*
+=============
+RE_FinishVideoFrames
+=============
+*/
+void RE_FinishVideoFrames( void )
+{
+	if( !tr.registered ) {
+		return;
+	}
+
+	R_IssuePendingRenderCommands();
+	RB_FinishVideoFrames();
 }
@@ -30,6 +30,14 @@ Suite 120, Rockville, Maryland 20850 USA.
 // tr_image.c
 #include "tr_local.h"
 
+#if idx64
+#include <emmintrin.h>
+#endif
+
+// smallest amount of work worth handing to a worker thread
+#define MIN_JOB_PIXELS		16384
+#define MIN_JOB_ROWS( w )	( MIN_JOB_PIXELS / MAX( 1, (w) ) + 1 )
+
 static byte			 s_intensitytable[256];
 static unsigned char s_gammatable[256];
 
@@ -279,7 +287,10 @@ void R_ImageList_f( void ) {
 
 	ri.Printf (PRINT_ALL, " ---------\n");
 	ri.Printf (PRINT_ALL, " approx %i bytes\n", estTotalSize);
-	ri.Printf (PRINT_ALL, " %i total images\n\n", tr.numImages );
+	ri.Printf (PRINT_ALL, " %i total images\n", tr.numImages );
+	ri.Printf (PRINT_ALL, " %i images decoded in %i msec\n", tr.imageColdLoads, tr.imageColdMsec );
+	ri.Printf (PRINT_ALL, " %i images loaded from cache in %i msec\n", tr.imageWarmLoads, tr.imageWarmMsec );
+	ri.Printf (PRINT_ALL, " %i images waiting to be streamed\n\n", R_NumStreamImages() );
 }
 
 //=======================================================================
@@ -297,44 +308,90 @@ If a larger shrinking is needed, use the mipmap function
 before or after.
 ================
 */
+typedef struct {
+	unsigned	*in;
+	int			inwidth, inheight;
+	unsigned	*out;
+	int			outwidth, outheight;
+	unsigned	p1[2048], p2[2048];
+} resampleJob_t;
+
+static void ResampleTextureRows( void *data, int start, int end ) {
+	resampleJob_t *job = data;
+	int		i, j;
+	unsigned	*inrow, *inrow2, *out;
+	byte		*pix1, *pix2, *pix3, *pix4;
+#if idx64
+	__m128i		zero = _mm_setzero_si128();
+	__m128i		a, b, c, d;
+#endif
+
+	for (i=start ; i<end ; i++) {
+		out = job->out + i*job->outwidth;
+		inrow = job->in + job->inwidth*(int)((i+0.25)*job->inheight/job->outheight);
+		inrow2 = job->in + job->inwidth*(int)((i+0.75)*job->inheight/job->outheight);
+		j = 0;
+#if idx64
+		// two pixels at a time, 16 bits per channel
+#define LOADPIXELS( row, p ) _mm_unpacklo_epi8( _mm_unpacklo_epi32( \
+			_mm_cvtsi32_si128( *(int *)( (byte *)(row) + (p)[j] ) ), \
+			_mm_cvtsi32_si128( *(int *)( (byte *)(row) + (p)[j+1] ) ) ), zero )
+		for ( ; j+1<job->outwidth ; j+=2) {
+			a = LOADPIXELS( inrow, job->p1 );
+			b = LOADPIXELS( inrow, job->p2 );
+			c = LOADPIXELS( inrow2, job->p1 );
+			d = LOADPIXELS( inrow2, job->p2 );
+			a = _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16( a, b ), _mm_add_epi16( c, d ) ), 2 );
+			_mm_storel_epi64( (__m128i *)(out+j), _mm_packus_epi16( a, zero ) );
+		}
+#undef LOADPIXELS
+#endif
+		for ( ; j<job->outwidth ; j++) {
+			pix1 = (byte *)inrow + job->p1[j];
+			pix2 = (byte *)inrow + job->p2[j];
+			pix3 = (byte *)inrow2 + job->p1[j];
+			pix4 = (byte *)inrow2 + job->p2[j];
+			((byte *)(out+j))[0] = (pix1[0] + pix2[0] + pix3[0] + pix4[0])>>2;
+			((byte *)(out+j))[1] = (pix1[1] + pix2[1] + pix3[1] + pix4[1])>>2;
+			((byte *)(out+j))[2] = (pix1[2] + pix2[2] + pix3[2] + pix4[2])>>2;
+			((byte *)(out+j))[3] = (pix1[3] + pix2[3] + pix3[3] + pix4[3])>>2;
+		}
+	}
+}
+
 static void ResampleTexture( unsigned *in, int inwidth, int inheight, unsigned *out,  
 							int outwidth, int outheight ) {
-	int		i, j;
-	unsigned	*inrow, *inrow2;
+	int		i;
 	unsigned	frac, fracstep;
-	unsigned	p1[2048], p2[2048];
-	byte		*pix1, *pix2, *pix3, *pix4;
+	resampleJob_t	*job;
 
 	if (outwidth>2048)
 		ri.Error(ERR_DROP, "ResampleTexture: max width");
-								
+
+	job = ri.Hunk_AllocateTempMemory( sizeof( *job ) );
+	job->in = in;
+	job->inwidth = inwidth;
+	job->inheight = inheight;
+	job->out = out;
+	job->outwidth = outwidth;
+	job->outheight = outheight;
+
 	fracstep = inwidth*0x10000/outwidth;
 
 	frac = fracstep>>2;
 	for ( i=0 ; i<outwidth ; i++ ) {
-		p1[i] = 4*(frac>>16);
+		job->p1[i] = 4*(frac>>16);
 		frac += fracstep;
 	}
 	frac = 3*(fracstep>>2);
 	for ( i=0 ; i<outwidth ; i++ ) {
-		p2[i] = 4*(frac>>16);
+		job->p2[i] = 4*(frac>>16);
 		frac += fracstep;
 	}
 
-	for (i=0 ; i<outheight ; i++, out += outwidth) {
-		inrow = in + inwidth*(int)((i+0.25)*inheight/outheight);
-		inrow2 = in + inwidth*(int)((i+0.75)*inheight/outheight);
-		for (j=0 ; j<outwidth ; j++) {
-			pix1 = (byte *)inrow + p1[j];
-			pix2 = (byte *)inrow + p2[j];
-			pix3 = (byte *)inrow2 + p1[j];
-			pix4 = (byte *)inrow2 + p2[j];
-			((byte *)(out+j))[0] = (pix1[0] + pix2[0] + pix3[0] + pix4[0])>>2;
-			((byte *)(out+j))[1] = (pix1[1] + pix2[1] + pix3[1] + pix4[1])>>2;
-			((byte *)(out+j))[2] = (pix1[2] + pix2[2] + pix3[2] + pix4[2])>>2;
-			((byte *)(out+j))[3] = (pix1[3] + pix2[3] + pix3[3] + pix4[3])>>2;
-		}
-	}
+	R_ParallelFor( ResampleTextureRows, job, outheight, MIN_JOB_ROWS( outwidth ) );
+
+	ri.Hunk_FreeTempMemory( job );
 }
 
 /*
@@ -345,54 +402,59 @@ Scale up the pixel values in a texture to increase the
 lighting range
 ================
 */
+typedef struct {
+	byte	*pixels;
+	byte	table[256];
+} lightScaleJob_t;
+
+static void R_LightScalePixels( void *data, int start, int end ) {
+	lightScaleJob_t *job = data;
+	int		i;
+	byte	*p;
+
+	p = job->pixels + start*4;
+
+	for (i=start ; i<end ; i++, p+=4)
+	{
+		p[0] = job->table[p[0]];
+		p[1] = job->table[p[1]];
+		p[2] = job->table[p[2]];
+	}
+}
+
 void R_LightScaleTexture (unsigned *in, int inwidth, int inheight, qboolean only_gamma )
 {
+	lightScaleJob_t	job;
+	int		i;
+
 	if ( only_gamma )
 	{
-		if ( !glConfig.deviceSupportsGamma )
+		if ( glConfig.deviceSupportsGamma )
 		{
-			int		i, c;
-			byte	*p;
-
-			p = (byte *)in;
-
-			c = inwidth*inheight;
-			for (i=0 ; i<c ; i++, p+=4)
-			{
-				p[0] = s_gammatable[p[0]];
-				p[1] = s_gammatable[p[1]];
-				p[2] = s_gammatable[p[2]];
-			}
+			return;
 		}
+
+		Com_Memcpy( job.table, s_gammatable, sizeof( job.table ) );
 	}
 	else
 	{
-		int		i, c;
-		byte	*p;
-
-		p = (byte *)in;
-
-		c = inwidth*inheight;
-
 		if ( glConfig.deviceSupportsGamma )
 		{
-			for (i=0 ; i<c ; i++, p+=4)
-			{
-				p[0] = s_intensitytable[p[0]];
-				p[1] = s_intensitytable[p[1]];
-				p[2] = s_intensitytable[p[2]];
-			}
+			Com_Memcpy( job.table, s_intensitytable, sizeof( job.table ) );
 		}
 		else
 		{
-			for (i=0 ; i<c ; i++, p+=4)
+			// combine the tables so each channel only needs one lookup
+			for (i=0 ; i<256 ; i++)
 			{
-				p[0] = s_gammatable[s_intensitytable[p[0]]];
-				p[1] = s_gammatable[s_intensitytable[p[1]]];
-				p[2] = s_gammatable[s_intensitytable[p[2]]];
+				job.table[i] = s_gammatable[s_intensitytable[i]];
 			}
 		}
 	}
+
+	job.pixels = (byte *)in;
+
+	R_ParallelFor( R_LightScalePixels, &job, inwidth*inheight, MIN_JOB_PIXELS );
 }
 
 
@@ -400,28 +462,34 @@ void R_LightScaleTexture (unsigned *in, int inwidth, int inheight, qboolean only
 ================
 R_MipMap2
 
-Operates in place, quartering the size of the texture
+Quarters the size of the texture
 Proper linear filter
 ================
 */
-static void R_MipMap2( unsigned *in, int inWidth, int inHeight ) {
+typedef struct {
+	const byte	*in;
+	byte		*out;
+	int			inWidth, inHeight;
+} mipMapJob_t;
+
+static void R_MipMap2Rows( void *data, int start, int end ) {
+	mipMapJob_t *job = data;
+	const unsigned	*in = (const unsigned *)job->in;
+	int			inWidth = job->inWidth;
 	int			i, j, k;
 	byte		*outpix;
 	int			inWidthMask, inHeightMask;
 	int			total;
-	int			outWidth, outHeight;
-	unsigned	*temp;
+	int			outWidth;
 
 	outWidth = inWidth >> 1;
-	outHeight = inHeight >> 1;
-	temp = ri.Hunk_AllocateTempMemory( outWidth * outHeight * 4 );
 
 	inWidthMask = inWidth - 1;
-	inHeightMask = inHeight - 1;
+	inHeightMask = job->inHeight - 1;
 
-	for ( i = 0 ; i < outHeight ; i++ ) {
+	for ( i = start ; i < end ; i++ ) {
 		for ( j = 0 ; j < outWidth ; j++ ) {
-			outpix = (byte *) ( temp + i * outWidth + j );
+			outpix = job->out + ( i * outWidth + j ) * 4;
 			for ( k = 0 ; k < 4 ; k++ ) {
 				total = 
 					1 * ((byte *)&in[ ((i*2-1)&inHeightMask)*inWidth + ((j*2-1)&inWidthMask) ])[k] +
@@ -447,39 +515,87 @@ static void R_MipMap2( unsigned *in, int inWidth, int inHeight ) {
 			}
 		}
 	}
-
-	Com_Memcpy( in, temp, outWidth * outHeight * 4 );
-	ri.Hunk_FreeTempMemory( temp );
 }
 
 /*
 ================
-R_MipMap
+R_MipMapRows
 
-Operates in place, quartering the size of the texture
+Box filter
 ================
 */
-static void R_MipMap (byte *in, int width, int height) {
-	int		i, j;
+static void R_MipMapRows( void *data, int start, int end ) {
+	mipMapJob_t *job = data;
+	const byte	*in;
 	byte	*out;
-	int		row;
+	int		i, j;
+	int		row, width;
+#if idx64
+	__m128i	zero = _mm_setzero_si128();
+	__m128i	a, b, lo, hi;
+#endif
+
+	row = job->inWidth * 4;
+	width = job->inWidth >> 1;
+
+	for (i=start ; i<end ; i++) {
+		in = job->in + i*2*row;
+		out = job->out + i*width*4;
+		j = 0;
+#if idx64
+		// two output pixels at a time, 16 bits per channel
+		for ( ; j+1<width ; j+=2, out+=8, in+=16) {
+			a = _mm_loadu_si128( (const __m128i *)in );
+			b = _mm_loadu_si128( (const __m128i *)( in + row ) );
+			lo = _mm_add_epi16( _mm_unpacklo_epi8( a, zero ), _mm_unpacklo_epi8( b, zero ) );
+			hi = _mm_add_epi16( _mm_unpackhi_epi8( a, zero ), _mm_unpackhi_epi8( b, zero ) );
+			a = _mm_add_epi16( _mm_unpacklo_epi64( lo, hi ), _mm_unpackhi_epi64( lo, hi ) );
+			_mm_storel_epi64( (__m128i *)out, _mm_packus_epi16( _mm_srli_epi16( a, 2 ), zero ) );
+		}
+#endif
+		for ( ; j<width ; j++, out+=4, in+=8) {
+			out[0] = (in[0] + in[4] + in[row+0] + in[row+4])>>2;
+			out[1] = (in[1] + in[5] + in[row+1] + in[row+5])>>2;
+			out[2] = (in[2] + in[6] + in[row+2] + in[row+6])>>2;
+			out[3] = (in[3] + in[7] + in[row+3] + in[row+7])>>2;
+		}
+	}
+}
+
+/*
+================
+R_MipMapInto
+
+Writes the next mip level of in to out, in and out must not overlap
+================
+*/
+static void R_MipMapInto( const byte *in, int width, int height, byte *out ) {
+	int		i;
+	mipMapJob_t	job;
+
+	job.in = in;
+	job.out = out;
+	job.inWidth = width;
+	job.inHeight = height;
 
 	if ( !r_simpleMipMaps->integer ) {
-		R_MipMap2( (unsigned *)in, width, height );
+		if ( width == 1 || height == 1 ) {
+			// can't filter a single row or column, keep the first pixels
+			Com_Memcpy( out, in, MAX( 1, width >> 1 ) * MAX( 1, height >> 1 ) * 4 );
+			return;
+		}
+
+		R_ParallelFor( R_MipMap2Rows, &job, height >> 1, MIN_JOB_ROWS( width >> 1 ) );
 		return;
 	}
 
 	if ( width == 1 && height == 1 ) {
+		Com_Memcpy( out, in, 4 );
 		return;
 	}
 
-	row = width * 4;
-	out = in;
-	width >>= 1;
-	height >>= 1;
-
-	if ( width == 0 || height == 0 ) {
-		width += height;	// get largest
+	if ( width == 1 || height == 1 ) {
+		width = ( width * height ) >> 1;
 		for (i=0 ; i<width ; i++, out+=4, in+=8 ) {
 			out[0] = ( in[0] + in[4] )>>1;
 			out[1] = ( in[1] + in[5] )>>1;
@@ -489,14 +605,31 @@ static void R_MipMap (byte *in, int width, int height) {
 		return;
 	}
 
-	for (i=0 ; i<height ; i++, in+=row) {
-		for (j=0 ; j<width ; j++, out+=4, in+=8) {
-			out[0] = (in[0] + in[4] + in[row+0] + in[row+4])>>2;
-			out[1] = (in[1] + in[5] + in[row+1] + in[row+5])>>2;
-			out[2] = (in[2] + in[6] + in[row+2] + in[row+6])>>2;
-			out[3] = (in[3] + in[7] + in[row+3] + in[row+7])>>2;
-		}
+	R_ParallelFor( R_MipMapRows, &job, height >> 1, MIN_JOB_ROWS( width >> 1 ) );
+}
+
+/*
+================
+R_MipMap
+
+Operates in place, quartering the size of the texture
+================
+*/
+static void R_MipMap (byte *in, int width, int height) {
+	byte	*temp;
+	int		size;
+
+	if ( width == 1 && height == 1 ) {
+		return;
 	}
+
+	size = MAX( 1, width >> 1 ) * MAX( 1, height >> 1 ) * 4;
+	temp = ri.Hunk_AllocateTempMemory( size );
+
+	R_MipMapInto( in, width, height, temp );
+
+	Com_Memcpy( in, temp, size );
+	ri.Hunk_FreeTempMemory( temp );
 }
 
 
@@ -588,6 +721,69 @@ static qboolean UploadOneTexLevel( int level, const textureLevel_t *pic )
 	return qtrue;
 }
 
+/*
+===============
+SetTextureFilter
+===============
+*/
+static void SetTextureFilter( qboolean mipmap )
+{
+	if (mipmap)
+	{
+		if ( glConfig.textureFilterAnisotropic )
+			qglTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT,
+					(GLint)Com_Clamp( 1, glConfig.maxAnisotropy, r_ext_max_anisotropy->integer ) );
+
+		qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, gl_filter_min);
+		qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, gl_filter_max);
+	}
+	else
+	{
+		if ( glConfig.textureFilterAnisotropic )
+			qglTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 1 );
+
+		qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+		qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	}
+}
+
+/*
+===============
+UploadProcessed
+
+Uploads a mip chain that was already processed by Upload32, such as
+one from the image cache
+===============
+*/
+static void UploadProcessed( int numTexLevels, const textureLevel_t *pics,
+						  qboolean mipmap,
+						  int internalFormat,
+						  int *format,
+						  int *pUploadWidth, int *pUploadHeight )
+{
+	int		i;
+
+	if ( !mipmap ) {
+		numTexLevels = 1;
+	}
+
+	for ( i = 0; i < numTexLevels; i++ ) {
+		if ( pics[i].format == GL_RGBA8 ) {
+			qglTexImage2D( GL_TEXTURE_2D, i, internalFormat, pics[i].width, pics[i].height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pics[i].data );
+		} else if ( !UploadOneTexLevel( i, &pics[i] ) ) {
+			ri.Error(ERR_DROP, "Unsupported Texture format: %8x", pics[i].format );
+		}
+	}
+
+	*pUploadWidth = pics[0].width;
+	*pUploadHeight = pics[0].height;
+	*format = internalFormat;
+
+	SetTextureFilter( mipmap );
+
+	GL_CheckErrors();
+}
+
 /*
 ===============
 Upload32
@@ -857,11 +1053,20 @@ static void Upload32( int numTexLevels, const textureLevel_t *pics,
 	if (mipmap)
 	{
 		int		miplevel;
+		unsigned	*mipBuffer, *src, *dst, *swap;
+
+		// ping-pong between two buffers so each level is filtered out of place
+		mipBuffer = ri.Hunk_AllocateTempMemory( sizeof( unsigned ) * MAX( 1, scaled_width >> 1 ) * MAX( 1, scaled_height >> 1 ) );
+		src = scaledBuffer;
+		dst = mipBuffer;
 
 		miplevel = 0;
 		while (scaled_width > 1 || scaled_height > 1)
 		{
-			R_MipMap( (byte *)scaledBuffer, scaled_width, scaled_height );
+			R_MipMapInto( (byte *)src, scaled_width, scaled_height, (byte *)dst );
+			swap = src;
+			src = dst;
+			dst = swap;
 			scaled_width >>= 1;
 			scaled_height >>= 1;
 			if (scaled_width < 1)
@@ -871,31 +1076,17 @@ static void Upload32( int numTexLevels, const textureLevel_t *pics,
 			miplevel++;
 
 			if ( r_colorMipLevels->integer ) {
-				R_BlendOverTexture( (byte *)scaledBuffer, scaled_width * scaled_height, mipBlendColors[miplevel] );
+				R_BlendOverTexture( (byte *)src, scaled_width * scaled_height, mipBlendColors[miplevel] );
 			}
 
-			qglTexImage2D (GL_TEXTURE_2D, miplevel, internalFormat, scaled_width, scaled_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, scaledBuffer );
+			qglTexImage2D (GL_TEXTURE_2D, miplevel, internalFormat, scaled_width, scaled_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, src );
 		}
-	}
-done:
-
-	if (mipmap)
-	{
-		if ( glConfig.textureFilterAnisotropic )
-			qglTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT,
-					(GLint)Com_Clamp( 1, glConfig.maxAnisotropy, r_ext_max_anisotropy->integer ) );
 
-		qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, gl_filter_min);
-		qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, gl_filter_max);
+		ri.Hunk_FreeTempMemory( mipBuffer );
 	}
-	else
-	{
-		if ( glConfig.textureFilterAnisotropic )
-			qglTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 1 );
+done:
 
-		qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-		qglTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-	}
+	SetTextureFilter( mipmap );
 
 	GL_CheckErrors();
 
@@ -931,22 +1122,18 @@ image_t *R_CreateImage( const char *name, byte *pic, int width, int height,
 R_CreateImage2
 
 This is the only way any image_t are created
+If internalFormat is set, pic is a mip chain that has already been processed
+for upload with that format
 ================
 */
 image_t *R_CreateImage2( const char *name, int numTexLevels, const textureLevel_t *pic,
 		imgType_t type, imgFlags_t flags, int internalFormat ) {
 	image_t		*image;
-	qboolean	isLightmap = qfalse;
-	int			picmip;
 	long		hash;
-	int         glWrapClampMode;
 
 	if (strlen(name) >= MAX_QPATH ) {
 		ri.Error (ERR_DROP, "R_CreateImage: \"%s\" is too long", name);
 	}
-	if ( !strncmp( name, "*lightmap", 9 ) ) {
-		isLightmap = qtrue;
-	}
 
 	if ( tr.numImages == MAX_DRAWIMAGES ) {
 		ri.Error( ERR_DROP, "R_CreateImage: MAX_DRAWIMAGES hit");
@@ -961,20 +1148,66 @@ image_t *R_CreateImage2( const char *name, int numTexLevels, const textureLevel_
 
 	strcpy (image->imgName, name);
 
-	image->width = pic[0].width;
-	image->height = pic[0].height;
-	if (flags & IMGFLAG_CLAMPTOEDGE)
-		glWrapClampMode = haveClampToEdge ? GL_CLAMP_TO_EDGE : GL_CLAMP;
-	else
-		glWrapClampMode = GL_REPEAT;
-
 	// lightmaps are always allocated on TMU 1
-	if ( qglActiveTextureARB && isLightmap ) {
+	if ( qglActiveTextureARB && !strncmp( name, "*lightmap", 9 ) ) {
 		image->TMU = 1;
 	} else {
 		image->TMU = 0;
 	}
 
+	R_UploadImage( image, numTexLevels, pic, internalFormat );
+
+	hash = generateHashValue(name);
+	image->next = hashTable[hash];
+	hashTable[hash] = image;
+
+	return image;
+}
+
+/*
+================
+R_UpdateImage
+
+Replaces the texture of an image with a new 32 bit picture
+================
+*/
+void R_UpdateImage( image_t *image, byte *pic, int width, int height ) {
+	textureLevel_t texLevel;
+
+	texLevel.format = GL_RGBA8;
+	texLevel.width = width;
+	texLevel.height = height;
+	texLevel.size = width * height * 4;
+	texLevel.data = pic;
+
+	R_UploadImage( image, 1, &texLevel, 0 );
+}
+
+/*
+================
+R_UploadImage
+
+Replaces the texture of an image, the image keeps its texture name
+If internalFormat is set, pic is a mip chain that has already been processed
+for upload with that format
+================
+*/
+void R_UploadImage( image_t *image, int numTexLevels, const textureLevel_t *pic, int internalFormat ) {
+	qboolean	isLightmap = qfalse;
+	int			picmip;
+	int         glWrapClampMode;
+
+	if ( !strncmp( image->imgName, "*lightmap", 9 ) ) {
+		isLightmap = qtrue;
+	}
+
+	image->width = pic[0].width;
+	image->height = pic[0].height;
+	if (image->flags & IMGFLAG_CLAMPTOEDGE)
+		glWrapClampMode = haveClampToEdge ? GL_CLAMP_TO_EDGE : GL_CLAMP;
+	else
+		glWrapClampMode = GL_REPEAT;
+
 	if ( qglActiveTextureARB ) {
 		GL_SelectTexture( image->TMU );
 	}
@@ -988,7 +1221,16 @@ image_t *R_CreateImage2( const char *name, int numTexLevels, const textureLevel_
 	else
 		picmip = 0;
 
-	Upload32( numTexLevels, pic,
+	if ( internalFormat ) {
+		// already processed, from the image cache
+		UploadProcessed( numTexLevels, pic,
+								image->flags & IMGFLAG_MIPMAP,
+								internalFormat,
+								&image->internalFormat,
+								&image->uploadWidth,
+								&image->uploadHeight );
+	} else {
+		Upload32( numTexLevels, pic,
 								image->flags & IMGFLAG_MIPMAP,
 								picmip,
 								isLightmap,
@@ -996,6 +1238,7 @@ image_t *R_CreateImage2( const char *name, int numTexLevels, const textureLevel_
 								&image->internalFormat,
 								&image->uploadWidth,
 								&image->uploadHeight );
+	}
 
 	qglTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, glWrapClampMode );
 	qglTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, glWrapClampMode );
@@ -1006,12 +1249,6 @@ image_t *R_CreateImage2( const char *name, int numTexLevels, const textureLevel_
 	if ( image->TMU == 1 ) {
 		GL_SelectTexture( 0 );
 	}
-
-	hash = generateHashValue(name);
-	image->next = hashTable[hash];
-	hashTable[hash] = image;
-
-	return image;
 }
 
 //===================================================================
@@ -1020,43 +1257,54 @@ typedef struct
 {
 	char *ext;
 	void (*ImageLoader)( const char *, int *, textureLevel_t ** );
+	imageDecoder_t ImageDecoder;	// NULL if it can't run on the worker threads
 } imageExtToLoaderMap_t;
 
 // Note that the ordering indicates the order of preference used
 // when there are multiple images of different formats available
 static imageExtToLoaderMap_t imageLoaders[ ] =
 {
-	{ "tga",  R_LoadTGA },
-	{ "jpg",  R_LoadJPG },
-	{ "jpeg", R_LoadJPG },
-	{ "png",  R_LoadPNG },
-	{ "ftx",  R_LoadFTX },
-	{ "dds",  R_LoadDDS },
-	{ "pcx",  R_LoadPCX },
-	{ "bmp",  R_LoadBMP }
+	{ "tga",  R_LoadTGA, R_DecodeTGA },
+	{ "jpg",  R_LoadJPG, R_DecodeJPG },
+	{ "jpeg", R_LoadJPG, R_DecodeJPG },
+	{ "png",  R_LoadPNG, R_DecodePNG },
+	{ "ftx",  R_LoadFTX, NULL },
+	{ "dds",  R_LoadDDS, NULL },
+	{ "pcx",  R_LoadPCX, NULL },
+	{ "bmp",  R_LoadBMP, NULL }
 };
 
 static int numImageLoaders = ARRAY_LEN( imageLoaders );
 
+typedef struct
+{
+	char		name[ MAX_QPATH ];		// as passed to R_LoadImage, empty once taken
+	char		fileName[ MAX_QPATH ];
+	qboolean	orgNameFailed;
+} prefetchImage_t;
+
+static prefetchImage_t	prefetchImages[ MAX_PREFETCH_IMAGES ];
+static imageDecode_t	prefetchDecodes[ MAX_PREFETCH_IMAGES ];
+static int				numPrefetchImages;
+
 /*
 =================
-R_LoadImage
+R_FindImageLoader
 
-Loads any of the supported image types into a canonical
-32 bit format.
+Finds the next file R_LoadImage tries for name after the one of loader, or
+the first one if loader is -1. orgNameFailed is set if it isn't the file
+name refers to and checksum to the checksum of the pk3 the file is in.
+Returns the loader index, or -1 if there isn't one.
 =================
 */
-void R_LoadImage( const char *name, int *numLevels, textureLevel_t **pic )
+static int R_FindImageLoader( const char *name, int loader, char *fileName, int fileNameSize, qboolean *orgNameFailed, int *checksum )
 {
-	qboolean orgNameFailed = qfalse;
-	int orgLoader = -1;
-	int i;
 	char localName[ MAX_QPATH ];
 	const char *ext;
-	char *altName;
+	int orgLoader = -1;
+	int i;
 
-	*pic = NULL;
-	*numLevels = 0;
+	*orgNameFailed = qfalse;
 
 	Q_strncpyz( localName, name, MAX_QPATH );
 
@@ -1064,54 +1312,231 @@ void R_LoadImage( const char *name, int *numLevels, textureLevel_t **pic )
 
 	if( *ext )
 	{
-		// Look for the correct loader and use it
 		for( i = 0; i < numImageLoaders; i++ )
 		{
 			if( !Q_stricmp( ext, imageLoaders[ i ].ext ) )
 			{
-				// Load
-				imageLoaders[ i ].ImageLoader( localName, numLevels, pic );
 				break;
 			}
 		}
 
-		// A loader was found
+		// A loader was found, the name itself is tried first
 		if( i < numImageLoaders )
 		{
-			if( *pic == NULL )
-			{
-				// Loader failed, most likely because the file isn't there;
-				// try again without the extension
-				orgNameFailed = qtrue;
-				orgLoader = i;
-				COM_StripExtension( name, localName, MAX_QPATH );
-			}
-			else
+			if( loader < 0 && ri.FS_FilePakChecksum( localName, checksum ) )
 			{
-				// Something loaded
-				return;
+				Q_strncpyz( fileName, localName, fileNameSize );
+				return i;
 			}
+
+			*orgNameFailed = qtrue;
+			orgLoader = i;
+			COM_StripExtension( name, localName, MAX_QPATH );
 		}
 	}
 
 	// Try and find a suitable match using all
 	// the image formats supported
-	for( i = 0; i < numImageLoaders; i++ )
+	for( i = ( loader == orgLoader ) ? 0 : loader + 1; i < numImageLoaders; i++ )
 	{
-		if (i == orgLoader)
+		if( i == orgLoader )
+			continue;
+
+		Com_sprintf( fileName, fileNameSize, "%s.%s", localName, imageLoaders[ i ].ext );
+
+		if( ri.FS_FilePakChecksum( fileName, checksum ) )
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/*
+=================
+R_PrefetchImages
+
+Frees the previous prefetched images, then reads the files R_LoadImage would
+load for names on the main thread and decodes the TGA, JPG and PNG ones on the
+worker threads. R_LoadImage takes the decoded images instead of loading them
+again until R_FreePrefetchedImages is called.
+=================
+*/
+void R_PrefetchImages( const char **names, int numNames )
+{
+	prefetchImage_t	*prefetch;
+	imageDecode_t	*decode;
+	image_t		*image;
+	union {
+		byte *b;
+		void *v;
+	} buffer;
+	int			i, j, loader, checksum;
+
+	R_FreePrefetchedImages();
+
+	// nothing to gain without worker threads
+	if ( R_NumWorkerThreads() < 2 ) {
+		return;
+	}
+
+	for ( i = 0; i < numNames && numPrefetchImages < MAX_PREFETCH_IMAGES; i++ ) {
+		// skip images that are already loaded, streamed images still need it
+		for ( image = hashTable[ generateHashValue( names[ i ] ) ]; image; image = image->next ) {
+			if ( !strcmp( names[ i ], image->imgName ) ) {
+				break;
+			}
+		}
+
+		if ( image && !image->pending ) {
+			continue;
+		}
+
+		for ( j = 0; j < numPrefetchImages; j++ ) {
+			if ( !strcmp( names[ i ], prefetchImages[ j ].name ) ) {
+				break;
+			}
+		}
+
+		if ( j < numPrefetchImages ) {
+			continue;
+		}
+
+		prefetch = &prefetchImages[ numPrefetchImages ];
+		decode = &prefetchDecodes[ numPrefetchImages ];
+
+		loader = R_FindImageLoader( names[ i ], -1, prefetch->fileName, sizeof ( prefetch->fileName ), &prefetch->orgNameFailed, &checksum );
+		if ( loader < 0 || !imageLoaders[ loader ].ImageDecoder ) {
+			continue;
+		}
+
+		decode->length = ri.FS_ReadFile( prefetch->fileName, &buffer.v );
+		if ( !buffer.b || decode->length < 0 ) {
 			continue;
+		}
 
-		altName = va( "%s.%s", localName, imageLoaders[ i ].ext );
+		Q_strncpyz( prefetch->name, names[ i ], sizeof ( prefetch->name ) );
+		decode->name = prefetch->fileName;
+		decode->decoder = imageLoaders[ loader ].ImageDecoder;
+		decode->buffer = buffer.b;
+		numPrefetchImages++;
+	}
 
-		// Load
-		imageLoaders[ i ].ImageLoader( altName, numLevels, pic );
+	R_DecodeImages( prefetchDecodes, numPrefetchImages );
+
+	// the files are in temp memory, free them in reverse order
+	for ( i = numPrefetchImages - 1; i >= 0; i-- ) {
+		ri.FS_FreeFile( (void *)prefetchDecodes[ i ].buffer );
+		prefetchDecodes[ i ].buffer = NULL;
+	}
+}
+
+/*
+=================
+R_FreePrefetchedImages
+
+Frees the prefetched images R_LoadImage didn't take
+=================
+*/
+void R_FreePrefetchedImages( void )
+{
+	int i;
+
+	for ( i = 0; i < numPrefetchImages; i++ ) {
+		if ( prefetchDecodes[ i ].pic ) {
+			ri.Free( prefetchDecodes[ i ].pic );
+			prefetchDecodes[ i ].pic = NULL;
+		}
+	}
+
+	numPrefetchImages = 0;
+}
+
+/*
+=================
+R_TakePrefetchedImage
+
+Returns qfalse if name wasn't prefetched or failed to decode without an
+error, in which case R_LoadImage goes on to try the other formats
+=================
+*/
+static qboolean R_TakePrefetchedImage( const char *name, int *numLevels, textureLevel_t **pic )
+{
+	prefetchImage_t	*prefetch;
+	imageDecode_t	*decode;
+	int i;
+
+	for ( i = 0; i < numPrefetchImages; i++ ) {
+		prefetch = &prefetchImages[ i ];
+		decode = &prefetchDecodes[ i ];
+
+		if ( strcmp( name, prefetch->name ) ) {
+			continue;
+		}
+
+		prefetch->name[ 0 ] = '\0';
+
+		if ( decode->error[ 0 ] ) {
+			char error[ MAX_STRING_CHARS ];
+
+			Q_strncpyz( error, decode->error, sizeof ( error ) );
+			R_FreePrefetchedImages();
+			ri.Error( ERR_DROP, "%s", error );
+		}
+
+		if ( !decode->pic ) {
+			return qfalse;
+		}
+
+		if ( prefetch->orgNameFailed ) {
+			ri.Printf( PRINT_DEVELOPER, "WARNING: %s not present, using %s instead\n",
+					name, prefetch->fileName );
+		}
+
+		*numLevels = decode->numLevels;
+		*pic = decode->pic;
+		decode->pic = NULL;
+		return qtrue;
+	}
+
+	return qfalse;
+}
+
+/*
+=================
+R_LoadImage
+
+Loads any of the supported image types into a canonical
+32 bit format.
+=================
+*/
+void R_LoadImage( const char *name, int *numLevels, textureLevel_t **pic )
+{
+	char fileName[ MAX_QPATH ];
+	qboolean orgNameFailed;
+	int loader, checksum;
+
+	*pic = NULL;
+	*numLevels = 0;
+
+	if ( R_TakePrefetchedImage( name, numLevels, pic ) ) {
+		return;
+	}
+
+	// Load the files in the order of preference until one loads
+	for( loader = R_FindImageLoader( name, -1, fileName, sizeof ( fileName ), &orgNameFailed, &checksum );
+		loader >= 0;
+		loader = R_FindImageLoader( name, loader, fileName, sizeof ( fileName ), &orgNameFailed, &checksum ) )
+	{
+		imageLoaders[ loader ].ImageLoader( fileName, numLevels, pic );
 
 		if( *pic )
 		{
 			if( orgNameFailed )
 			{
 				ri.Printf( PRINT_DEVELOPER, "WARNING: %s not present, using %s instead\n",
-						name, altName );
+						name, fileName );
 			}
 
 			break;
@@ -1120,6 +1545,21 @@ void R_LoadImage( const char *name, int *numLevels, textureLevel_t **pic )
 }
 
 
+/*
+=================
+R_FindImageSource
+
+Finds the file R_LoadImage would load and the checksum of the pk3 it is in
+=================
+*/
+qboolean R_FindImageSource( const char *name, char *sourceName, int sourceNameSize, int *checksum )
+{
+	qboolean orgNameFailed;
+
+	return R_FindImageLoader( name, -1, sourceName, sourceNameSize, &orgNameFailed, checksum ) >= 0;
+}
+
+
 /*
 ===============
 R_FindImageFile
@@ -1131,8 +1571,6 @@ Returns NULL if it fails, not a default image.
 image_t	*R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
 {
 	image_t	*image;
-	int	numLevels;
-	textureLevel_t	*pic;
 	long	hash;
 
 	if (!name) {
@@ -1156,6 +1594,47 @@ image_t	*R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
 		}
 	}
 
+	// create a placeholder if the image is loaded when it's needed
+	image = R_CreateStreamImage( name, type, flags );
+	if ( image ) {
+		return image;
+	}
+
+	return R_LoadImageFile( name, type, flags, NULL );
+}
+
+/*
+===============
+R_LoadImageFile
+
+Loads the given image into image, or into a new image if it's NULL.
+Returns NULL if it fails.
+==============
+*/
+image_t *R_LoadImageFile( const char *name, imgType_t type, imgFlags_t flags, image_t *image )
+{
+	int	numLevels;
+	textureLevel_t	*pic;
+	image_t	*cachedImage;
+	imageCacheKey_t	cacheKey;
+	qboolean	useCache;
+	int		startTime;
+
+	startTime = ri.Milliseconds();
+
+	//
+	// try the already processed image from the cache
+	//
+	useCache = R_ImageCacheKey( name, type, flags, &cacheKey );
+	if ( useCache ) {
+		cachedImage = R_LoadCachedImage( name, type, flags, &cacheKey, image );
+		if ( cachedImage ) {
+			tr.imageWarmLoads++;
+			tr.imageWarmMsec += ri.Milliseconds() - startTime;
+			return cachedImage;
+		}
+	}
+
 	//
 	// load the pic from disk
 	//
@@ -1169,8 +1648,19 @@ image_t	*R_FindImageFile( const char *name, imgType_t type, imgFlags_t flags )
 		R_ProcessLightmap( (byte**)&pic[0].data, 4, pic[0].width, pic[0].height, (byte**)&pic[0].data );
 	}
 
-	image = R_CreateImage2( ( char * ) name, numLevels, pic, type, flags, 0 );
+	if ( image ) {
+		R_UploadImage( image, numLevels, pic, 0 );
+	} else {
+		image = R_CreateImage2( ( char * ) name, numLevels, pic, type, flags, 0 );
+	}
 	ri.Free( pic );
+
+	if ( useCache ) {
+		R_SaveCachedImage( image, &cacheKey );
+	}
+
+	tr.imageColdLoads++;
+	tr.imageColdMsec += ri.Milliseconds() - startTime;
 	return image;
 }
 
@@ -1537,6 +2027,8 @@ void R_SetColorMappings( void ) {
 	{
 		GLimp_SetGamma( s_gammatable, s_gammatable, s_gammatable );
 	}
+
+	R_SetImageCacheSettings( glConfig.deviceSupportsGamma ? NULL : s_gammatable, s_intensitytable );
 }
 
 /*
@@ -1568,6 +2060,9 @@ void R_DeleteTextures( void ) {
 
 	tr.numImages = 0;
 
+	R_ClearStreamImages();
+	R_FreePrefetchedImages();
+
 	Com_Memset( glState.currenttextures, 0, sizeof( glState.currenttextures ) );
 	if ( qglActiveTextureARB ) {
 		GL_SelectTexture( 1 );
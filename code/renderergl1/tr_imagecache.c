@@ -0,0 +1,348 @@
+/*
+===========================================================================
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of Spearmint Source Code.
+
+Spearmint Source Code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 3 of the License,
+or (at your option) any later version.
+
+Spearmint Source Code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Spearmint Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, Spearmint Source Code is also subject to certain additional terms.
+You should have received a copy of these additional terms immediately following
+the terms and conditions of the GNU General Public License.  If not, please
+request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional
+terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc.,
+Suite 120, Rockville, Maryland 20850 USA.
+===========================================================================
+*/
+// tr_imagecache.c -- on disk cache of processed textures
+#include "tr_local.h"
+
+/*
+
+Images found by R_FindImageFile go through resampling, picmip, light
+scaling and mipmapping before upload, and the driver may compress them
+too. With r_imageCache enabled the finished mip chain is read back from
+OpenGL and written to imagecache/ in the homepath as a DDS file. The next
+time the image is loaded (vid_restart, map change, next session) the levels
+are uploaded directly, skipping the decoder and all the processing.
+
+Only images from pk3 files are cached. The file name includes a hash of the
+image type, flags and picmip, so an image registered more than one way gets
+a file for each. The key in the header also covers the pk3 checksum, the
+source file name and any settings that change the result, so a stale entry
+is simply overwritten. Entries that don't pass R_CheckDDS are reloaded from
+the source image.
+
+*/
+
+#define IMAGECACHE_IDENT	(('C'<<24)+('G'<<16)+('M'<<8)+'I')
+#define IMAGECACHE_VERSION	1
+
+typedef struct {
+	int			ident;
+	int			version;
+	int			key;
+	int			internalFormat;
+	int			width, height;		// source image
+	int			ddsLength;
+} imageCacheHeader_t;
+
+/*
+================
+R_ImageCacheHash
+================
+*/
+static unsigned R_ImageCacheHash( unsigned hash, const void *data, int length ) {
+	const byte *p = data;
+	int i;
+
+	// FNV-1a
+	for ( i = 0; i < length; i++ ) {
+		hash = ( hash ^ p[i] ) * 16777619;
+	}
+
+	return hash;
+}
+
+/*
+================
+R_SetImageCacheSettings
+
+Called when the light scale tables change, gammaTable is NULL if it isn't
+applied to images
+================
+*/
+void R_SetImageCacheSettings( const byte *gammaTable, const byte *intensityTable ) {
+	unsigned	key;
+	int			settings[6];
+
+	settings[0] = r_greyscale->value * 255;
+	settings[1] = r_texturebits->integer;
+	settings[2] = r_roundImagesDown->integer;
+	settings[3] = r_simpleMipMaps->integer;
+	settings[4] = glConfig.textureCompression;
+	settings[5] = glConfig.maxTextureSize;
+
+	key = 2166136261u;
+	key = R_ImageCacheHash( key, settings, sizeof ( settings ) );
+	key = R_ImageCacheHash( key, intensityTable, 256 );
+	if ( gammaTable ) {
+		key = R_ImageCacheHash( key, gammaTable, 256 );
+	}
+
+	tr.imageSettingsKey = key;
+}
+
+/*
+================
+R_ImageCacheKey
+
+Returns qfalse if the image shouldn't be cached
+================
+*/
+qboolean R_ImageCacheKey( const char *name, imgType_t type, imgFlags_t flags, imageCacheKey_t *cacheKey ) {
+	char	sourceName[MAX_QPATH];
+	char	strippedName[MAX_QPATH];
+	int		checksum;
+	unsigned	key, variant;
+	int		picmip;
+
+	if ( !r_imageCache->integer || r_colorMipLevels->integer ) {
+		return qfalse;
+	}
+
+	// can't read back textures from OpenGL ES
+	if ( !qglGetTexImage ) {
+		return qfalse;
+	}
+
+	// lightmaps are processed depending on the map
+	if ( flags & IMGFLAG_LIGHTMAP ) {
+		return qfalse;
+	}
+
+	if ( !R_FindImageSource( name, sourceName, sizeof ( sourceName ), &checksum ) ) {
+		return qfalse;
+	}
+
+	// loose files may change at any time and dds files are already processed
+	if ( !checksum || !Q_stricmp( COM_GetExtension( sourceName ), "dds" ) ) {
+		return qfalse;
+	}
+
+	if ( flags & IMGFLAG_PICMIP2 )
+		picmip = r_picmip2->integer;
+	else if ( flags & IMGFLAG_PICMIP )
+		picmip = r_picmip->integer;
+	else
+		picmip = 0;
+
+	// registrations of the same image that are processed differently
+	variant = 2166136261u;
+	variant = R_ImageCacheHash( variant, &type, sizeof ( type ) );
+	variant = R_ImageCacheHash( variant, &flags, sizeof ( flags ) );
+	variant = R_ImageCacheHash( variant, &picmip, sizeof ( picmip ) );
+
+	key = 2166136261u;
+	key = R_ImageCacheHash( key, &checksum, sizeof ( checksum ) );
+	key = R_ImageCacheHash( key, sourceName, strlen( sourceName ) );
+	key = R_ImageCacheHash( key, &variant, sizeof ( variant ) );
+	key = R_ImageCacheHash( key, &tr.imageSettingsKey, sizeof ( tr.imageSettingsKey ) );
+
+	COM_StripExtension( name, strippedName, sizeof ( strippedName ) );
+	Com_sprintf( cacheKey->path, sizeof ( cacheKey->path ), "imagecache/%s_%08x.dds", strippedName, variant );
+	cacheKey->key = key;
+
+	return qtrue;
+}
+
+/*
+================
+R_LoadCachedImage
+
+Loads the cached image into image, or into a new image if it's NULL
+================
+*/
+image_t *R_LoadCachedImage( const char *name, imgType_t type, imgFlags_t flags, imageCacheKey_t *cacheKey, image_t *image ) {
+	union {
+		byte *b;
+		void *v;
+	} buffer;
+	imageCacheHeader_t	header;
+	textureLevel_t		*pic;
+	int					numLevels;
+	int					length;
+
+	cacheKey->writable = qtrue;
+
+	length = ri.FS_ReadFile( cacheKey->path, &buffer.v );
+	if ( !buffer.b ) {
+		// files outside of pk3s can't be read on pure servers, don't keep rewriting it
+		if ( ri.FS_FileExists( cacheKey->path ) ) {
+			cacheKey->writable = qfalse;
+		}
+		return NULL;
+	}
+
+	if ( length < sizeof ( header ) ) {
+		ri.FS_FreeFile( buffer.v );
+		return NULL;
+	}
+
+	Com_Memcpy( &header, buffer.b, sizeof ( header ) );
+	header.ident = LittleLong( header.ident );
+	header.version = LittleLong( header.version );
+	header.key = LittleLong( header.key );
+	header.internalFormat = LittleLong( header.internalFormat );
+	header.width = LittleLong( header.width );
+	header.height = LittleLong( header.height );
+	header.ddsLength = LittleLong( header.ddsLength );
+
+	if ( header.ident != IMAGECACHE_IDENT || header.version != IMAGECACHE_VERSION
+		|| header.key != cacheKey->key || header.ddsLength != length - sizeof ( header ) ) {
+		ri.FS_FreeFile( buffer.v );
+		return NULL;
+	}
+
+	// R_LoadDDSFromBuffer drops to the menu on a bad file
+	if ( header.width <= 0 || header.height <= 0 || !R_CheckDDS( buffer.b + sizeof ( header ), header.ddsLength ) ) {
+		ri.Printf( PRINT_DEVELOPER, "WARNING: corrupt image cache file %s, loading %s\n", cacheKey->path, name );
+		ri.FS_FreeFile( buffer.v );
+		return NULL;
+	}
+
+	R_LoadDDSFromBuffer( cacheKey->path, buffer.b + sizeof ( header ), header.ddsLength, &numLevels, &pic );
+	ri.FS_FreeFile( buffer.v );
+
+	if ( !pic ) {
+		return NULL;
+	}
+
+	if ( image ) {
+		R_UploadImage( image, numLevels, pic, header.internalFormat );
+	} else {
+		image = R_CreateImage2( name, numLevels, pic, type, flags, header.internalFormat );
+	}
+	image->width = header.width;
+	image->height = header.height;
+	ri.Free( pic );
+
+	return image;
+}
+
+/*
+================
+R_SaveCachedImage
+
+Reads the uploaded mip chain back from OpenGL and writes it to the cache
+================
+*/
+void R_SaveCachedImage( image_t *image, const imageCacheKey_t *cacheKey ) {
+	textureLevel_t		pic[32];
+	imageCacheHeader_t	*header;
+	byte		*dds, *data;
+	int			numLevels, i;
+	int			size, ddsLength;
+	qboolean	compressed;
+	GLint		width, height, compressedSize;
+
+	if ( !cacheKey->writable ) {
+		return;
+	}
+
+	switch ( image->internalFormat ) {
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+			compressed = qtrue;
+			break;
+		default:
+			compressed = qfalse;
+			break;
+	}
+
+	if ( compressed && !qglGetCompressedTexImageARB ) {
+		return;
+	}
+
+	if ( qglActiveTextureARB ) {
+		GL_SelectTexture( image->TMU );
+	}
+
+	GL_Bind( image );
+
+	// count levels and size
+	numLevels = 0;
+	size = 0;
+	do {
+		qglGetTexLevelParameteriv( GL_TEXTURE_2D, numLevels, GL_TEXTURE_WIDTH, &width );
+		qglGetTexLevelParameteriv( GL_TEXTURE_2D, numLevels, GL_TEXTURE_HEIGHT, &height );
+
+		if ( compressed ) {
+			qglGetTexLevelParameteriv( GL_TEXTURE_2D, numLevels, GL_TEXTURE_COMPRESSED_IMAGE_SIZE_ARB, &compressedSize );
+			pic[numLevels].format = image->internalFormat;
+			pic[numLevels].size = compressedSize;
+		} else {
+			pic[numLevels].format = GL_RGBA8;
+			pic[numLevels].size = width * height * 4;
+		}
+
+		pic[numLevels].width = width;
+		pic[numLevels].height = height;
+		size += pic[numLevels].size;
+		numLevels++;
+	} while ( ( image->flags & IMGFLAG_MIPMAP ) && ( width > 1 || height > 1 ) && numLevels < ARRAY_LEN( pic ) );
+
+	data = ri.Hunk_AllocateTempMemory( size );
+
+	for ( i = 0, size = 0; i < numLevels; i++ ) {
+		pic[i].data = data + size;
+		size += pic[i].size;
+
+		if ( compressed ) {
+			qglGetCompressedTexImageARB( GL_TEXTURE_2D, i, pic[i].data );
+		} else {
+			qglGetTexImage( GL_TEXTURE_2D, i, GL_RGBA, GL_UNSIGNED_BYTE, pic[i].data );
+		}
+	}
+
+	if ( qglGetError() == GL_NO_ERROR ) {
+		ddsLength = R_WriteDDS( &dds, numLevels, pic );
+	} else {
+		ddsLength = 0;
+	}
+
+	ri.Hunk_FreeTempMemory( data );
+
+	if ( !ddsLength ) {
+		return;
+	}
+
+	// the cache header goes in front of the dds file
+	header = ri.Malloc( sizeof ( *header ) + ddsLength );
+	header->ident = LittleLong( IMAGECACHE_IDENT );
+	header->version = LittleLong( IMAGECACHE_VERSION );
+	header->key = LittleLong( cacheKey->key );
+	header->internalFormat = LittleLong( image->internalFormat );
+	header->width = LittleLong( image->width );
+	header->height = LittleLong( image->height );
+	header->ddsLength = LittleLong( ddsLength );
+	Com_Memcpy( header + 1, dds, ddsLength );
+	ri.Free( dds );
+
+	ri.FS_WriteFile( cacheKey->path, header, sizeof ( *header ) + ddsLength );
+
+	ri.Free( header );
+}
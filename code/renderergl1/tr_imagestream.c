@@ -0,0 +1,282 @@
+/*
+===========================================================================
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of Spearmint Source Code.
+
+Spearmint Source Code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 3 of the License,
+or (at your option) any later version.
+
+Spearmint Source Code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Spearmint Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, Spearmint Source Code is also subject to certain additional terms.
+You should have received a copy of these additional terms immediately following
+the terms and conditions of the GNU General Public License.  If not, please
+request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional
+terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc.,
+Suite 120, Rockville, Maryland 20850 USA.
+===========================================================================
+*/
+// tr_imagestream.c -- loading world and model textures when they are needed
+#include "tr_local.h"
+
+/*
+
+With r_streamImages enabled, R_FindImageFile doesn't load mipmapped images
+(world and model textures) during registration. The image is created with a
+grey placeholder texture and added to the stream queue, so map loading only
+parses shaders and the first frame is drawn right away.
+
+At the start of each frame R_StreamImages loads queued images until
+r_streamImageMsec is used up, decoding a batch of them on the worker threads
+at a time. Images of world surfaces that were in view last
+frame go first, closest surface first, as requested by R_AddWorldSurface.
+Next are images bound last frame by anything else, such as models, then the
+rest in the order they were registered. The image keeps its texture name, so
+shaders don't change when the real texture replaces the placeholder.
+
+*/
+
+static image_t	*streamImages[MAX_DRAWIMAGES];	// in the order they were registered
+static int		numStreamImages;
+
+/*
+================
+R_CreateStreamImage
+
+Returns a placeholder image that is loaded later, or NULL if the image should
+be loaded right away
+================
+*/
+image_t *R_CreateStreamImage( const char *name, imgType_t type, imgFlags_t flags ) {
+	static byte	placeholder[4] = { 128, 128, 128, 255 };
+	char		sourceName[MAX_QPATH];
+	int			checksum;
+	image_t		*image;
+
+	if ( !r_streamImages->integer ) {
+		return NULL;
+	}
+
+	// 2D pics, lightmaps, and normal maps are needed as is
+	if ( !( flags & IMGFLAG_MIPMAP ) || ( flags & IMGFLAG_LIGHTMAP ) || type != IMGTYPE_COLORALPHA ) {
+		return NULL;
+	}
+
+	// missing images still fail during registration
+	if ( !R_FindImageSource( name, sourceName, sizeof ( sourceName ), &checksum ) ) {
+		return NULL;
+	}
+
+	image = R_CreateImage( name, placeholder, 1, 1, type, flags, 0 );
+	image->pending = qtrue;
+	image->requestFrame = 0;
+	image->frameUsed = 0;
+
+	streamImages[numStreamImages++] = image;
+
+	return image;
+}
+
+/*
+================
+R_ClearStreamImages
+================
+*/
+void R_ClearStreamImages( void ) {
+	numStreamImages = 0;
+}
+
+/*
+================
+R_NumStreamImages
+================
+*/
+int R_NumStreamImages( void ) {
+	return numStreamImages;
+}
+
+/*
+================
+R_RequestShaderImages
+
+Called for shaders of visible world surfaces with the distance to the surface,
+clears pendingImages once none of the images are pending
+================
+*/
+void R_RequestShaderImages( shader_t *shader, float distance ) {
+	shaderStage_t	*stage;
+	image_t		*image;
+	qboolean	pending;
+	int			i, b, j, numImages;
+
+	pending = qfalse;
+
+	for ( i = 0; i < MAX_SHADER_STAGES && shader->stages[i]; i++ ) {
+		stage = shader->stages[i];
+
+		for ( b = 0; b < NUM_TEXTURE_BUNDLES; b++ ) {
+			numImages = MAX( stage->bundle[b].numImageAnimations, 1 );
+
+			for ( j = 0; j < numImages; j++ ) {
+				image = stage->bundle[b].image[j];
+
+				if ( !image || !image->pending ) {
+					continue;
+				}
+
+				if ( image->requestFrame != tr.frameCount || distance < image->requestDistance ) {
+					image->requestDistance = distance;
+				}
+				image->requestFrame = tr.frameCount;
+				pending = qtrue;
+			}
+		}
+	}
+
+	if ( shader->isSky ) {
+		for ( i = 0; i < 6; i++ ) {
+			image = shader->sky.outerbox[i];
+			if ( image && image->pending ) {
+				image->requestFrame = tr.frameCount;
+				image->requestDistance = 0;
+				pending = qtrue;
+			}
+
+			image = shader->sky.innerbox[i];
+			if ( image && image->pending ) {
+				image->requestFrame = tr.frameCount;
+				image->requestDistance = 0;
+				pending = qtrue;
+			}
+		}
+	}
+
+	shader->pendingImages = pending;
+}
+
+/*
+================
+R_StreamImagePriority
+
+Lower is loaded first
+================
+*/
+static int R_StreamImagePriority( const image_t *image ) {
+	// called after tr.frameCount was incremented for the new frame
+	if ( image->requestFrame > 0 && image->requestFrame >= tr.frameCount - 1 ) {
+		return 0;
+	}
+
+	if ( image->frameUsed > 0 && image->frameUsed >= tr.frameCount - 1 ) {
+		return 1;
+	}
+
+	return 2;
+}
+
+/*
+================
+R_NextStreamImage
+
+Removes the image to load next from the queue
+================
+*/
+static image_t *R_NextStreamImage( void ) {
+	image_t	*image;
+	int		i, best, priority, bestPriority;
+
+	best = 0;
+	bestPriority = R_StreamImagePriority( streamImages[0] );
+
+	for ( i = 1; i < numStreamImages && bestPriority > 0; i++ ) {
+		priority = R_StreamImagePriority( streamImages[i] );
+
+		if ( priority < bestPriority ) {
+			best = i;
+			bestPriority = priority;
+		}
+	}
+
+	// closest of the images in view
+	for ( ; i < numStreamImages; i++ ) {
+		if ( R_StreamImagePriority( streamImages[i] ) == 0
+			&& streamImages[i]->requestDistance < streamImages[best]->requestDistance ) {
+			best = i;
+		}
+	}
+
+	image = streamImages[best];
+	numStreamImages--;
+	memmove( &streamImages[best], &streamImages[best + 1], ( numStreamImages - best ) * sizeof ( image_t * ) );
+
+	return image;
+}
+
+/*
+================
+R_StreamImages
+
+Loads pending images until r_streamImageMsec is used up. Images are decoded
+on the worker threads a batch at a time, at least one batch is loaded each
+frame.
+================
+*/
+void R_StreamImages( void ) {
+	image_t		*batch[MAX_PREFETCH_IMAGES];
+	const char	*names[MAX_PREFETCH_IMAGES];
+	imageCacheKey_t	cacheKey;
+	int			startTime;
+	int			i, numBatch, maxBatch, numNames;
+
+	if ( !numStreamImages ) {
+		return;
+	}
+
+	R_IssuePendingRenderCommands();
+
+	startTime = ri.Milliseconds();
+
+	// an image per thread
+	maxBatch = MIN( R_NumWorkerThreads(), MAX_PREFETCH_IMAGES );
+
+	do {
+		numBatch = 0;
+		numNames = 0;
+
+		while ( numStreamImages && numBatch < maxBatch ) {
+			batch[numBatch] = R_NextStreamImage();
+
+			// cached images aren't decoded
+			if ( !R_ImageCacheKey( batch[numBatch]->imgName, batch[numBatch]->type, batch[numBatch]->flags, &cacheKey )
+				|| !ri.FS_FileExists( cacheKey.path ) ) {
+				names[numNames++] = batch[numBatch]->imgName;
+			}
+
+			numBatch++;
+		}
+
+		// still pending so they are prefetched
+		R_PrefetchImages( names, numNames );
+
+		for ( i = 0; i < numBatch; i++ ) {
+			batch[i]->pending = qfalse;
+
+			if ( !R_LoadImageFile( batch[i]->imgName, batch[i]->type, batch[i]->flags, batch[i] ) ) {
+				ri.Printf( PRINT_WARNING, "WARNING: couldn't stream image %s\n", batch[i]->imgName );
+			}
+		}
+	} while ( numStreamImages && ri.Milliseconds() - startTime < r_streamImageMsec->integer );
+
+	R_FreePrefetchedImages();
+}
@@ -49,6 +49,7 @@ cvar_t  *com_altivec;
 cvar_t	*r_flareSize;
 cvar_t	*r_flareFade;
 cvar_t	*r_flareCoeff;
+cvar_t	*r_flareOcclusionQuery;
 
 cvar_t	*r_ignoreFastPath;
 
@@ -160,6 +161,9 @@ cvar_t	*r_mapOverBrightBits;
 
 cvar_t	*r_debugSurface;
 cvar_t	*r_simpleMipMaps;
+cvar_t	*r_imageCache;
+cvar_t	*r_streamImages;
+cvar_t	*r_streamImageMsec;
 
 cvar_t	*r_showImages;
 
@@ -171,6 +175,9 @@ cvar_t	*r_printShaders;
 cvar_t	*r_saveFontData;
 cvar_t	*r_fontBorderWidth;
 cvar_t	*r_fontForceAutoHint;
+cvar_t	*r_fontCache;
+
+cvar_t	*r_shaderCache;
 
 cvar_t	*r_marksOnTriangleMeshes;
 cvar_t	*r_marksOnBrushModels;
@@ -814,81 +821,166 @@ void R_ScreenShotPNG_f (void) {
 
 //============================================================================
 
+/*
+==================
+RB_HandOverVideoFrame
+
+Passes a frame read back from the framebuffer to the client for encoding,
+removing line padding and gamma correcting on the way
+==================
+*/
+static void RB_HandOverVideoFrame( const byte *pixels, int width, int height, int padlen )
+{
+	byte	*frame;
+	int		linelen, y;
+
+	frame = ri.CL_BeginAVIVideoFrame( width, height );
+	if ( !frame ) {
+		return;
+	}
+
+	linelen = width * 3;
+
+	for ( y = 0; y < height; y++ ) {
+		Com_Memcpy( frame, pixels, linelen );
+
+		// gamma correct
+		if ( glConfig.deviceSupportsGamma ) {
+			R_GammaCorrect( frame, linelen );
+		}
+
+		frame += linelen;
+		pixels += linelen + padlen;
+	}
+
+	ri.CL_EndAVIVideoFrame();
+}
+
+/*
+==================
+RB_FinishVideoReadback
+==================
+*/
+static void RB_FinishVideoReadback( videoReadback_t *readback )
+{
+	const byte	*pixels;
+
+	if ( !readback->pending ) {
+		return;
+	}
+
+	readback->pending = qfalse;
+
+	qglBindBuffer( GL_PIXEL_PACK_BUFFER, readback->pbo );
+
+	pixels = qglMapBufferRange( GL_PIXEL_PACK_BUFFER, 0, readback->size, GL_MAP_READ_BIT );
+	if ( pixels ) {
+		RB_HandOverVideoFrame( pixels, readback->width, readback->height, readback->padlen );
+		qglUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+	}
+
+	qglBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+}
+
+/*
+==================
+RB_FinishVideoFrames
+
+Hands over the frames that are still being read back, oldest first
+==================
+*/
+void RB_FinishVideoFrames( void )
+{
+	int		i;
+
+	for ( i = 0; i < NUM_VIDEO_READBACKS; i++ ) {
+		RB_FinishVideoReadback( &backEnd.videoReadbacks[( backEnd.nextVideoReadback + i ) % NUM_VIDEO_READBACKS] );
+	}
+}
+
+/*
+==================
+R_ShutdownVideoReadback
+
+Frames that are still being read back are dropped
+==================
+*/
+void R_ShutdownVideoReadback( void )
+{
+	int		i;
+
+	for ( i = 0; i < NUM_VIDEO_READBACKS; i++ ) {
+		if ( backEnd.videoReadbacks[i].pbo ) {
+			qglDeleteBuffers( 1, &backEnd.videoReadbacks[i].pbo );
+		}
+	}
+
+	Com_Memset( backEnd.videoReadbacks, 0, sizeof( backEnd.videoReadbacks ) );
+	backEnd.nextVideoReadback = 0;
+}
+
 /*
 ==================
 RB_TakeVideoFrameCmd
+
+With pixel buffer objects glReadPixels returns right away and the frame is
+handed to the client when the buffer comes around again, by which time the
+copy has long finished.
 ==================
 */
 const void *RB_TakeVideoFrameCmd( const void *data )
 {
 	const videoFrameCommand_t	*cmd;
-	byte				*cBuf;
-	size_t				memcount, linelen;
-	int				padwidth, avipadwidth, padlen, avipadlen;
-	GLint packAlign;
-	
+	videoReadback_t		*readback;
+	byte				*buffer;
+	size_t				offset, memcount;
+	int					padwidth, padlen;
+	GLint				packAlign;
+
 	cmd = (const videoFrameCommand_t *)data;
-	
-	qglGetIntegerv(GL_PACK_ALIGNMENT, &packAlign);
 
-	linelen = cmd->width * 3;
+	if ( !qglBindBuffer || !qglMapBufferRange ) {
+		offset = 0;
+		buffer = RB_ReadPixels( 0, 0, cmd->width, cmd->height, &offset, &padlen );
+		RB_HandOverVideoFrame( buffer + offset, cmd->width, cmd->height, padlen );
+		ri.Hunk_FreeTempMemory( buffer );
 
-	// Alignment stuff for glReadPixels
-	padwidth = PAD(linelen, packAlign);
-	padlen = padwidth - linelen;
-	// AVI line padding
-	avipadwidth = PAD(linelen, AVI_LINE_PADDING);
-	avipadlen = avipadwidth - linelen;
+		return (const void *)(cmd + 1);
+	}
 
-	cBuf = PADP(cmd->captureBuffer, packAlign);
-		
-	qglReadPixels(0, 0, cmd->width, cmd->height, GL_RGB,
-		GL_UNSIGNED_BYTE, cBuf);
+	qglGetIntegerv( GL_PACK_ALIGNMENT, &packAlign );
 
+	padwidth = PAD( cmd->width * 3, packAlign );
+	padlen = padwidth - cmd->width * 3;
 	memcount = padwidth * cmd->height;
 
-	// gamma correct
-	if(glConfig.deviceSupportsGamma)
-		R_GammaCorrect(cBuf, memcount);
+	readback = &backEnd.videoReadbacks[backEnd.nextVideoReadback];
+	backEnd.nextVideoReadback = ( backEnd.nextVideoReadback + 1 ) % NUM_VIDEO_READBACKS;
 
-	if(cmd->motionJpeg)
-	{
-		memcount = RE_SaveJPGToBuffer(cmd->encodeBuffer, linelen * cmd->height,
-			r_aviMotionJpegQuality->integer,
-			cmd->width, cmd->height, cBuf, padlen);
-		ri.CL_WriteAVIVideoFrame(cmd->encodeBuffer, memcount);
+	// hand over the frame from the last time this buffer was used
+	RB_FinishVideoReadback( readback );
+
+	if ( !readback->pbo ) {
+		qglGenBuffers( 1, &readback->pbo );
 	}
-	else
-	{
-		byte *lineend, *memend;
-		byte *srcptr, *destptr;
-	
-		srcptr = cBuf;
-		destptr = cmd->encodeBuffer;
-		memend = srcptr + memcount;
-		
-		// swap R and B and remove line paddings
-		while(srcptr < memend)
-		{
-			lineend = srcptr + linelen;
-			while(srcptr < lineend)
-			{
-				*destptr++ = srcptr[2];
-				*destptr++ = srcptr[1];
-				*destptr++ = srcptr[0];
-				srcptr += 3;
-			}
-			
-			Com_Memset(destptr, '\0', avipadlen);
-			destptr += avipadlen;
-			
-			srcptr += padlen;
-		}
-		
-		ri.CL_WriteAVIVideoFrame(cmd->encodeBuffer, avipadwidth * cmd->height);
+
+	qglBindBuffer( GL_PIXEL_PACK_BUFFER, readback->pbo );
+
+	if ( readback->size != memcount ) {
+		qglBufferData( GL_PIXEL_PACK_BUFFER, memcount, NULL, GL_STREAM_READ );
+		readback->size = memcount;
 	}
 
-	return (const void *)(cmd + 1);	
+	qglReadPixels( 0, 0, cmd->width, cmd->height, GL_RGB, GL_UNSIGNED_BYTE, NULL );
+
+	qglBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+
+	readback->pending = qtrue;
+	readback->width = cmd->width;
+	readback->height = cmd->height;
+	readback->padlen = padlen;
+
+	return (const void *)(cmd + 1);
 }
 
 //============================================================================
@@ -1113,6 +1205,9 @@ void R_Register( void )
 	r_customwidth = ri.Cvar_Get( "r_customwidth", "1600", CVAR_ARCHIVE | CVAR_LATCH );
 	r_customheight = ri.Cvar_Get( "r_customheight", "1024", CVAR_ARCHIVE | CVAR_LATCH );
 	r_simpleMipMaps = ri.Cvar_Get( "r_simpleMipMaps", "1", CVAR_ARCHIVE | CVAR_LATCH );
+	r_imageCache = ri.Cvar_Get( "r_imageCache", "0", CVAR_ARCHIVE | CVAR_LATCH );
+	r_streamImages = ri.Cvar_Get( "r_streamImages", "0", CVAR_ARCHIVE | CVAR_LATCH );
+	r_streamImageMsec = ri.Cvar_Get( "r_streamImageMsec", "4", CVAR_ARCHIVE );
 	r_vertexLight = ri.Cvar_Get( "r_vertexLight", "0", CVAR_ARCHIVE | CVAR_LATCH );
 	r_subdivisions = ri.Cvar_Get ("r_subdivisions", "4", CVAR_ARCHIVE | CVAR_LATCH);
 	r_stereoEnabled = ri.Cvar_Get( "r_stereoEnabled", "0", CVAR_ARCHIVE | CVAR_LATCH);
@@ -1138,6 +1233,7 @@ void R_Register( void )
 	r_defaultFogParmsType = ri.Cvar_Get ("r_defaultfogParmsType", "exp", CVAR_LATCH );
 	r_globalLinearFogDrawSky = ri.Cvar_Get ("r_globalLinearFogDrawSky", "1", 0 );
 	r_shadersDirectory = ri.Cvar_Get( "r_shadersDirectory", "scripts", CVAR_LATCH );
+	r_shaderCache = ri.Cvar_Get( "r_shaderCache", "1", CVAR_ARCHIVE | CVAR_LATCH );
 	r_surfaceFlagNoDraw = ri.Cvar_Get( "r_surfaceFlagNoDraw", "128", CVAR_LATCH ); // Q3's SURF_NODRAW (0x80)
 	r_colorize2DIdentity = ri.Cvar_Get( "r_colorize2DIdentity", "0", CVAR_LATCH );
 	r_missingLightmapUseDiffuseLighting = ri.Cvar_Get( "r_missingLightmapUseDiffuseLighting", "0", CVAR_LATCH );
@@ -1185,6 +1281,7 @@ void R_Register( void )
 	r_saveFontData = ri.Cvar_Get( "r_saveFontData", "0", 0 );
 	r_fontBorderWidth = ri.Cvar_Get( "r_fontBorderWidth", "0", 0 );
 	r_fontForceAutoHint = ri.Cvar_Get( "r_fontForceAutoHint", "0", 0 );
+	r_fontCache = ri.Cvar_Get( "r_fontCache", "1", CVAR_ARCHIVE );
 
 	r_nocurves = ri.Cvar_Get ("r_nocurves", "0", CVAR_CHEAT );
 	r_drawworld = ri.Cvar_Get ("r_drawworld", "1", CVAR_CHEAT );
@@ -1196,6 +1293,7 @@ void R_Register( void )
 	r_flareSize = ri.Cvar_Get ("r_flareSize", "40", CVAR_CHEAT);
 	r_flareFade = ri.Cvar_Get ("r_flareFade", "7", CVAR_CHEAT);
 	r_flareCoeff = ri.Cvar_Get ("r_flareCoeff", FLARE_STDCOEFF, CVAR_CHEAT);
+	r_flareOcclusionQuery = ri.Cvar_Get ("r_flareOcclusionQuery", "1", CVAR_ARCHIVE);
 
 	r_skipBackEnd = ri.Cvar_Get ("r_skipBackEnd", "0", CVAR_CHEAT);
 
@@ -1346,6 +1444,8 @@ void R_Init( void ) {
 
 	InitOpenGL();
 
+	R_InitWorkers();
+
 	R_InitImages();
 
 	R_InitShaders();
@@ -1402,11 +1502,15 @@ void RE_Shutdown( qboolean destroyWindow ) {
 
 	if ( tr.registered ) {
 		R_IssuePendingRenderCommands();
+		R_ShutdownVideoReadback();
+		R_ShutdownFlares();
 		R_DeleteTextures();
 	}
 
 	R_DoneFreeType();
 
+	R_ShutdownWorkers();
+
 	// shut down platform specific OpenGL stuff
 	if ( destroyWindow ) {
 		GLimp_Shutdown();
@@ -1482,6 +1586,7 @@ refexport_t *GetRefAPI ( int apiVersion, refimport_t *rimp, qboolean headless )
 
 	re.MarkFragments = R_MarkFragments;
 	re.LerpTag = R_LerpTag;
+	re.LerpTags = R_LerpTags;
 	re.ModelBounds = R_ModelBounds;
 
 	re.ClearScene = RE_ClearScene;
@@ -1513,6 +1618,8 @@ refexport_t *GetRefAPI ( int apiVersion, refimport_t *rimp, qboolean headless )
 	re.inPVS = R_inPVS;
 
 	re.TakeVideoFrame = RE_TakeVideoFrame;
+	re.FinishVideoFrames = RE_FinishVideoFrames;
+	re.SaveJPGToBuffer = RE_SaveJPGToBuffer;
 
 	re.GetGlobalFog = RE_GetGlobalFog;
 	re.GetViewFog = RE_GetViewFog;
@@ -46,7 +46,9 @@ QGL_1_1_PROCS;
 QGL_1_1_FIXED_FUNCTION_PROCS;
 QGL_DESKTOP_1_1_PROCS;
 QGL_DESKTOP_1_1_FIXED_FUNCTION_PROCS;
+QGL_1_5_PROCS;
 QGL_3_0_PROCS;
+QGL_ARB_occlusion_query_PROCS;
 #undef GLE
 #endif
 
@@ -432,6 +434,8 @@ typedef struct shader_s {
 
   struct shader_s *remappedShader;                  // current shader this one is remapped too
 
+	qboolean	pendingImages;			// some images may still need to be streamed
+
 	struct	shader_s	*next;
 } shader_t;
 
@@ -938,6 +942,13 @@ int			R_LerpTag( orientation_t *tag, qhandle_t handle,
 					 qhandle_t torsoFrameModel, int torsoStartFrame,
 					 qhandle_t torsoEndFrameModel, int torsoEndFrame,
 					 float torsoFrac );
+int			R_LerpTags( orientation_t *tags, int maxTags, qhandle_t handle,
+					 qhandle_t frameModel, int startFrame,
+					 qhandle_t endFrameModel, int endFrame,
+					 float frac, const vec3_t *torsoAxis, // vec3_t[3]
+					 qhandle_t torsoFrameModel, int torsoStartFrame,
+					 qhandle_t torsoEndFrameModel, int torsoEndFrame,
+					 float torsoFrac );
 int			R_ModelBounds( qhandle_t handle, vec3_t mins, vec3_t maxs, int startFrame, int endFrame, float frac );
 shader_t	*R_CustomSurfaceShader( const char *surfaceName, qhandle_t customShader, qhandle_t customSkin );
 
@@ -1031,6 +1042,18 @@ typedef struct {
 	int		msec;			// total msec for backend run
 } backEndCounters_t;
 
+// video frames are read back into pixel buffer objects
+// and handed to the client a couple of frames later
+#define NUM_VIDEO_READBACKS 3
+
+typedef struct {
+	GLuint		pbo;
+	size_t		size;
+	qboolean	pending;
+	int			width, height;
+	int			padlen;
+} videoReadback_t;
+
 // all state modified by the back end is separated
 // from the front end state
 typedef struct {
@@ -1046,6 +1069,9 @@ typedef struct {
 	byte		color2D[4];
 	qboolean	vertexes2D;		// shader needs to be finished
 	trRefEntity_t	entity2D;	// currentEntity will point at this when doing 2D rendering
+
+	videoReadback_t	videoReadbacks[NUM_VIDEO_READBACKS];
+	int			nextVideoReadback;
 } backEndState_t;
 
 /*
@@ -1151,6 +1177,11 @@ typedef struct {
 	int						numImages;
 	image_t					*images[MAX_DRAWIMAGES];
 
+	// image file load times, warm loads come from the image cache
+	int						imageColdLoads, imageColdMsec;
+	int						imageWarmLoads, imageWarmMsec;
+	int						imageSettingsKey;		// changes with settings that affect uploaded images
+
 	// shader indexes from other modules will be looked up in tr.shaders[]
 	// shader indexes from drawsurfs will be looked up in sortedShaders[]
 	// lower indexed sortedShaders must be rendered first (opaque surfaces before translucent)
@@ -1187,6 +1218,7 @@ extern cvar_t	*r_flareFade;
 // coefficient for the flare intensity falloff function.
 #define FLARE_STDCOEFF "150"
 extern cvar_t	*r_flareCoeff;
+extern cvar_t	*r_flareOcclusionQuery;	// use occlusion queries instead of reading back depth for flares
 
 extern cvar_t	*r_ignore;				// used for debugging anything
 extern cvar_t	*r_verbose;				// used for verbose debug spew
@@ -1278,6 +1310,9 @@ extern	cvar_t	*r_mapOverBrightBits;
 
 extern	cvar_t	*r_debugSurface;
 extern	cvar_t	*r_simpleMipMaps;
+extern	cvar_t	*r_imageCache;
+extern	cvar_t	*r_streamImages;
+extern	cvar_t	*r_streamImageMsec;
 
 extern	cvar_t	*r_showImages;
 extern	cvar_t	*r_debugSort;
@@ -1437,12 +1472,40 @@ float	R_FogFactor( float s, float t );
 float	R_FogTcScale( fogType_t fogType, float depthForOpaque, float density );
 void	R_InitImages( void );
 void	R_DeleteTextures( void );
+void	R_UploadImage( image_t *image, int numTexLevels, const textureLevel_t *pic, int internalFormat );
+image_t	*R_LoadImageFile( const char *name, imgType_t type, imgFlags_t flags, image_t *image );
+qboolean	R_FindImageSource( const char *name, char *sourceName, int sourceNameSize, int *checksum );
 int		R_SumOfUsedImages( void );
 void	R_InitSkins( void );
 
 int R_ComputeLOD( trRefEntity_t *ent );
 
 const void *RB_TakeVideoFrameCmd( const void *data );
+void RB_FinishVideoFrames( void );
+void R_ShutdownVideoReadback( void );
+
+//
+// tr_imagecache.c
+//
+typedef struct {
+	char		path[MAX_OSPATH];	// source name plus the variant hash and extension
+	int			key;
+	qboolean	writable;
+} imageCacheKey_t;
+
+void		R_SetImageCacheSettings( const byte *gammaTable, const byte *intensityTable );
+qboolean	R_ImageCacheKey( const char *name, imgType_t type, imgFlags_t flags, imageCacheKey_t *cacheKey );
+image_t		*R_LoadCachedImage( const char *name, imgType_t type, imgFlags_t flags, imageCacheKey_t *cacheKey, image_t *image );
+void		R_SaveCachedImage( image_t *image, const imageCacheKey_t *cacheKey );
+
+//
+// tr_imagestream.c
+//
+image_t		*R_CreateStreamImage( const char *name, imgType_t type, imgFlags_t flags );
+void		R_ClearStreamImages( void );
+void		R_RequestShaderImages( shader_t *shader, float distance );
+void		R_StreamImages( void );
+int			R_NumStreamImages( void );
 
 //
 // tr_shader.c
@@ -1544,6 +1607,7 @@ FLARES
 */
 
 void R_ClearFlares( void );
+void R_ShutdownFlares( void );
 
 void RB_AddFlare( void *surface, int fogNum, vec3_t point, vec3_t color, float scale, vec3_t normal, int id, qboolean cgvisible, shader_t *shader );
 void RB_AddDlightFlares( void );
@@ -1663,6 +1727,14 @@ int R_GetMDSBoneTag( orientation_t *outTag, const model_t *mod,
 					 qhandle_t torsoFrameModel, int torsoStartFrame,
 					 qhandle_t torsoEndFrameModel, int torsoEndFrame,
 					 float torsoFrac );
+int R_GetMDSBoneTags( orientation_t *outTags, int maxTags, const model_t *mod,
+					 qhandle_t frameModel, int startFrame,
+					 qhandle_t endFrameModel, int endFrame,
+					 float frac, const vec3_t *torsoAxis,
+					 qhandle_t torsoFrameModel, int torsoStartFrame,
+					 qhandle_t torsoEndFrameModel, int torsoEndFrame,
+					 float torsoFrac );
+void R_ClearMDSPoseCache( void );
 
 void R_MDMAddAnimSurfaces( trRefEntity_t *ent );
 void RB_MDMSurfaceAnim( mdmSurface_t *surface );
@@ -1737,9 +1809,26 @@ RENDERER BACK END COMMAND QUEUE
 
 #define	MAX_RENDER_COMMANDS	0x100000
 
+typedef struct {
+	float	x, y;
+	float	w, h;
+	float	s1, t1;
+	float	s2, t2;
+} stretchPic_t;
+
+// consecutive pics with the same shader, like the glyphs of a string, go in
+// one command that is followed by numPics stretchPic_t
+typedef struct {
+	int		commandId;
+	int		numPics;
+	shader_t	*shader;
+} stretchPicsCommand_t;
+
 typedef struct {
 	byte	cmds[MAX_RENDER_COMMANDS];
 	int		used;
+
+	stretchPicsCommand_t	*stretchPics;	// last stretch pics command added
 } renderCommandList_t;
 
 typedef struct {
@@ -1816,9 +1905,6 @@ typedef struct {
 	int						commandId;
 	int						width;
 	int						height;
-	byte					*captureBuffer;
-	byte					*encodeBuffer;
-	qboolean			motionJpeg;
 } videoFrameCommand_t;
 
 typedef struct
@@ -1904,8 +1990,8 @@ void RE_SaveJPG(char * filename, int quality, int image_width, int image_height,
 size_t RE_SaveJPGToBuffer(byte *buffer, size_t bufSize, int quality,
 		          int image_width, int image_height, byte *image_buffer, int padding);
 void RE_SaveTGA(char * filename, int image_width, int image_height, byte *image_buffer, int padding);
-void RE_TakeVideoFrame( int width, int height,
-		byte *captureBuffer, byte *encodeBuffer, qboolean motionJpeg );
+void RE_TakeVideoFrame( int width, int height );
+void RE_FinishVideoFrames( void );
 void RE_GetGlobalFog( fogType_t *type, vec3_t color, float *depthForOpaque, float *density, float *farClip );
 void RE_GetViewFog( const vec3_t origin, fogType_t *type, vec3_t color, float *depthForOpaque, float *density, float *farClip, qboolean inwater );
 
@@ -1853,6 +1853,8 @@ void R_ModelInit( void ) {
 
 	mod = R_AllocModel();
 	mod->type = MOD_BAD;
+
+	R_ClearMDSPoseCache();
 }
 
 
@@ -2213,6 +2215,140 @@ int R_LerpTag( orientation_t *tag, qhandle_t handle,
 	return qtrue;
 }
 
+/*
+================
+R_GetTagName
+
+Returns NULL if tagIndex is out of range.
+================
+*/
+static const char *R_GetTagName( model_t *model, int tagIndex ) {
+	int		i;
+
+	if ( tagIndex < 0 ) {
+		return NULL;
+	}
+
+	if ( model->type == MOD_MESH )
+	{
+		md3Header_t *header = model->md3[0];
+
+		if ( tagIndex < header->numTags ) {
+			return ( (md3Tag_t *)( (byte *)header + header->ofsTags ) + tagIndex )->name;
+		}
+	}
+	else if ( model->type == MOD_MDR )
+	{
+		mdrHeader_t *header = (mdrHeader_t *)model->modelData;
+
+		if ( tagIndex < header->numTags ) {
+			return ( (mdrTag_t *)( (byte *)header + header->ofsTags ) + tagIndex )->name;
+		}
+	}
+	else if ( model->type == MOD_MDC )
+	{
+		mdcHeader_t *header = (mdcHeader_t *)model->mdc[0];
+
+		if ( tagIndex < header->numTags ) {
+			return ( (mdcTagName_t *)( (byte *)header + header->ofsTagNames ) + tagIndex )->name;
+		}
+	}
+	else if ( model->type == MOD_TAN )
+	{
+		tanHeader_t *header = (tanHeader_t *)model->modelData;
+
+		if ( tagIndex < header->numTags ) {
+			return ( (tanTag_t *)( (byte *)header + header->ofsTags[tagIndex] ) )->name;
+		}
+	}
+	else if ( model->type == MOD_MDS )
+	{
+		mdsHeader_t *header = (mdsHeader_t *)model->modelData;
+
+		if ( tagIndex < header->numTags ) {
+			return ( (mdsTag_t *)( (byte *)header + header->ofsTags ) + tagIndex )->name;
+		}
+	}
+	else if ( model->type == MOD_MDM )
+	{
+		mdmHeader_t *header = (mdmHeader_t *)model->modelData;
+		mdmTag_t *pTag;
+
+		if ( tagIndex < header->numTags ) {
+			pTag = ( mdmTag_t * )( (byte *)header + header->ofsTags );
+			for ( i = 0; i < tagIndex; i++ ) {
+				pTag = ( mdmTag_t * )( (byte *)pTag + pTag->ofsEnd );
+			}
+			return pTag->name;
+		}
+	}
+	else if ( model->type == MOD_IQM )
+	{
+		iqmData_t *data = (iqmData_t *)model->modelData;
+		char *names = data->jointNames;
+
+		if ( tagIndex < data->num_joints ) {
+			for ( i = 0; i < tagIndex; i++ ) {
+				names += strlen( names ) + 1;
+			}
+			return names;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+================
+R_LerpTags
+
+Lerp all tags in the model, "tags[ i ]" is set to the tag with tag index i.
+Skeletal models only calculate the bones once for all of the tags.
+
+returns the number of tags set
+================
+*/
+int R_LerpTags( orientation_t *tags, int maxTags, qhandle_t handle,
+					 qhandle_t frameModel, int startFrame,
+					 qhandle_t endFrameModel, int endFrame,
+					 float frac, const vec3_t *torsoAxis, // vec3_t[3]
+					 qhandle_t torsoFrameModel, int torsoStartFrame,
+					 qhandle_t torsoEndFrameModel, int torsoEndFrame,
+					 float torsoFrac )
+{
+	model_t		*model;
+	const char	*tagName;
+	int			tagIndex;
+	int			i;
+
+	model = R_GetModelByHandle( handle );
+
+	if ( model->type == MOD_MDS ) {
+		return R_GetMDSBoneTags( tags, maxTags, model,
+				frameModel, startFrame,
+				endFrameModel, endFrame,
+				frac, torsoAxis,
+				torsoFrameModel, torsoStartFrame,
+				torsoEndFrameModel, torsoEndFrame,
+				torsoFrac );
+	}
+
+	for ( i = 0; i < maxTags; i++ ) {
+		tagName = R_GetTagName( model, i );
+
+		if ( !tagName ) {
+			break;
+		}
+
+		tagIndex = i;
+		R_LerpTag( &tags[i], handle, frameModel, startFrame, endFrameModel, endFrame,
+				frac, tagName, &tagIndex, torsoAxis, torsoFrameModel, torsoStartFrame,
+				torsoEndFrameModel, torsoEndFrame, torsoFrac );
+	}
+
+	return i;
+}
+
 
 /*
 ====================
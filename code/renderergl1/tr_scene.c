@@ -61,6 +61,7 @@ R_InitNextFrame
 */
 void R_InitNextFrame( void ) {
 	backEndData->commands.used = 0;
+	backEndData->commands.stretchPics = NULL;
 
 	r_firstSceneDrawSurf = 0;
 
@@ -198,6 +198,33 @@ static int R_DlightSurface( msurface_t *surface, int dlightBits ) {
 
 
 
+/*
+======================
+R_SurfaceDistance
+
+Distance from the view to the surface's bounding sphere
+======================
+*/
+static float R_SurfaceDistance( surfaceType_t *surface ) {
+	srfGeneric_t	*gen;
+	float			dist;
+
+	switch ( *surface )
+	{
+	case SF_TRIANGLES:
+	case SF_GRID:
+	case SF_FOLIAGE:
+		break;
+	default:
+		return 0;
+	}
+
+	gen = (srfGeneric_t *) surface;
+	dist = Distance( tr.or.viewOrigin, gen->origin ) - gen->radius;
+
+	return ( dist > 0 ) ? dist : 0;
+}
+
 /*
 ======================
 R_AddWorldSurface
@@ -224,6 +251,11 @@ static void R_AddWorldSurface( msurface_t *surf, shader_t *shader, int fogNum, i
 		return;
 	}
 
+	// load the shader's streamed images first
+	if ( shader->pendingImages ) {
+		R_RequestShaderImages( shader, R_SurfaceDistance( surf->data ) );
+	}
+
 	// check for dlighting
 	if ( dlightBits ) {
 		dlightBits = R_DlightSurface( surf, dlightBits );
@@ -921,8 +921,7 @@ void RE_EndFrame( int *frontEndMsec, int *backEndMsec ) {
 RE_TakeVideoFrame
 =============
 */
-void RE_TakeVideoFrame( int width, int height,
-		byte *captureBuffer, byte *encodeBuffer, qboolean motionJpeg )
+void RE_TakeVideoFrame( int width, int height )
 {
 	videoFrameCommand_t	*cmd;
 
@@ -939,7 +938,19 @@ void RE_TakeVideoFrame( int width, int height,
 
 	cmd->width = width;
 	cmd->height = height;
-	cmd->captureBuffer = captureBuffer;
-	cmd->encodeBuffer = encodeBuffer;
-	cmd->motionJpeg = motionJpeg;
+}
+
+/*
+=============
+RE_FinishVideoFrames
+=============
+*/
+void RE_FinishVideoFrames( void )
+{
+	if( !tr.registered ) {
+		return;
+	}
+
+	R_IssuePendingRenderCommands();
+	RB_FinishVideoFrames();
 }
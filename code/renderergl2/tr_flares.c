@@ -44,9 +44,12 @@ projected area of the light source.
 A surface that has been flagged as having a light flare will calculate the depth
 buffer value that its midpoint should have when the surface is added.
 
-After all opaque surfaces have been rendered, the depth buffer is read back for
-each flare in view.  If the point has not been obscured by a closer surface, the
-flare should be drawn.
+After all opaque surfaces have been rendered, an occlusion query is issued for
+each flare in view that draws its midpoint against the depth buffer.  The result
+is picked up a frame or two later, so it doesn't stall the pipeline.  If the point
+has not been obscured by a closer surface, the flare should be drawn.  Without
+occlusion queries (or with r_flareOcclusionQuery 0) the depth buffer is read back
+for each flare instead.
 
 Surfaces that have a repeated texture should never be flagged as flaring, because
 there will only be a single flare added at the midpoint of the polygon.
@@ -81,6 +84,9 @@ typedef struct flare_s {
 	qboolean	visible;			// state of last test
 	float		drawIntensity;		// may be non 0 even if !visible due to fading
 
+	qboolean	queryPending;		// waiting for the result of an occlusion query
+	int			queryTime;			// refdef time the pending query was issued
+
 	int			windowX, windowY;
 	float		eyeZ;
 
@@ -98,6 +104,10 @@ typedef struct flare_s {
 flare_t		r_flareStructs[MAX_FLARES];
 flare_t		*r_activeFlares, *r_inactiveFlares;
 
+// occlusion queries for r_flareStructs, by index
+static GLuint	r_flareQueries[MAX_FLARES];
+static qboolean	r_flareQueriesCreated;
+
 int flareCoeff;
 
 /*
@@ -133,6 +143,20 @@ void R_ClearFlares( void ) {
 	R_SetFlareCoeff();
 }
 
+/*
+==================
+R_ShutdownFlares
+
+Frees the occlusion queries, called while the OpenGL context is still current
+==================
+*/
+void R_ShutdownFlares( void ) {
+	if ( r_flareQueriesCreated ) {
+		qglDeleteQueries( MAX_FLARES, r_flareQueries );
+		r_flareQueriesCreated = qfalse;
+	}
+}
+
 
 /*
 ==================
@@ -211,6 +235,7 @@ void RB_AddFlare( void *surface, int fogNum, vec3_t point, vec3_t color, float s
 	if ( f->addedFrame != backEnd.viewParms.frameCount - 1 ) {
 		f->visible = qfalse;
 		f->fadeTime = backEnd.refdef.time - 2000;
+		f->queryPending = qfalse;
 	}
 
 	f->addedFrame = backEnd.viewParms.frameCount;
@@ -285,24 +310,111 @@ FLARE BACK END
 ===============================================================================
 */
 
+/*
+==================
+RB_FlareQueries
+
+Returns qtrue if flare visibility should be tested with occlusion queries
+==================
+*/
+static qboolean RB_FlareQueries( void ) {
+	if ( !r_flareOcclusionQuery->integer || !glRefConfig.occlusionQuery ) {
+		return qfalse;
+	}
+
+	if ( !r_flareQueriesCreated ) {
+		qglGenQueries( MAX_FLARES, r_flareQueries );
+		r_flareQueriesCreated = qtrue;
+	}
+
+	return qtrue;
+}
+
+/*
+==================
+RB_QueryFlare
+
+Starts an occlusion query for the flare if there isn't one in flight and picks
+up the result of an earlier one. Returns qfalse if the visibility is still unknown.
+Expects window coordinates with z as negative depth buffer value.
+==================
+*/
+static qboolean RB_QueryFlare( flare_t *f, qboolean *visible ) {
+	GLuint		query;
+	GLint		available;
+	GLuint		samples;
+	float		eyeZ, depth;
+	float		*projection;
+	vec4_t		quadVerts[4];
+
+	query = r_flareQueries[f - r_flareStructs];
+
+	if ( f->queryPending ) {
+		qglGetQueryObjectiv( query, GL_QUERY_RESULT_AVAILABLE, &available );
+		if ( !available ) {
+			return qfalse;
+		}
+
+		qglGetQueryObjectuiv( query, GL_QUERY_RESULT, &samples );
+		f->queryPending = qfalse;
+
+		*visible = ( samples > 0 );
+		return qtrue;
+	}
+
+	// test a point 24 units in front of the flare, same as the readback tolerance
+	projection = backEnd.viewParms.projectionMatrix;
+	eyeZ = f->eyeZ + 24;
+
+	if ( eyeZ >= -r_znear->value ) {
+		depth = 0;
+	} else {
+		depth = 0.5f * ( projection[10] * eyeZ + projection[14] ) / ( projection[11] * eyeZ ) + 0.5f;
+	}
+
+	VectorSet4( quadVerts[0], f->windowX,     f->windowY,     -depth, 1.0f );
+	VectorSet4( quadVerts[1], f->windowX + 1, f->windowY,     -depth, 1.0f );
+	VectorSet4( quadVerts[2], f->windowX + 1, f->windowY + 1, -depth, 1.0f );
+	VectorSet4( quadVerts[3], f->windowX,     f->windowY + 1, -depth, 1.0f );
+
+	qglBeginQuery( glRefConfig.occlusionQueryTarget, query );
+	RB_InstantQuad( quadVerts );
+	qglEndQuery( glRefConfig.occlusionQueryTarget );
+
+	f->queryPending = qtrue;
+	f->queryTime = backEnd.refdef.time;
+
+	return qfalse;
+}
+
 /*
 ==================
 RB_TestFlare
 ==================
 */
-void RB_TestFlare( flare_t *f ) {
+void RB_TestFlare( flare_t *f, qboolean useQueries ) {
 	float			depth;
 	qboolean		visible;
 	float			fade;
 	float			screenZ;
 	FBO_t           *oldFbo;
+	int				testTime;
 
 	backEnd.pc.c_flareTests++;
 
+	testTime = backEnd.refdef.time;
+
 	// ZTM: let cgame tell us visable to make sure coronas aren't seen though walls,
 	//      but use depth buffer to make sure not seen though masked textures
 	if ( f->id != -1 && !f->cgvisible ) {
 		visible = qfalse;
+	} else if ( useQueries ) {
+		// the result is from an earlier frame, fade from when it was tested
+		testTime = f->queryTime;
+
+		if ( !RB_QueryFlare( f, &visible ) ) {
+			visible = f->visible;
+		}
 	} else {
 		// doing a readpixels is as good as doing a glFinish(), so
 		// don't bother with another sync
@@ -333,13 +445,13 @@ void RB_TestFlare( flare_t *f ) {
 	if ( visible ) {
 		if ( !f->visible ) {
 			f->visible = qtrue;
-			f->fadeTime = backEnd.refdef.time - 1;
+			f->fadeTime = testTime - 1;
 		}
 		fade = ( ( backEnd.refdef.time - f->fadeTime ) /1000.0f ) * r_flareFade->value;
 	} else {
 		if ( f->visible ) {
 			f->visible = qfalse;
-			f->fadeTime = backEnd.refdef.time - 1;
+			f->fadeTime = testTime - 1;
 		}
 		fade = 1.0f - ( ( backEnd.refdef.time - f->fadeTime ) / 1000.0f ) * r_flareFade->value;
 	}
@@ -509,18 +621,23 @@ void RB_RenderFlares (void) {
 	flare_t		*f;
 	flare_t		**prev;
 	qboolean	draw;
+	qboolean	useQueries;
+	GLboolean	colorMask[4];
 	mat4_t    oldmodelview, oldprojection, matrix;
 
 	if ( !r_flares->integer ) {
 		return;
 	}
 
-	if ( r_flares->modified ) {
-		if ( qglesMajorVersion >= 1 && !glRefConfig.readDepth ) {
+	useQueries = RB_FlareQueries();
+
+	if ( r_flares->modified || r_flareOcclusionQuery->modified ) {
+		if ( !useQueries && qglesMajorVersion >= 1 && !glRefConfig.readDepth ) {
 			ri.Printf( PRINT_WARNING, "OpenGL ES needs GL_NV_read_depth to read depth to determine if flares are visible\n" );
 			ri.Cvar_Set( "r_flares", "0" );
 		}
 		r_flares->modified = qfalse;
+		r_flareOcclusionQuery->modified = qfalse;
 	}
 
 	if(r_flareCoeff->modified)
@@ -539,7 +656,25 @@ void RB_RenderFlares (void) {
 
 	RB_AddCoronaFlares();
 
-	// perform z buffer readback on each flare in this view
+	Mat4Copy(glState.projection, oldprojection);
+	Mat4Copy(glState.modelview, oldmodelview);
+
+	if ( useQueries ) {
+		// window coordinates with z as negative depth buffer value,
+		// depth test without writing anything
+		Mat4Identity(matrix);
+		GL_SetModelviewMatrix(matrix);
+		Mat4Ortho( backEnd.viewParms.viewportX, backEnd.viewParms.viewportX + backEnd.viewParms.viewportWidth,
+		               backEnd.viewParms.viewportY, backEnd.viewParms.viewportY + backEnd.viewParms.viewportHeight,
+		               0, 1, matrix );
+		GL_SetProjectionMatrix(matrix);
+		GL_State( 0 );
+		GL_Cull( CT_TWO_SIDED );
+		qglGetBooleanv( GL_COLOR_WRITEMASK, colorMask );
+		qglColorMask( GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE );
+	}
+
+	// perform occlusion query or z buffer readback on each flare in this view
 	draw = qfalse;
 	prev = &r_activeFlares;
 	while ( ( f = *prev ) != NULL ) {
@@ -555,10 +690,10 @@ void RB_RenderFlares (void) {
 		f->drawIntensity = 0;
 		if ( f->frameSceneNum == backEnd.viewParms.frameSceneNum
 			&& f->inPortal == backEnd.viewParms.isPortal ) {
-			RB_TestFlare( f );
+			RB_TestFlare( f, useQueries );
 			if ( f->drawIntensity ) {
 				draw = qtrue;
-			} else {
+			} else if ( !f->queryPending ) {
 				// this flare has completely faded out, so remove it from the chain
 				*prev = f->next;
 				f->next = r_inactiveFlares;
@@ -570,12 +705,16 @@ void RB_RenderFlares (void) {
 		prev = &f->next;
 	}
 
+	if ( useQueries ) {
+		qglColorMask( colorMask[0], colorMask[1], colorMask[2], colorMask[3] );
+		GL_SetProjectionMatrix(oldprojection);
+		GL_SetModelviewMatrix(oldmodelview);
+	}
+
 	if ( !draw ) {
 		return;		// none visible
 	}
 
-	Mat4Copy(glState.projection, oldprojection);
-	Mat4Copy(glState.modelview, oldmodelview);
 	Mat4Identity(matrix);
 	GL_SetModelviewMatrix(matrix);
 	Mat4Ortho( backEnd.viewParms.viewportX, backEnd.viewParms.viewportX + backEnd.viewParms.viewportWidth,
@@ -30,6 +30,10 @@ Suite 120, Rockville, Maryland 20850 USA.
 // tr_image.c
 #include "tr_local.h"
 
+#if idx64
+#include <emmintrin.h>
+#endif
+
 #include "tr_dsa.h"
 
 static byte			 s_intensitytable[256];
@@ -38,6 +42,10 @@ static unsigned char s_gammatable[256];
 int		gl_filter_min = GL_LINEAR_MIPMAP_NEAREST;
 int		gl_filter_max = GL_LINEAR;
 
+// smallest amount of work worth handing to a worker thread
+#define MIN_JOB_PIXELS		16384
+#define MIN_JOB_ROWS( w )	( MIN_JOB_PIXELS / MAX( 1, (w) ) + 1 )
+
 #define FILE_HASH_SIZE		1024
 static	image_t*		hashTable[FILE_HASH_SIZE];
 
@@ -329,44 +337,90 @@ If a larger shrinking is needed, use the mipmap function
 before or after.
 ================
 */
+typedef struct {
+	byte		*in;
+	int			inwidth, inheight;
+	byte		*out;
+	int			outwidth, outheight;
+	int			p1[2048], p2[2048];
+} resampleJob_t;
+
+static void ResampleTextureRows( void *data, int start, int end ) {
+	resampleJob_t *job = data;
+	int		i, j;
+	byte		*inrow, *inrow2, *out;
+	byte		*pix1, *pix2, *pix3, *pix4;
+#if idx64
+	__m128i		zero = _mm_setzero_si128();
+	__m128i		a, b, c, d;
+#endif
+
+	for (i=start ; i<end ; i++) {
+		out = job->out + 4*i*job->outwidth;
+		inrow = job->in + 4*job->inwidth*(int)((i+0.25)*job->inheight/job->outheight);
+		inrow2 = job->in + 4*job->inwidth*(int)((i+0.75)*job->inheight/job->outheight);
+		j = 0;
+#if idx64
+		// two pixels at a time, 16 bits per channel
+#define LOADPIXELS( row, p ) _mm_unpacklo_epi8( _mm_unpacklo_epi32( \
+			_mm_cvtsi32_si128( *(int *)( (row) + (p)[j] ) ), \
+			_mm_cvtsi32_si128( *(int *)( (row) + (p)[j+1] ) ) ), zero )
+		for ( ; j+1<job->outwidth ; j+=2) {
+			a = LOADPIXELS( inrow, job->p1 );
+			b = LOADPIXELS( inrow, job->p2 );
+			c = LOADPIXELS( inrow2, job->p1 );
+			d = LOADPIXELS( inrow2, job->p2 );
+			a = _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16( a, b ), _mm_add_epi16( c, d ) ), 2 );
+			_mm_storel_epi64( (__m128i *)(out+4*j), _mm_packus_epi16( a, zero ) );
+		}
+#undef LOADPIXELS
+#endif
+		for ( ; j<job->outwidth ; j++) {
+			pix1 = inrow + job->p1[j];
+			pix2 = inrow + job->p2[j];
+			pix3 = inrow2 + job->p1[j];
+			pix4 = inrow2 + job->p2[j];
+			out[4*j+0] = (pix1[0] + pix2[0] + pix3[0] + pix4[0])>>2;
+			out[4*j+1] = (pix1[1] + pix2[1] + pix3[1] + pix4[1])>>2;
+			out[4*j+2] = (pix1[2] + pix2[2] + pix3[2] + pix4[2])>>2;
+			out[4*j+3] = (pix1[3] + pix2[3] + pix3[3] + pix4[3])>>2;
+		}
+	}
+}
+
 static void ResampleTexture( byte *in, int inwidth, int inheight, byte *out,  
 							int outwidth, int outheight ) {
-	int		i, j;
-	byte	*inrow, *inrow2;
+	int		i;
 	int		frac, fracstep;
-	int		p1[2048], p2[2048];
-	byte	*pix1, *pix2, *pix3, *pix4;
+	resampleJob_t	*job;
 
 	if (outwidth>2048)
 		ri.Error(ERR_DROP, "ResampleTexture: max width");
-								
+
+	job = ri.Hunk_AllocateTempMemory( sizeof( *job ) );
+	job->in = in;
+	job->inwidth = inwidth;
+	job->inheight = inheight;
+	job->out = out;
+	job->outwidth = outwidth;
+	job->outheight = outheight;
+
 	fracstep = inwidth*0x10000/outwidth;
 
 	frac = fracstep>>2;
 	for ( i=0 ; i<outwidth ; i++ ) {
-		p1[i] = 4*(frac>>16);
+		job->p1[i] = 4*(frac>>16);
 		frac += fracstep;
 	}
 	frac = 3*(fracstep>>2);
 	for ( i=0 ; i<outwidth ; i++ ) {
-		p2[i] = 4*(frac>>16);
+		job->p2[i] = 4*(frac>>16);
 		frac += fracstep;
 	}
 
-	for (i=0 ; i<outheight ; i++) {
-		inrow = in + 4*inwidth*(int)((i+0.25)*inheight/outheight);
-		inrow2 = in + 4*inwidth*(int)((i+0.75)*inheight/outheight);
-		for (j=0 ; j<outwidth ; j++) {
-			pix1 = inrow + p1[j];
-			pix2 = inrow + p2[j];
-			pix3 = inrow2 + p1[j];
-			pix4 = inrow2 + p2[j];
-			*out++ = (pix1[0] + pix2[0] + pix3[0] + pix4[0])>>2;
-			*out++ = (pix1[1] + pix2[1] + pix3[1] + pix4[1])>>2;
-			*out++ = (pix1[2] + pix2[2] + pix3[2] + pix4[2])>>2;
-			*out++ = (pix1[3] + pix2[3] + pix3[3] + pix4[3])>>2;
-		}
-	}
+	R_ParallelFor( ResampleTextureRows, job, outheight, MIN_JOB_ROWS( outwidth ) );
+
+	ri.Hunk_FreeTempMemory( job );
 }
 
 static void RGBAtoYCoCgA(const byte *in, byte *out, int width, int height)
@@ -1252,57 +1306,101 @@ Scale up the pixel values in a texture to increase the
 lighting range
 ================
 */
+typedef struct {
+	byte	*pixels;
+	byte	table[256];
+} lightScaleJob_t;
+
+static void R_LightScalePixels( void *data, int start, int end ) {
+	lightScaleJob_t *job = data;
+	int		i;
+	byte	*p;
+
+	p = job->pixels + start*4;
+
+	for (i=start ; i<end ; i++, p+=4)
+	{
+		p[0] = job->table[p[0]];
+		p[1] = job->table[p[1]];
+		p[2] = job->table[p[2]];
+	}
+}
+
 void R_LightScaleTexture (byte *in, int inwidth, int inheight, qboolean only_gamma )
 {
+	lightScaleJob_t	job;
+	int		i;
+
 	if ( only_gamma )
 	{
-		if ( !glConfig.deviceSupportsGamma )
+		if ( glConfig.deviceSupportsGamma )
 		{
-			int		i, c;
-			byte	*p;
-
-			p = in;
-
-			c = inwidth*inheight;
-			for (i=0 ; i<c ; i++, p+=4)
-			{
-				p[0] = s_gammatable[p[0]];
-				p[1] = s_gammatable[p[1]];
-				p[2] = s_gammatable[p[2]];
-			}
+			return;
 		}
+
+		Com_Memcpy( job.table, s_gammatable, sizeof( job.table ) );
 	}
 	else
 	{
-		int		i, c;
-		byte	*p;
-
-		p = in;
-
-		c = inwidth*inheight;
-
 		if ( glConfig.deviceSupportsGamma )
 		{
-			for (i=0 ; i<c ; i++, p+=4)
-			{
-				p[0] = s_intensitytable[p[0]];
-				p[1] = s_intensitytable[p[1]];
-				p[2] = s_intensitytable[p[2]];
-			}
+			Com_Memcpy( job.table, s_intensitytable, sizeof( job.table ) );
 		}
 		else
 		{
-			for (i=0 ; i<c ; i++, p+=4)
+			// combine the tables so each channel only needs one lookup
+			for (i=0 ; i<256 ; i++)
 			{
-				p[0] = s_gammatable[s_intensitytable[p[0]]];
-				p[1] = s_gammatable[s_intensitytable[p[1]]];
-				p[2] = s_gammatable[s_intensitytable[p[2]]];
+				job.table[i] = s_gammatable[s_intensitytable[i]];
 			}
 		}
 	}
+
+	job.pixels = in;
+
+	R_ParallelFor( R_LightScalePixels, &job, inwidth*inheight, MIN_JOB_PIXELS );
 }
 
 
+typedef struct {
+	const byte	*in;
+	byte		*out;
+	int			inWidth;
+	qboolean	swizzle;
+} mipMapJob_t;
+
+static float downmipSrgbLookup[256];
+static int downmipSrgbLookupSet = 0;
+
+static void R_MipMapsRGBRows( void *data, int start, int end )
+{
+	mipMapJob_t *job = data;
+	int x, y, c, stride, width;
+	const byte *in, *in2;
+	byte *out;
+	float total;
+
+	stride = job->inWidth * 4;
+	width = job->inWidth >> 1;
+
+	for (y = start; y < end; y++) {
+		in = job->in + y * 2 * stride;
+		in2 = in + stride;
+		out = job->out + y * width * 4;
+
+		for (x = width; x; x--) {
+			for (c = 3; c; c--, in++, in2++) {
+				total = downmipSrgbLookup[*(in)]  + downmipSrgbLookup[*(in + 4)]
+				      + downmipSrgbLookup[*(in2)] + downmipSrgbLookup[*(in2 + 4)];
+
+				*out++ = (byte)(powf(total, 1.0f / 2.2f) * 255.0f);
+			}
+
+			*out++ = (*(in) + *(in + 4) + *(in2) + *(in2 + 4)) >> 2; in += 5, in2 += 5;
+		}
+	}
+}
+
 /*
 ================
 R_MipMapsRGB
@@ -1313,12 +1411,10 @@ Colors are gamma correct
 */
 static void R_MipMapsRGB( byte *in, int inWidth, int inHeight)
 {
-	int x, y, c, stride;
-	const byte *in2;
+	int x, c, size;
 	float total;
-	static float downmipSrgbLookup[256];
-	static int downmipSrgbLookupSet = 0;
 	byte *out = in;
+	mipMapJob_t job;
 
 	if (!downmipSrgbLookupSet) {
 		for (x = 0; x < 256; x++)
@@ -1342,41 +1438,37 @@ static void R_MipMapsRGB( byte *in, int inWidth, int inHeight)
 		return;
 	}
 
-	stride = inWidth * 4;
-	inWidth >>= 1; inHeight >>= 1;
+	// the rows are split between the worker threads, so write to a copy
+	size = (inWidth >> 1) * (inHeight >> 1) * 4;
 
-	in2 = in + stride;
-	for (y = inHeight; y; y--, in += stride, in2 += stride) {
-		for (x = inWidth; x; x--) {
-			for (c = 3; c; c--, in++, in2++) {
-				total = downmipSrgbLookup[*(in)]  + downmipSrgbLookup[*(in + 4)]
-				      + downmipSrgbLookup[*(in2)] + downmipSrgbLookup[*(in2 + 4)];
+	job.in = in;
+	job.out = ri.Hunk_AllocateTempMemory(size);
+	job.inWidth = inWidth;
 
-				*out++ = (byte)(powf(total, 1.0f / 2.2f) * 255.0f);
-			}
+	R_ParallelFor( R_MipMapsRGBRows, &job, inHeight >> 1, MIN_JOB_ROWS( inWidth >> 1 ) );
 
-			*out++ = (*(in) + *(in + 4) + *(in2) + *(in2 + 4)) >> 2; in += 5, in2 += 5;
-		}
-	}
+	Com_Memcpy(in, job.out, size);
+	ri.Hunk_FreeTempMemory(job.out);
 }
 
 
-static void R_MipMapNormalHeight (const byte *in, byte *out, int width, int height, qboolean swizzle)
+static void R_MipMapNormalHeightRows( void *data, int start, int end )
 {
+	mipMapJob_t *job = data;
+	const byte	*in;
+	byte		*out;
 	int		i, j;
-	int		row;
-	int sx = swizzle ? 3 : 0;
-	int sa = swizzle ? 0 : 3;
+	int		row, width;
+	int sx = job->swizzle ? 3 : 0;
+	int sa = job->swizzle ? 0 : 3;
 
-	if ( width == 1 && height == 1 ) {
-		return;
-	}
+	row = job->inWidth * 4;
+	width = job->inWidth >> 1;
+
+	for (i=start ; i<end ; i++) {
+		in = job->in + i * 2 * row;
+		out = job->out + i * width * 4;
 
-	row = width * 4;
-	width >>= 1;
-	height >>= 1;
-	
-	for (i=0 ; i<height ; i++, in+=row) {
 		for (j=0 ; j<width ; j++, out+=4, in+=8) {
 			vec3_t v;
 
@@ -1411,6 +1503,39 @@ static void R_MipMapNormalHeight (const byte *in, byte *out, int width, int heig
 	}
 }
 
+/*
+================
+R_MipMapNormalHeight
+
+Operates in place, quartering the size of the texture
+================
+*/
+static void R_MipMapNormalHeight( byte *in, int width, int height, qboolean swizzle )
+{
+	int		size;
+	mipMapJob_t	job;
+
+	if ( width == 1 && height == 1 ) {
+		return;
+	}
+
+	// the rows are split between the worker threads, so write to a copy
+	size = (width >> 1) * (height >> 1) * 4;
+	if ( !size ) {
+		return;
+	}
+
+	job.in = in;
+	job.out = ri.Hunk_AllocateTempMemory( size );
+	job.inWidth = width;
+	job.swizzle = swizzle;
+
+	R_ParallelFor( R_MipMapNormalHeightRows, &job, height >> 1, MIN_JOB_ROWS( width >> 1 ) );
+
+	Com_Memcpy( in, job.out, size );
+	ri.Hunk_FreeTempMemory( job.out );
+}
+
 
 /*
 ==================
@@ -1708,7 +1833,7 @@ static qboolean RawImage_ScaleToPower2( const textureLevel_t *pic, int baseLevel
 		while (width > scaled_width || height > scaled_height)
 		{
 			if (type == IMGTYPE_NORMAL || type == IMGTYPE_NORMALHEIGHT)
-				R_MipMapNormalHeight(*resampledBuffer, *resampledBuffer, width, height, qfalse);
+				R_MipMapNormalHeight(*resampledBuffer, width, height, qfalse);
 			else
 				R_MipMapsRGB(*resampledBuffer, width, height);
 
@@ -2102,7 +2227,7 @@ static void RawImage_UploadTexture(GLuint texture, byte *data, int x, int y, int
 			else if (rgba8)
 			{
 				if (type == IMGTYPE_NORMAL || type == IMGTYPE_NORMALHEIGHT)
-					R_MipMapNormalHeight(data, data, width, height, glRefConfig.swizzleNormalmap);
+					R_MipMapNormalHeight(data, width, height, glRefConfig.swizzleNormalmap);
 				else
 					R_MipMapsRGB(data, width, height);
 			}
@@ -2504,49 +2629,65 @@ void R_UpdateSubImage( image_t *image, byte *pic, int x, int y, int width, int h
 	Upload32(1, &texLevel, x, y, width, height, picFormat, dataFormat, dataType, image, qfalse, 0);
 }
 
+void R_UpdateImage( image_t *image, byte *pic, int width, int height )
+{
+	R_UpdateSubImage( image, pic, 0, 0, width, height, GL_RGBA8 );
+}
+
 //===================================================================
 
 typedef struct
 {
 	char *ext;
 	void (*ImageLoader)( const char *, int *, textureLevel_t ** );
+	imageDecoder_t ImageDecoder;	// NULL if it can't run on the worker threads
 } imageExtToLoaderMap_t;
 
 // Note that the ordering indicates the order of preference used
 // when there are multiple images of different formats available
 static imageExtToLoaderMap_t imageLoaders[ ] =
 {
-	{ "tga",  R_LoadTGA },
-	{ "jpg",  R_LoadJPG },
-	{ "jpeg", R_LoadJPG },
-	{ "png",  R_LoadPNG },
-	{ "ftx",  R_LoadFTX },
-	{ "dds",  R_LoadDDS },
-	{ "pcx",  R_LoadPCX },
-	{ "bmp",  R_LoadBMP }
+	{ "tga",  R_LoadTGA, R_DecodeTGA },
+	{ "jpg",  R_LoadJPG, R_DecodeJPG },
+	{ "jpeg", R_LoadJPG, R_DecodeJPG },
+	{ "png",  R_LoadPNG, R_DecodePNG },
+	{ "ftx",  R_LoadFTX, NULL },
+	{ "dds",  R_LoadDDS, NULL },
+	{ "pcx",  R_LoadPCX, NULL },
+	{ "bmp",  R_LoadBMP, NULL }
 };
 
 static int numImageLoaders = ARRAY_LEN( imageLoaders );
 
+typedef struct
+{
+	char		name[ MAX_QPATH ];		// as passed to R_LoadImage, empty once taken
+	char		fileName[ MAX_QPATH ];
+	qboolean	orgNameFailed;
+} prefetchImage_t;
+
+static prefetchImage_t	prefetchImages[ MAX_PREFETCH_IMAGES ];
+static imageDecode_t	prefetchDecodes[ MAX_PREFETCH_IMAGES ];
+static int				numPrefetchImages;
+
 /*
 =================
-R_LoadImage
+R_FindImageLoader
 
-Loads any of the supported image types into a canonical
-32 bit format.
+Finds the next file R_LoadImage tries for name after the one of loader, or
+the first one if loader is -1. orgNameFailed is set if it isn't the file
+name refers to and checksum to the checksum of the pk3 the file is in.
+Returns the loader index, or -1 if there isn't one.
 =================
 */
-void R_LoadImage( const char *name, int *numLevels, textureLevel_t **pic )
+static int R_FindImageLoader( const char *name, int loader, char *fileName, int fileNameSize, qboolean *orgNameFailed, int *checksum )
 {
-	qboolean orgNameFailed = qfalse;
-	int orgLoader = -1;
-	int i;
 	char localName[ MAX_QPATH ];
 	const char *ext;
-	char *altName;
+	int orgLoader = -1;
+	int i;
 
-	*pic = NULL;
-	*numLevels = 0;
+	*orgNameFailed = qfalse;
 
 	Q_strncpyz( localName, name, MAX_QPATH );
 
@@ -2554,54 +2695,231 @@ void R_LoadImage( const char *name, int *numLevels, textureLevel_t **pic )
 
 	if( *ext )
 	{
-		// Look for the correct loader and use it
 		for( i = 0; i < numImageLoaders; i++ )
 		{
 			if( !Q_stricmp( ext, imageLoaders[ i ].ext ) )
 			{
-				// Load
-				imageLoaders[ i ].ImageLoader( localName, numLevels, pic );
 				break;
 			}
 		}
 
-		// A loader was found
+		// A loader was found, the name itself is tried first
 		if( i < numImageLoaders )
 		{
-			if( *pic == NULL )
+			if( loader < 0 && ri.FS_FilePakChecksum( localName, checksum ) )
 			{
-				// Loader failed, most likely because the file isn't there;
-				// try again without the extension
-				orgNameFailed = qtrue;
-				orgLoader = i;
-				COM_StripExtension( name, localName, MAX_QPATH );
-			}
-			else
-			{
-				// Something loaded
-				return;
+				Q_strncpyz( fileName, localName, fileNameSize );
+				return i;
 			}
+
+			*orgNameFailed = qtrue;
+			orgLoader = i;
+			COM_StripExtension( name, localName, MAX_QPATH );
 		}
 	}
 
 	// Try and find a suitable match using all
 	// the image formats supported
-	for( i = 0; i < numImageLoaders; i++ )
+	for( i = ( loader == orgLoader ) ? 0 : loader + 1; i < numImageLoaders; i++ )
 	{
-		if (i == orgLoader)
+		if( i == orgLoader )
+			continue;
+
+		Com_sprintf( fileName, fileNameSize, "%s.%s", localName, imageLoaders[ i ].ext );
+
+		if( ri.FS_FilePakChecksum( fileName, checksum ) )
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/*
+=================
+R_PrefetchImages
+
+Frees the previous prefetched images, then reads the files R_LoadImage would
+load for names on the main thread and decodes the TGA, JPG and PNG ones on the
+worker threads. R_LoadImage takes the decoded images instead of loading them
+again until R_FreePrefetchedImages is called.
+=================
+*/
+void R_PrefetchImages( const char **names, int numNames )
+{
+	prefetchImage_t	*prefetch;
+	imageDecode_t	*decode;
+	image_t		*image;
+	union {
+		byte *b;
+		void *v;
+	} buffer;
+	int			i, j, loader, checksum;
+
+	R_FreePrefetchedImages();
+
+	// nothing to gain without worker threads
+	if ( R_NumWorkerThreads() < 2 ) {
+		return;
+	}
+
+	for ( i = 0; i < numNames && numPrefetchImages < MAX_PREFETCH_IMAGES; i++ ) {
+		// skip images that are already loaded
+		for ( image = hashTable[ generateHashValue( names[ i ] ) ]; image; image = image->next ) {
+			if ( !strcmp( names[ i ], image->imgName ) ) {
+				break;
+			}
+		}
+
+		if ( image ) {
+			continue;
+		}
+
+		for ( j = 0; j < numPrefetchImages; j++ ) {
+			if ( !strcmp( names[ i ], prefetchImages[ j ].name ) ) {
+				break;
+			}
+		}
+
+		if ( j < numPrefetchImages ) {
+			continue;
+		}
+
+		prefetch = &prefetchImages[ numPrefetchImages ];
+		decode = &prefetchDecodes[ numPrefetchImages ];
+
+		loader = R_FindImageLoader( names[ i ], -1, prefetch->fileName, sizeof ( prefetch->fileName ), &prefetch->orgNameFailed, &checksum );
+		if ( loader < 0 || !imageLoaders[ loader ].ImageDecoder ) {
+			continue;
+		}
+
+		decode->length = ri.FS_ReadFile( prefetch->fileName, &buffer.v );
+		if ( !buffer.b || decode->length < 0 ) {
+			continue;
+		}
+
+		Q_strncpyz( prefetch->name, names[ i ], sizeof ( prefetch->name ) );
+		decode->name = prefetch->fileName;
+		decode->decoder = imageLoaders[ loader ].ImageDecoder;
+		decode->buffer = buffer.b;
+		numPrefetchImages++;
+	}
+
+	R_DecodeImages( prefetchDecodes, numPrefetchImages );
+
+	// the files are in temp memory, free them in reverse order
+	for ( i = numPrefetchImages - 1; i >= 0; i-- ) {
+		ri.FS_FreeFile( (void *)prefetchDecodes[ i ].buffer );
+		prefetchDecodes[ i ].buffer = NULL;
+	}
+}
+
+/*
+=================
+R_FreePrefetchedImages
+
+Frees the prefetched images R_LoadImage didn't take
+=================
+*/
+void R_FreePrefetchedImages( void )
+{
+	int i;
+
+	for ( i = 0; i < numPrefetchImages; i++ ) {
+		if ( prefetchDecodes[ i ].pic ) {
+			ri.Free( prefetchDecodes[ i ].pic );
+			prefetchDecodes[ i ].pic = NULL;
+		}
+	}
+
+	numPrefetchImages = 0;
+}
+
+/*
+=================
+R_TakePrefetchedImage
+
+Returns qfalse if name wasn't prefetched or failed to decode without an
+error, in which case R_LoadImage goes on to try the other formats
+=================
+*/
+static qboolean R_TakePrefetchedImage( const char *name, int *numLevels, textureLevel_t **pic )
+{
+	prefetchImage_t	*prefetch;
+	imageDecode_t	*decode;
+	int i;
+
+	for ( i = 0; i < numPrefetchImages; i++ ) {
+		prefetch = &prefetchImages[ i ];
+		decode = &prefetchDecodes[ i ];
+
+		if ( strcmp( name, prefetch->name ) ) {
 			continue;
+		}
+
+		prefetch->name[ 0 ] = '\0';
+
+		if ( decode->error[ 0 ] ) {
+			char error[ MAX_STRING_CHARS ];
+
+			Q_strncpyz( error, decode->error, sizeof ( error ) );
+			R_FreePrefetchedImages();
+			ri.Error( ERR_DROP, "%s", error );
+		}
+
+		if ( !decode->pic ) {
+			return qfalse;
+		}
+
+		if ( prefetch->orgNameFailed ) {
+			ri.Printf( PRINT_DEVELOPER, "WARNING: %s not present, using %s instead\n",
+					name, prefetch->fileName );
+		}
 
-		altName = va( "%s.%s", localName, imageLoaders[ i ].ext );
+		*numLevels = decode->numLevels;
+		*pic = decode->pic;
+		decode->pic = NULL;
+		return qtrue;
+	}
+
+	return qfalse;
+}
 
-		// Load
-		imageLoaders[ i ].ImageLoader( altName, numLevels, pic );
+/*
+=================
+R_LoadImage
+
+Loads any of the supported image types into a canonical
+32 bit format.
+=================
+*/
+void R_LoadImage( const char *name, int *numLevels, textureLevel_t **pic )
+{
+	char fileName[ MAX_QPATH ];
+	qboolean orgNameFailed;
+	int loader, checksum;
+
+	*pic = NULL;
+	*numLevels = 0;
+
+	if ( R_TakePrefetchedImage( name, numLevels, pic ) ) {
+		return;
+	}
+
+	// Load the files in the order of preference until one loads
+	for( loader = R_FindImageLoader( name, -1, fileName, sizeof ( fileName ), &orgNameFailed, &checksum );
+		loader >= 0;
+		loader = R_FindImageLoader( name, loader, fileName, sizeof ( fileName ), &orgNameFailed, &checksum ) )
+	{
+		imageLoaders[ loader ].ImageLoader( fileName, numLevels, pic );
 
 		if( *pic )
 		{
 			if( orgNameFailed )
 			{
 				ri.Printf( PRINT_DEVELOPER, "WARNING: %s not present, using %s instead\n",
-						name, altName );
+						name, fileName );
 			}
 
 			break;
@@ -3255,6 +3573,8 @@ void R_DeleteTextures( void ) {
 
 	tr.numImages = 0;
 
+	R_FreePrefetchedImages();
+
 	GL_BindNullTextures();
 }
 
@@ -52,6 +52,7 @@ cvar_t  *com_altivec;
 cvar_t	*r_flareSize;
 cvar_t	*r_flareFade;
 cvar_t	*r_flareCoeff;
+cvar_t	*r_flareOcclusionQuery;
 
 cvar_t	*r_verbose;
 cvar_t	*r_ignore;
@@ -238,6 +239,9 @@ cvar_t	*r_printShaders;
 cvar_t	*r_saveFontData;
 cvar_t	*r_fontBorderWidth;
 cvar_t	*r_fontForceAutoHint;
+cvar_t	*r_fontCache;
+
+cvar_t	*r_shaderCache;
 
 cvar_t	*r_marksOnTriangleMeshes;
 cvar_t	*r_marksOnBrushModels;
@@ -964,26 +968,150 @@ void R_ExportCubemaps_f(void)
 
 //============================================================================
 
+/*
+==================
+RB_HandOverVideoFrame
+
+Passes a frame read back from the framebuffer to the client for encoding,
+converting to RGB, removing line padding and gamma correcting on the way
+==================
+*/
+static void RB_HandOverVideoFrame( const byte *pixels, int width, int height, int bytesPerPixel, int padlen )
+{
+	byte	*frame;
+	int		linelen, x, y;
+
+	frame = ri.CL_BeginAVIVideoFrame( width, height );
+	if ( !frame ) {
+		return;
+	}
+
+	linelen = width * 3;
+
+	for ( y = 0; y < height; y++ ) {
+		if ( bytesPerPixel == 3 ) {
+			Com_Memcpy( frame, pixels, linelen );
+		} else {
+			for ( x = 0; x < width; x++ ) {
+				frame[x*3 + 0] = pixels[x*bytesPerPixel + 0];
+				frame[x*3 + 1] = pixels[x*bytesPerPixel + 1];
+				frame[x*3 + 2] = pixels[x*bytesPerPixel + 2];
+			}
+		}
+
+		// gamma correct
+		if ( glConfig.deviceSupportsGamma ) {
+			R_GammaCorrect( frame, linelen );
+		}
+
+		frame += linelen;
+		pixels += width * bytesPerPixel + padlen;
+	}
+
+	ri.CL_EndAVIVideoFrame();
+}
+
+/*
+==================
+RB_FinishVideoReadback
+==================
+*/
+static void RB_FinishVideoReadback( videoReadback_t *readback )
+{
+	const byte	*pixels;
+	int			bytesPerPixel;
+
+	if ( !readback->pending ) {
+		return;
+	}
+
+	readback->pending = qfalse;
+
+	// OpenGL ES is only required to support reading GL_RGBA
+	bytesPerPixel = ( qglesMajorVersion >= 1 ) ? 4 : 3;
+
+	qglBindBuffer( GL_PIXEL_PACK_BUFFER, readback->pbo );
+
+	pixels = qglMapBufferRange( GL_PIXEL_PACK_BUFFER, 0, readback->size, GL_MAP_READ_BIT );
+	if ( pixels ) {
+		RB_HandOverVideoFrame( pixels, readback->width, readback->height, bytesPerPixel, readback->padlen );
+		qglUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+	}
+
+	qglBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+}
+
+/*
+==================
+RB_FinishVideoFrames
+
+Hands over the frames that are still being read back, oldest first
+==================
+*/
+void RB_FinishVideoFrames( void )
+{
+	int		i;
+
+	for ( i = 0; i < NUM_VIDEO_READBACKS; i++ ) {
+		RB_FinishVideoReadback( &backEnd.videoReadbacks[( backEnd.nextVideoReadback + i ) % NUM_VIDEO_READBACKS] );
+	}
+}
+
+/*
+==================
+R_ShutdownVideoReadback
+
+Frames that are still being read back are dropped
+==================
+*/
+void R_ShutdownVideoReadback( void )
+{
+	int		i;
+
+	for ( i = 0; i < NUM_VIDEO_READBACKS; i++ ) {
+		if ( backEnd.videoReadbacks[i].pbo ) {
+			qglDeleteBuffers( 1, &backEnd.videoReadbacks[i].pbo );
+		}
+	}
+
+	Com_Memset( backEnd.videoReadbacks, 0, sizeof( backEnd.videoReadbacks ) );
+	backEnd.nextVideoReadback = 0;
+}
+
 /*
 ==================
 RB_TakeVideoFrameCmd
+
+With pixel buffer objects glReadPixels returns right away and the frame is
+handed to the client when the buffer comes around again, by which time the
+copy has long finished.
 ==================
 */
 const void *RB_TakeVideoFrameCmd( const void *data )
 {
 	const videoFrameCommand_t	*cmd;
-	byte				*cBuf;
-	size_t				memcount, bytesPerPixel, linelen, avilinelen;
-	int				padwidth, avipadwidth, padlen, avipadlen;
-	int				yin, xin, xout;
-	GLint packAlign, format;
+	videoReadback_t		*readback;
+	byte				*buffer;
+	size_t				offset, memcount;
+	int					bytesPerPixel, padwidth, padlen;
+	GLint				packAlign, format;
 
 	// finish any 2D drawing if needed
 	if(tess.numIndexes)
 		RB_EndSurface();
 
 	cmd = (const videoFrameCommand_t *)data;
-	
+
+	if ( !qglMapBufferRange ) {
+		// converts RGBA to RGB for OpenGL ES
+		offset = 0;
+		buffer = RB_ReadPixels( 0, 0, cmd->width, cmd->height, &offset, &padlen );
+		RB_HandOverVideoFrame( buffer + offset, cmd->width, cmd->height, 3, padlen );
+		ri.Hunk_FreeTempMemory( buffer );
+
+		return (const void *)(cmd + 1);
+	}
+
 	// OpenGL ES is only required to support reading GL_RGBA
 	if (qglesMajorVersion >= 1) {
 		format = GL_RGBA;
@@ -993,83 +1121,39 @@ const void *RB_TakeVideoFrameCmd( const void *data )
 		bytesPerPixel = 3;
 	}
 
-	qglGetIntegerv(GL_PACK_ALIGNMENT, &packAlign);
+	qglGetIntegerv( GL_PACK_ALIGNMENT, &packAlign );
 
-	linelen = cmd->width * bytesPerPixel;
+	padwidth = PAD( cmd->width * bytesPerPixel, packAlign );
+	padlen = padwidth - cmd->width * bytesPerPixel;
+	memcount = padwidth * cmd->height;
 
-	// Alignment stuff for glReadPixels
-	padwidth = PAD(linelen, packAlign);
-	padlen = padwidth - linelen;
+	readback = &backEnd.videoReadbacks[backEnd.nextVideoReadback];
+	backEnd.nextVideoReadback = ( backEnd.nextVideoReadback + 1 ) % NUM_VIDEO_READBACKS;
 
-	avilinelen = cmd->width * 3;
+	// hand over the frame from the last time this buffer was used
+	RB_FinishVideoReadback( readback );
 
-	// AVI line padding
-	avipadwidth = PAD(avilinelen, AVI_LINE_PADDING);
-	avipadlen = avipadwidth - avilinelen;
+	if ( !readback->pbo ) {
+		qglGenBuffers( 1, &readback->pbo );
+	}
 
-	cBuf = PADP(cmd->captureBuffer, packAlign);
-		
-	qglReadPixels(0, 0, cmd->width, cmd->height, format,
-		GL_UNSIGNED_BYTE, cBuf);
+	qglBindBuffer( GL_PIXEL_PACK_BUFFER, readback->pbo );
 
-	memcount = padwidth * cmd->height;
+	if ( readback->size != memcount ) {
+		qglBufferData( GL_PIXEL_PACK_BUFFER, memcount, NULL, GL_STREAM_READ );
+		readback->size = memcount;
+	}
 
-	// gamma correct
-	if(glConfig.deviceSupportsGamma)
-		R_GammaCorrect(cBuf, memcount);
+	qglReadPixels( 0, 0, cmd->width, cmd->height, format, GL_UNSIGNED_BYTE, NULL );
 
-	if(cmd->motionJpeg)
-	{
-		// Convert RGBA to RGB, in place, line by line
-		if (format == GL_RGBA) {
-			linelen = cmd->width * 3;
-			padlen = padwidth - linelen;
-
-			for (yin = 0; yin < cmd->height; yin++) {
-				for (xin = 0, xout = 0; xout < linelen; xin += 4, xout += 3) {
-					cBuf[yin*padwidth + xout + 0] = cBuf[yin*padwidth + xin + 0];
-					cBuf[yin*padwidth + xout + 1] = cBuf[yin*padwidth + xin + 1];
-					cBuf[yin*padwidth + xout + 2] = cBuf[yin*padwidth + xin + 2];
-				}
-			}
-		}
+	qglBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
 
-		memcount = RE_SaveJPGToBuffer(cmd->encodeBuffer, avilinelen * cmd->height,
-			r_aviMotionJpegQuality->integer,
-			cmd->width, cmd->height, cBuf, padlen);
-		ri.CL_WriteAVIVideoFrame(cmd->encodeBuffer, memcount);
-	}
-	else
-	{
-		byte *lineend, *memend;
-		byte *srcptr, *destptr;
-	
-		srcptr = cBuf;
-		destptr = cmd->encodeBuffer;
-		memend = srcptr + memcount;
-		
-		// swap R and B and remove line paddings
-		while(srcptr < memend)
-		{
-			lineend = srcptr + linelen;
-			while(srcptr < lineend)
-			{
-				*destptr++ = srcptr[2];
-				*destptr++ = srcptr[1];
-				*destptr++ = srcptr[0];
-				srcptr += bytesPerPixel;
-			}
-			
-			Com_Memset(destptr, '\0', avipadlen);
-			destptr += avipadlen;
-			
-			srcptr += padlen;
-		}
-		
-		ri.CL_WriteAVIVideoFrame(cmd->encodeBuffer, avipadwidth * cmd->height);
-	}
+	readback->pending = qtrue;
+	readback->width = cmd->width;
+	readback->height = cmd->height;
+	readback->padlen = padlen;
 
-	return (const void *)(cmd + 1);	
+	return (const void *)(cmd + 1);
 }
 
 //============================================================================
@@ -1418,6 +1502,7 @@ void R_Register( void )
 	r_defaultFogParmsType = ri.Cvar_Get ("r_defaultfogParmsType", "exp", CVAR_LATCH );
 	r_globalLinearFogDrawSky = ri.Cvar_Get ("r_globalLinearFogDrawSky", "1", 0 );
 	r_shadersDirectory = ri.Cvar_Get( "r_shadersDirectory", "scripts", CVAR_LATCH );
+	r_shaderCache = ri.Cvar_Get( "r_shaderCache", "1", CVAR_ARCHIVE | CVAR_LATCH );
 	r_surfaceFlagNoDraw = ri.Cvar_Get( "r_surfaceFlagNoDraw", "128", CVAR_LATCH ); // Q3's SURF_NODRAW (0x80)
 	r_colorize2DIdentity = ri.Cvar_Get( "r_colorize2DIdentity", "0", CVAR_LATCH );
 	r_missingLightmapUseDiffuseLighting = ri.Cvar_Get( "r_missingLightmapUseDiffuseLighting", "0", CVAR_LATCH );
@@ -1470,6 +1555,7 @@ void R_Register( void )
 	r_saveFontData = ri.Cvar_Get( "r_saveFontData", "0", 0 );
 	r_fontBorderWidth = ri.Cvar_Get( "r_fontBorderWidth", "0", 0 );
 	r_fontForceAutoHint = ri.Cvar_Get( "r_fontForceAutoHint", "0", 0 );
+	r_fontCache = ri.Cvar_Get( "r_fontCache", "1", CVAR_ARCHIVE );
 
 	r_nocurves = ri.Cvar_Get ("r_nocurves", "0", CVAR_CHEAT );
 	r_drawworld = ri.Cvar_Get ("r_drawworld", "1", CVAR_CHEAT );
@@ -1481,6 +1567,7 @@ void R_Register( void )
 	r_flareSize = ri.Cvar_Get ("r_flareSize", "40", CVAR_CHEAT);
 	r_flareFade = ri.Cvar_Get ("r_flareFade", "7", CVAR_CHEAT);
 	r_flareCoeff = ri.Cvar_Get ("r_flareCoeff", FLARE_STDCOEFF, CVAR_CHEAT);
+	r_flareOcclusionQuery = ri.Cvar_Get ("r_flareOcclusionQuery", "1", CVAR_ARCHIVE);
 
 	r_skipBackEnd = ri.Cvar_Get ("r_skipBackEnd", "0", CVAR_CHEAT);
 
@@ -1556,6 +1643,8 @@ void R_ShutDownQueries(void)
 
 	if (r_drawSunRays->integer && r_drawSunRaysOcclusionQuery->integer)
 		qglDeleteQueries(ARRAY_LEN(tr.sunFlareQuery), tr.sunFlareQuery);
+
+	R_ShutdownFlares();
 }
 
 /*
@@ -1651,6 +1740,8 @@ void R_Init( void ) {
 
 	InitOpenGL();
 
+	R_InitWorkers();
+
 	R_InitImages();
 
 	if (glRefConfig.framebufferObject)
@@ -1718,6 +1809,7 @@ void RE_Shutdown( qboolean destroyWindow ) {
 
 	if ( tr.registered ) {
 		R_IssuePendingRenderCommands();
+		R_ShutdownVideoReadback();
 		R_ShutDownQueries();
 		if (glRefConfig.framebufferObject)
 			FBO_Shutdown();
@@ -1728,6 +1820,8 @@ void RE_Shutdown( qboolean destroyWindow ) {
 
 	R_DoneFreeType();
 
+	R_ShutdownWorkers();
+
 	// shut down platform specific OpenGL stuff
 	if ( destroyWindow ) {
 		GLimp_Shutdown();
@@ -1803,6 +1897,7 @@ refexport_t *GetRefAPI ( int apiVersion, refimport_t *rimp, qboolean headless )
 
 	re.MarkFragments = R_MarkFragments;
 	re.LerpTag = R_LerpTag;
+	re.LerpTags = R_LerpTags;
 	re.ModelBounds = R_ModelBounds;
 
 	re.ClearScene = RE_ClearScene;
@@ -1834,6 +1929,8 @@ refexport_t *GetRefAPI ( int apiVersion, refimport_t *rimp, qboolean headless )
 	re.inPVS = R_inPVS;
 
 	re.TakeVideoFrame = RE_TakeVideoFrame;
+	re.FinishVideoFrames = RE_FinishVideoFrames;
+	re.SaveJPGToBuffer = RE_SaveJPGToBuffer;
 
 	re.GetGlobalFog = RE_GetGlobalFog;
 	re.GetViewFog = RE_GetViewFog;
@@ -1471,6 +1471,13 @@ int			R_LerpTag( orientation_t *tag, qhandle_t handle,
 					 qhandle_t torsoFrameModel, int torsoStartFrame,
 					 qhandle_t torsoEndFrameModel, int torsoEndFrame,
 					 float torsoFrac );
+int			R_LerpTags( orientation_t *tags, int maxTags, qhandle_t handle,
+					 qhandle_t frameModel, int startFrame,
+					 qhandle_t endFrameModel, int endFrame,
+					 float frac, const vec3_t *torsoAxis, // vec3_t[3]
+					 qhandle_t torsoFrameModel, int torsoStartFrame,
+					 qhandle_t torsoEndFrameModel, int torsoEndFrame,
+					 float torsoFrac );
 int			R_ModelBounds( qhandle_t handle, vec3_t mins, vec3_t maxs, int startFrame, int endFrame, float frac );
 shader_t	*R_CustomSurfaceShader( const char *surfaceName, qhandle_t customShader, qhandle_t customSkin );
 
@@ -1654,6 +1661,18 @@ typedef struct {
 	int		msec;			// total msec for backend run
 } backEndCounters_t;
 
+// video frames are read back into pixel buffer objects
+// and handed to the client a couple of frames later
+#define NUM_VIDEO_READBACKS 3
+
+typedef struct {
+	GLuint		pbo;
+	size_t		size;
+	qboolean	pending;
+	int			width, height;
+	int			padlen;
+} videoReadback_t;
+
 // all state modified by the back end is separated
 // from the front end state
 typedef struct {
@@ -1673,6 +1692,9 @@ typedef struct {
 	FBO_t *last2DFBO;
 	qboolean    colorMask[4];
 	qboolean    depthFill;
+
+	videoReadback_t	videoReadbacks[NUM_VIDEO_READBACKS];
+	int			nextVideoReadback;
 } backEndState_t;
 
 /*
@@ -1904,6 +1926,7 @@ extern cvar_t	*r_flareFade;
 // coefficient for the flare intensity falloff function.
 #define FLARE_STDCOEFF "150"
 extern cvar_t	*r_flareCoeff;
+extern cvar_t	*r_flareOcclusionQuery;	// use occlusion queries instead of reading back depth for flares
 
 extern cvar_t	*r_ignore;				// used for debugging anything
 extern cvar_t	*r_verbose;				// used for verbose debug spew
@@ -2263,6 +2286,8 @@ void	R_InitSkins( void );
 int R_ComputeLOD( trRefEntity_t *ent );
 
 const void *RB_TakeVideoFrameCmd( const void *data );
+void RB_FinishVideoFrames( void );
+void R_ShutdownVideoReadback( void );
 
 //
 // tr_shader.c
@@ -2388,6 +2413,7 @@ FLARES
 */
 
 void R_ClearFlares( void );
+void R_ShutdownFlares( void );
 
 void RB_AddFlare( void *surface, int fogNum, vec3_t point, vec3_t color, float scale, vec3_t normal, int id, qboolean cgvisible, shader_t *shader );
 void RB_AddDlightFlares( void );
@@ -2572,6 +2598,14 @@ int R_GetMDSBoneTag( orientation_t *outTag, const model_t *mod,
 					 qhandle_t torsoFrameModel, int torsoStartFrame,
 					 qhandle_t torsoEndFrameModel, int torsoEndFrame,
 					 float torsoFrac );
+int R_GetMDSBoneTags( orientation_t *outTags, int maxTags, const model_t *mod,
+					 qhandle_t frameModel, int startFrame,
+					 qhandle_t endFrameModel, int endFrame,
+					 float frac, const vec3_t *torsoAxis,
+					 qhandle_t torsoFrameModel, int torsoStartFrame,
+					 qhandle_t torsoEndFrameModel, int torsoEndFrame,
+					 float torsoFrac );
+void R_ClearMDSPoseCache( void );
 
 void R_MDMAddAnimSurfaces( trRefEntity_t *ent );
 void RB_MDMSurfaceAnim( mdmSurface_t *surface );
@@ -2716,9 +2750,6 @@ typedef struct {
 	int						commandId;
 	int						width;
 	int						height;
-	byte					*captureBuffer;
-	byte					*encodeBuffer;
-	qboolean			motionJpeg;
 } videoFrameCommand_t;
 
 typedef struct
@@ -2826,8 +2857,8 @@ void RE_SaveJPG(char * filename, int quality, int image_width, int image_height,
 size_t RE_SaveJPGToBuffer(byte *buffer, size_t bufSize, int quality,
 		          int image_width, int image_height, byte *image_buffer, int padding);
 void RE_SaveTGA(char * filename, int image_width, int image_height, byte *image_buffer, int padding);
-void RE_TakeVideoFrame( int width, int height,
-		byte *captureBuffer, byte *encodeBuffer, qboolean motionJpeg );
+void RE_TakeVideoFrame( int width, int height );
+void RE_FinishVideoFrames( void );
 void RE_GetGlobalFog( fogType_t *type, vec3_t color, float *depthForOpaque, float *density, float *farClip );
 void RE_GetViewFog( const vec3_t origin, fogType_t *type, vec3_t color, float *depthForOpaque, float *density, float *farClip, qboolean inwater );
 
@@ -4994,17 +4994,12 @@ static shader_t *FinishShader( void ) {
 
 /*
 ====================
-FindShaderInShaderText
-
-Scans the combined text description of all the shader files for
-the given shader name.
+FindShaderInShaderTextHash
 
-return NULL if not found
-
-If found, it will return a valid shader
+Only looks in the shader name index
 =====================
 */
-static char *FindShaderInShaderText( const char *shadername ) {
+static char *FindShaderInShaderTextHash( const char *shadername ) {
 
 	char *token, *p;
 
@@ -5024,6 +5019,30 @@ static char *FindShaderInShaderText( const char *shadername ) {
 		}
 	}
 
+	return NULL;
+}
+
+/*
+====================
+FindShaderInShaderText
+
+Scans the combined text description of all the shader files for
+the given shader name.
+
+return NULL if not found
+
+If found, it will return a valid shader
+=====================
+*/
+static char *FindShaderInShaderText( const char *shadername ) {
+
+	char *token, *p;
+
+	p = FindShaderInShaderTextHash( shadername );
+	if ( p ) {
+		return p;
+	}
+
 	p = s_shaderText;
 
 	if ( !p ) {
@@ -5049,6 +5068,90 @@ static char *FindShaderInShaderText( const char *shadername ) {
 	return NULL;
 }
 
+/*
+====================
+R_AddPrefetchImageName
+=====================
+*/
+static void R_AddPrefetchImageName( const char *name, char names[MAX_PREFETCH_IMAGES][MAX_QPATH], int *numNames ) {
+	// $lightmap, *white, etc. aren't files
+	if ( !name[0] || name[0] == '$' || name[0] == '*' || *numNames >= MAX_PREFETCH_IMAGES ) {
+		return;
+	}
+
+	Q_strncpyz( names[*numNames], name, MAX_QPATH );
+	(*numNames)++;
+}
+
+/*
+====================
+R_PrefetchShaderImages
+
+Prefetches the images the shaders are likely to load. The shader text is only
+scanned for map, clampMap and animMap stages and implicit mappings, any image
+that is missed is loaded when the shader is parsed as usual.
+=====================
+*/
+void R_PrefetchShaderImages( const char **shaderNames, int numShaders ) {
+	char		imageNames[MAX_PREFETCH_IMAGES][MAX_QPATH];
+	const char	*names[MAX_PREFETCH_IMAGES];
+	char		strippedName[MAX_QPATH];
+	char		*text, *token;
+	int			i, depth, numNames;
+
+	numNames = 0;
+
+	for ( i = 0; i < numShaders; i++ ) {
+		COM_StripExtension( shaderNames[i], strippedName, sizeof( strippedName ) );
+
+		// skip the slow search of all the text FindShaderInShaderText falls back to
+		text = FindShaderInShaderTextHash( strippedName );
+		if ( !text ) {
+			// implicit shader
+			R_AddPrefetchImageName( shaderNames[i], imageNames, &numNames );
+			continue;
+		}
+
+		depth = 0;
+		do {
+			token = COM_ParseExt( &text, qtrue );
+			if ( !token[0] ) {
+				break;
+			}
+
+			if ( token[0] == '{' ) {
+				depth++;
+			} else if ( token[0] == '}' ) {
+				depth--;
+			} else if ( !Q_stricmp( token, "map" ) || !Q_stricmp( token, "clampMap" ) ) {
+				R_AddPrefetchImageName( COM_ParseExt( &text, qfalse ), imageNames, &numNames );
+			} else if ( !Q_stricmp( token, "animMap" ) || !Q_stricmp( token, "clampAnimMap" ) ) {
+				COM_ParseExt( &text, qfalse );	// frequency
+
+				while ( 1 ) {
+					token = COM_ParseExt( &text, qfalse );
+					if ( !token[0] ) {
+						break;
+					}
+					R_AddPrefetchImageName( token, imageNames, &numNames );
+				}
+			} else if ( !Q_stricmpn( token, "implicit", 8 ) ) {
+				token = COM_ParseExt( &text, qfalse );
+				if ( !token[0] || !strcmp( token, "-" ) ) {
+					token = (char *)shaderNames[i];
+				}
+				R_AddPrefetchImageName( token, imageNames, &numNames );
+			}
+		} while ( depth > 0 );
+	}
+
+	for ( i = 0; i < numNames; i++ ) {
+		names[i] = imageNames[i];
+	}
+
+	R_PrefetchImages( names, numNames );
+}
+
 
 /*
 ==================
@@ -5524,16 +5627,10 @@ a single large text block that can be scanned for shader names
 static void ScanAndLoadShaderFiles( void )
 {
 	char **shaderFiles;
-	char *buffers[MAX_SHADER_FILES] = {NULL};
-	char *p;
+	char **filenames;
 	int numShaderFiles;
 	int i;
-	char *oldp, *token, *hashMem, *textEnd;
-	int shaderTextHashTableSizes[MAX_SHADERTEXT_HASH], hash, size;
-	char shaderName[MAX_QPATH];
-	int shaderLine;
 
-	long sum = 0, summand;
 	// scan for shader files
 	shaderFiles = ri.FS_ListFiles( r_shadersDirectory->string, ".shader", &numShaderFiles );
 
@@ -5547,145 +5644,38 @@ static void ScanAndLoadShaderFiles( void )
 		numShaderFiles = MAX_SHADER_FILES;
 	}
 
-	// load and parse shader files
+	filenames = ri.Hunk_AllocateTempMemory( numShaderFiles * ( sizeof ( char * ) + MAX_QPATH ) );
+
 	for ( i = 0; i < numShaderFiles; i++ )
 	{
-		char filename[MAX_QPATH];
+		filenames[i] = (char *)( filenames + numShaderFiles ) + i * MAX_QPATH;
 
 		// look for a .mtr file first
 		{
 			char *ext;
-			Com_sprintf( filename, sizeof( filename ), "%s/%s", r_shadersDirectory->string, shaderFiles[i] );
-			if ( (ext = strrchr(filename, '.')) )
+			Com_sprintf( filenames[i], MAX_QPATH, "%s/%s", r_shadersDirectory->string, shaderFiles[i] );
+			if ( (ext = strrchr(filenames[i], '.')) )
 			{
 				strcpy(ext, ".mtr");
 			}
 
-			if ( ri.FS_ReadFile( filename, NULL ) <= 0 )
-			{
-				Com_sprintf( filename, sizeof( filename ), "%s/%s", r_shadersDirectory->string, shaderFiles[i] );
-			}
-		}
-		
-		ri.Printf( PRINT_DEVELOPER, "...loading '%s'\n", filename );
-		summand = ri.FS_ReadFile( filename, (void **)&buffers[i] );
-		
-		if ( !buffers[i] )
-			ri.Error( ERR_DROP, "Couldn't load %s", filename );
-		
-		// Do a simple check on the shader structure in that file to make sure one bad shader file cannot fuck up all other shaders.
-		p = buffers[i];
-		COM_BeginParseSession(filename);
-		while(1)
-		{
-			token = COM_ParseExt(&p, qtrue);
-			
-			if(!*token)
-				break;
-
-			Q_strncpyz(shaderName, token, sizeof(shaderName));
-			shaderLine = COM_GetCurrentParseLine();
-
-			token = COM_ParseExt(&p, qtrue);
-			if(token[0] != '{' || token[1] != '\0')
-			{
-				ri.Printf(PRINT_WARNING, "WARNING: Ignoring shader file %s. Shader \"%s\" on line %d missing opening brace",
-							filename, shaderName, shaderLine);
-				if (token[0])
-				{
-					ri.Printf(PRINT_WARNING, " (found \"%s\" on line %d)", token, COM_GetCurrentParseLine());
-				}
-				ri.Printf(PRINT_WARNING, ".\n");
-				ri.FS_FreeFile(buffers[i]);
-				buffers[i] = NULL;
-				break;
-			}
-
-			if(!SkipBracedSection(&p, 1))
+			if ( ri.FS_ReadFile( filenames[i], NULL ) <= 0 )
 			{
-				ri.Printf(PRINT_WARNING, "WARNING: Ignoring shader file %s. Shader \"%s\" on line %d missing closing brace.\n",
-							filename, shaderName, shaderLine);
-				ri.FS_FreeFile(buffers[i]);
-				buffers[i] = NULL;
-				break;
+				Com_sprintf( filenames[i], MAX_QPATH, "%s/%s", r_shadersDirectory->string, shaderFiles[i] );
 			}
 		}
-			
-		
-		if (buffers[i])
-			sum += summand;		
-	}
-
-	// build single large buffer
-	s_shaderText = ri.Hunk_Alloc( sum + numShaderFiles*2, h_low );
-	s_shaderText[ 0 ] = '\0';
-	textEnd = s_shaderText;
- 
-	// free in reverse order, so the temp files are all dumped
-	for ( i = numShaderFiles - 1; i >= 0 ; i-- )
-	{
-		if ( !buffers[i] )
-			continue;
-
-		strcat( textEnd, buffers[i] );
-		strcat( textEnd, "\n" );
-		textEnd += strlen( textEnd );
-		ri.FS_FreeFile( buffers[i] );
 	}
 
-	COM_Compress( s_shaderText );
-
 	// free up memory
 	ri.FS_FreeFileList( shaderFiles );
 
-	Com_Memset(shaderTextHashTableSizes, 0, sizeof(shaderTextHashTableSizes));
-	size = 0;
-
-	p = s_shaderText;
-	// look for shader names
-	while ( 1 ) {
-		token = COM_ParseExt( &p, qtrue );
-		if ( token[0] == 0 ) {
-			break;
-		}
-
-		hash = generateHashValue(token, MAX_SHADERTEXT_HASH);
-		shaderTextHashTableSizes[hash]++;
-		size++;
-		SkipBracedSection(&p, 0);
-	}
-
-	size += MAX_SHADERTEXT_HASH;
-
-	hashMem = ri.Hunk_Alloc( size * sizeof(char *), h_low );
-
-	for (i = 0; i < MAX_SHADERTEXT_HASH; i++) {
-		shaderTextHashTable[i] = (char **) hashMem;
-		hashMem = ((char *) hashMem) + ((shaderTextHashTableSizes[i] + 1) * sizeof(char *));
-	}
-
-	Com_Memset(shaderTextHashTableSizes, 0, sizeof(shaderTextHashTableSizes));
-
-	p = s_shaderText;
-	// look for shader names
-	while ( 1 ) {
-		oldp = p;
-		token = COM_ParseExt( &p, qtrue );
-		if ( token[0] == 0 ) {
-			break;
-		}
-
-		hash = generateHashValue(token, MAX_SHADERTEXT_HASH);
-		shaderTextHashTable[hash][shaderTextHashTableSizes[hash]++] = oldp;
-
-		SkipBracedSection(&p, 0);
-	}
-
-	return;
+	// read, check and index the files, or load them from the cache
+	s_shaderText = R_LoadShaderText( r_shadersDirectory->string, filenames, numShaderFiles,
+						generateHashValue, shaderTextHashTable, MAX_SHADERTEXT_HASH );
 
+	ri.Hunk_FreeTempMemory( filenames );
 }
 
-
 /*
 ====================
 CreateInternalShaders
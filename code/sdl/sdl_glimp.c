@@ -81,6 +81,7 @@ void (APIENTRYP qglCompressedTexImage2DARB) (GLenum target, GLint level,
 						GLsizei width, GLsizei height,
 						GLint border, GLsizei imageSize,
 						const GLvoid *data);
+void (APIENTRYP qglGetCompressedTexImageARB) (GLenum target, GLint level, GLvoid *img);
 
 
 #define GLE(ret, name, ...) name##proc * qgl##name = NULL;
@@ -323,6 +324,11 @@ static qboolean GLimp_GetProcAddresses( qboolean fixedFunction ) {
 			QGL_1_1_FIXED_FUNCTION_PROCS;
 			QGL_DESKTOP_1_1_PROCS;
 			QGL_DESKTOP_1_1_FIXED_FUNCTION_PROCS;
+
+			// buffer objects are only used for reading back video frames
+			if ( QGL_VERSION_ATLEAST( 1, 5 ) ) {
+				QGL_1_5_PROCS;
+			}
 		} else if ( qglesMajorVersion == 1 && qglesMinorVersion >= 1 ) {
 			// OpenGL ES 1.1 (2.0 is not backward compatible)
 			QGL_1_1_PROCS;
@@ -978,6 +984,7 @@ static void GLimp_InitExtensions( qboolean fixedFunction )
 
 	glConfig.textureCompression = TC_NONE;
 	qglCompressedTexImage2DARB = NULL;
+	qglGetCompressedTexImageARB = NULL;
 
 	// GL_EXT_texture_compression_s3tc
 	if ( ( QGLES_VERSION_ATLEAST( 2, 0 ) || SDL_GL_ExtensionSupported( "GL_ARB_texture_compression" ) ) &&
@@ -985,6 +992,7 @@ static void GLimp_InitExtensions( qboolean fixedFunction )
 	{
 		// Compressed DDS image uploading requires this
 		qglCompressedTexImage2DARB = SDL_GL_GetProcAddress( "glCompressedTexImage2DARB" );
+		qglGetCompressedTexImageARB = SDL_GL_GetProcAddress( "glGetCompressedTexImageARB" );
 
 		if ( r_ext_compressed_textures->value )
 		{
@@ -1107,6 +1115,26 @@ static void GLimp_InitExtensions( qboolean fixedFunction )
 		{
 			ri.Printf( PRINT_ALL, "...GL_EXT_compiled_vertex_array not found\n" );
 		}
+
+		// GL_ARB_occlusion_query
+		if ( QGL_VERSION_ATLEAST( 1, 5 ) )
+		{
+#define GLE(ret, name, ...) qgl##name = (name##proc *) SDL_GL_GetProcAddress("gl" #name);
+			QGL_ARB_occlusion_query_PROCS;
+#undef GLE
+			ri.Printf( PRINT_ALL, "...using GL_ARB_occlusion_query\n" );
+		}
+		else if ( SDL_GL_ExtensionSupported( "GL_ARB_occlusion_query" ) )
+		{
+#define GLE(ret, name, ...) qgl##name = (name##proc *) SDL_GL_GetProcAddress("gl" #name "ARB");
+			QGL_ARB_occlusion_query_PROCS;
+#undef GLE
+			ri.Printf( PRINT_ALL, "...using GL_ARB_occlusion_query\n" );
+		}
+		else
+		{
+			ri.Printf( PRINT_ALL, "...GL_ARB_occlusion_query not found\n" );
+		}
 	}
 
 	glConfig.textureFilterAnisotropic = qfalse;
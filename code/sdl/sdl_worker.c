@@ -0,0 +1,267 @@
+/*
+===========================================================================
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of Spearmint Source Code.
+
+Spearmint Source Code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 3 of the License,
+or (at your option) any later version.
+
+Spearmint Source Code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Spearmint Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, Spearmint Source Code is also subject to certain additional terms.
+You should have received a copy of these additional terms immediately following
+the terms and conditions of the GNU General Public License.  If not, please
+request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional
+terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc.,
+Suite 120, Rockville, Maryland 20850 USA.
+===========================================================================
+*/
+
+/*
+** SDL_WORKER.C
+**
+** Worker threads for splitting up CPU heavy renderer work, such as image
+** resampling and mipmapping, across multiple cores.
+**
+** R_ParallelFor may only be called from the thread that called R_InitWorkers
+** and functions run by the workers must not use GL or ri functions, except
+** for ri.Malloc, ri.Free and ri.Printf between R_LockWorkers and
+** R_UnlockWorkers. ri.Error must never be called from a worker.
+*/
+
+#ifdef USE_LOCAL_HEADERS
+#	include "SDL.h"
+#else
+#	include <SDL.h>
+#endif
+
+#include "../renderercommon/tr_common.h"
+
+#define MAX_WORKERS 16
+
+typedef struct {
+	SDL_Thread		*thread;
+	SDL_sem			*wake;
+
+	parallelFunc_t	func;
+	void			*data;
+	int				start, end;	// end is exclusive
+} worker_t;
+
+static worker_t		workers[MAX_WORKERS];
+static int			numWorkers;
+static SDL_sem		*workersDone;
+static SDL_mutex	*workersLock;
+static qboolean		workersQuit;
+
+cvar_t *r_workerThreads;
+
+/*
+===============
+R_WorkerThread
+===============
+*/
+static int SDLCALL R_WorkerThread( void *data ) {
+	worker_t *worker = data;
+
+	while ( 1 ) {
+		SDL_SemWait( worker->wake );
+
+		if ( workersQuit ) {
+			break;
+		}
+
+		worker->func( worker->data, worker->start, worker->end );
+
+		SDL_SemPost( workersDone );
+	}
+
+	return 0;
+}
+
+/*
+===============
+R_InitWorkers
+===============
+*/
+void R_InitWorkers( void ) {
+	int i, count;
+
+	r_workerThreads = ri.Cvar_Get( "r_workerThreads", "-1", CVAR_ARCHIVE | CVAR_LATCH );
+	ri.Cvar_SetDescription( r_workerThreads, "Number of threads to use for CPU heavy image processing in addition to the main thread, -1 uses one per CPU core." );
+
+	numWorkers = 0;
+	workersQuit = qfalse;
+
+	count = r_workerThreads->integer;
+	if ( count < 0 ) {
+		count = SDL_GetCPUCount() - 1;
+	}
+	count = MIN( count, MAX_WORKERS );
+
+	if ( count <= 0 ) {
+		return;
+	}
+
+	workersLock = SDL_CreateMutex();
+	if ( !workersLock ) {
+		ri.Printf( PRINT_WARNING, "R_InitWorkers: %s\n", SDL_GetError() );
+		return;
+	}
+
+	workersDone = SDL_CreateSemaphore( 0 );
+	if ( !workersDone ) {
+		ri.Printf( PRINT_WARNING, "R_InitWorkers: %s\n", SDL_GetError() );
+		return;
+	}
+
+	for ( i = 0; i < count; i++ ) {
+		worker_t *worker = &workers[numWorkers];
+
+		worker->wake = SDL_CreateSemaphore( 0 );
+		if ( !worker->wake ) {
+			break;
+		}
+
+		worker->thread = SDL_CreateThread( R_WorkerThread, "renderer worker", worker );
+		if ( !worker->thread ) {
+			SDL_DestroySemaphore( worker->wake );
+			worker->wake = NULL;
+			break;
+		}
+
+		numWorkers++;
+	}
+
+	if ( numWorkers < count ) {
+		ri.Printf( PRINT_WARNING, "R_InitWorkers: Only created %d of %d threads: %s\n", numWorkers, count, SDL_GetError() );
+	}
+
+	ri.Printf( PRINT_DEVELOPER, "Using %d renderer worker threads\n", numWorkers );
+}
+
+/*
+===============
+R_ShutdownWorkers
+===============
+*/
+void R_ShutdownWorkers( void ) {
+	int i;
+
+	workersQuit = qtrue;
+
+	for ( i = 0; i < numWorkers; i++ ) {
+		SDL_SemPost( workers[i].wake );
+	}
+
+	for ( i = 0; i < numWorkers; i++ ) {
+		SDL_WaitThread( workers[i].thread, NULL );
+		SDL_DestroySemaphore( workers[i].wake );
+	}
+
+	if ( workersDone ) {
+		SDL_DestroySemaphore( workersDone );
+		workersDone = NULL;
+	}
+
+	if ( workersLock ) {
+		SDL_DestroyMutex( workersLock );
+		workersLock = NULL;
+	}
+
+	Com_Memset( workers, 0, sizeof ( workers ) );
+	numWorkers = 0;
+}
+
+/*
+===============
+R_NumWorkerThreads
+
+Returns the number of threads R_ParallelFor splits work between, including
+the calling thread
+===============
+*/
+int R_NumWorkerThreads( void ) {
+	return numWorkers + 1;
+}
+
+/*
+===============
+R_LockWorkers
+
+Serializes the ri functions called by functions run by the workers
+===============
+*/
+void R_LockWorkers( void ) {
+	if ( workersLock ) {
+		SDL_LockMutex( workersLock );
+	}
+}
+
+/*
+===============
+R_UnlockWorkers
+===============
+*/
+void R_UnlockWorkers( void ) {
+	if ( workersLock ) {
+		SDL_UnlockMutex( workersLock );
+	}
+}
+
+/*
+===============
+R_ParallelFor
+
+Calls func( data, start, end ) for ranges covering 0 to count - 1, the ranges are split between
+the workers and the calling thread. Ranges are at least minPerJob long so that
+small jobs are not worth waking the workers for. Returns once all are done.
+===============
+*/
+void R_ParallelFor( parallelFunc_t func, void *data, int count, int minPerJob ) {
+	int i, numJobs, start;
+
+	numJobs = numWorkers + 1;
+
+	if ( minPerJob > 0 && count / minPerJob < numJobs ) {
+		numJobs = count / minPerJob;
+	}
+
+	if ( numJobs < 2 ) {
+		func( data, 0, count );
+		return;
+	}
+
+	start = 0;
+
+	for ( i = 0; i < numJobs - 1; i++ ) {
+		worker_t *worker = &workers[i];
+
+		worker->func = func;
+		worker->data = data;
+		worker->start = start;
+		worker->end = start + count / numJobs;
+
+		start = worker->end;
+
+		SDL_SemPost( worker->wake );
+	}
+
+	// the calling thread does the remainder
+	func( data, start, count );
+
+	for ( i = 0; i < numJobs - 1; i++ ) {
+		SDL_SemWait( workersDone );
+	}
+}
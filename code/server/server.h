@@ -309,6 +309,7 @@ extern	cvar_t	*sv_pure;
 extern	cvar_t	*sv_floodProtect;
 extern	cvar_t	*sv_lanForceRate;
 extern	cvar_t	*sv_banFile;
+extern	cvar_t	*sv_autoMasterDemo;
 
 extern	cvar_t	*sv_public;
 
@@ -412,6 +413,18 @@ int SV_SendQueuedMessages(void);
 //
 void SV_Heartbeat_f( void );
 
+//
+// sv_demo.c
+//
+void SV_DemoAnalyze_f( void );
+void SV_MasterRecord_f( void );
+void SV_MasterStop_f( void );
+void SV_MasterDemoStop( void );
+void SV_MasterDemoAutoRecord( void );
+void SV_MasterDemoFrame( void );
+void SV_MasterDemoConfigstring( int index );
+void SV_MasterDemoServerCommand( client_t *client, int localPlayerNum, const char *cmd );
+
 //
 // sv_snapshot.c
 //
@@ -441,6 +454,7 @@ qboolean	SV_inPVS (const vec3_t p1, const vec3_t p2);
 // sv_bot.c
 //
 void		SV_BotFrame( int time );
+void		SV_BotFrameStats_f( void );
 int			SV_BotAllocateClient(void);
 void		SV_BotFreeClient( int playerNum );
 
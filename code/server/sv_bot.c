@@ -43,6 +43,15 @@ static bot_debugpoly_t *debugpolygons;
 cvar_t *bot_maxdebugpolys;
 
 cvar_t *bot_enable;
+cvar_t *bot_frameWarnUsec;
+
+// time the game spends running the bots each frame
+static struct {
+	int		frames;
+	int		overruns;
+	int		usecMax;
+	int64_t	usecTotal;
+} botFrameStats;
 
 
 /*
@@ -246,10 +255,41 @@ SV_BotFrame
 ==================
 */
 void SV_BotFrame( int time ) {
+	int64_t start;
+	int usec;
+
 	if (!bot_enable->integer) return;
 	//NOTE: maybe the game is already shutdown
 	if (!gvm) return;
+
+	start = Sys_Microseconds();
 	VM_Call( gvm, BOTAI_START_FRAME, time );
+	usec = Sys_Microseconds() - start;
+
+	botFrameStats.frames++;
+	botFrameStats.usecTotal += usec;
+	if ( usec > botFrameStats.usecMax ) {
+		botFrameStats.usecMax = usec;
+	}
+	if ( bot_frameWarnUsec->integer > 0 && usec > bot_frameWarnUsec->integer ) {
+		botFrameStats.overruns++;
+	}
+}
+
+/*
+==================
+SV_BotFrameStats_f
+
+Print and reset the time spent running the bots
+==================
+*/
+void SV_BotFrameStats_f( void ) {
+	Com_Printf( "bots: %d frames, %d usec average, %d usec max\n", botFrameStats.frames,
+		botFrameStats.frames ? (int)( botFrameStats.usecTotal / botFrameStats.frames ) : 0, botFrameStats.usecMax );
+	if ( bot_frameWarnUsec->integer > 0 ) {
+		Com_Printf( "%d frames over %d usec\n", botFrameStats.overruns, bot_frameWarnUsec->integer );
+	}
+	Com_Memset( &botFrameStats, 0, sizeof( botFrameStats ) );
 }
 
 /*
@@ -262,6 +302,8 @@ Called at start up and map change
 void SV_BotInitCvars(void) {
 	bot_enable = Cvar_Get( "bot_enable", "1", CVAR_LATCH );
 	bot_maxdebugpolys = Cvar_Get( "bot_maxdebugpolys", "2", CVAR_LATCH );
+	bot_frameWarnUsec = Cvar_Get( "bot_frameWarnUsec", "0", 0 );
+	Cvar_SetDescription( bot_frameWarnUsec, "Bot frames taking longer than this many microseconds are counted as overruns by botframestats, it doesn't limit the frame. The botlib variable max_frameusec sets the budget for routing and movement prediction." );
 }
 
 /*
@@ -278,6 +320,7 @@ void SV_BotInitBotLib(void) {
 		bot_maxdebugpolys->modified = qfalse;
 	}
 	Com_Memset( debugpolygons, 0, sizeof(bot_debugpoly_t) * bot_maxdebugpolys->integer );
+	Com_Memset( &botFrameStats, 0, sizeof( botFrameStats ) );
 }
 
 
@@ -1240,6 +1240,10 @@ void SV_AddOperatorCommands( void ) {
 	Cmd_AddCommand("bandel", SV_BanDel_f);
 	Cmd_AddCommand("exceptdel", SV_ExceptDel_f);
 	Cmd_AddCommand("flushbans", SV_FlushBans_f);
+	Cmd_AddCommand("demoanalyze", SV_DemoAnalyze_f);
+	Cmd_AddCommand("masterrecord", SV_MasterRecord_f);
+	Cmd_AddCommand("masterstop", SV_MasterStop_f);
+	Cmd_AddCommand("botframestats", SV_BotFrameStats_f);
 }
 
 /*
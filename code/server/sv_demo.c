@@ -0,0 +1,1278 @@
+/*
+===========================================================================
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of Spearmint Source Code.
+
+Spearmint Source Code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 3 of the License,
+or (at your option) any later version.
+
+Spearmint Source Code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Spearmint Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, Spearmint Source Code is also subject to certain additional terms.
+You should have received a copy of these additional terms immediately following
+the terms and conditions of the GNU General Public License.  If not, please
+request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional
+terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc.,
+Suite 120, Rockville, Maryland 20850 USA.
+===========================================================================
+*/
+// sv_demo.c -- demo analysis and master demo recording
+
+#include "server.h"
+
+/*
+===============================================================================
+
+DEMO ANALYSIS
+
+Parses client demos with msg.c alone, without a cgame, renderer or sound, as
+fast as the demo can be read, and writes what they contain as JSON lines: one
+object per gamestate, server command and snapshot. Entity and player state
+fields are keyed by their index in the game's net field tables, so a map has
+to be running for the game to have registered them. Start one dedicated
+server process per batch of demos to use more cores.
+===============================================================================
+*/
+
+#define DEMO_PARSE_ENTITIES		( MAX_SPLITVIEW * PACKET_BACKUP * MAX_SNAPSHOT_ENTITIES )
+#define DEMO_JSON_SIZE			0x10000
+
+typedef struct {
+	qboolean	valid;
+	int			messageNum;
+	int			serverTime;
+	int			numPSs;
+	int			localPlayerIndex[MAX_SPLITVIEW];
+	int			playerNums[MAX_SPLITVIEW];
+	int			numEntities;
+	int			parseEntitiesNum;
+} demoSnapshot_t;
+
+typedef struct {
+	fileHandle_t	out;
+
+	int				entitySize;
+	int				playerSize;
+
+	byte			*baselines;			// [MAX_GENTITIES]
+	byte			*parseEntities;		// [DEMO_PARSE_ENTITIES]
+	int				parseEntitiesNum;
+	byte			*playerStates;		// [PACKET_BACKUP][MAX_SPLITVIEW]
+
+	demoSnapshot_t	snapshots[PACKET_BACKUP];
+	int				lastMessageNum;
+	int				serverTime;
+	int				serverCommandSequence;
+
+	qboolean		illegible;
+	int				numSnapshots;
+	int				numCommands;
+
+	char			json[DEMO_JSON_SIZE];
+} demoParse_t;
+
+static demoParse_t	*dp;
+
+/*
+==================
+SV_DemoEntity
+==================
+*/
+static sharedEntityState_t *SV_DemoEntity( int num ) {
+	return (sharedEntityState_t *)( dp->parseEntities + ( num % DEMO_PARSE_ENTITIES ) * dp->entitySize );
+}
+
+/*
+==================
+SV_DemoPlayerState
+==================
+*/
+static sharedPlayerState_t *SV_DemoPlayerState( int messageNum, int index ) {
+	return (sharedPlayerState_t *)( dp->playerStates + ( ( messageNum & PACKET_MASK ) * MAX_SPLITVIEW + index ) * dp->playerSize );
+}
+
+/*
+==================
+SV_DemoWriteString
+
+Writes s as a quoted JSON string
+==================
+*/
+static void SV_DemoWriteString( const char *s ) {
+	char	buf[MAX_STRING_CHARS];
+	int		len;
+
+	len = 0;
+	buf[len++] = '"';
+
+	for ( ; *s; s++ ) {
+		if ( len > sizeof( buf ) - 8 ) {
+			FS_Write( buf, len, dp->out );
+			len = 0;
+		}
+
+		if ( *s == '"' || *s == '\\' ) {
+			buf[len++] = '\\';
+			buf[len++] = *s;
+		} else if ( (byte)*s < ' ' ) {
+			len += Com_sprintf( buf + len, sizeof( buf ) - len, "\\u%04x", (byte)*s );
+		} else {
+			buf[len++] = *s;
+		}
+	}
+
+	buf[len++] = '"';
+	FS_Write( buf, len, dp->out );
+}
+
+/*
+==================
+SV_DemoWriteText
+==================
+*/
+static void SV_DemoWriteText( const char *s ) {
+	FS_Write( s, strlen( s ), dp->out );
+}
+
+/*
+==================
+SV_DemoWriteState
+
+Writes an entity or player state as a JSON object of its non-zero fields
+==================
+*/
+static void SV_DemoWriteState( const void *state, qboolean playerState ) {
+	if ( !MSG_NetFieldsToJSON( state, playerState, dp->json, sizeof( dp->json ) ) ) {
+		Com_Printf( "SV_DemoWriteState: state too large\n" );
+		dp->json[0] = '\0';
+	}
+
+	SV_DemoWriteText( "{" );
+	SV_DemoWriteText( dp->json );
+	SV_DemoWriteText( "}" );
+}
+
+/*
+==================
+SV_DemoParseGamestate
+==================
+*/
+static void SV_DemoParseGamestate( msg_t *msg ) {
+	int		cmd, i, num;
+
+	dp->serverCommandSequence = MSG_ReadLong( msg );
+
+	Com_Memset( dp->snapshots, 0, sizeof( dp->snapshots ) );
+	Com_Memset( dp->baselines, 0, MAX_GENTITIES * dp->entitySize );
+	dp->lastMessageNum = 0;
+
+	SV_DemoWriteText( va( "{\"gamestate\":%d,\"cs\":{", dp->serverCommandSequence ) );
+
+	num = 0;
+	while ( 1 ) {
+		cmd = MSG_ReadByte( msg );
+
+		if ( cmd == svc_EOF ) {
+			break;
+		}
+
+		if ( cmd != svc_configstring ) {
+			Com_Printf( "SV_DemoParseGamestate: bad command byte\n" );
+			dp->illegible = qtrue;
+			break;
+		}
+
+		i = MSG_ReadShort( msg );
+		if ( i < 0 || i >= MAX_CONFIGSTRINGS ) {
+			Com_Printf( "configstring > MAX_CONFIGSTRINGS\n" );
+			dp->illegible = qtrue;
+			break;
+		}
+
+		SV_DemoWriteText( va( "%s\"%d\":", num++ ? "," : "", i ) );
+		SV_DemoWriteString( MSG_ReadBigString( msg ) );
+	}
+
+	SV_DemoWriteText( "},\"players\":[" );
+	for ( i = 0; i < MAX_SPLITVIEW; i++ ) {
+		SV_DemoWriteText( va( "%s%d", i ? "," : "", MSG_ReadLong( msg ) ) );
+	}
+	SV_DemoWriteText( "]}\n" );
+}
+
+/*
+==================
+SV_DemoParseEntities
+
+Same as CL_ParsePacketEntities
+==================
+*/
+static void SV_DemoParseEntities( msg_t *msg, demoSnapshot_t *oldframe, demoSnapshot_t *newframe ) {
+	sharedEntityState_t	*oldstate, *state;
+	int			oldindex, oldnum, newnum;
+	int			oldNumEntities;
+
+	newframe->parseEntitiesNum = dp->parseEntitiesNum;
+	newframe->numEntities = 0;
+
+	oldNumEntities = oldframe ? oldframe->numEntities : 0;
+	oldindex = 0;
+	oldstate = NULL;
+
+	if ( oldindex >= oldNumEntities ) {
+		oldnum = 99999;
+	} else {
+		oldstate = SV_DemoEntity( oldframe->parseEntitiesNum + oldindex );
+		oldnum = oldstate->number;
+	}
+
+	while ( 1 ) {
+		newnum = MSG_ReadBits( msg, GENTITYNUM_BITS );
+
+		if ( msg->readcount > msg->cursize ) {
+			Com_Printf( "SV_DemoParseEntities: end of message\n" );
+			dp->illegible = qtrue;
+			return;
+		}
+
+		// unchanged entities from the old frame, then this one
+		while ( oldnum < newnum || ( newnum == MAX_GENTITIES-1 && oldnum != 99999 ) ) {
+			state = SV_DemoEntity( dp->parseEntitiesNum );
+			Com_Memcpy( state, oldstate, dp->entitySize );
+			dp->parseEntitiesNum++;
+			newframe->numEntities++;
+
+			oldindex++;
+			if ( oldindex >= oldNumEntities ) {
+				oldnum = 99999;
+			} else {
+				oldstate = SV_DemoEntity( oldframe->parseEntitiesNum + oldindex );
+				oldnum = oldstate->number;
+			}
+		}
+
+		if ( newnum == MAX_GENTITIES-1 ) {
+			break;
+		}
+
+		state = SV_DemoEntity( dp->parseEntitiesNum );
+
+		if ( oldnum == newnum ) {
+			MSG_ReadDeltaEntity( msg, oldstate, state, newnum );
+
+			oldindex++;
+			if ( oldindex >= oldNumEntities ) {
+				oldnum = 99999;
+			} else {
+				oldstate = SV_DemoEntity( oldframe->parseEntitiesNum + oldindex );
+				oldnum = oldstate->number;
+			}
+		} else {
+			MSG_ReadDeltaEntity( msg, (sharedEntityState_t *)( dp->baselines + newnum * dp->entitySize ), state, newnum );
+		}
+
+		// removed entities aren't kept
+		if ( state->number != MAX_GENTITIES-1 ) {
+			dp->parseEntitiesNum++;
+			newframe->numEntities++;
+		}
+	}
+}
+
+/*
+==================
+SV_DemoParseSnapshot
+
+Same as CL_ParseSnapshot, writing valid snapshots out instead of passing
+them to the cgame
+==================
+*/
+static void SV_DemoParseSnapshot( msg_t *msg, int messageNum ) {
+	demoSnapshot_t	newSnap, *old;
+	sharedPlayerState_t	*oldPS;
+	byte		areamask[MAX_MAP_AREA_BYTES];
+	int			deltaNum, len, i;
+
+	Com_Memset( &newSnap, 0, sizeof( newSnap ) );
+
+	newSnap.messageNum = messageNum;
+	newSnap.serverTime = MSG_ReadLong( msg );
+
+	deltaNum = MSG_ReadByte( msg );
+	MSG_ReadByte( msg );	// snapFlags
+
+	old = NULL;
+	if ( !deltaNum ) {
+		newSnap.valid = qtrue;
+	} else {
+		old = &dp->snapshots[( messageNum - deltaNum ) & PACKET_MASK];
+		if ( old->valid && old->messageNum == messageNum - deltaNum
+			&& dp->parseEntitiesNum - old->parseEntitiesNum <= DEMO_PARSE_ENTITIES - MAX_SNAPSHOT_ENTITIES * MAX_SPLITVIEW ) {
+			newSnap.valid = qtrue;
+		}
+	}
+
+	newSnap.numPSs = MSG_ReadByte( msg );
+	if ( newSnap.numPSs > MAX_SPLITVIEW ) {
+		newSnap.numPSs = MAX_SPLITVIEW;
+	}
+
+	for ( i = 0; i < MAX_SPLITVIEW; i++ ) {
+		newSnap.localPlayerIndex[i] = MSG_ReadByte( msg );
+		newSnap.playerNums[i] = MSG_ReadByte( msg );
+
+		if ( newSnap.localPlayerIndex[i] >= newSnap.numPSs || newSnap.playerNums[i] >= MAX_CLIENTS ) {
+			newSnap.localPlayerIndex[i] = -1;
+			newSnap.playerNums[i] = -1;
+		}
+
+		len = MSG_ReadByte( msg );
+		if ( len > sizeof( areamask ) ) {
+			Com_Printf( "SV_DemoParseSnapshot: Invalid size %d for areamask\n", len );
+			dp->illegible = qtrue;
+			return;
+		}
+		MSG_ReadData( msg, areamask, len );
+	}
+
+	for ( i = 0; i < MAX_SPLITVIEW; i++ ) {
+		if ( newSnap.localPlayerIndex[i] == -1 ) {
+			continue;
+		}
+
+		if ( old && old->valid && old->localPlayerIndex[i] != -1 ) {
+			oldPS = SV_DemoPlayerState( old->messageNum, old->localPlayerIndex[i] );
+		} else {
+			oldPS = NULL;
+		}
+
+		MSG_ReadDeltaPlayerstate( msg, oldPS, SV_DemoPlayerState( messageNum, newSnap.localPlayerIndex[i] ),
+									newSnap.playerNums[i] );
+	}
+
+	SV_DemoParseEntities( msg, newSnap.valid ? old : NULL, &newSnap );
+
+	if ( !newSnap.valid || dp->illegible ) {
+		return;
+	}
+
+	// forget frames skipped since the last one
+	for ( i = dp->lastMessageNum + 1; i < messageNum && i > messageNum - PACKET_BACKUP; i++ ) {
+		dp->snapshots[i & PACKET_MASK].valid = qfalse;
+	}
+	dp->lastMessageNum = messageNum;
+	dp->snapshots[messageNum & PACKET_MASK] = newSnap;
+	dp->serverTime = newSnap.serverTime;
+	dp->numSnapshots++;
+
+	// write it out
+	SV_DemoWriteText( va( "{\"snap\":%d,\"time\":%d,\"players\":[", messageNum, newSnap.serverTime ) );
+	for ( i = 0, len = 0; i < MAX_SPLITVIEW; i++ ) {
+		if ( newSnap.localPlayerIndex[i] == -1 ) {
+			continue;
+		}
+		SV_DemoWriteText( va( "%s{\"num\":%d,\"ps\":", len++ ? "," : "", newSnap.playerNums[i] ) );
+		SV_DemoWriteState( SV_DemoPlayerState( messageNum, newSnap.localPlayerIndex[i] ), qtrue );
+		SV_DemoWriteText( "}" );
+	}
+
+	SV_DemoWriteText( "],\"ents\":[" );
+	for ( i = 0; i < newSnap.numEntities; i++ ) {
+		sharedEntityState_t *ent = SV_DemoEntity( newSnap.parseEntitiesNum + i );
+
+		SV_DemoWriteText( va( "%s{\"n\":%d,\"es\":", i ? "," : "", ent->number ) );
+		SV_DemoWriteState( ent, qfalse );
+		SV_DemoWriteText( "}" );
+	}
+	SV_DemoWriteText( "]}\n" );
+}
+
+/*
+==================
+SV_DemoParseMessage
+
+Returns qfalse if the rest of the demo can't be understood
+==================
+*/
+static qboolean SV_DemoParseMessage( msg_t *msg, int messageNum ) {
+	int		cmd, seq, num;
+	char	*s;
+
+	MSG_Bitstream( msg );
+	MSG_ReadLong( msg );	// reliable acknowledge
+
+	while ( 1 ) {
+		if ( dp->illegible ) {
+			return qfalse;
+		}
+
+		if ( msg->readcount > msg->cursize ) {
+			Com_Printf( "SV_DemoParseMessage: read past end of server message\n" );
+			return qfalse;
+		}
+
+		cmd = MSG_ReadByte( msg );
+
+		switch ( cmd ) {
+		case svc_EOF:
+			return qtrue;
+		case svc_nop:
+			break;
+		case svc_serverCommand:
+			seq = MSG_ReadLong( msg );
+			s = MSG_ReadString( msg );
+			if ( seq <= dp->serverCommandSequence ) {
+				break;
+			}
+			dp->serverCommandSequence = seq;
+			dp->numCommands++;
+			SV_DemoWriteText( va( "{\"cmd\":%d,\"time\":%d,\"text\":", seq, dp->serverTime ) );
+			SV_DemoWriteString( s );
+			SV_DemoWriteText( "}\n" );
+			break;
+		case svc_gamestate:
+			SV_DemoParseGamestate( msg );
+			break;
+		case svc_baseline:
+			num = MSG_ReadBits( msg, GENTITYNUM_BITS );
+			if ( num < 0 || num >= MAX_GENTITIES ) {
+				Com_Printf( "Baseline number out of range: %i\n", num );
+				return qfalse;
+			}
+			MSG_ReadDeltaEntity( msg, NULL, (sharedEntityState_t *)( dp->baselines + num * dp->entitySize ), num );
+			break;
+		case svc_snapshot:
+			SV_DemoParseSnapshot( msg, messageNum );
+			break;
+		case svc_download:
+		case svc_voipSpeex:
+		case svc_voipOpus:
+			// these are last in a message and carry nothing of interest
+			return qtrue;
+		default:
+			Com_Printf( "SV_DemoParseMessage: Illegible server message %d\n", cmd );
+			return qfalse;
+		}
+	}
+}
+
+/*
+==================
+SV_DemoAnalyze
+
+Writes the contents of demos/<name> to demos/<name>.jsonl
+==================
+*/
+static void SV_DemoAnalyze( const char *demoName ) {
+	char			name[MAX_OSPATH];
+	char			dotdemoext[MAX_QPATH];
+	demoHeader_t	header;
+	fileHandle_t	f;
+	msg_t			buf;
+	byte			bufData[MAX_MSGLEN];
+	int				values[2];
+	int				start, msec, messages;
+
+	Com_sprintf( name, sizeof( name ), "demos/%s", demoName );
+	Com_sprintf( dotdemoext, sizeof( dotdemoext ), ".%s", com_demoext->string );
+	COM_DefaultExtension( name, sizeof( name ), dotdemoext );
+
+	if ( FS_FOpenFileRead( name, &f, qtrue ) <= 0 || !f ) {
+		Com_Printf( "Couldn't open demo '%s'\n", name );
+		return;
+	}
+
+	if ( FS_Read( &header, offsetof( demoHeader_t, protocol ) + sizeof( int ), f ) != offsetof( demoHeader_t, protocol ) + sizeof( int )
+		|| memcmp( header.magic, DEMO_MAGIC, sizeof( header.magic ) ) ) {
+		Com_Printf( "Invalid demo header in '%s'\n", name );
+		FS_FCloseFile( f );
+		return;
+	}
+
+	FS_Seek( f, LittleLong( header.headerSize ), FS_SEEK_SET );
+
+	Q_strcat( name, sizeof( name ), ".jsonl" );
+	dp->out = FS_FOpenFileWrite( name );
+	if ( !dp->out ) {
+		Com_Printf( "Couldn't write '%s'\n", name );
+		FS_FCloseFile( f );
+		return;
+	}
+
+	dp->parseEntitiesNum = 0;
+	dp->serverTime = 0;
+	dp->serverCommandSequence = 0;
+	dp->illegible = qfalse;
+	dp->numSnapshots = 0;
+	dp->numCommands = 0;
+	Com_Memset( dp->snapshots, 0, sizeof( dp->snapshots ) );
+
+	start = Sys_Milliseconds();
+	messages = 0;
+
+	while ( FS_Read( values, sizeof( values ), f ) == sizeof( values ) ) {
+		values[0] = LittleLong( values[0] );
+		values[1] = LittleLong( values[1] );
+
+		if ( values[1] == -1 ) {
+			break;
+		}
+
+		if ( values[1] < 0 || values[1] > sizeof( bufData ) ) {
+			Com_Printf( "Bad message length %d in '%s'\n", values[1], demoName );
+			break;
+		}
+
+		MSG_Init( &buf, bufData, sizeof( bufData ) );
+		if ( FS_Read( buf.data, values[1], f ) != values[1] ) {
+			Com_Printf( "Demo file was truncated.\n" );
+			break;
+		}
+		buf.cursize = values[1];
+
+		messages++;
+		if ( !SV_DemoParseMessage( &buf, values[0] ) ) {
+			break;
+		}
+	}
+
+	msec = Sys_Milliseconds() - start;
+
+	Com_Printf( "%s: %d messages, %d snapshots, %d commands in %d msec\n", name, messages,
+		dp->numSnapshots, dp->numCommands, msec );
+
+	FS_FCloseFile( dp->out );
+	FS_FCloseFile( f );
+}
+
+/*
+==================
+SV_DemoAnalyze_f
+
+demoanalyze <demo> [demo ...]
+==================
+*/
+void SV_DemoAnalyze_f( void ) {
+	int		i;
+
+	if ( Cmd_Argc() < 2 ) {
+		Com_Printf( "demoanalyze <demo> [demo ...]\n" );
+		return;
+	}
+
+	if ( !com_sv_running->integer || !sv.gameEntityStateSize || !sv.gamePlayerStateSize ) {
+		Com_Printf( "The game has to be running to decode entities, start a map first.\n" );
+		return;
+	}
+
+	dp = Z_Malloc( sizeof( *dp ) );
+	dp->entitySize = sv.gameEntityStateSize;
+	dp->playerSize = sv.gamePlayerStateSize;
+	dp->baselines = Z_Malloc( MAX_GENTITIES * dp->entitySize );
+	dp->parseEntities = Z_Malloc( DEMO_PARSE_ENTITIES * dp->entitySize );
+	dp->playerStates = Z_Malloc( PACKET_BACKUP * MAX_SPLITVIEW * dp->playerSize );
+
+	for ( i = 1; i < Cmd_Argc(); i++ ) {
+		SV_DemoAnalyze( Cmd_Argv( i ) );
+	}
+
+	Z_Free( dp->playerStates );
+	Z_Free( dp->parseEntities );
+	Z_Free( dp->baselines );
+	Z_Free( dp );
+	dp = NULL;
+}
+
+/*
+===============================================================================
+
+MASTER DEMO RECORDING
+
+A master demo is recorded once per server, not per client. Each server frame
+stores every entity that may be sent to any client and every player's state,
+so the match can be replayed from any viewpoint later.
+
+File layout:
+4	"SMMD"
+4	MASTERDEMO_VERSION
+4	protocol
+4	sv_fps
+records of <frame> <length> <bitstream message>, ending with -1 -1
+
+Messages use svc_ ops, each message ends with svc_EOF:
+svc_gamestate		[long frame] [configstrings as in a client gamestate]
+svc_configstring	[short index] [bigstring]
+svc_serverCommand	[short client, -1 for all] [byte localPlayerNum+1] [string]
+svc_snapshot		[long serverTime] [byte full]
+					([byte playerNum] [delta playerstate])... [byte 255]
+					[packet entities as in a client snapshot]
+
+Frames are delta compressed against the previous frame with the game's net
+fields. A full frame, preceded by a gamestate record, starts the demo and
+follows any frame that couldn't be recorded.
+
+Encoding happens on the main thread, since the bitstream coder isn't
+reentrant, and never waits: if the writer thread hasn't freed a buffer the
+frame is dropped and the next one is full. Records are encoded into a buffer
+big enough for the worst case and copied to the writer's buffer, a record
+that still overflows stops the recording. The time it takes is measured and
+reported by masterrecord.
+===============================================================================
+*/
+
+#define MASTERDEMO_MAGIC	"SMMD"
+#define MASTERDEMO_VERSION	1
+#define MASTERDEMO_JOBS		32
+
+typedef struct {
+	int		frame;
+	int		len;
+	byte	*data;
+	int		size;
+} masterDemoJob_t;
+
+typedef struct {
+	qboolean		recording;
+	char			name[MAX_OSPATH];
+	fileHandle_t	f;
+
+	// writer thread, jobs are written in order from jobTail
+	sysThread_t		*thread;
+	sysSemaphore_t	*jobsQueued;
+	sysSemaphore_t	*jobsFree;
+	masterDemoJob_t	jobs[MASTERDEMO_JOBS];
+	int				jobHead;
+	int				jobTail;
+	volatile qboolean	writeError;
+
+	// records are encoded here first
+	byte			*msgData;
+	int				msgSize;
+	int				maxEntityBits;
+	int				maxPlayerBits;
+
+	// previous frame
+	int				frame;
+	qboolean		fullFrame;
+	int				entitySize;
+	int				playerSize;
+	byte			*entities;			// [MAX_GENTITIES]
+	qboolean		entityPresent[MAX_GENTITIES];
+	int				numEntities;		// highest present entity + 1
+	byte			*players;			// [MAX_CLIENTS]
+	qboolean		playerPresent[MAX_CLIENTS];
+
+	// cost
+	int				startTime;
+	int				frames;
+	int				droppedFrames;
+	int				droppedRecords;
+	int64_t			bytes;
+	int64_t			usecTotal;
+	int				usecMax;
+} masterDemo_t;
+
+static masterDemo_t	md;
+
+/*
+==================
+SV_MasterDemoWriteData
+
+Runs on the writer thread, errors are reported by SV_MasterDemoStop
+==================
+*/
+static void SV_MasterDemoWriteData( const void *data, int len ) {
+	if ( md.writeError ) {
+		return;
+	}
+
+	if ( FS_ThreadWrite( data, len, md.f ) < len ) {
+		md.writeError = qtrue;
+	}
+}
+
+/*
+==================
+SV_MasterDemoWriteJob
+==================
+*/
+static void SV_MasterDemoWriteJob( masterDemoJob_t *job ) {
+	int		header[2];
+
+	header[0] = LittleLong( job->frame );
+	header[1] = LittleLong( job->len );
+
+	SV_MasterDemoWriteData( header, sizeof( header ) );
+	SV_MasterDemoWriteData( job->data, job->len );
+}
+
+/*
+==================
+SV_MasterDemoWriterThread
+==================
+*/
+static int SV_MasterDemoWriterThread( void *data ) {
+	masterDemoJob_t	*job;
+
+	while ( 1 ) {
+		Sys_SemaphoreWait( md.jobsQueued );
+
+		job = &md.jobs[md.jobTail];
+		if ( job->len < 0 ) {
+			break;
+		}
+
+		SV_MasterDemoWriteJob( job );
+
+		md.jobTail = ( md.jobTail + 1 ) % MASTERDEMO_JOBS;
+		Sys_SemaphorePost( md.jobsFree );
+	}
+
+	return 0;
+}
+
+/*
+==================
+SV_MasterDemoBeginRecord
+
+Sets msg up to encode a record of at most maxBits before Huffman coding
+into, returns qfalse if all buffers are waiting to be written
+==================
+*/
+static qboolean SV_MasterDemoBeginRecord( msg_t *msg, int maxBits ) {
+	int		size;
+
+	if ( md.thread && !Sys_SemaphoreTryWait( md.jobsFree ) ) {
+		return qfalse;
+	}
+
+	size = MSG_BitstreamSize( maxBits );
+	if ( size > md.msgSize ) {
+		if ( md.msgData ) {
+			Z_Free( md.msgData );
+		}
+		md.msgData = Z_Malloc( size );
+		md.msgSize = size;
+	}
+
+	MSG_Init( msg, md.msgData, md.msgSize );
+	MSG_Bitstream( msg );
+	return qtrue;
+}
+
+/*
+==================
+SV_MasterDemoEndRecord
+
+Queues the record for writing. A record that overflowed stops the recording,
+returns qfalse then
+==================
+*/
+static qboolean SV_MasterDemoEndRecord( msg_t *msg ) {
+	masterDemoJob_t	*job;
+
+	job = &md.jobs[md.jobHead];
+
+	if ( msg->overflowed ) {
+		if ( md.thread ) {
+			Sys_SemaphorePost( md.jobsFree );
+		}
+
+		Com_Printf( S_COLOR_RED "ERROR: master demo record of frame %d overflowed\n", md.frame );
+		SV_MasterDemoStop();
+		return qfalse;
+	}
+
+	// the writer is done with the buffer
+	if ( msg->cursize > job->size ) {
+		if ( job->data ) {
+			Z_Free( job->data );
+		}
+		job->data = Z_Malloc( msg->cursize );
+		job->size = msg->cursize;
+	}
+
+	Com_Memcpy( job->data, msg->data, msg->cursize );
+	job->frame = md.frame;
+	job->len = msg->cursize;
+	md.bytes += 8 + msg->cursize;
+
+	if ( !md.thread ) {
+		SV_MasterDemoWriteJob( job );
+		return qtrue;
+	}
+
+	md.jobHead = ( md.jobHead + 1 ) % MASTERDEMO_JOBS;
+	Sys_SemaphorePost( md.jobsQueued );
+	return qtrue;
+}
+
+/*
+==================
+SV_MasterDemoRecordLost
+
+A configstring or command that couldn't be recorded is covered by the
+gamestate in front of the next full frame
+==================
+*/
+static void SV_MasterDemoRecordLost( void ) {
+	md.droppedRecords++;
+	md.fullFrame = qtrue;
+}
+
+/*
+==================
+SV_MasterDemoConfigstring
+
+Called by SV_SetConfigstring after a change
+==================
+*/
+void SV_MasterDemoConfigstring( int index ) {
+	msg_t	msg;
+
+	if ( !md.recording || md.fullFrame ) {
+		return;
+	}
+
+	if ( !SV_MasterDemoBeginRecord( &msg, 8 + 16 + ( strlen( sv.configstrings[index].s ) + 1 ) * 8 + 8 ) ) {
+		SV_MasterDemoRecordLost();
+		return;
+	}
+
+	MSG_WriteByte( &msg, svc_configstring );
+	MSG_WriteShort( &msg, index );
+	MSG_WriteBigString( &msg, sv.configstrings[index].s );
+	MSG_WriteByte( &msg, svc_EOF );
+
+	SV_MasterDemoEndRecord( &msg );
+}
+
+/*
+==================
+SV_MasterDemoServerCommand
+
+Called by SV_SendServerCommand, client is NULL for broadcasts
+==================
+*/
+void SV_MasterDemoServerCommand( client_t *client, int localPlayerNum, const char *cmd ) {
+	msg_t	msg;
+
+	if ( !md.recording ) {
+		return;
+	}
+
+	if ( !SV_MasterDemoBeginRecord( &msg, 8 + 16 + 8 + ( strlen( cmd ) + 1 ) * 8 + 8 ) ) {
+		md.droppedRecords++;
+		return;
+	}
+
+	MSG_WriteByte( &msg, svc_serverCommand );
+	MSG_WriteShort( &msg, client ? client - svs.clients : -1 );
+	MSG_WriteByte( &msg, localPlayerNum + 1 );
+	MSG_WriteString( &msg, cmd );
+	MSG_WriteByte( &msg, svc_EOF );
+
+	SV_MasterDemoEndRecord( &msg );
+}
+
+/*
+==================
+SV_MasterDemoWriteGamestate
+
+Records all configstrings, returns qfalse if they couldn't be recorded
+==================
+*/
+static qboolean SV_MasterDemoWriteGamestate( void ) {
+	msg_t	msg;
+	int		i, bits;
+
+	bits = 8 + 32 + 8;
+	for ( i = 0 ; i < MAX_CONFIGSTRINGS ; i++ ) {
+		if ( sv.configstrings[i].s[0] ) {
+			bits += 8 + 16 + ( strlen( sv.configstrings[i].s ) + 1 ) * 8;
+		}
+	}
+
+	if ( !SV_MasterDemoBeginRecord( &msg, bits ) ) {
+		return qfalse;
+	}
+
+	MSG_WriteByte( &msg, svc_gamestate );
+	MSG_WriteLong( &msg, md.frame );
+
+	for ( i = 0 ; i < MAX_CONFIGSTRINGS ; i++ ) {
+		if ( sv.configstrings[i].s[0] ) {
+			MSG_WriteByte( &msg, svc_configstring );
+			MSG_WriteShort( &msg, i );
+			MSG_WriteBigString( &msg, sv.configstrings[i].s );
+		}
+	}
+
+	MSG_WriteByte( &msg, svc_EOF );
+
+	return SV_MasterDemoEndRecord( &msg );
+}
+
+/*
+==================
+SV_MasterDemoMaxSnapshotBits
+
+Returns the most bits SV_MasterDemoWriteSnapshot can write before Huffman coding
+==================
+*/
+static int SV_MasterDemoMaxSnapshotBits( void ) {
+	int		numEntities;
+
+	// present entities and removes of the ones present in the previous frame
+	numEntities = MAX( sv.num_entities, md.numEntities );
+	numEntities = MIN( numEntities, MAX_GENTITIES-1 );
+
+	return 8 + 32 + 8
+		+ sv_maxclients->integer * ( 8 + md.maxPlayerBits ) + 8
+		+ numEntities * md.maxEntityBits + GENTITYNUM_BITS + 8;
+}
+
+/*
+==================
+SV_MasterDemoWriteSnapshot
+
+Writes the current frame as a delta from the previous one, or from nothing
+for a full frame, and makes it the previous frame
+==================
+*/
+static void SV_MasterDemoWriteSnapshot( msg_t *msg, qboolean full ) {
+	sharedEntity_t		*ent;
+	sharedEntityState_t	*state, *old;
+	sharedPlayerState_t	*ps, *oldPs;
+	qboolean	present;
+	int			i;
+
+	MSG_WriteByte( msg, svc_snapshot );
+	MSG_WriteLong( msg, sv.time );
+	MSG_WriteByte( msg, full );
+
+	for ( i = 0; i < sv_maxclients->integer; i++ ) {
+		if ( !svs.players[i].inUse || !svs.players[i].inWorld ) {
+			md.playerPresent[i] = qfalse;
+			continue;
+		}
+
+		ps = SV_GamePlayerNum( i );
+		oldPs = (sharedPlayerState_t *)( md.players + i * md.playerSize );
+
+		MSG_WriteByte( msg, i );
+		MSG_WriteDeltaPlayerstate( msg, ( !full && md.playerPresent[i] ) ? oldPs : NULL, ps );
+
+		Com_Memcpy( oldPs, ps, md.playerSize );
+		md.playerPresent[i] = qtrue;
+	}
+	MSG_WriteByte( msg, 255 );
+
+	// entities are written in increasing number order like SV_EmitPacketEntities
+	for ( i = 0; i < MAX_GENTITIES-1; i++ ) {
+		old = (sharedEntityState_t *)( md.entities + i * md.entitySize );
+
+		if ( i < sv.num_entities ) {
+			ent = SV_GentityNum( i );
+			state = &ent->s;
+			present = ent->r.linked && !( ent->r.svFlags & SVF_NOCLIENT ) && state->number == i;
+		} else {
+			state = NULL;
+			present = qfalse;
+		}
+
+		if ( !present ) {
+			if ( md.entityPresent[i] && !full ) {
+				MSG_WriteDeltaEntity( msg, old, NULL, qtrue );
+			}
+			md.entityPresent[i] = qfalse;
+			continue;
+		}
+
+		if ( md.entityPresent[i] && !full ) {
+			MSG_WriteDeltaEntity( msg, old, state, qfalse );
+		} else {
+			MSG_WriteDeltaEntity( msg, NULL, state, qtrue );
+		}
+
+		Com_Memcpy( old, state, md.entitySize );
+		md.entityPresent[i] = qtrue;
+
+		if ( i >= md.numEntities ) {
+			md.numEntities = i + 1;
+		}
+	}
+
+	MSG_WriteBits( msg, (MAX_GENTITIES-1), GENTITYNUM_BITS );
+	MSG_WriteByte( msg, svc_EOF );
+}
+
+/*
+==================
+SV_MasterDemoFrame
+
+Called by SV_Frame after the game has run
+==================
+*/
+void SV_MasterDemoFrame( void ) {
+	msg_t		msg;
+	int64_t		start;
+	int			usec;
+	qboolean	full, recorded;
+
+	if ( !md.recording ) {
+		return;
+	}
+
+	if ( md.writeError ) {
+		SV_MasterDemoStop();
+		return;
+	}
+
+	start = Sys_Microseconds();
+
+	md.frame++;
+
+	full = md.fullFrame;
+
+	if ( full && !SV_MasterDemoWriteGamestate() ) {
+		recorded = qfalse;
+	} else if ( SV_MasterDemoBeginRecord( &msg, SV_MasterDemoMaxSnapshotBits() ) ) {
+		SV_MasterDemoWriteSnapshot( &msg, full );
+		recorded = SV_MasterDemoEndRecord( &msg );
+	} else {
+		recorded = qfalse;
+	}
+
+	// a record overflowed
+	if ( !md.recording ) {
+		return;
+	}
+
+	if ( recorded ) {
+		md.fullFrame = qfalse;
+	} else {
+		md.droppedFrames++;
+		md.fullFrame = qtrue;
+	}
+
+	usec = Sys_Microseconds() - start;
+
+	md.frames++;
+	md.usecTotal += usec;
+	if ( usec > md.usecMax ) {
+		md.usecMax = usec;
+	}
+}
+
+/*
+==================
+SV_MasterDemoStatus
+==================
+*/
+static void SV_MasterDemoStatus( void ) {
+	int		msec;
+
+	msec = Sys_Milliseconds() - md.startTime;
+
+	Com_Printf( "%s: %d frames in %d sec, %d KB\n", md.name, md.frames, msec / 1000, (int)( md.bytes / 1024 ) );
+	Com_Printf( "encoding: %d usec average, %d usec max\n", md.frames ? (int)( md.usecTotal / md.frames ) : 0, md.usecMax );
+	Com_Printf( "dropped: %d frames, %d records\n", md.droppedFrames, md.droppedRecords );
+}
+
+/*
+==================
+SV_MasterDemoStart
+==================
+*/
+static void SV_MasterDemoStart( const char *name ) {
+	int		header[4];
+
+	if ( md.recording ) {
+		Com_Printf( "Already recording master demo %s.\n", md.name );
+		return;
+	}
+
+	if ( sv.state != SS_GAME ) {
+		Com_Printf( "Server is not running.\n" );
+		return;
+	}
+
+	if ( !sv.gameEntityStateSize || !sv.gamePlayerStateSize ) {
+		Com_Printf( "Game hasn't set net fields, can't record a master demo.\n" );
+		return;
+	}
+
+	Com_Memset( &md, 0, sizeof( md ) );
+
+	Com_sprintf( md.name, sizeof( md.name ), "demos/%s.mdm", name );
+	md.f = FS_FOpenFileWrite( md.name );
+	if ( !md.f ) {
+		Com_Printf( "ERROR: couldn't open %s.\n", md.name );
+		return;
+	}
+
+	Com_Memcpy( &header[0], MASTERDEMO_MAGIC, 4 );
+	header[1] = LittleLong( MASTERDEMO_VERSION );
+	header[2] = LittleLong( com_protocol->integer );
+	header[3] = LittleLong( sv_fps->integer );
+	FS_Write( header, sizeof( header ), md.f );
+
+	md.entitySize = sv.gameEntityStateSize;
+	md.playerSize = sv.gamePlayerStateSize;
+	md.entities = Z_Malloc( MAX_GENTITIES * md.entitySize );
+	md.players = Z_Malloc( MAX_CLIENTS * md.playerSize );
+	md.maxEntityBits = MSG_MaxDeltaBits( qfalse );
+	md.maxPlayerBits = MSG_MaxDeltaBits( qtrue );
+
+	md.jobsQueued = Sys_CreateSemaphore( 0 );
+	md.jobsFree = Sys_CreateSemaphore( MASTERDEMO_JOBS );
+
+	if ( md.jobsQueued && md.jobsFree ) {
+		md.thread = Sys_CreateThread( SV_MasterDemoWriterThread, NULL );
+	}
+
+	if ( !md.thread ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: Couldn't start master demo writer thread, writing inline\n" );
+	}
+
+	md.fullFrame = qtrue;
+	md.startTime = Sys_Milliseconds();
+	md.recording = qtrue;
+
+	Com_Printf( "Recording master demo %s.\n", md.name );
+}
+
+/*
+==================
+SV_MasterDemoStop
+
+Waits for the queued records to be written
+==================
+*/
+void SV_MasterDemoStop( void ) {
+	int		end[2];
+	int		i;
+
+	if ( !md.recording ) {
+		return;
+	}
+
+	if ( md.thread ) {
+		Sys_SemaphoreWait( md.jobsFree );
+		md.jobs[md.jobHead].len = -1;
+		Sys_SemaphorePost( md.jobsQueued );
+		Sys_WaitThread( md.thread );
+	}
+
+	if ( md.jobsQueued ) {
+		Sys_DestroySemaphore( md.jobsQueued );
+	}
+	if ( md.jobsFree ) {
+		Sys_DestroySemaphore( md.jobsFree );
+	}
+
+	end[0] = end[1] = -1;
+	SV_MasterDemoWriteData( end, sizeof( end ) );
+	FS_FCloseFile( md.f );
+
+	if ( md.writeError ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: Couldn't write master demo %s\n", md.name );
+	}
+
+	for ( i = 0; i < MASTERDEMO_JOBS; i++ ) {
+		if ( md.jobs[i].data ) {
+			Z_Free( md.jobs[i].data );
+		}
+	}
+	if ( md.msgData ) {
+		Z_Free( md.msgData );
+	}
+	Z_Free( md.players );
+	Z_Free( md.entities );
+
+	md.recording = qfalse;
+
+	Com_Printf( "Stopped master demo.\n" );
+	SV_MasterDemoStatus();
+}
+
+/*
+==================
+SV_MasterDemoStartDated
+
+Names the demo after the date and map
+==================
+*/
+static void SV_MasterDemoStartDated( void ) {
+	qtime_t		now;
+
+	Com_RealTime( &now );
+
+	SV_MasterDemoStart( va( "%04d%02d%02d%02d%02d%02d-%s",
+		1900 + now.tm_year, 1 + now.tm_mon, now.tm_mday,
+		now.tm_hour, now.tm_min, now.tm_sec, sv_mapname->string ) );
+}
+
+/*
+==================
+SV_MasterDemoAutoRecord
+
+Called when a map has been spawned
+==================
+*/
+void SV_MasterDemoAutoRecord( void ) {
+	if ( sv_autoMasterDemo->integer ) {
+		SV_MasterDemoStartDated();
+	}
+}
+
+/*
+==================
+SV_MasterRecord_f
+
+masterrecord [name]
+==================
+*/
+void SV_MasterRecord_f( void ) {
+	if ( md.recording ) {
+		SV_MasterDemoStatus();
+		return;
+	}
+
+	if ( Cmd_Argc() > 2 ) {
+		Com_Printf( "masterrecord [name]\n" );
+		return;
+	}
+
+	if ( Cmd_Argc() == 2 ) {
+		SV_MasterDemoStart( Cmd_Argv( 1 ) );
+	} else {
+		SV_MasterDemoStartDated();
+	}
+}
+
+/*
+==================
+SV_MasterStop_f
+==================
+*/
+void SV_MasterStop_f( void ) {
+	if ( !md.recording ) {
+		Com_Printf( "Not recording a master demo.\n" );
+		return;
+	}
+
+	SV_MasterDemoStop();
+}
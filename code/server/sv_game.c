@@ -312,6 +312,8 @@ intptr_t SV_GameSystemCalls( intptr_t *args ) {
 		return 0;
 	case G_MILLISECONDS:
 		return Sys_Milliseconds();
+	case G_MICROSECONDS:
+		return (int)Sys_Microseconds();
 	case G_REAL_TIME:
 		return Com_RealTime( VMA(1) );
 	case G_SNAPVECTOR:
@@ -540,6 +542,15 @@ intptr_t SV_GameSystemCalls( intptr_t *args ) {
 		return re.LerpTag( VMA(1), args[2], args[3], args[4], args[5], args[6], VMF(7), VMA(8), VMA(9), NULL, 0, 0, 0, 0, 0 );
 	case G_R_LERPTAG_TORSO:
 		return re.LerpTag( VMA(1), args[2], args[3], args[4], args[5], args[6], VMF(7), VMA(8), VMA(9), VMA(10), args[11], args[12], args[13], args[14], VMF(15) );
+	case G_R_LERPTAGS:
+		if ( args[2] < 0 ) {
+			Com_Error( ERR_DROP, "G_R_LERPTAGS: negative maxTags" );
+		}
+		VM_CheckBlock( args[1], args[2] * sizeof ( orientation_t ), "G_R_LERPTAGS" );
+		if ( args[9] ) {
+			VM_CheckBlock( args[9], 3 * sizeof ( vec3_t ), "G_R_LERPTAGS" );
+		}
+		return re.LerpTags( VMA(1), args[2], args[3], args[4], args[5], args[6], args[7], VMF(8), VMA(9), args[10], args[11], args[12], args[13], VMF(14) );
 	case G_R_MODELBOUNDS:
 		return re.ModelBounds( args[1], VMA(2), VMA(3), args[4], args[5], VMF(6) );
 
@@ -137,6 +137,7 @@ void SV_SetConfigstring (int index, const char *val) {
 	// send it to all the clients if we aren't
 	// spawning a new server
 	if ( sv.state == SS_GAME || sv.restarting ) {
+		SV_MasterDemoConfigstring( index );
 
 		// send the data to all relevant clients
 		for (i = 0, client = svs.clients; i < sv_maxclients->integer ; i++, client++) {
@@ -426,6 +427,8 @@ SV_ClearServer
 static void SV_ClearServer(void) {
 	int i;
 
+	SV_MasterDemoStop();
+
 	for ( i = 0 ; i < MAX_CONFIGSTRINGS ; i++ ) {
 		if ( sv.configstrings[i].s ) {
 			Z_Free( sv.configstrings[i].s );
@@ -726,6 +729,8 @@ void SV_SpawnServer( char *server, qboolean killBots ) {
 
 	Hunk_SetMark();
 
+	SV_MasterDemoAutoRecord();
+
 #ifndef DEDICATED
 	if ( com_dedicated->integer ) {
 		// restart cgame in order to show console for dedicated servers
@@ -810,6 +815,7 @@ void SV_Init (void)
 	sv_mapChecksum = Cvar_Get ("sv_mapChecksum", "", CVAR_ROM);
 	sv_lanForceRate = Cvar_Get ("sv_lanForceRate", "1", CVAR_ARCHIVE );
 	sv_banFile = Cvar_Get("sv_banFile", "serverbans.dat", CVAR_ARCHIVE);
+	sv_autoMasterDemo = Cvar_Get("sv_autoMasterDemo", "0", CVAR_ARCHIVE);
 
 	sv_public = Cvar_Get("sv_public", "0", 0);
 	Cvar_CheckRange(sv_public, -2, 1, qtrue);
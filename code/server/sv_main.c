@@ -69,6 +69,7 @@ cvar_t	*sv_pure;
 cvar_t	*sv_floodProtect;
 cvar_t	*sv_lanForceRate; // dedicated 1 (LAN) server forces local client rates to 99999 (bug #491)
 cvar_t	*sv_banFile;
+cvar_t	*sv_autoMasterDemo;		// record a master demo of every map
 
 cvar_t  *sv_public;
 
@@ -223,6 +224,8 @@ void QDECL SV_SendServerCommand(client_t *cl, int localPlayerNum, const char *fm
 		return;
 	}
 
+	SV_MasterDemoServerCommand( cl, localPlayerNum, (char *)message );
+
 	if ( cl != NULL ) {
 		SV_AddServerCommand( cl, localPlayerNum, (char *)message );
 		return;
@@ -1243,6 +1246,8 @@ void SV_Frame( int msec ) {
 		time_game = Sys_Milliseconds () - startTime;
 	}
 
+	SV_MasterDemoFrame();
+
 	// check timeouts
 	SV_CheckTimeouts();
 
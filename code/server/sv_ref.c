@@ -76,6 +76,7 @@ refexport_t *GetRefAPI ( int apiVersion, refimport_t *rimp, qboolean headless )
 
 	re.RegisterModel = RE_RegisterModel;
 	re.LerpTag = R_LerpTag;
+	re.LerpTags = R_LerpTags;
 	re.ModelBounds = R_ModelBounds;
 
 	return &re;
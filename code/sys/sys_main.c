@@ -368,6 +368,9 @@ cpuFeatures_t Sys_GetProcessorFeatures( void )
 	if( SDL_HasSSE( ) )        features |= CF_SSE;
 	if( SDL_HasSSE2( ) )       features |= CF_SSE2;
 	if( SDL_HasAltiVec( ) )    features |= CF_ALTIVEC;
+#if SDL_VERSION_ATLEAST( 2, 0, 4 )
+	if( SDL_HasAVX2( ) )       features |= CF_AVX2;
+#endif
 #endif
 
 	return features;
@@ -47,6 +47,7 @@ Suite 120, Rockville, Maryland 20850 USA.
 #include <fenv.h>
 #include <sys/wait.h>
 #include <time.h>
+#include <pthread.h>
 
 qboolean stdinIsATTY;
 
@@ -142,6 +143,25 @@ int Sys_Milliseconds (void)
 	return curtime;
 }
 
+/*
+================
+Sys_Microseconds
+
+Same origin as Sys_Milliseconds, so dividing by 1000 gives the same value
+================
+*/
+int64_t Sys_Microseconds (void)
+{
+	struct timeval tp;
+
+	gettimeofday(&tp, NULL);
+
+	if (!sys_timeBase)
+		sys_timeBase = tp.tv_sec;
+
+	return (int64_t)(tp.tv_sec - sys_timeBase)*1000000 + tp.tv_usec;
+}
+
 /*
 ==================
 Sys_RandomBytes
@@ -571,6 +591,260 @@ void Sys_Sleep( int msec )
 	}
 }
 
+struct sysThread_s {
+	pthread_t		thread;
+	sysThreadFunc_t	func;
+	void			*data;
+	int				result;
+};
+
+struct sysMutex_s {
+	pthread_mutex_t	mutex;
+};
+
+// POSIX unnamed semaphores are not available on macOS
+struct sysSemaphore_s {
+	pthread_mutex_t	mutex;
+	pthread_cond_t	cond;
+	int				value;
+};
+
+/*
+==================
+Sys_ThreadMain
+==================
+*/
+static void *Sys_ThreadMain( void *data )
+{
+	sysThread_t *thread = data;
+
+	thread->result = thread->func( thread->data );
+
+	return NULL;
+}
+
+/*
+==================
+Sys_CreateThread
+
+Returns NULL if the thread could not be started
+==================
+*/
+sysThread_t *Sys_CreateThread( sysThreadFunc_t func, void *data )
+{
+	sysThread_t *thread;
+
+	thread = malloc( sizeof( *thread ) );
+	if( !thread )
+		return NULL;
+
+	thread->func = func;
+	thread->data = data;
+	thread->result = 0;
+
+	if( pthread_create( &thread->thread, NULL, Sys_ThreadMain, thread ) != 0 )
+	{
+		free( thread );
+		return NULL;
+	}
+
+	return thread;
+}
+
+/*
+==================
+Sys_WaitThread
+
+Waits for the thread to return, frees it and returns the result of its function
+==================
+*/
+int Sys_WaitThread( sysThread_t *thread )
+{
+	int result;
+
+	pthread_join( thread->thread, NULL );
+
+	result = thread->result;
+	free( thread );
+
+	return result;
+}
+
+/*
+==================
+Sys_CreateMutex
+==================
+*/
+sysMutex_t *Sys_CreateMutex( void )
+{
+	sysMutex_t *mutex;
+
+	mutex = malloc( sizeof( *mutex ) );
+	if( !mutex )
+		return NULL;
+
+	if( pthread_mutex_init( &mutex->mutex, NULL ) != 0 )
+	{
+		free( mutex );
+		return NULL;
+	}
+
+	return mutex;
+}
+
+/*
+==================
+Sys_DestroyMutex
+==================
+*/
+void Sys_DestroyMutex( sysMutex_t *mutex )
+{
+	pthread_mutex_destroy( &mutex->mutex );
+	free( mutex );
+}
+
+/*
+==================
+Sys_LockMutex
+==================
+*/
+void Sys_LockMutex( sysMutex_t *mutex )
+{
+	pthread_mutex_lock( &mutex->mutex );
+}
+
+/*
+==================
+Sys_UnlockMutex
+==================
+*/
+void Sys_UnlockMutex( sysMutex_t *mutex )
+{
+	pthread_mutex_unlock( &mutex->mutex );
+}
+
+/*
+==================
+Sys_CreateSemaphore
+==================
+*/
+sysSemaphore_t *Sys_CreateSemaphore( int value )
+{
+	sysSemaphore_t *sem;
+
+	sem = malloc( sizeof( *sem ) );
+	if( !sem )
+		return NULL;
+
+	if( pthread_mutex_init( &sem->mutex, NULL ) != 0 )
+	{
+		free( sem );
+		return NULL;
+	}
+
+	if( pthread_cond_init( &sem->cond, NULL ) != 0 )
+	{
+		pthread_mutex_destroy( &sem->mutex );
+		free( sem );
+		return NULL;
+	}
+
+	sem->value = value;
+
+	return sem;
+}
+
+/*
+==================
+Sys_DestroySemaphore
+==================
+*/
+void Sys_DestroySemaphore( sysSemaphore_t *sem )
+{
+	pthread_cond_destroy( &sem->cond );
+	pthread_mutex_destroy( &sem->mutex );
+	free( sem );
+}
+
+/*
+==================
+Sys_SemaphoreWait
+
+Blocks until the semaphore value is above 0 and decrements it
+==================
+*/
+void Sys_SemaphoreWait( sysSemaphore_t *sem )
+{
+	pthread_mutex_lock( &sem->mutex );
+
+	while( sem->value <= 0 )
+		pthread_cond_wait( &sem->cond, &sem->mutex );
+
+	sem->value--;
+
+	pthread_mutex_unlock( &sem->mutex );
+}
+
+/*
+==================
+Sys_SemaphoreTryWait
+
+Decrements the semaphore value if it is above 0 without blocking
+==================
+*/
+qboolean Sys_SemaphoreTryWait( sysSemaphore_t *sem )
+{
+	qboolean acquired = qfalse;
+
+	pthread_mutex_lock( &sem->mutex );
+
+	if( sem->value > 0 )
+	{
+		sem->value--;
+		acquired = qtrue;
+	}
+
+	pthread_mutex_unlock( &sem->mutex );
+
+	return acquired;
+}
+
+/*
+==================
+Sys_SemaphorePost
+==================
+*/
+void Sys_SemaphorePost( sysSemaphore_t *sem )
+{
+	pthread_mutex_lock( &sem->mutex );
+	sem->value++;
+	pthread_cond_signal( &sem->cond );
+	pthread_mutex_unlock( &sem->mutex );
+}
+
+/*
+==================
+Sys_AtomicLoad
+
+Everything the storing thread wrote before the matching
+Sys_AtomicStore is visible once this returns the new value.
+==================
+*/
+int Sys_AtomicLoad( volatile int *value )
+{
+	return __atomic_load_n( value, __ATOMIC_ACQUIRE );
+}
+
+/*
+==================
+Sys_AtomicStore
+==================
+*/
+void Sys_AtomicStore( volatile int *value, int newValue )
+{
+	__atomic_store_n( value, newValue, __ATOMIC_RELEASE );
+}
+
 /*
 ==============
 Sys_ErrorDialog
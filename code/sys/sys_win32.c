@@ -159,6 +159,18 @@ int Sys_Milliseconds (void)
 	return sys_curtime;
 }
 
+/*
+================
+Sys_Microseconds
+
+Only millisecond resolution, on the same origin as Sys_Milliseconds
+================
+*/
+int64_t Sys_Microseconds (void)
+{
+	return (int64_t)Sys_Milliseconds() * 1000;
+}
+
 /*
 ================
 Sys_RandomBytes
@@ -618,6 +630,222 @@ void Sys_Sleep( int msec )
 #endif
 }
 
+struct sysThread_s {
+	HANDLE			handle;
+	sysThreadFunc_t	func;
+	void			*data;
+};
+
+struct sysMutex_s {
+	CRITICAL_SECTION	section;
+};
+
+struct sysSemaphore_s {
+	HANDLE			handle;
+};
+
+/*
+==============
+Sys_ThreadMain
+==============
+*/
+static DWORD WINAPI Sys_ThreadMain( LPVOID data )
+{
+	sysThread_t *thread = data;
+
+	return (DWORD)thread->func( thread->data );
+}
+
+/*
+==============
+Sys_CreateThread
+
+Returns NULL if the thread could not be started
+==============
+*/
+sysThread_t *Sys_CreateThread( sysThreadFunc_t func, void *data )
+{
+	sysThread_t *thread;
+
+	thread = malloc( sizeof( *thread ) );
+	if( !thread )
+		return NULL;
+
+	thread->func = func;
+	thread->data = data;
+
+	thread->handle = CreateThread( NULL, 0, Sys_ThreadMain, thread, 0, NULL );
+	if( !thread->handle )
+	{
+		free( thread );
+		return NULL;
+	}
+
+	return thread;
+}
+
+/*
+==============
+Sys_WaitThread
+
+Waits for the thread to return, frees it and returns the result of its function
+==============
+*/
+int Sys_WaitThread( sysThread_t *thread )
+{
+	DWORD result = 0;
+
+	WaitForSingleObject( thread->handle, INFINITE );
+	GetExitCodeThread( thread->handle, &result );
+	CloseHandle( thread->handle );
+	free( thread );
+
+	return (int)result;
+}
+
+/*
+==============
+Sys_CreateMutex
+==============
+*/
+sysMutex_t *Sys_CreateMutex( void )
+{
+	sysMutex_t *mutex;
+
+	mutex = malloc( sizeof( *mutex ) );
+	if( !mutex )
+		return NULL;
+
+	InitializeCriticalSection( &mutex->section );
+
+	return mutex;
+}
+
+/*
+==============
+Sys_DestroyMutex
+==============
+*/
+void Sys_DestroyMutex( sysMutex_t *mutex )
+{
+	DeleteCriticalSection( &mutex->section );
+	free( mutex );
+}
+
+/*
+==============
+Sys_LockMutex
+==============
+*/
+void Sys_LockMutex( sysMutex_t *mutex )
+{
+	EnterCriticalSection( &mutex->section );
+}
+
+/*
+==============
+Sys_UnlockMutex
+==============
+*/
+void Sys_UnlockMutex( sysMutex_t *mutex )
+{
+	LeaveCriticalSection( &mutex->section );
+}
+
+/*
+==============
+Sys_CreateSemaphore
+==============
+*/
+sysSemaphore_t *Sys_CreateSemaphore( int value )
+{
+	sysSemaphore_t *sem;
+
+	sem = malloc( sizeof( *sem ) );
+	if( !sem )
+		return NULL;
+
+	sem->handle = CreateSemaphore( NULL, value, INT_MAX, NULL );
+	if( !sem->handle )
+	{
+		free( sem );
+		return NULL;
+	}
+
+	return sem;
+}
+
+/*
+==============
+Sys_DestroySemaphore
+==============
+*/
+void Sys_DestroySemaphore( sysSemaphore_t *sem )
+{
+	CloseHandle( sem->handle );
+	free( sem );
+}
+
+/*
+==============
+Sys_SemaphoreWait
+
+Blocks until the semaphore value is above 0 and decrements it
+==============
+*/
+void Sys_SemaphoreWait( sysSemaphore_t *sem )
+{
+	WaitForSingleObject( sem->handle, INFINITE );
+}
+
+/*
+==============
+Sys_SemaphoreTryWait
+
+Decrements the semaphore value if it is above 0 without blocking
+==============
+*/
+qboolean Sys_SemaphoreTryWait( sysSemaphore_t *sem )
+{
+	return WaitForSingleObject( sem->handle, 0 ) == WAIT_OBJECT_0;
+}
+
+/*
+==============
+Sys_SemaphorePost
+==============
+*/
+void Sys_SemaphorePost( sysSemaphore_t *sem )
+{
+	ReleaseSemaphore( sem->handle, 1, NULL );
+}
+
+/*
+==============
+Sys_AtomicLoad
+==============
+*/
+int Sys_AtomicLoad( volatile int *value )
+{
+	int result;
+
+	result = *value;
+	MemoryBarrier( );
+
+	return result;
+}
+
+/*
+==============
+Sys_AtomicStore
+==============
+*/
+void Sys_AtomicStore( volatile int *value, int newValue )
+{
+	MemoryBarrier( );
+	*value = newValue;
+}
+
 /*
 ==============
 Sys_ErrorDialog